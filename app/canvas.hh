@@ -33,6 +33,7 @@ class Grid;
 class Image;
 class Index;
 class IntPoint;
+class IntRect;
 class IntSize;
 class Object;
 class Point;
@@ -104,6 +105,8 @@ public:
   virtual IntSize GetSize() const = 0;
   virtual ToolInterface& GetTool() = 0;
   virtual const ToolInterface& GetTool() const = 0;
+  // The part of the image in view, in image coordinates.
+  virtual IntRect GetVisibleImageRect() const = 0;
   virtual coord GetZoom() const = 0;
   virtual ZoomLevel GetZoomLevel() const = 0;
   virtual bool Has(const FrameId&) const = 0;
@@ -20,6 +20,7 @@
 #include "app/context-commands.hh" // For context_targetted
 #include "app/faint-window-app-context.hh"
 #include "bitmap/draw.hh"
+#include "geo/int-rect.hh"
 #include "gui/art.hh"
 #include "gui/help-frame.hh"
 #include "gui/interpreter-frame.hh"
@@ -304,6 +305,26 @@ public:
     Update();
   }
 
+  void SetBitmapRegion(const Bitmap& bmp, const IntPoint& topLeft) override{
+    if (m_bitmap == nullptr){
+      Initialize();
+    }
+    blit(offsat(bmp, topLeft), onto(*m_bitmap));
+    Update();
+  }
+
+  IntRect GetVisibleRect() override{
+    const IntRect visible(m_canvas.GetVisibleImageRect());
+    if (m_rasterSelection != nullptr){
+      return translated(visible, -m_rasterSelection->TopLeft());
+    }
+    return visible;
+  }
+
+  coord GetZoom() override{
+    return m_canvas.GetZoom();
+  }
+
 private:
   void Update(){
     if (m_rasterSelection != nullptr && m_rasterSelection->Floating()){
@@ -41,6 +41,10 @@ uchar AlphaMapRef::Get(int x, int y) const{
   return m_data[to_index(x,y,m_stride)];
 }
 
+const uchar* AlphaMapRef::GetRow(int y) const{
+  return m_data + to_index(0, y, m_stride);
+}
+
 IntSize AlphaMapRef::GetSize() const{
   return m_size;
 }
@@ -154,11 +158,10 @@ static int int_abs(int v){
 }
 
 using std::swap;
-void stroke(AlphaMap& data, const UpperLeft& p0, const UpperLeft& p1,
-  const Brush& b)
+void stroke_steps(const UpperLeft& p0, const UpperLeft& p1,
+  const stroke_step_func& f)
 {
-
-int x0 = p0.Get().x;
+  int x0 = p0.Get().x;
   int y0 = p0.Get().y;
   int x1 = p1.Get().x;
   int y1 = p1.Get().y;
@@ -180,10 +183,10 @@ int x0 = p0.Get().x;
   for (int x = x0; x <= x1; x++){
     err += dy;
     if (steep){
-      brush_stroke(data, y, x, b);
+      f(IntPoint(y, x));
     }
     else{
-      brush_stroke(data, x, y, b);
+      f(IntPoint(x, y));
     }
 
     if (2 * err > dx){
@@ -193,4 +196,13 @@ int x0 = p0.Get().x;
   }
 }
 
+void stroke(AlphaMap& data, const UpperLeft& p0, const UpperLeft& p1,
+  const Brush& b)
+{
+  stroke_steps(p0, p1,
+    [&](const IntPoint& pos){
+      brush_stroke(data, pos.x, pos.y, b);
+    });
+}
+
 } // namespace
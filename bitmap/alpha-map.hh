@@ -15,6 +15,7 @@
 
 #ifndef FAINT_ALPHA_MAP_HH
 #define FAINT_ALPHA_MAP_HH
+#include <functional>
 #include <vector>
 #include "geo/primitive.hh" // uchar
 #include "geo/int-size.hh"
@@ -31,6 +32,9 @@ class AlphaMapRef{
   // View of a sub-region in an AlphaMap.
 public:
   uchar Get(int x, int y) const;
+
+  // The values of row y, for consecutive access.
+  const uchar* GetRow(int y) const;
   IntSize GetSize() const;
 
   // Returns the rectangle surrounding >0 positions
@@ -68,6 +72,13 @@ private:
 class category_alpha_map;
 using UpperLeft = Distinct<IntPoint, category_alpha_map, 0>;
 
+using stroke_step_func = std::function<void(const IntPoint&)>;
+
+// Calls the function with each position of a line from "from" to
+// "to", i.e. where the brush is applied in a stroke.
+void stroke_steps(const UpperLeft& from, const UpperLeft& to,
+  const stroke_step_func&);
+
 // Brush stroke between from and to, using the given brush. The
 // positions refer to the upper-left pixel of the Brush bounding
 // rectangle.
@@ -62,23 +62,34 @@ inline uchar* allocate_bitmap_data(size_t len){
   }
 }
 
+Bitmap::Pixels::Pixels(size_t len)
+  : data(allocate_bitmap_data(len)),
+    pins(0)
+{}
+
+Bitmap::Pixels::~Pixels(){
+  delete[] data;
+}
+
 Bitmap::Bitmap()
-  : m_row_stride(0)
+  : m_row_stride(0),
+    m_data(nullptr)
 {
   m_w = m_h = 0;
-  m_data = nullptr;
 }
 
 Bitmap::Bitmap(const Bitmap& other)
   : m_row_stride(other.m_row_stride),
     m_w(other.m_w),
     m_h(other.m_h),
-    m_data(nullptr)
+    m_pixels(other.m_pixels),
+    m_data(other.m_data)
 {
-  if (other.m_data != nullptr){
-    const auto len = data_length(m_row_stride, m_h);
-    m_data = allocate_bitmap_data(len);
-    memcpy(m_data, other.m_data, len);
+  if (m_pixels != nullptr && m_pixels->pins != 0){
+    // Pinned pixels can change via pointers held elsewhere, so must
+    // not be shared.
+    Allocate();
+    memcpy(m_data, other.m_data, data_length(m_row_stride, m_h));
   }
 }
 
@@ -91,9 +102,8 @@ Bitmap::Bitmap(const IntSize& sz)
   assert(m_w > 0);
   assert(m_h > 0);
   m_row_stride = faint_cairo_stride(sz);
-  const auto len = data_length(m_row_stride, m_h);
-  m_data = allocate_bitmap_data(len);
-  memset(m_data, 0, len);
+  Allocate();
+  memset(m_data, 0, data_length(m_row_stride, m_h));
 }
 
 Bitmap::Bitmap(const IntSize& sz, const Color& bgColor)
@@ -105,8 +115,7 @@ Bitmap::Bitmap(const IntSize& sz, const Color& bgColor)
   assert(m_w > 0);
   assert(m_h > 0);
   m_row_stride = faint_cairo_stride(sz);
-  const auto len = data_length(m_row_stride, m_h);
-  m_data = allocate_bitmap_data(len);
+  Allocate();
   clear(*this, bgColor);
 }
 
@@ -119,8 +128,7 @@ Bitmap::Bitmap(const IntSize& sz, const Paint& bg)
   assert(m_w > 0);
   assert(m_h > 0);
   m_row_stride = faint_cairo_stride(sz);
-  const auto len = data_length(m_row_stride, m_h);
-  m_data = allocate_bitmap_data(len);
+  Allocate();
   clear(*this, bg);
 }
 
@@ -134,24 +142,51 @@ Bitmap::Bitmap(const IntSize& sz, int stride)
   assert(sz.h > 0);
   assert(m_row_stride >= sz.w);
 
-  const auto len = data_length(m_row_stride, m_h);
-  m_data = allocate_bitmap_data(len);
-  memset(m_data, 0, len);
+  Allocate();
+  memset(m_data, 0, data_length(m_row_stride, m_h));
 }
 
 Bitmap::Bitmap(Bitmap&& source)
   : m_row_stride(source.m_row_stride),
     m_w(source.m_w),
     m_h(source.m_h),
+    m_pixels(std::move(source.m_pixels)),
     m_data(source.m_data)
 {
+  source.m_pixels = nullptr;
   source.m_data = nullptr;
   source.m_w = 0;
   source.m_h = 0;
 }
 
-Bitmap::~Bitmap(){
-  delete[] m_data;
+Bitmap::~Bitmap(){}
+
+void Bitmap::Allocate(){
+  m_pixels = std::make_shared<Pixels>(data_length(m_row_stride, m_h));
+  m_data = m_pixels->data;
+}
+
+void Bitmap::Detach(){
+  if (!IsShared()){
+    return;
+  }
+
+  std::shared_ptr<Pixels> shared(std::move(m_pixels));
+  Allocate();
+  memcpy(m_data, shared->data, data_length(m_row_stride, m_h));
+}
+
+PixelPin Bitmap::Pin(){
+  Detach();
+  if (m_pixels == nullptr){
+    return nullptr;
+  }
+
+  std::shared_ptr<Pixels> pixels(m_pixels);
+  pixels->pins++;
+  return PixelPin(m_data, [pixels](void*){
+    pixels->pins--;
+  });
 }
 
 Bitmap& Bitmap::operator=(const Bitmap& other){
@@ -165,6 +200,7 @@ void Bitmap::Swap(Bitmap& other){
   swap(m_row_stride, other.m_row_stride);
   swap(m_w, other.m_w);
   swap(m_h, other.m_h);
+  swap(m_pixels, other.m_pixels);
   swap(m_data, other.m_data);
 }
 
@@ -178,9 +214,12 @@ bool Bitmap::operator==(const Bitmap& other) const{
   if (m_w != other.m_w || m_h != other.m_h){
     return false;
   }
+  if (m_data == other.m_data){
+    return true;
+  }
 
-  uchar* lhs = m_data;
-  uchar* rhs = other.m_data;
+  const uchar* lhs = m_data;
+  const uchar* rhs = other.m_data;
 
   int lhsStride = m_row_stride;
   int rhsStride = other.m_row_stride;
@@ -208,7 +247,7 @@ bool bitmap_ok(const Bitmap& bmp){
 }
 
 void clear(Bitmap& bmp, const Color& c){
-  uchar* data = bmp.m_data;
+  uchar* data = bmp.GetRaw();
   for (int y = 0; y != bmp.m_h; y++){
     for (int x = 0; x != bmp.m_w; x++){
       int dst = y * bmp.m_row_stride + x * ByPP;
@@ -234,7 +273,7 @@ Color get_color(const Bitmap& bmp, const IntPoint& pos){
 
 Color get_color_raw(const Bitmap& bmp, int x, int y){
   int pos = y * bmp.m_row_stride + x * ByPP;
-  uchar* data = bmp.m_data;
+  const uchar* data = bmp.GetRaw();
   return Color(data[pos + iR],
     data[pos + iG],
     data[pos + iB],
@@ -15,6 +15,8 @@
 
 #ifndef FAINT_BITMAP_HH
 #define FAINT_BITMAP_HH
+#include <atomic>
+#include <memory>
 #include "bitmap/paint-fwd.hh"
 #include "geo/geo-fwd.hh"
 #include "geo/int-size.hh"
@@ -29,8 +31,18 @@ const int iB = 0;
 const int iA = 3;
 const int CHANNEL_MAX = 255;
 
+// Keeps the pixels of a Bitmap unshared during its lifetime, see
+// Bitmap::Pin.
+using PixelPin = std::shared_ptr<void>;
+
 class Bitmap {
   // BGRA32 Bitmap
+  //
+  // Copies share the pixel memory until one of them is modified
+  // (copy-on-write). The non-const GetRaw() (which DstBmp and
+  // put_pixel use) first gives the Bitmap its own copy of shared
+  // pixels, so pointers it returns must not be written through after
+  // the Bitmap has been copied, unless the Bitmap is pinned.
 public:
   // Initializes an invalid Bitmap. Must be assigned to before use
   Bitmap();
@@ -42,6 +54,9 @@ public:
   Bitmap(Bitmap&&);
   ~Bitmap();
   inline uchar* GetRaw(){
+    if (IsShared()){
+      Detach();
+    }
     return m_data;
   }
 
@@ -57,6 +72,26 @@ public:
     return m_row_stride;
   }
 
+  // Gives this Bitmap its own copy of the pixels, if shared.
+  //
+  // The non-const GetRaw() does this as needed, but is not safe to
+  // call concurrently on a shared Bitmap, so this must be called
+  // before writing to a copied Bitmap from multiple threads.
+  void Detach();
+
+  // True if the pixel memory is shared with another Bitmap.
+  inline bool IsShared() const{
+    return m_pixels != nullptr &&
+      m_pixels->pins == 0 &&
+      m_pixels.use_count() > 1;
+  }
+
+  // Detaches the pixels, and makes copies of this Bitmap get their
+  // own pixels while the returned pin exists, for when the pixels are
+  // written via a pointer kept elsewhere (e.g. by a cairo surface or
+  // an exported Python buffer).
+  PixelPin Pin();
+
   void Swap(Bitmap&);
 
   Bitmap& operator=(const Bitmap&);
@@ -68,6 +103,24 @@ public:
   int m_row_stride;
   int m_w;
   int m_h;
+private:
+  class Pixels{
+    // Pixel memory, reference counted by the Bitmaps sharing it and
+    // the PixelPins.
+  public:
+    explicit Pixels(size_t len);
+    ~Pixels();
+
+    Pixels(const Pixels&) = delete;
+    Pixels& operator=(const Pixels&) = delete;
+
+    uchar* const data;
+    std::atomic<int> pins;
+  };
+
+  void Allocate();
+
+  std::shared_ptr<Pixels> m_pixels;
   uchar* m_data;
 };
 
@@ -107,7 +160,7 @@ public:
   }
 
   uchar* GetRaw() const{
-    return m_bmp.m_data;
+    return m_bmp.GetRaw();
   }
 
   IntSize GetSize() const{
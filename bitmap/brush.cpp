@@ -55,6 +55,10 @@ uchar Brush::Get(int x, int y) const{
   return m_data[y * m_w + x];
 }
 
+const uchar* Brush::GetRaw() const{
+  return m_data;
+}
+
 IntSize Brush::GetSize() const{
   return IntSize(m_w, m_h);
 }
@@ -28,6 +28,9 @@ public:
   void Set(int x, int y, uchar value);
   void Set(const IntPoint&, uchar value);
   uchar Get(int x, int y) const;
+
+  // The brush values, row by row without padding.
+  const uchar* GetRaw() const;
   IntSize GetSize() const;
   Brush& operator=(const Brush&);
 private:
@@ -14,54 +14,301 @@
 // permissions and limitations under the License.
 
 #include <algorithm>
+#include <bitset>
 #include <cassert>
-#include <unordered_set>
+#include <cstdint>
+#include <cstring> // memcpy
 #include "bitmap/bitmap.hh"
 #include "bitmap/color.hh"
 #include "bitmap/color-counting.hh"
 #include "bitmap/mask.hh"
+#include "util/parallel.hh"
 
 namespace faint{
 
 using color_vec_t = std::vector<Color>;
 using rgb_vec_t = std::vector<ColRGB>;
 
-static void insert_color_count(color_counts_t& colors, const Color& c){
-  auto h = to_hash(c);
-  auto it = colors.find(h);
-  if (it != colors.end()){
-    it->second++;
+// Bitmaps with fewer pixels are counted without the RGB presence
+// bitsets, which use 2 MiB each.
+static const int MIN_PIXELS_FOR_BITSET = 262144;
+
+// Pixels per shard, smaller bitmaps are counted on the calling thread.
+static const int MIN_PIXELS_PER_SHARD = 65536;
+
+// Colors per shard for add_color_counts, beyond which the table is
+// slower than adding to the color_counts_t directly (e.g. with mostly
+// distinct pixels).
+static const int MAX_COLORS_PER_SHARD = 65536;
+
+// One bit per 24-bit RGB color.
+using rgb_bitset_t = std::vector<uint64_t>;
+static const size_t RGB_BITSET_WORDS = (size_t(1) << 24) / 64;
+
+static uint32_t raw_pixel(const uchar* p){
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static uint32_t rgb_key(const uchar* p){
+  // The bit index for the color, ordered like ColRGB::operator<
+  return (static_cast<uint32_t>(p[iR]) << 16) |
+    (static_cast<uint32_t>(p[iG]) << 8) |
+    static_cast<uint32_t>(p[iB]);
+}
+
+static color_hash rgba_key(const uchar* p){
+  // Same as to_hash(const Color&)
+  return (static_cast<color_hash>(p[iR]) << 24) |
+    (static_cast<color_hash>(p[iG]) << 16) |
+    (static_cast<color_hash>(p[iB]) << 8) |
+    static_cast<color_hash>(p[iA]);
+}
+
+static void set_bit(rgb_bitset_t& bits, uint32_t key){
+  bits[key >> 6] |= uint64_t(1) << (key & 63);
+}
+
+static void merge_bits(rgb_bitset_t& dst, const rgb_bitset_t& src){
+  for (size_t i = 0; i != dst.size(); i++){
+    dst[i] |= src[i];
   }
-  else{
-    colors.insert({h, 1});
+}
+
+static int count_bits(const rgb_bitset_t& bits){
+  size_t num = 0;
+  for (uint64_t word : bits){
+    num += std::bitset<64>(word).count();
   }
+  return static_cast<int>(num);
 }
 
-void add_color_counts(const Bitmap& bmp, color_counts_t& colors){
-  assert(bmp.m_w > 0 && bmp.m_h > 0);
-  for (int y = 0; y != bmp.m_h; y++){
-    for (int x = 0; x != bmp.m_w; ++x){
-      insert_color_count(colors, get_color_raw(bmp, x,y));
+class ColorCountTable{
+  // Open addressing hash table with linear probing, from color_hash to
+  // pixel count. A count of zero marks an empty slot.
+public:
+  ColorCountTable()
+    : m_bits(INITIAL_BITS),
+      m_slots(size_t(1) << INITIAL_BITS)
+  {}
+
+  void Add(color_hash key, int count){
+    const size_t mask = m_slots.size() - 1;
+    for (size_t i = Index(key);; i = (i + 1) & mask){
+      Slot& slot = m_slots[i];
+      if (slot.count == 0){
+        slot.key = key;
+        slot.count = count;
+        m_size++;
+        if (2 * m_size > m_slots.size()){
+          Grow();
+        }
+        return;
+      }
+      if (slot.key == key){
+        slot.count += count;
+        return;
+      }
     }
   }
+
+  void Merge(const ColorCountTable& other){
+    other.Visit([this](color_hash key, int count){
+      Add(key, count);
+    });
+  }
+
+  int Size() const{
+    return static_cast<int>(m_size);
+  }
+
+  template<typename FUNC>
+  void Visit(const FUNC& func) const{
+    for (const Slot& slot : m_slots){
+      if (slot.count != 0){
+        func(slot.key, slot.count);
+      }
+    }
+  }
+
+private:
+  struct Slot{
+    color_hash key = 0;
+    int count = 0;
+  };
+
+  size_t Index(color_hash key) const{
+    // Fibonacci hashing
+    return static_cast<size_t>(
+      (static_cast<uint64_t>(key) * 0x9e3779b97f4a7c15ull) >> (64 - m_bits));
+  }
+
+  void Grow(){
+    std::vector<Slot> slots(m_slots.size() * 2);
+    slots.swap(m_slots);
+    m_bits++;
+    m_size = 0;
+    for (const Slot& slot : slots){
+      if (slot.count != 0){
+        Add(slot.key, slot.count);
+      }
+    }
+  }
+
+  static const int INITIAL_BITS = 8;
+  int m_bits;
+  size_t m_size = 0;
+  std::vector<Slot> m_slots;
+};
+
+// Splits the rows of the bitmap into one band per shard and calls
+// func(shard, y0, y1) for each band, concurrently.
+template<typename SHARD, typename FUNC>
+static std::vector<SHARD> count_in_shards(const Bitmap& bmp, const FUNC& func){
+  const int h = bmp.m_h;
+  const int numShards = std::max(1, std::min({get_max_threads(), h,
+    area(bmp.GetSize()) / MIN_PIXELS_PER_SHARD}));
+
+  std::vector<SHARD> shards(to_size_t(numShards));
+  parallel_for(numShards, 1,
+    [&](int first, int last){
+      for (int i = first; i != last; i++){
+        func(shards[to_size_t(i)], h * i / numShards,
+          h * (i + 1) / numShards);
+      }
+    });
+  return shards;
 }
 
-int count_colors(const Bitmap& bmp){
-  std::unordered_set<unsigned int> s;
-  for (int y = 0; y != bmp.m_h; y++){
+// Adds the colors in the rows [y0, y1) with add(key, count). Runs of
+// equal pixels are added once.
+template<typename FUNC>
+static void add_rows(const Bitmap& bmp, int y0, int y1, const FUNC& add){
+  for (int y = y0; y != y1; y++){
+    const uchar* row = bmp.GetRaw() + y * bmp.m_row_stride;
+    uint32_t prev = raw_pixel(row);
+    int run = 0;
     for (int x = 0; x != bmp.m_w; x++){
-      s.insert(to_hash(get_color_raw(bmp, x,y)));
+      const uchar* p = row + x * ByPP;
+      const uint32_t v = raw_pixel(p);
+      if (v != prev){
+        add(rgba_key(p - ByPP), run);
+        prev = v;
+        run = 0;
+      }
+      run++;
     }
+    add(rgba_key(row + (bmp.m_w - 1) * ByPP), run);
   }
-  return resigned(s.size());
 }
 
-rgb_vec_t unique_colors_rgb(const Bitmap& bmp, const Mask& exclude){
+class ColorCountShard{
+  // The colors counted for a band of rows. Counting stops when the
+  // table has too many colors to be worth merging, and the remaining
+  // rows [y0, y1) are counted directly into the color_counts_t
+  // instead.
+public:
+  ColorCountTable table;
+  int y0 = 0;
+  int y1 = 0;
+};
+
+void add_color_counts(const Bitmap& bmp, color_counts_t& colors){
   assert(bmp.m_w > 0 && bmp.m_h > 0);
-  assert(bmp.GetSize() == exclude.GetSize());
+  auto shards = count_in_shards<ColorCountShard>(bmp,
+    [&](ColorCountShard& shard, int y0, int y1){
+      for (int y = y0; y != y1; y++){
+        if (shard.table.Size() > MAX_COLORS_PER_SHARD){
+          shard.y0 = y;
+          shard.y1 = y1;
+          return;
+        }
+        add_rows(bmp, y, y + 1, [&](color_hash key, int count){
+          shard.table.Add(key, count);
+        });
+      }
+    });
+
+  const bool allInTables = std::all_of(begin(shards), end(shards),
+    [](const ColorCountShard& shard){
+      return shard.y0 == shard.y1;
+    });
+  if (allInTables){
+    // Reserving for only part of the colors made the remaining
+    // insertions slower, so this is only done when all colors are
+    // known to be in the tables.
+    size_t total = colors.size();
+    for (const auto& shard : shards){
+      total += to_size_t(shard.table.Size());
+    }
+    colors.reserve(total);
+  }
+
+  for (const auto& shard : shards){
+    shard.table.Visit([&](color_hash key, int count){
+      colors[key] += count;
+    });
+    add_rows(bmp, shard.y0, shard.y1, [&](color_hash key, int count){
+      colors[key] += count;
+    });
+  }
+}
+
+class DistinctColors{
+  // Opaque colors are recorded in a bitset (if allocated), others in
+  // the table.
+public:
+  rgb_bitset_t opaque;
+  ColorCountTable other;
+};
+
+int count_colors(const Bitmap& bmp){
+  if (bmp.m_w == 0 || bmp.m_h == 0){
+    return 0;
+  }
+
+  const bool useBitset = area(bmp.GetSize()) >= MIN_PIXELS_FOR_BITSET;
+  auto shards = count_in_shards<DistinctColors>(bmp,
+    [&](DistinctColors& colors, int y0, int y1){
+      if (useBitset){
+        colors.opaque.assign(RGB_BITSET_WORDS, 0);
+      }
+      for (int y = y0; y != y1; y++){
+        const uchar* row = bmp.GetRaw() + y * bmp.m_row_stride;
+        uint32_t prev = ~raw_pixel(row);
+        for (int x = 0; x != bmp.m_w; x++){
+          const uchar* p = row + x * ByPP;
+          const uint32_t v = raw_pixel(p);
+          if (v == prev){
+            continue;
+          }
+          prev = v;
+          if (useBitset && p[iA] == 255){
+            set_bit(colors.opaque, rgb_key(p));
+          }
+          else{
+            colors.other.Add(rgba_key(p), 1);
+          }
+        }
+      }
+    });
 
+  DistinctColors& merged = shards.front();
+  for (size_t i = 1; i < shards.size(); i++){
+    if (useBitset){
+      merge_bits(merged.opaque, shards[i].opaque);
+    }
+    merged.other.Merge(shards[i].other);
+  }
+  return count_bits(merged.opaque) + merged.other.Size();
+}
+
+static rgb_vec_t unique_colors_rgb_sorted(const Bitmap& bmp,
+  const Mask& exclude)
+{
   rgb_vec_t colors;
-  colors.reserve(area(bmp.GetSize()));
+  colors.reserve(to_size_t(area(bmp.GetSize())));
 
   for (int y = 0; y != bmp.m_h; y++){
     for (int x = 0; x != bmp.m_w; ++x){
@@ -75,6 +322,49 @@ rgb_vec_t unique_colors_rgb(const Bitmap& bmp, const Mask& exclude){
   return {begin(colors), std::unique(begin(colors), end(colors))};
 }
 
+rgb_vec_t unique_colors_rgb(const Bitmap& bmp, const Mask& exclude){
+  assert(bmp.m_w > 0 && bmp.m_h > 0);
+  assert(bmp.GetSize() == exclude.GetSize());
+
+  if (area(bmp.GetSize()) < MIN_PIXELS_FOR_BITSET){
+    return unique_colors_rgb_sorted(bmp, exclude);
+  }
+
+  auto shards = count_in_shards<rgb_bitset_t>(bmp,
+    [&](rgb_bitset_t& bits, int y0, int y1){
+      bits.assign(RGB_BITSET_WORDS, 0);
+      for (int y = y0; y != y1; y++){
+        const uchar* row = bmp.GetRaw() + y * bmp.m_row_stride;
+        for (int x = 0; x != bmp.m_w; x++){
+          if (!exclude.Get(x, y)){
+            set_bit(bits, rgb_key(row + x * ByPP));
+          }
+        }
+      }
+    });
+
+  rgb_bitset_t& merged = shards.front();
+  for (size_t i = 1; i < shards.size(); i++){
+    merge_bits(merged, shards[i]);
+  }
+
+  // The bit order is the ColRGB sort order.
+  rgb_vec_t colors;
+  colors.reserve(to_size_t(count_bits(merged)));
+  for (size_t i = 0; i != merged.size(); i++){
+    const uint64_t word = merged[i];
+    if (word == 0){
+      continue;
+    }
+    for (unsigned int bit = 0; bit != 64; bit++){
+      if (((word >> bit) & 1) != 0){
+        colors.push_back(rgb_from_hex(static_cast<unsigned int>(i * 64) + bit));
+      }
+    }
+  }
+  return colors;
+}
+
 Color most_common(const color_counts_t& colors){
   assert(!colors.empty());
   auto it = std::max_element(begin(colors), end(colors),
@@ -0,0 +1,229 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <algorithm>
+#include <cstring> // memcpy
+#include "bitmap/bitmap.hh"
+#include "bitmap/color.hh"
+#include "bitmap/composite.hh"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+  (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FAINT_COMPOSITE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace faint{
+
+static int div_255(int v){
+  // Exact v / 255 for 0 <= v <= 255 * 255
+  return (v + 1 + (v >> 8)) >> 8;
+}
+
+static uchar lerp(int src, int dst, int alpha){
+  return static_cast<uchar>(div_255(src * alpha + dst * (255 - alpha)));
+}
+
+static bool is_color(const uchar* p, const Color& c){
+  return p[iR] == c.r && p[iG] == c.g && p[iB] == c.b && p[iA] == c.a;
+}
+
+#ifdef FAINT_COMPOSITE_SSE2
+// Four pixels per __m128i. The alpha is the high byte of each 32-bit
+// lane, matching iA on the little-endian targets with SSE2.
+
+static __m128i load(const uchar* p){
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+static void store(uchar* p, __m128i v){
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+}
+
+static __m128i pixel_vector(const Color& c){
+  uchar px[ByPP];
+  px[iR] = c.r;
+  px[iG] = c.g;
+  px[iB] = c.b;
+  px[iA] = c.a;
+  int v;
+  memcpy(&v, px, ByPP);
+  return _mm_set1_epi32(v);
+}
+
+static __m128i alpha_mask(){
+  return _mm_set1_epi32(static_cast<int>(0xff000000u));
+}
+
+static __m128i alpha_of(__m128i pixels){
+  // The alpha of each pixel in all of its channels
+  const __m128i a = _mm_srli_epi32(pixels, 24);
+  const __m128i a2 = _mm_or_si128(a, _mm_slli_epi32(a, 8));
+  return _mm_or_si128(a2, _mm_slli_epi32(a2, 16));
+}
+
+static __m128i alpha_values(const uchar* alpha){
+  // Four alpha values, each in all channels of its pixel
+  int v;
+  memcpy(&v, alpha, 4);
+  const __m128i a = _mm_cvtsi32_si128(v);
+  const __m128i a2 = _mm_unpacklo_epi8(a, a);
+  return _mm_unpacklo_epi16(a2, a2);
+}
+
+static __m128i div_255_epu16(__m128i v){
+  const __m128i one = _mm_set1_epi16(1);
+  return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(v, one),
+    _mm_srli_epi16(v, 8)), 8);
+}
+
+static __m128i lerp_epu16(__m128i src, __m128i dst, __m128i alpha){
+  // The products and their sum are at most 255 * 255, so fit in
+  // unsigned 16-bit lanes.
+  const __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+  return div_255_epu16(_mm_add_epi16(_mm_mullo_epi16(src, alpha),
+    _mm_mullo_epi16(dst, inverse)));
+}
+
+static __m128i lerp_4(__m128i src, __m128i dst, __m128i alpha){
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i lo = lerp_epu16(_mm_unpacklo_epi8(src, zero),
+    _mm_unpacklo_epi8(dst, zero),
+    _mm_unpacklo_epi8(alpha, zero));
+  const __m128i hi = lerp_epu16(_mm_unpackhi_epi8(src, zero),
+    _mm_unpackhi_epi8(dst, zero),
+    _mm_unpackhi_epi8(alpha, zero));
+  return _mm_packus_epi16(lo, hi);
+}
+
+static __m128i select_pixels(__m128i mask, __m128i onTrue, __m128i onFalse){
+  return _mm_or_si128(_mm_and_si128(mask, onTrue),
+    _mm_andnot_si128(mask, onFalse));
+}
+#endif
+
+void blend_row(const uchar* src, uchar* dst, int n){
+  int i = 0;
+  #ifdef FAINT_COMPOSITE_SSE2
+  const __m128i alphaMask = alpha_mask();
+  for (; i + 4 <= n; i += 4){
+    const __m128i s = load(src + i * ByPP);
+    const __m128i d = load(dst + i * ByPP);
+    store(dst + i * ByPP, select_pixels(alphaMask, _mm_max_epu8(s, d),
+      lerp_4(s, d, alpha_of(s))));
+  }
+  #endif
+  for (; i != n; i++){
+    const uchar* s = src + i * ByPP;
+    uchar* d = dst + i * ByPP;
+    const int alpha = s[iA];
+    d[iR] = lerp(s[iR], d[iR], alpha);
+    d[iG] = lerp(s[iG], d[iG], alpha);
+    d[iB] = lerp(s[iB], d[iB], alpha);
+    d[iA] = std::max(s[iA], d[iA]);
+  }
+}
+
+void blend_row_masked(const uchar* src, uchar* dst, int n,
+  const Color& mask)
+{
+  int i = 0;
+  #ifdef FAINT_COMPOSITE_SSE2
+  const __m128i alphaMask = alpha_mask();
+  const __m128i maskPixel = pixel_vector(mask);
+  for (; i + 4 <= n; i += 4){
+    const __m128i s = load(src + i * ByPP);
+    const __m128i d = load(dst + i * ByPP);
+    const __m128i keep = _mm_or_si128(_mm_cmpeq_epi32(s, maskPixel),
+      alphaMask);
+    store(dst + i * ByPP, select_pixels(keep, d, lerp_4(s, d, alpha_of(s))));
+  }
+  #endif
+  for (; i != n; i++){
+    const uchar* s = src + i * ByPP;
+    uchar* d = dst + i * ByPP;
+    if (s[iA] == 0 || is_color(s, mask)){
+      continue;
+    }
+    const int alpha = s[iA];
+    d[iR] = lerp(s[iR], d[iR], alpha);
+    d[iG] = lerp(s[iG], d[iG], alpha);
+    d[iB] = lerp(s[iB], d[iB], alpha);
+  }
+}
+
+void blit_row_masked(const uchar* src, uchar* dst, int n,
+  const Color& mask)
+{
+  int i = 0;
+  #ifdef FAINT_COMPOSITE_SSE2
+  const __m128i maskPixel = pixel_vector(mask);
+  for (; i + 4 <= n; i += 4){
+    const __m128i s = load(src + i * ByPP);
+    const __m128i d = load(dst + i * ByPP);
+    store(dst + i * ByPP, select_pixels(_mm_cmpeq_epi32(s, maskPixel), d, s));
+  }
+  #endif
+  for (; i != n; i++){
+    const uchar* s = src + i * ByPP;
+    if (!is_color(s, mask)){
+      memcpy(dst + i * ByPP, s, ByPP);
+    }
+  }
+}
+
+void blend_color_row(const Color& c, const uchar* alpha, uchar* dst, int n){
+  int i = 0;
+  #ifdef FAINT_COMPOSITE_SSE2
+  const __m128i s = pixel_vector(c);
+  for (; i + 4 <= n; i += 4){
+    const __m128i d = load(dst + i * ByPP);
+    store(dst + i * ByPP, lerp_4(s, d, alpha_values(alpha + i)));
+  }
+  #endif
+  for (; i != n; i++){
+    uchar* d = dst + i * ByPP;
+    d[iR] = lerp(c.r, d[iR], alpha[i]);
+    d[iG] = lerp(c.g, d[iG], alpha[i]);
+    d[iB] = lerp(c.b, d[iB], alpha[i]);
+    d[iA] = lerp(c.a, d[iA], alpha[i]);
+  }
+}
+
+void blend_alpha_row(const uchar* src, const uchar* alpha, uchar* dst,
+  int n)
+{
+  int i = 0;
+  #ifdef FAINT_COMPOSITE_SSE2
+  const __m128i alphaMask = alpha_mask();
+  for (; i + 4 <= n; i += 4){
+    const __m128i s = load(src + i * ByPP);
+    const __m128i d = load(dst + i * ByPP);
+    const __m128i a = alpha_values(alpha + i);
+    store(dst + i * ByPP, select_pixels(alphaMask, _mm_max_epu8(a, d),
+      lerp_4(s, d, a)));
+  }
+  #endif
+  for (; i != n; i++){
+    const uchar* s = src + i * ByPP;
+    uchar* d = dst + i * ByPP;
+    d[iR] = lerp(s[iR], d[iR], alpha[i]);
+    d[iG] = lerp(s[iG], d[iG], alpha[i]);
+    d[iB] = lerp(s[iB], d[iB], alpha[i]);
+    d[iA] = std::max(alpha[i], d[iA]);
+  }
+}
+
+} // namespace
@@ -0,0 +1,55 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_COMPOSITE_HH
+#define FAINT_COMPOSITE_HH
+#include "geo/primitive.hh" // uchar
+
+namespace faint{
+
+class Color;
+
+// Kernels for compositing n consecutive pixels of a bitmap row.
+//
+// Channels are blended as (src * alpha + dst * (255 - alpha)) / 255,
+// rounded down. The division is exact integer arithmetic, using SSE2
+// when available.
+
+// Blends src onto dst using the alpha of src. The destination alpha
+// becomes the larger of the source and destination alpha.
+void blend_row(const uchar* src, uchar* dst, int n);
+
+// Like blend_row, but leaves the destination pixel unchanged where
+// the source is the mask color, and keeps the destination alpha.
+void blend_row_masked(const uchar* src, uchar* dst, int n,
+  const Color& mask);
+
+// Copies the source pixels which differ from the mask color.
+void blit_row_masked(const uchar* src, uchar* dst, int n,
+  const Color& mask);
+
+// Blends the color onto dst using the alpha values, one per pixel,
+// for all four channels.
+void blend_color_row(const Color&, const uchar* alpha, uchar* dst, int n);
+
+// Blends the colors of src onto dst using the alpha values, one per
+// pixel, instead of the alpha of src. The destination alpha becomes
+// the larger of the alpha value and the destination alpha.
+void blend_alpha_row(const uchar* src, const uchar* alpha, uchar* dst,
+  int n);
+
+} // namespace
+
+#endif
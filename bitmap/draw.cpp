@@ -15,6 +15,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring> // memcpy
 #include <functional>
 #include <unordered_set>
 #include "bitmap/alpha-map.hh"
@@ -22,6 +23,7 @@
 #include "bitmap/bitmap.hh"
 #include "bitmap/bitmap-templates.hh"
 #include "bitmap/color-ptr.hh"
+#include "bitmap/composite.hh"
 #include "bitmap/draw.hh"
 #include "bitmap/iter-bmp.hh"
 #include "bitmap/mask.hh"
@@ -30,6 +32,7 @@
 #include "bitmap/scale-bilinear.hh"
 #include "bitmap/scale-nearest.hh"
 #include "bitmap/scale-quality.hh"
+#include "bitmap/scanline-fill.hh"
 #include "geo/axis.hh"
 #include "geo/geo-func.hh"
 #include "geo/geo-list-points.hh"
@@ -38,26 +41,13 @@
 #include "geo/measure.hh"
 #include "geo/offsat.hh"
 #include "geo/point.hh"
+#include "geo/primitive.hh"
 #include "geo/range.hh"
 #include "geo/scale.hh"
 #include "geo/size.hh"
 #include "util/make-vector.hh"
 #include "util/optional.hh"
-
-namespace std{
-
-template<>
-struct hash<faint::IntPoint>{
-  typedef faint::IntPoint argument_type;
-  typedef std::size_t result_type;
-
-  result_type operator()(const faint::IntPoint& pt) const{
-    // http://stackoverflow.com/a/2634715
-    return (51 + std::hash<int>()(pt.x)) * 51 + std::hash<int>()(pt.y);
-  }
-};
-
-} // namespace
+#include "util/parallel.hh"
 
 namespace faint{
 
@@ -834,8 +824,8 @@ void fill_triangle_f(Bitmap& bmp,
 
 static Bitmap flip_horizontal(const Bitmap& src){
   Bitmap dst(src);
-  uchar* pDst = dst.m_data;
-  uchar* pSrc = src.m_data;
+  uchar* pDst = dst.GetRaw();
+  const uchar* pSrc = src.GetRaw();
   for (int y = 0; y != src.m_h; y++){
     for (int x = 0 ; x != src.m_w; x++){
       int iSrc = y * src.m_row_stride + x * ByPP;
@@ -851,8 +841,8 @@ static Bitmap flip_horizontal(const Bitmap& src){
 
 static Bitmap flip_vertical(const Bitmap& src){
   Bitmap dst(src);
-  uchar* pDst = dst.m_data;
-  uchar* pSrc = src.m_data;
+  uchar* pDst = dst.GetRaw();
+  const uchar* pSrc = src.GetRaw();
   for (int y = 0; y != src.m_h; y++){
     for (int x = 0 ; x != src.m_w; x++){
       int iSrc = y * src.m_row_stride + x * ByPP;
@@ -930,11 +920,12 @@ void blend_alpha(Bitmap& bmp, const ColRGB& color){
   bmp = alpha_blended(bmp, color);
 }
 
-void blend(const Offsat<Bitmap>& src, DstBmp dst){
-  if (!intersects(src, dst)){
-    return;
-  }
-
+// Calls func(srcRow, dstRow, n) for each row where the source overlaps
+// the destination.
+template<typename FUNC>
+static void composite_rows(const Offsat<Bitmap>& src, DstBmp& dst,
+  const FUNC& func)
+{
   const int x0 = src.Offset().x;
   const int y0 = src.Offset().y;
 
@@ -948,21 +939,20 @@ void blend(const Offsat<Bitmap>& src, DstBmp dst){
   const int dstStride = dst.GetStride();
   const uchar* srcData = src->GetRaw();
   uchar* dstData = dst.GetRaw();
-  for (int y = yMin; y != yMax; y++){
-    for (int x = xMin; x != xMax; x++){
-      int srcPos = y * srcStride + x * ByPP;
-      int dstPos = (y + y0) * dstStride + (x + x0) * ByPP;
-      float alpha = srcData[srcPos + iA];
-      dstData[dstPos + iR] = static_cast<uchar>((srcData[srcPos + iR] * alpha +
-        dstData[dstPos + iR] * (255 - alpha)) / 255);
-      dstData[dstPos + iG] = static_cast<uchar>((srcData[srcPos + iG] * alpha +
-        dstData[dstPos + iG] * (255 - alpha)) / 255);
-      dstData[dstPos + iB] = static_cast<uchar>((srcData[srcPos + iB] * alpha +
-        dstData[dstPos + iB] * (255 - alpha)) / 255);
-      dstData[dstPos + iA] =
-        std::max(srcData[srcPos + iA], dstData[dstPos + iA]);
+  for_row_ranges(yMin, yMax, xMax - xMin, [&](int first, int last){
+    for (int y = first; y != last; y++){
+      func(srcData + y * srcStride + xMin * ByPP,
+        dstData + (y + y0) * dstStride + (xMin + x0) * ByPP,
+        xMax - xMin);
     }
+  });
+}
+
+void blend(const Offsat<Bitmap>& src, DstBmp dst){
+  if (!intersects(src, dst)){
+    return;
   }
+  composite_rows(src, dst, blend_row);
 }
 
 void blend_masked(const Offsat<Bitmap>& src, DstBmp dst,
@@ -971,100 +961,107 @@ void blend_masked(const Offsat<Bitmap>& src, DstBmp dst,
   if (!intersects(src, dst)){
     return;
   }
+  composite_rows(src, dst,
+    [&](const uchar* srcRow, uchar* dstRow, int n){
+      blend_row_masked(srcRow, dstRow, n, maskColor);
+    });
+}
 
-  int x0 = src.Offset().x;
-  int y0 = src.Offset().y;
+// Calls rowFunc(alphaRow, dstRow, x, y, n) for each row where the
+// alpha map overlaps the destination, x and y being the position of
+// the first overlapping value in the alpha map. A row function is
+// created with createRowFunc for each range of rows, so that it can
+// keep buffers for its thread.
+template<typename CREATE_ROW_FUNC>
+static void composite_alpha_rows(const Offsat<AlphaMapRef>& offsatAlphaMap,
+  DstBmp& dst,
+  const CREATE_ROW_FUNC& createRowFunc)
+{
+  const AlphaMapRef& alphaMap(offsatAlphaMap.Get());
+  const IntPoint topLeft(offsatAlphaMap.Offset());
 
+  const int xMin = std::max(0, -topLeft.x);
+  const int yMin = std::max(0, -topLeft.y);
+  IntSize srcSz(alphaMap.GetSize());
   IntSize dstSz(dst.GetSize());
-  const int xMin = std::max(0, -x0);
-  const int yMin = std::max(0, -y0);
-  const int xMax = std::min(dstSz.w - x0, src->m_w);
-  const int yMax = std::min(dstSz.h - y0, src->m_h);
+  const int xMax = std::min(dstSz.w - topLeft.x, srcSz.w);
+  const int yMax = std::min(dstSz.h - topLeft.y, srcSz.h);
 
-  int srcStride = src->GetStride();
-  int dstStride = dst.GetStride();
-  const uchar* srcData = src->GetRaw();
+  const int stride = dst.GetStride();
   uchar* dstData = dst.GetRaw();
+  for_row_ranges(yMin, yMax, xMax - xMin, [&](int first, int last){
+    auto rowFunc = createRowFunc(xMax - xMin);
+    for (int y = first; y != last; y++){
+      rowFunc(alphaMap.GetRow(y) + xMin,
+        dstData + (y + topLeft.y) * stride + (xMin + topLeft.x) * ByPP,
+        xMin, y, xMax - xMin);
+    }
+  });
+}
 
-  for (int y = yMin; y != yMax; y++){
-    for (int x = xMin; x != xMax; x++){
-      int srcPos = y * srcStride + x * ByPP;
-       if (srcData[srcPos + iA] == 0 ||
-         (srcData[srcPos + iA] == maskColor.a &&
-           srcData[srcPos + iR] == maskColor.r &&
-           srcData[srcPos + iG] == maskColor.g &&
-           srcData[srcPos + iB] == maskColor.b)){
-         continue;
-       }
-
-      int dstPos = (y + y0) * dstStride + (x + x0) * ByPP;
-      uchar alpha = srcData[srcPos + iA];
-      dstData[dstPos + iR] = static_cast<uchar>((srcData[srcPos + iR] * alpha +
-         dstData[dstPos + iR] * (255 - alpha)) / 255);
-      dstData[dstPos + iG] = static_cast<uchar>((srcData[srcPos + iG] * alpha +
-         dstData[dstPos + iG] * (255 - alpha)) / 255);
-      dstData[dstPos + iB] = static_cast<uchar>((srcData[srcPos + iB] * alpha +
-         dstData[dstPos + iB] * (255 - alpha)) / 255);
+static void repeated_row(const Bitmap& src, int x0, int y, int n,
+  uchar* dst)
+{
+  // Copies n pixels starting at x0, y from the bitmap, repeated in
+  // all directions, like get_color_modulo_raw.
+  const uchar* row = src.GetRaw() + wrap(y, src.m_h) * src.GetStride();
+  for (int i = 0; i != n;){
+    const int x = x0 + i;
+    if (x >= 0){
+      const int srcX = x % src.m_w;
+      const int count = std::min(n - i, src.m_w - srcX);
+      memcpy(dst + i * ByPP, row + srcX * ByPP, to_size_t(count * ByPP));
+      i += count;
+    }
+    else{
+      memcpy(dst + i * ByPP, row + wrap(x, src.m_w) * ByPP, ByPP);
+      i++;
     }
   }
 }
 
-static void blend_pattern(const Offsat<AlphaMapRef>& inAlphaMap, DstBmp dst,
-  const Pattern& p)
+static void blend_repeated(const Offsat<AlphaMapRef>& alphaMap, DstBmp dst,
+  const Bitmap& src,
+  const IntPoint& srcOffset)
 {
-  const AlphaMapRef& alphaMap = inAlphaMap.Get();
-  auto blendFunc = [&](int x, int y){return alphaMap.Get(x,y);};
+  // Blends the colors of the repeated bitmap (offset relative to the
+  // alpha map) using the alpha map, one row at a time instead of
+  // via a bitmap for the whole map.
+  composite_alpha_rows(alphaMap, dst, [&](int width){
+    return [&, colors = std::vector<uchar>(to_size_t(width * ByPP))]
+      (const uchar* alphaRow, uchar* dstRow, int x, int y, int n) mutable{
+        repeated_row(src, x + srcOffset.x, y + srcOffset.y, n,
+          colors.data());
+        blend_alpha_row(colors.data(), alphaRow, dstRow, n);
+      };
+  });
+}
 
-  Bitmap strokeMap(alphaMap.GetSize()); // Fixme: Costly allocation
-  blend_pixels(strokeMap, ColorFromPattern(p), blendFunc);
-  blend(offsat(strokeMap, inAlphaMap.Offset()), dst);
+static void blend_pattern(const Offsat<AlphaMapRef>& alphaMap, DstBmp dst,
+  const Pattern& p)
+{
+  blend_repeated(alphaMap, dst, p.GetBitmap(), p.GetAnchor());
 }
 
-static void blend_gradient(const Offsat<AlphaMapRef>& offsatAlphaMap,
+static void blend_gradient(const Offsat<AlphaMapRef>& alphaMap,
   DstBmp dst,
   const Gradient& g)
 {
-  const AlphaMapRef& alphaMap = offsatAlphaMap.Get();
-  alphaMap.BoundingRect().IfSet(
+  alphaMap->BoundingRect().IfSet(
     [&](const IntRect& r){
-      Bitmap strokeMap(alphaMap.GetSize()); // Fixme: Costly allocation
-      blend_pixels(strokeMap, ColorFromGradient(g, r),
-        [&](int x, int y){
-          return alphaMap.Get(x,y);});
-      blend(offsat(strokeMap, offsatAlphaMap.Offset()), dst);
+      blend_repeated(alphaMap, dst, cairo_gradient_bitmap(g, r.GetSize()),
+        -r.TopLeft());
     });
 }
 
-static void blend_color(const Offsat<AlphaMapRef>& offsatAlphaMap, DstBmp dst,
+static void blend_color(const Offsat<AlphaMapRef>& alphaMap, DstBmp dst,
   const Color& c)
 {
-  const AlphaMapRef& alphaMap(offsatAlphaMap.Get());
-  const IntPoint topLeft(offsatAlphaMap.Offset());
-
-  const int xMin = std::max(0, -topLeft.x);
-  const int yMin = std::max(0, -topLeft.y);
-  IntSize srcSz(alphaMap.GetSize());
-  IntSize dstSz(dst.GetSize());
-  const int xMax = std::min(dstSz.w - topLeft.x, srcSz.w);
-  const int yMax = std::min(dstSz.h - topLeft.y, srcSz.h);
-
-  const int stride = dst.GetStride();
-  uchar* dstData = dst.GetRaw();
-
-  for (int y = yMin; y != yMax; y++){
-    for (int x = xMin; x != xMax; x++){
-      int dstPos = (y + topLeft.y) * stride + (x + topLeft.x) * ByPP;
-      uchar alpha = alphaMap.Get(x,y);
-      dstData[dstPos + iR] = static_cast<uchar>((c.r * alpha +
-          dstData[dstPos + iR] * (255 - alpha)) / 255);
-      dstData[dstPos + iG] = static_cast<uchar>((c.g * alpha +
-          dstData[dstPos + iG] * (255 - alpha)) / 255);
-      dstData[dstPos + iB] = static_cast<uchar>((c.b * alpha +
-          dstData[dstPos + iB] * (255 - alpha)) / 255);
-      dstData[dstPos + iA] = static_cast<uchar>((c.a * alpha +
-          dstData[dstPos + iA] * (255 - alpha)) / 255);
-    }
-  }
+  composite_alpha_rows(alphaMap, dst, [&](int){
+    return [&](const uchar* alphaRow, uchar* dstRow, int, int, int n){
+      blend_color_row(c, alphaRow, dstRow, n);
+    };
+  });
 }
 
 void blend(const Offsat<AlphaMapRef>& alphaMap, DstBmp dst, const Paint& paint){
@@ -1100,16 +1097,12 @@ void blit(const Offsat<Bitmap>& src, DstBmp dst){
   const int srcStride = src->GetStride();
   uchar* dstData = dst.GetRaw();
   const uchar* srcData = src->GetRaw();
+  const size_t rowBytes = to_size_t((xMax - xMin) * ByPP);
 
   for (int y = yMin; y != yMax; y++){
-    for (int x = xMin; x != xMax; x++){
-      int srcPos = y * srcStride + x * ByPP;
-      int dstPos = (y + y0) * dstStride + (x + x0) * ByPP;
-      dstData[dstPos] = srcData[srcPos];
-      dstData[dstPos + 1] = srcData[srcPos + 1];
-      dstData[dstPos + 2] = srcData[srcPos + 2];
-      dstData[dstPos + 3] = srcData[srcPos + 3];
-    }
+    memcpy(dstData + (y + y0) * dstStride + (xMin + x0) * ByPP,
+      srcData + y * srcStride + xMin * ByPP,
+      rowBytes);
   }
 }
 
@@ -1117,369 +1110,82 @@ void blit_masked(const Offsat<Bitmap>& src, DstBmp dst, const Color& maskColor){
   if (!intersects(src, dst)){
     return;
   }
-
-  int x0 = src.Offset().x;
-  int y0 = src.Offset().y;
-  const int xMin = std::max(0, -x0);
-  const int yMin = std::max(0, -y0);
-
-  IntSize dstSz(dst.GetSize());
-  const int xMax = std::min(dstSz.w - x0, src->m_w);
-  const int yMax = std::min(dstSz.h - y0, src->m_h);
-
-  const int srcStride = src->GetStride();
-  const int dstStride = dst.GetStride();
-
-  uchar* dstData = dst.GetRaw();
-  const uchar* srcData = src->GetRaw();
-
-  for (int y = yMin; y != yMax; y++){
-    for (int x = xMin; x != xMax; x++){
-      int srcPos = y * srcStride + x * ByPP;
-      int dstPos = (y + y0) * dstStride + (x + x0) * ByPP;
-      if (
-          srcData[srcPos + 3] != maskColor.a ||
-          srcData[srcPos + 2] != maskColor.r ||
-          srcData[srcPos + 1] != maskColor.g ||
-          srcData[srcPos] != maskColor.b)
-        {
-          dstData[dstPos] = srcData[srcPos];
-          dstData[dstPos + 1] = srcData[srcPos + 1];
-          dstData[dstPos + 2] = srcData[srcPos + 2];
-          dstData[dstPos + 3] = srcData[srcPos + 3];
-        }
-    }
-  }
-}
-
-static void boundary_fill_color(Bitmap& bmp, const IntPoint& pos,
-  const Color& fillColor, const Color& boundaryColor)
-{
-  if (get_color(bmp, pos) == boundaryColor){
-    return;
-  }
-  std::vector<IntPoint> v;
-  std::unordered_set<IntPoint> used;
-  v.push_back(pos);
-
-  for (uint i = 0; i != v.size(); i++){
-    IntPoint w = v[i];
-    bool addedUp = false;
-    bool addedDown = false;
-    for (EVER){
-      put_pixel(bmp, w, fillColor);
-      used.insert(w);
-      IntPoint above = w - delta_y(1);
-      if (above.y > 0 && used.find(above) == used.end() &&
-        get_color(bmp, above) != boundaryColor)
-      {
-        if (!addedUp){
-          addedUp = true;
-          v.push_back(above);
-        }
-      }
-      else{
-        addedUp = false;
-      }
-      IntPoint below = w + delta_y(1);
-      if (below.y != bmp.m_h && used.find(below) == used.end() &&
-        get_color(bmp, below) != boundaryColor)
-      {
-        if (!addedDown){
-          v.push_back(below);
-          addedDown = true;
-        }
-      }
-      else{
-        addedDown = false;
-      }
-
-      IntPoint nextW = w - delta_x(1);
-      if (nextW.x < 0 || used.find(nextW) != used.end() ||
-        get_color(bmp, nextW) == boundaryColor)
-      {
-        break;
-      }
-      w = nextW;
-    }
-
-    addedUp = false;
-    addedDown = false;
-    IntPoint e = v[i];
-    for (EVER){
-      put_pixel(bmp, e, fillColor);
-      used.insert(e);
-      IntPoint nextE = e + delta_x(1);
-      if (nextE.x == bmp.m_w || used.find(nextE) != used.end() ||
-        get_color(bmp, nextE) == boundaryColor)
-      {
-        break;
-      }
-      e = nextE;
-      IntPoint above = e - delta_y(1);
-      if (above.y >= 0 && used.find(above) == used.end() &&
-        get_color(bmp, above) != boundaryColor)
-      {
-        if (!addedUp){
-          addedUp = true;
-          v.push_back(above);
-        }
-      }
-      else{
-        addedUp = false;
-      }
-
-      IntPoint below = e + delta_y(1);
-      if (below.y != bmp.m_h && used.find(below) == used.end() &&
-        get_color(bmp, below) != boundaryColor)
-      {
-        if (!addedDown){
-          v.push_back(below);
-          addedDown = true;
-        }
-      }
-      else{
-        addedDown = false;
-      }
-    }
-  }
+  composite_rows(src, dst,
+    [&](const uchar* srcRow, uchar* dstRow, int n){
+      blit_row_masked(srcRow, dstRow, n, maskColor);
+    });
 }
 
-void boundary_fill_pattern_relative(Bitmap& bmp, const IntPoint& pos,
-  const Pattern& pattern, const Color& boundaryColor)
+template<typename INSIDE>
+static void fill_region(Bitmap& bmp, const IntPoint& pos, const Paint& paint,
+  const INSIDE& inside)
 {
-  if (get_color(bmp, pos) == boundaryColor){
-    return;
-  }
-
-  Bitmap filled(bmp);
-  std::vector<IntPoint> v;
-  std::unordered_set<IntPoint> used;
-  v.push_back(pos);
-
-  const Bitmap& patBmp(pattern.GetBitmap());
-  const IntPoint patOffset = pattern.GetAnchor();
-
-  for (uint i = 0; i != v.size(); i++){
-    IntPoint w = v[i];
-    bool addedUp = false;
-    bool addedDown = false;
-    for (EVER){
-      put_pixel(filled, w, get_color_modulo(patBmp, w + patOffset));
-      used.insert(w);
-      IntPoint above = w - delta_y(1);
-      if (above.y > 0 && used.find(above) == used.end() &&
-        get_color(bmp, above) != boundaryColor)
-      {
-        if (!addedUp){
-          addedUp = true;
-          v.push_back(above);
-        }
-      }
-      else{
-        addedUp = false;
-      }
-      IntPoint below = w + delta_y(1);
-      if (below.y != bmp.m_h && used.find(below) == used.end() &&
-        get_color(bmp, below) != boundaryColor)
-      {
-        if (!addedDown){
-          v.push_back(below);
-          addedDown = true;
-        }
-      }
-      else{
-        addedDown = false;
-      }
-
-      IntPoint nextW = w - delta_x(1);
-      if (nextW.x < 0 || used.find(nextW) != used.end() ||
-        get_color(bmp, nextW) == boundaryColor)
-      {
-        break;
+  // Fills the 4-connected region of pixels around pos for which
+  // inside(x, y) is true with the paint.
+  const IntSize size(bmp.GetSize());
+  visit(paint,
+    [&](const Color& color){
+      uchar* data = bmp.GetRaw();
+      scanline_fill(size, pos, inside,
+        [&](int y, int x0, int x1){
+          uchar* p = data + y * bmp.m_row_stride + x0 * ByPP;
+          for (int x = x0; x != x1; x++, p += ByPP){
+            color_ptr(p).Set(color);
+          }
+        });
+    },
+    [&](const Pattern& pattern){
+      const Bitmap& patBmp(pattern.GetBitmap());
+      const IntPoint patOffset = pattern.GetAnchor();
+      scanline_fill(size, pos, inside,
+        [&](int y, int x0, int x1){
+          for (int x = x0; x != x1; x++){
+            put_pixel_raw(bmp, x, y, get_color_modulo_raw(patBmp,
+              x + patOffset.x, y + patOffset.y));
+          }
+        });
+    },
+    [&](const Gradient& gradient){
+      // The gradient is stretched over the bounding rectangle of the
+      // region, so the spans are drawn after the region is known.
+      std::vector<IntLineSegment> spans;
+      IntPoint minPos(size.w, size.h);
+      IntPoint maxPos(0, 0);
+      scanline_fill(size, pos, inside,
+        [&](int y, int x0, int x1){
+          spans.emplace_back(IntPoint(x0, y), IntPoint(x1 - 1, y));
+          minPos = min_coords(minPos, IntPoint(x0, y));
+          maxPos = max_coords(maxPos, IntPoint(x1 - 1, y));
+        });
+      if (spans.empty()){
+        return;
       }
-      w = nextW;
-    }
 
-    addedUp = false;
-    addedDown = false;
-    IntPoint e = v[i];
-    for (EVER){
-      put_pixel(filled, e, get_color_modulo(patBmp, e + patOffset));
-      used.insert(e);
-      IntPoint nextE = e + delta_x(1);
-      if (nextE.x == bmp.m_w || used.find(nextE) != used.end() ||
-        get_color(bmp, nextE) == boundaryColor)
-      {
-        break;
-      }
-      e = nextE;
-      IntPoint above = e - delta_y(1);
-      if (above.y >= 0 && used.find(above) == used.end() &&
-        get_color(bmp, above) != boundaryColor)
-      {
-        if (!addedUp){
-          v.push_back(above);
-          addedUp = true;
-        }
-      }
-      else{
-        addedUp = false;
-      }
-      IntPoint below = e + delta_y(1);
-      if (below.y != bmp.m_h && used.find(below) == used.end() &&
-        get_color(bmp, below) != boundaryColor)
-      {
-        if (!addedDown){
-          v.push_back(below);
-          addedDown = true;
+      const Bitmap grBmp(IntSize(maxPos.x - minPos.x + 1,
+        maxPos.y - minPos.y + 1), Paint(gradient));
+      for (const auto& span : spans){
+        const int y = span.p0.y;
+        for (int x = span.p0.x; x <= span.p1.x; x++){
+          const Color c(get_color_raw(grBmp, x - minPos.x, y - minPos.y));
+          put_pixel_raw(bmp, x, y, Color(strip_alpha(c), 255));
         }
       }
-      else{
-        addedDown = false;
-      }
-    }
-  }
-  blit(at_top_left(filled), onto(bmp));
+    });
 }
 
-void boundary_fill_gradient(Bitmap& bmp, const IntPoint& pos,
-  const Gradient& gradient, const Color& boundaryColor)
+void boundary_fill(Bitmap& bmp, const IntPoint& pos, const Paint& fillPaint,
+  const Color& boundaryColor)
 {
   if (get_color(bmp, pos) == boundaryColor){
     return;
   }
 
-  Color fillColor = boundaryColor == color_black ? color_white : color_black;
-  Bitmap filled(bmp.GetSize(), fillColor == color_white ? color_black :
-    color_white);
-
-  std::vector<IntPoint> v;
-  std::unordered_set<IntPoint> used;
-  v.push_back(pos);
-
-  // Min and max filled pixels, used to determine the gradient rectangle
-  int min_x = bmp.m_w - 1;
-  int min_y = bmp.m_h - 1;
-  int max_x = 0;
-  int max_y = 0;
-
-  for (uint i = 0; i != v.size(); i++){
-    IntPoint w = v[i];
-    bool addedUp = false;
-    bool addedDown = false;
-    for (EVER){
-      put_pixel(filled, w, fillColor);
-      put_pixel(bmp, w, fillColor);
-      min_x = std::min(min_x, w.x);
-      max_x = std::max(max_x, w.x);
-      min_y = std::min(min_y, w.y);
-      max_y = std::max(max_y, w.y);
-
-      used.insert(w);
-      IntPoint above = w - delta_y(1);
-      if (above.y > 0 && used.find(above) == used.end() &&
-        get_color(bmp, above) != boundaryColor)
-      {
-        if (!addedUp){
-          v.push_back(above);
-          addedUp = true;
-        }
-      }
-      else{
-        addedUp = false;
-      }
-      IntPoint below = w + delta_y(1);
-      if (below.y != bmp.m_h && used.find(below) == used.end() &&
-        get_color(bmp, below) != boundaryColor)
-      {
-        if (!addedDown){
-          v.push_back(below);
-        }
-      }
-      else{
-        addedDown = false;
-      }
-
-      IntPoint nextW = w - delta_x(1);
-      if (nextW.x < 0 || used.find(nextW) != used.end() ||
-        get_color(bmp, nextW) == boundaryColor)
-      {
-        break;
-      }
-      w = nextW;
-    }
-
-    addedUp = false;
-    addedDown = false;
-    IntPoint e = v[i];
-    for (EVER){
-      put_pixel(bmp, e, fillColor);
-      put_pixel(filled, e, fillColor);
-      min_x = std::min(min_x, e.x);
-      max_x = std::max(max_x, e.x);
-      min_y = std::min(min_y, e.y);
-      max_y = std::max(max_y, e.y);
-
-      used.insert(e);
-      IntPoint nextE = e + delta_x(1);
-      if (nextE.x == bmp.m_w || used.find(nextE) != used.end() ||
-        get_color(bmp, nextE) == boundaryColor)
-      {
-        break;
-      }
-      e = nextE;
-      IntPoint above = e - delta_y(1);
-      if (above.y >= 0 && used.find(above) == used.end() &&
-        get_color(bmp, above) != boundaryColor)
-      {
-        if (!addedUp){
-          v.push_back(above);
-          addedUp = true;
-        }
-      }
-      else{
-        addedUp = false;
-      }
-      IntPoint below = e + delta_y(1);
-      if (below.y != bmp.m_h && used.find(below) == used.end() &&
-        get_color(bmp, below) != boundaryColor)
-      {
-        if (!addedDown){
-          v.push_back(below);
-          addedDown = true;
-        }
-      }
-      else{
-        addedDown = false;
-      }
-    }
-  }
-
-  Bitmap grBmp(IntSize(max_x - min_x + 1, max_y - min_y + 1), Paint(gradient));
-  set_alpha(grBmp, 255);
-  for (int y = 0; y != grBmp.m_h; y++){
-    for (int x = 0; x != grBmp.m_w; x++){
-      if (get_color_raw(filled, x + min_x, y + min_y) != fillColor){
-        put_pixel_raw(grBmp, x, y, color_transparent_white);
-      }
-    }
-  }
-  blend(offsat(grBmp, min_x, min_y), onto(bmp));
-}
-
-void boundary_fill(Bitmap& bmp, const IntPoint& pos, const Paint& fillPaint,
-  const Color& boundaryColor)
-{
-  visit(fillPaint,
-    [&](const Color& c){
-      boundary_fill_color(bmp, pos, c, boundaryColor);
-    },
-    [&](const Pattern& p){
-      boundary_fill_pattern_relative(bmp, pos, p, boundaryColor);
-    },
-    [&](const Gradient& g){
-      boundary_fill_gradient(bmp, pos, g, boundaryColor);
+  // Detached before filling, so that the test sees the filled pixels
+  uchar* data = bmp.GetRaw();
+  fill_region(bmp, pos, fillPaint,
+    [&](int x, int y){
+      return !(color_ptr(data + y * bmp.m_row_stride + x * ByPP) ==
+        boundaryColor);
     });
 }
 
@@ -1693,210 +1399,21 @@ Bitmap flip(const Bitmap& bmp, const across& axis){
 void flood_fill_color(Bitmap& bmp, const IntPoint& pos,
   const Color& fillColor)
 {
-  std::vector< IntPoint > v;
-  const Color targetColor = get_color(bmp, pos);
-  if (targetColor == fillColor){
-    return;
-  }
-
-  v.push_back(pos);
-  for (uint i = 0; i != v.size(); i++){
-    if (get_color(bmp, v[i]) == targetColor){
-      IntPoint w = v[i];
-      IntPoint e = v[i];
-      for (EVER){
-        put_pixel(bmp, w, fillColor);
-        if (w.x - 1 < 0 || get_color_raw(bmp, w.x - 1, w.y) != targetColor){
-          break;
-        }
-        w.x -= 1;
-        if (w.y != 0 && get_color_raw(bmp, w.x, w.y - 1) == targetColor){
-          v.push_back(IntPoint(w.x, w.y - 1));
-        }
-        if (w.y != bmp.m_h - 1 && get_color_raw(bmp, w.x, w.y + 1) ==
-          targetColor)
-        {
-          v.push_back(IntPoint(w.x, w.y + 1));
-        }
-      }
-
-      for (EVER){
-        put_pixel(bmp, e, fillColor); // Fixme: Will put twice due to w
-        if (e.y != 0 && get_color_raw(bmp, e.x, e.y - 1) == targetColor){
-          v.push_back(IntPoint(e.x, e.y - 1));
-        }
-        if (e.y != bmp.m_h - 1 && get_color_raw(bmp, e.x, e.y + 1) ==
-          targetColor)
-        {
-          v.push_back(IntPoint(e.x, e.y + 1));
-        }
-
-        if (e.x + 1 == bmp.m_w || get_color_raw(bmp, e.x + 1, e.y) !=
-          targetColor)
-        {
-          break;
-        }
-        e.x += 1;
-      }
-    }
-  }
+  flood_fill(bmp, pos, Paint(fillColor));
 }
 
-void flood_fill_gradient(Bitmap& bmp, const IntPoint& pos,
-  const Gradient& gradient)
-{
-  std::vector<IntPoint> v;
+void flood_fill(Bitmap& bmp, const IntPoint& pos, const Paint& paint){
   const Color targetColor = get_color(bmp, pos);
-  Color fillColor = targetColor == color_black ? color_white : color_black;
-
-  Bitmap filled(bmp.GetSize(), fillColor == color_white ? color_black :
-    color_white);
-  v.push_back(pos);
-
-  // Min and max filled pixels, used to determine the gradient rectangle
-  int min_x = bmp.m_w - 1;
-  int min_y = bmp.m_h - 1;
-  int max_x = 0;
-  int max_y = 0;
-
-  for (uint i = 0; i != v.size(); i++){
-    if (get_color(bmp, v[i]) == targetColor){
-      IntPoint w = v[i];
-      IntPoint e = v[i];
-      for (EVER){
-        put_pixel(filled, w, fillColor);
-        put_pixel(bmp, w, fillColor);
-        min_x = std::min(min_x, w.x);
-        max_x = std::max(max_x, w.x);
-        min_y = std::min(min_y, w.y);
-        max_y = std::max(max_y, w.y);
-
-        if (w.x - 1 < 0 || get_color_raw(bmp, w.x - 1, w.y) != targetColor){
-          break;
-        }
-        w.x -= 1;
-        if (w.y != 0 && get_color_raw(bmp, w.x, w.y - 1) == targetColor){
-          v.push_back(IntPoint(w.x, w.y - 1));
-        }
-        if (w.y != bmp.m_h - 1 && get_color_raw(bmp, w.x, w.y + 1) ==
-          targetColor)
-        {
-          v.push_back(IntPoint(w.x, w.y + 1));
-        }
-      }
-
-      for (EVER){
-        put_pixel(filled, e, fillColor); // Fixme: Will put twice due to w
-        put_pixel(bmp, e, fillColor);
-        min_x = std::min(min_x, e.x);
-        max_x = std::max(max_x, e.x);
-        min_y = std::min(min_y, e.y);
-        max_y = std::max(max_y, e.y);
-        if (e.y != 0 && get_color_raw(bmp, e.x, e.y - 1) == targetColor){
-          v.push_back(IntPoint(e.x, e.y - 1));
-        }
-        if (e.y != bmp.m_h - 1 && get_color_raw(bmp, e.x, e.y + 1) ==
-          targetColor)
-        {
-          v.push_back(IntPoint(e.x, e.y + 1));
-        }
-
-        if (e.x + 1 == bmp.m_w || get_color_raw(bmp, e.x + 1, e.y) !=
-          targetColor)
-        {
-          break;
-        }
-        e.x += 1;
-      }
-    }
-  }
-  if (min_x > max_x || min_y > max_y){
+  if (paint.IsColor() && paint.GetColor() == targetColor){
     return;
   }
 
-  Bitmap grBmp(IntSize(max_x - min_x + 1, max_y - min_y + 1), Paint(gradient));
-  set_alpha(grBmp, 255);
-  for (int y = 0; y != grBmp.m_h; y++){
-    for (int x = 0; x != grBmp.m_w; x++){
-      if (get_color_raw(filled, x + min_x, y + min_y) != fillColor){
-        put_pixel_raw(grBmp, x, y, color_transparent_white);
-      }
-    }
-  }
-  blend(offsat(grBmp, min_x, min_y), onto(bmp));
-}
-
-void flood_fill_pattern_relative(Bitmap& bmp, const IntPoint& pos, const
-  Pattern& pattern)
-{
-  // Fixme: Use ColorFromPattern
-  Bitmap filled(bmp);
-  std::vector< IntPoint > v;
-  const Color targetColor = get_color(bmp, pos);
-  Color c = color_black;
-  if (c == targetColor){
-    c = color_white;
-  }
-
-  const Bitmap& patBmp(pattern.GetBitmap());
-  const IntPoint patOffset = pattern.GetAnchor();
-
-  v.push_back(pos);
-  for (uint i = 0; i != v.size(); i++){
-    if (get_color(bmp, v[i]) == targetColor){
-      IntPoint w = v[i];
-      IntPoint e = v[i];
-      for (EVER){
-        put_pixel(bmp, w, c);
-        put_pixel(filled, w, get_color_modulo(patBmp, w + patOffset));
-        if (w.x - 1 < 0 || get_color_raw(bmp, w.x - 1, w.y) != targetColor){
-          break;
-        }
-        w.x -= 1;
-        if (w.y != 0 && get_color_raw(bmp, w.x, w.y - 1) == targetColor){
-          v.push_back(IntPoint(w.x, w.y - 1));
-        }
-        if (w.y != bmp.m_h - 1 && get_color_raw(bmp, w.x, w.y + 1) ==
-          targetColor)
-        {
-          v.push_back(IntPoint(w.x, w.y + 1));
-        }
-      }
-
-      for (EVER){
-        put_pixel(bmp, e, c);
-        put_pixel(filled, e, get_color_modulo(patBmp, (e + patOffset)));
-        if (e.y != 0 && get_color_raw(bmp, e.x, e.y - 1) == targetColor){
-          v.push_back(IntPoint(e.x, e.y - 1));
-        }
-        if (e.y != bmp.m_h - 1 && get_color_raw(bmp, e.x, e.y + 1) ==
-          targetColor)
-        {
-          v.push_back(IntPoint(e.x, e.y + 1));
-        }
-
-        if (e.x + 1 == bmp.m_w || get_color_raw(bmp, e.x + 1, e.y) !=
-          targetColor)
-        {
-          break;
-        }
-        e.x += 1;
-      }
-    }
-  }
-  blit(at_top_left(filled), onto(bmp));
-}
-
-void flood_fill(Bitmap& bmp, const IntPoint& pos, const Paint& paint){
-  visit(paint,
-    [&](const Color& color){
-      flood_fill_color(bmp, pos, color);
-    },
-    [&](const Pattern& pattern){
-      flood_fill_pattern_relative(bmp, pos, pattern);
-    },
-    [&](const Gradient& gradient){
-      flood_fill_gradient(bmp, pos, gradient);
+  // Detached before filling, so that the test sees the filled pixels
+  uchar* data = bmp.GetRaw();
+  fill_region(bmp, pos, paint,
+    [&](int x, int y){
+      return color_ptr(data + y * bmp.m_row_stride + x * ByPP) ==
+        targetColor;
     });
 }
 
@@ -1951,8 +1468,9 @@ void replace_color_color(Bitmap& bmp, const OldColor& in_oldColor,
 {
   const Color& oldColor(in_oldColor.Get());
   const Color& newColor(in_newColor.Get());
+  uchar* data = bmp.GetRaw();
   for (int y = 0; y != bmp.m_h; y++){
-    uchar* row = bmp.m_data + y * bmp.m_row_stride;
+    uchar* row = data + y * bmp.m_row_stride;
     for (int x = 0; x != bmp.m_w * ByPP; x += ByPP){
       color_ptr current(row + x);
       if (current == oldColor){
@@ -2008,8 +1526,8 @@ void replace_color(Bitmap& bmp, const OldColor& oldColor, const Paint& paint){
 
 Bitmap rotate_90cw(const Bitmap& src){
   Bitmap dst(transposed(src.GetSize()));
-  uchar* pDst = dst.m_data;
-  uchar* pSrc = src.m_data;
+  uchar* pDst = dst.GetRaw();
+  const uchar* pSrc = src.GetRaw();
   for (int y = 0; y != src.m_h; y++){
     for (int x = 0 ; x != src.m_w; x++){
       int iSrc = y * src.m_row_stride + x * ByPP;
@@ -2068,8 +1586,13 @@ void set_alpha_masked(Bitmap& bmp, uchar a, const Mask& m){
 }
 
 Bitmap subbitmap(const Bitmap& orig, const IntRect& r){
+  if (r == IntRect(IntPoint(0,0), orig.GetSize())){
+    // Shares the pixels
+    return orig;
+  }
+
   int origStride = orig.m_row_stride;
-  const uchar* origData = orig.m_data;
+  const uchar* origData = orig.GetRaw();
 
   Bitmap bmp(r.GetSize());
   uchar* data = bmp.GetRaw();
@@ -20,6 +20,7 @@
 #include "bitmap/color.hh"
 #include "bitmap/filter.hh"
 #include "bitmap/gaussian-blur.hh"
+#include "bitmap/point-ops.hh"
 #include "geo/angle.hh"
 #include "geo/padding.hh"
 #include "geo/point.hh"
@@ -144,20 +145,8 @@ public:
 };
 
 Bitmap brightness_and_contrast(const Bitmap& src, const brightness_contrast_t& v){
-  double scaledBrightness = v.brightness * 255.0;
-  Bitmap dst(src.GetSize());
-
-  for (int y = 0; y != src.m_h; y++){
-    for (int x = 0; x != src.m_w; x++){
-      const auto c = get_color_raw(src, x, y);
-      const auto c2 =
-        color_from_double(c.r * v.contrast + scaledBrightness,
-          c.g * v.contrast + scaledBrightness,
-          c.b * v.contrast + scaledBrightness,
-          c.a);
-      put_pixel_raw(dst, x, y, c2);
-    }
-  }
+  Bitmap dst(src);
+  PointOps().BrightnessContrast(v).Apply(dst);
   return dst;
 }
 
@@ -171,17 +160,7 @@ Color desaturated_simple(const Color& c){
 }
 
 void desaturate_simple(Bitmap& bmp){
-  uchar* data = bmp.m_data;
-  for (int y = 0; y != bmp.m_h; y++){
-    for (int x = 0; x != bmp.m_w; x++){
-      int dst = y * bmp.m_row_stride + x * ByPP;
-      uchar* p = data + dst;
-      uchar gray = desaturated_simple(p[iR], p[iG], p[iB]);
-      p[iR] = gray;
-      p[iG] = gray;
-      p[iB] = gray;
-    }
-  }
+  PointOps().DesaturateSimple().Apply(bmp);
 }
 
 static uchar desaturated_weighted(uchar r, uchar g, uchar b){
@@ -189,17 +168,7 @@ static uchar desaturated_weighted(uchar r, uchar g, uchar b){
 }
 
 void desaturate_weighted(Bitmap& bmp){
-  uchar* data = bmp.m_data;
-  for (int y = 0; y != bmp.m_h; y++){
-    for (int x = 0; x != bmp.m_w; x++){
-      int dst = y * bmp.m_row_stride + x * ByPP;
-      uchar* p = data + dst;
-      const uchar gray = desaturated_weighted(p[iR], p[iG], p[iB]);
-      p[iR] = gray;
-      p[iG] = gray;
-      p[iB] = gray;
-    }
-  }
+  PointOps().DesaturateWeighted().Apply(bmp);
 }
 
 Color desaturated_weighted(const Color& c){
@@ -251,19 +220,7 @@ void pixelize(Bitmap& bmp, const pixelize_range_t& width){
 void sepia(Bitmap& bmp, int intensity){
   // Modified from:
   // https://groups.google.com/forum/#!topic/comp.lang.java.programmer/nSCnLECxGdA
-  int depth = 20;
-  const IntSize sz = bmp.GetSize();
-
-  for (int y = 0; y != sz.h; y++){
-    for (int x = 0; x != sz.w; x++){
-      Color c = get_color_raw(bmp, x, y);
-      const int gray = (c.r + c.g + c.b) / 3;
-      const int r = std::min(gray + depth * 2, 255);
-      const int g = std::min(gray + depth, 255);
-      const int b = std::max(gray - intensity, 0);
-      put_pixel_raw(bmp, x, y, color_from_ints(r,g,b, c.a));
-    }
-  }
+  PointOps().Sepia(intensity).Apply(bmp);
 }
 
 static int color_sum(const Color& c){
@@ -271,6 +228,11 @@ static int color_sum(const Color& c){
 }
 
 void threshold(Bitmap& bmp, const threshold_range_t& range, const Paint& in, const Paint& out){
+  if (in.IsColor() && out.IsColor()){
+    PointOps().Threshold(range, in.GetColor(), out.GetColor()).Apply(bmp);
+    return;
+  }
+
   const Interval interval(range.GetInterval());
   set_pixels_if_else(bmp, in, out,
     [&interval, &bmp](int x, int y){
@@ -320,9 +282,7 @@ Bitmap unsharp_mask_fast(const Bitmap& bmp, double blurSigma){
 }
 
 Bitmap unsharp_mask_exact(const Bitmap& bmp, double blurSigma){
-  Bitmap blurred = gaussian_blur_exact(bmp, blurSigma);
-  Bitmap usm = subtract(bmp, blurred);
-  return add(bmp, usm);
+  return gaussian_sharpen_exact(bmp, blurSigma);
 }
 
 std::vector<int> red_histogram(Bitmap& bmp){
@@ -379,19 +339,7 @@ FilterPtr get_pixelize_filter(){
 }
 
 void invert(Bitmap& bmp){
-  for (int y = 0; y != bmp.m_h; y++){
-    uchar* data = bmp.m_data + y * bmp.m_row_stride;
-    for (int x = 0; x != bmp.m_w * ByPP; x += ByPP){
-      uchar* pos = data + x;
-      *(pos + iR) = static_cast<uchar>(255 - *(pos + iR));
-      *(pos + iG) = static_cast<uchar>(255 - *(pos + iG));
-      *(pos + iB) = static_cast<uchar>(255 - *(pos + iB));
-    }
-  }
-}
-
-static uchar clip_rgb(coord value){
-  return static_cast<uchar>(std::min(255.0, std::max(0.0, value)));
+  PointOps().Invert().Apply(bmp);
 }
 
 void color_balance(Bitmap& bmp,
@@ -399,33 +347,7 @@ void color_balance(Bitmap& bmp,
   const color_range_t& g,
   const color_range_t& b)
 {
-  const Interval rSpan(r.GetInterval());
-  const Interval gSpan(b.GetInterval());
-  const Interval bSpan(g.GetInterval());
-  double Ar = static_cast<coord>(rSpan.Lower());
-  double Br = static_cast<coord>(rSpan.Upper());
-  double Ag = static_cast<coord>(gSpan.Lower());
-  double Bg = static_cast<coord>(gSpan.Upper());
-  double Ab = static_cast<coord>(bSpan.Lower());
-  double Bb = static_cast<coord>(bSpan.Upper());
-  double L = 0.0;
-  double U = 255.0;
-  double Xr = (U-L) / (Br-Ar);
-  double Yr = L - Ar*((U-L)/ (Br-Ar));
-  double Xg = (U-L) / (Bg-Ag);
-  double Yg = L - Ag*((U-L)/ (Bg-Ag));
-  double Xb = (U-L) / (Bb-Ab);
-  double Yb = L - Ab*((U-L)/ (Bb-Ab));
-
-  for (int y = 0; y != bmp.m_h; y++){
-    uchar* row = bmp.m_data + y * bmp.m_row_stride;
-    for (int x = 0; x != bmp.m_w * ByPP; x += ByPP){
-      uchar* pos = row + x;
-      *(pos + iR) = clip_rgb(*(pos + iR) * Xr + Yr);
-      *(pos + iG) = clip_rgb(*(pos + iG) * Xg + Yg);
-      *(pos + iB) = clip_rgb(*(pos + iB) * Xb + Yb);
-    }
-  }
+  PointOps().ColorBalance(r, g, b).Apply(bmp);
 }
 
 static IntPoint whirled(const Point& p, const Point& c, coord r,
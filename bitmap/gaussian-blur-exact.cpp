@@ -16,14 +16,29 @@
 #include <algorithm> // transform
 #include <cassert>
 #include <cmath> // sqrt
+#include <cstdint>
+#include <cstring> // memcpy
 #include <iterator> // back_inserter
 #include <numeric> // accumulate
 #include <vector>
 #include "bitmap/gaussian-blur.hh"
+#include "geo/int-size.hh"
+#include "geo/primitive.hh"
 #include "util/math-constants.hh"
+#include "util/parallel.hh"
 
 namespace faint{
 
+// Fractional bits of the kernel weights, which sum to exactly
+// 1 << WEIGHT_BITS so that uniform regions are unchanged.
+static const int WEIGHT_BITS = 16;
+
+// Fractional bits of the 16-bit values from the horizontal pass.
+static const int INTERMEDIATE_BITS = 8;
+
+// The width in pixels of the column blocks of the vertical pass.
+static const int COLUMN_BLOCK = 64;
+
 static double gauss_1d(double x, double sigma){
   using faint::math::e;
   using faint::math::pi;
@@ -54,74 +69,160 @@ static std::vector<double> gauss_kernel_1d(double sigma){
   return k;
 }
 
-static std::vector<double> normalized_gauss_kernel_1d(double sigma){
+static std::vector<uint32_t> fixed_point_gauss_kernel_1d(double sigma){
   assert(sigma >= 0);
-  return normalize(gauss_kernel_1d(sigma));
+  const uint32_t one = 1u << WEIGHT_BITS;
+  if (sigma == 0){
+    return {one};
+  }
+
+  std::vector<uint32_t> k;
+  int64_t sum = 0;
+  for (double v : normalize(gauss_kernel_1d(sigma))){
+    k.push_back(static_cast<uint32_t>(std::lround(v * one)));
+    sum += k.back();
+  }
+
+  // Compensate for the rounding in the center
+  k[k.size() / 2] = static_cast<uint32_t>(k[k.size() / 2] + (one - sum));
+  return k;
 }
 
-static Bitmap kernel_h_apply(const Bitmap& src, const std::vector<double>& k){
-  Bitmap dst(src.GetSize());
-  int r = static_cast<int>(k.size()) / 2;
-  int w = resigned(k.size());
-  for (int y = 0; y != src.m_h; y++){
-    const uchar* srcRow = src.m_data + y * src.m_row_stride;
-    uchar* dstRow = dst.m_data + y * dst.m_row_stride;
-
-    for (int x = 0; x != src.m_w; x++){
-      double vR = 0;
-      double vG = 0;
-      double vB = 0;
-      double vA = 0;
-
-      for (int i = 0; i != w; i++){
-        int d = std::min(x, std::max(i - r, -(src.m_w - x - 1)));
-        vR += srcRow[(x - d) * ByPP + iR] * k[to_size_t(i)];
-        vG += srcRow[(x - d) * ByPP + iG] * k[to_size_t(i)];
-        vB += srcRow[(x - d) * ByPP + iB] * k[to_size_t(i)];
-        vA += srcRow[(x - d) * ByPP + iA] * k[to_size_t(i)];
+static void kernel_h_apply(const Bitmap& src,
+  const std::vector<uint32_t>& k,
+  uint16_t* dst,
+  int firstRow,
+  int lastRow)
+{
+  // Blurs the rows horizontally into 16-bit values with
+  // INTERMEDIATE_BITS fractional bits. Each row is first copied with
+  // the edge pixels repeated for the kernel radius, so that the taps
+  // need no clamping.
+  const int w = src.m_w;
+  const int r = resigned(k.size()) / 2;
+  const int kw = resigned(k.size());
+  const uint32_t half = 1u << (WEIGHT_BITS - INTERMEDIATE_BITS - 1);
+  std::vector<uchar> padded(to_size_t((w + 2 * r) * ByPP));
+
+  for (int y = firstRow; y != lastRow; y++){
+    const uchar* srcRow = src.GetRaw() + y * src.m_row_stride;
+    uchar* p = padded.data();
+    for (int x = 0; x != r; x++){
+      memcpy(p + x * ByPP, srcRow, ByPP);
+      memcpy(p + (r + w + x) * ByPP, srcRow + (w - 1) * ByPP, ByPP);
+    }
+    memcpy(p + r * ByPP, srcRow, to_size_t(w * ByPP));
+
+    uint16_t* dstRow = dst + y * w * ByPP;
+    for (int x = 0; x != w; x++){
+      uint32_t v0 = 0;
+      uint32_t v1 = 0;
+      uint32_t v2 = 0;
+      uint32_t v3 = 0;
+      const uchar* taps = p + x * ByPP;
+      for (int i = 0; i != kw; i++){
+        const uint32_t weight = k[to_size_t(i)];
+        v0 += taps[i * ByPP] * weight;
+        v1 += taps[i * ByPP + 1] * weight;
+        v2 += taps[i * ByPP + 2] * weight;
+        v3 += taps[i * ByPP + 3] * weight;
       }
-      dstRow[x * ByPP + iR] = static_cast<uchar>(vR);
-      dstRow[x * ByPP + iG] = static_cast<uchar>(vG);
-      dstRow[x * ByPP + iB] = static_cast<uchar>(vB);
-      dstRow[x * ByPP + iA] = static_cast<uchar>(vA);
+      const int shift = WEIGHT_BITS - INTERMEDIATE_BITS;
+      dstRow[x * ByPP] = static_cast<uint16_t>((v0 + half) >> shift);
+      dstRow[x * ByPP + 1] = static_cast<uint16_t>((v1 + half) >> shift);
+      dstRow[x * ByPP + 2] = static_cast<uint16_t>((v2 + half) >> shift);
+      dstRow[x * ByPP + 3] = static_cast<uint16_t>((v3 + half) >> shift);
     }
   }
-  return dst;
 }
 
-static Bitmap kernel_v_apply(const Bitmap& src, const std::vector<double>& k){
-  Bitmap dst(src.GetSize());
-  int r = static_cast<int>(k.size()) / 2;
-  int w = resigned(k.size());
-  static_assert(ByPP == 4, "4-bytes per pixel required.");
-  for (int y = 0; y != src.m_h; y++){
-    const uchar* srcRow = src.m_data + y * src.m_row_stride;
-    uchar* dstRow = dst.m_data + y * dst.m_row_stride;
-    for (int x = 0; x != src.m_w; x++){
-      double vR = 0;
-      double vG = 0;
-      double vB = 0;
-      double vA = 0;
-      for (int i = 0; i != w; i++){
-        const int d = std::min(y, std::max(i - r, -(src.m_h - y - 1)));
-        vR += srcRow[x * ByPP - d * src.m_row_stride + iR] * k[to_size_t(i)];
-        vG += srcRow[x * ByPP - d * src.m_row_stride + iG] * k[to_size_t(i)];
-        vB += srcRow[x * ByPP - d * src.m_row_stride + iB] * k[to_size_t(i)];
-        vA += srcRow[x * ByPP - d * src.m_row_stride + iA] * k[to_size_t(i)];
-      }
+template<typename OUTPUT>
+static void kernel_v_apply(const uint16_t* src,
+  const std::vector<uint32_t>& k,
+  const IntSize& size,
+  int firstRow,
+  int lastRow,
+  const OUTPUT& output)
+{
+  // Blurs the horizontally blurred values vertically, in blocks of
+  // columns so that the rows of the kernel stay in the cache while
+  // moving down. Passes the blurred channel values for each row of a
+  // block to output(y, firstByte, values, count).
+  const int r = resigned(k.size()) / 2;
+  const int kw = resigned(k.size());
+  const int rowValues = size.w * ByPP;
+  const uint32_t half = 1u << (WEIGHT_BITS + INTERMEDIATE_BITS - 1);
+  std::vector<uint32_t> sums(COLUMN_BLOCK * ByPP);
+  std::vector<uchar> values(COLUMN_BLOCK * ByPP);
 
-      dstRow[x * ByPP + iR] = static_cast<uchar>(vR);
-      dstRow[x * ByPP + iG] = static_cast<uchar>(vG);
-      dstRow[x * ByPP + iB] = static_cast<uchar>(vB);
-      dstRow[x * ByPP + iA] = static_cast<uchar>(vA);
+  for (int x0 = 0; x0 < rowValues; x0 += COLUMN_BLOCK * ByPP){
+    const int n = std::min(COLUMN_BLOCK * ByPP, rowValues - x0);
+    for (int y = firstRow; y != lastRow; y++){
+      uint32_t* sum = sums.data();
+      std::fill(sum, sum + n, 0);
+      for (int i = 0; i != kw; i++){
+        const int srcY = std::max(0, std::min(y + i - r, size.h - 1));
+        const uint16_t* row = src + srcY * rowValues + x0;
+        const uint32_t weight = k[to_size_t(i)];
+        for (int j = 0; j != n; j++){
+          sum[j] += row[j] * weight;
+        }
+      }
+      for (int j = 0; j != n; j++){
+        values[to_size_t(j)] = static_cast<uchar>(
+          (sum[j] + half) >> (WEIGHT_BITS + INTERMEDIATE_BITS));
+      }
+      output(y, x0, values.data(), n);
     }
   }
-  return dst;
+}
+
+template<typename OUTPUT>
+static void gaussian_blur_exact(const Bitmap& src,
+  double sigma,
+  const OUTPUT& output)
+{
+  const IntSize size(src.GetSize());
+  if (size.w == 0 || size.h == 0){
+    return;
+  }
+  const std::vector<uint32_t> k(fixed_point_gauss_kernel_1d(sigma));
+  std::vector<uint16_t> tmp(to_size_t(size.w * size.h * ByPP));
+
+  for_row_ranges(0, size.h, size.w, [&](int first, int last){
+    kernel_h_apply(src, k, tmp.data(), first, last);
+  });
+
+  for_row_ranges(0, size.h, size.w, [&](int first, int last){
+    kernel_v_apply(tmp.data(), k, size, first, last, output);
+  });
 }
 
 Bitmap gaussian_blur_exact(const Bitmap& src, double sigma){
-  auto k = normalized_gauss_kernel_1d(sigma);
-  return kernel_v_apply(kernel_h_apply(src, k), k);
+  Bitmap dst(src.GetSize());
+  uchar* dstData = dst.GetRaw();
+  gaussian_blur_exact(src, sigma,
+    [&](int y, int x0, const uchar* blurred, int n){
+      memcpy(dstData + y * dst.m_row_stride + x0, blurred, to_size_t(n));
+    });
+  return dst;
+}
+
+Bitmap gaussian_sharpen_exact(const Bitmap& src, double sigma){
+  Bitmap dst(src.GetSize());
+  uchar* dstData = dst.GetRaw();
+  gaussian_blur_exact(src, sigma,
+    [&](int y, int x0, const uchar* blurred, int n){
+      // Adds the (clamped) difference from the blurred image to the
+      // source channel values.
+      const uchar* s = src.GetRaw() + y * src.m_row_stride + x0;
+      uchar* d = dstData + y * dst.m_row_stride + x0;
+      for (int i = 0; i != n; i++){
+        const int diff = std::max(s[i] - blurred[i], 0);
+        d[i] = static_cast<uchar>(std::min(s[i] + diff, 255));
+      }
+    });
+  return dst;
 }
 
 } // namespace
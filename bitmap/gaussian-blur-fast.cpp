@@ -15,10 +15,11 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <vector>
-#include "bitmap/channel.hh"
 #include "bitmap/gaussian-blur.hh"
 #include "geo/primitive.hh"
+#include "util/parallel.hh"
 
 namespace faint{
 
@@ -28,6 +29,12 @@ namespace faint{
 // http://blog.ivank.net/fastest-gaussian-blur.html
 // by Ivan Kuckir.
 
+// The width in pixels of the column blocks of the vertical pass.
+static const int COLUMN_BLOCK = 64;
+
+// Radii are limited so that the reciprocal division is exact.
+static const int MAX_RADIUS = 30000;
+
 static std::vector<int> boxes_for_gauss(double sigma, int n){
   // Ideal averaging filter width
   const double wIdeal = std::sqrt((12*sigma*sigma/n)+1);
@@ -46,94 +53,146 @@ static std::vector<int> boxes_for_gauss(double sigma, int n){
   return sizes;
 }
 
-static void box_blur_H(channel_t& scl, channel_t& tcl, const IntSize& size, int r){
-  auto iarr = 1.0 / (r+r+1);
-  for (int i = 0; i != size.h; i++){
-    auto ti = i*size.w;
-    auto li = ti;
-    auto ri = ti+r;
-    auto fv = scl[to_size_t(ti)];
-    auto lv = scl[to_size_t(ti+size.w-1)];
-    auto val = (r+1)*fv;
-
-    for (int j = 0; j < r; j++){
-      val += scl[to_size_t(ti+j)];
+class BoxDivider{
+  // Divides box sums by the box width, rounded to nearest, with a
+  // multiplication by the fixed-point reciprocal. Exact for sums of
+  // 8-bit values for box widths below 65536.
+public:
+  explicit BoxDivider(int r)
+    : m_half(static_cast<uint64_t>(r)),
+      m_reciprocal(((uint64_t(1) << 40) + 2 * m_half) / (2 * m_half + 1))
+  {}
+
+  uchar operator()(uint32_t sum) const{
+    return static_cast<uchar>(((sum + m_half) * m_reciprocal) >> 40);
+  }
+private:
+  uint64_t m_half;
+  uint64_t m_reciprocal;
+};
+
+static int clamped(int i, int n){
+  return std::max(0, std::min(i, n - 1));
+}
+
+static void box_blur_rows(const Bitmap& src, Bitmap& dst, int r,
+  int firstRow, int lastRow)
+{
+  // Running sums over interleaved channels, with the pixels beyond
+  // the edges clamped to the edge pixels.
+  const int w = src.GetSize().w;
+  const BoxDivider divide(r);
+
+  for (int y = firstRow; y != lastRow; y++){
+    const uchar* s = src.GetRaw() + y * src.GetStride();
+    uchar* t = dst.GetRaw() + y * dst.GetStride();
+
+    uint32_t sum[ByPP];
+    for (int c = 0; c != ByPP; c++){
+      sum[c] = static_cast<uint32_t>(r + 1) * s[c];
+    }
+    for (int x = 0; x != r; x++){
+      const uchar* add = s + clamped(x, w) * ByPP;
+      for (int c = 0; c != ByPP; c++){
+        sum[c] += add[c];
+      }
     }
-    for (int j = 0; j <= r; j++){
-      val += scl[to_size_t(ri++)] - fv;
-      tcl[to_size_t(ti++)] = static_cast<unsigned char>(rounded(val*iarr));
+
+    auto step = [&](int x, const uchar* add, const uchar* sub){
+      for (int c = 0; c != ByPP; c++){
+        sum[c] += add[c];
+        sum[c] -= sub[c];
+        t[x * ByPP + c] = divide(sum[c]);
+      }
+    };
+
+    // Only the pixels near the edges need clamping
+    const int middleFirst = std::min(r + 1, w);
+    const int middleLast = std::max(middleFirst, w - r);
+    for (int x = 0; x != middleFirst; x++){
+      step(x, s + clamped(x + r, w) * ByPP, s);
     }
-    for (int j = r + 1; j < size.w - r; j++){
-      val += scl[to_size_t(ri++)] - scl[to_size_t(li++)];
-      tcl[to_size_t(ti++)] = static_cast<unsigned char>(rounded(val*iarr));
+    for (int x = middleFirst; x != middleLast; x++){
+      step(x, s + (x + r) * ByPP, s + (x - r - 1) * ByPP);
     }
-    for (int j = size.w - r; j != size.w; j++){
-      val += lv- scl[to_size_t(li++)];
-      tcl[to_size_t(ti++)] = static_cast<unsigned char>(rounded(val*iarr));
+    for (int x = middleLast; x != w; x++){
+      step(x, s + (w - 1) * ByPP, s + clamped(x - r - 1, w) * ByPP);
     }
   }
 }
 
-static void box_blur_T(channel_t& scl, channel_t& tcl, const IntSize& size, int r){
-  auto iarr = 1.0 / (r+r+1);
-  for (int i = 0; i != size.w; i++){
-    auto ti = i;
-    auto li = ti;
-    auto ri = ti + r * size.w;
-    auto fv = scl[to_size_t(ti)];
-    auto lv = scl[to_size_t(ti+size.w * (size.h - 1))];
-    auto val = (r + 1) * fv;
-    for (int j = 0; j != r; j++){
-      val += scl[to_size_t(ti + j * size.w)];
-    }
+static void box_blur_columns(const Bitmap& src, Bitmap& dst, int r,
+  int firstBlock, int lastBlock)
+{
+  // Blurs blocks of columns at a time, row by row, so that the
+  // reads and writes stay within a few cache lines per row.
+  const IntSize size(src.GetSize());
+  const BoxDivider divide(r);
+  std::vector<uint32_t> sums(COLUMN_BLOCK * ByPP);
 
-    for (int j = 0; j <= r; j++){
-      val += scl[to_size_t(ri)] - fv;
-      tcl[to_size_t(ti)] = static_cast<unsigned char>(rounded(val*iarr));
-      ri += size.w;
-      ti += size.w;
-    }
+  auto row = [&](int y){
+    return src.GetRaw() + clamped(y, size.h) * src.GetStride();
+  };
+
+  for (int block = firstBlock; block != lastBlock; block++){
+    const int x0 = block * COLUMN_BLOCK * ByPP;
+    const int numBytes = std::min(COLUMN_BLOCK, size.w - block * COLUMN_BLOCK)
+      * ByPP;
 
-    for (int j = r + 1; j != size.h - r; j++){
-      val += scl[to_size_t(ri)] - scl[to_size_t(li)];
-      tcl[to_size_t(ti)] = static_cast<unsigned char>(rounded(val*iarr));
-      li += size.w;
-      ri += size.w;
-      ti+=size.w;
+    const uchar* first = row(0) + x0;
+    for (int i = 0; i != numBytes; i++){
+      sums[to_size_t(i)] = static_cast<uint32_t>(r + 1) * first[i];
+    }
+    for (int y = 0; y != r; y++){
+      const uchar* add = row(y) + x0;
+      for (int i = 0; i != numBytes; i++){
+        sums[to_size_t(i)] += add[i];
+      }
     }
 
-    for (int j = size.h - r; j != size.h; j++){
-      val += lv - scl[to_size_t(li)];
-      tcl[to_size_t(ti)] = static_cast<unsigned char>(rounded(val*iarr));
-      li += size.w;
-      ti += size.w;
+    for (int y = 0; y != size.h; y++){
+      const uchar* add = row(y + r) + x0;
+      const uchar* sub = row(y - r - 1) + x0;
+      uchar* t = dst.GetRaw() + y * dst.GetStride() + x0;
+      uint32_t* sum = sums.data();
+      for (int i = 0; i != numBytes; i++){
+        sum[i] += add[i];
+        sum[i] -= sub[i];
+        t[i] = divide(sum[i]);
+      }
     }
   }
 }
 
-static void box_blur(channel_t& scl, channel_t& tcl, const IntSize& size, int r){
-  tcl = scl;
-  box_blur_H(tcl, scl, size, r);
-  box_blur_T(scl, tcl, size, r);
-}
+static void box_blur(Bitmap& bmp, Bitmap& tmp, int r){
+  // Blurs bmp horizontally into tmp, and tmp vertically back into bmp.
+  const IntSize size(bmp.GetSize());
 
-static void faux_gauss_blur(channel_t& scl, channel_t& tcl, const IntSize& size,
-  const std::vector<int>& boxes)
-{
-  box_blur(scl, tcl, size, (boxes[0] - 1) / 2);
-  box_blur(tcl, scl, size, (boxes[1] - 1) / 2);
-  box_blur(scl, tcl, size, (boxes[2] - 1) / 2);
+  for_row_ranges(0, size.h, size.w, [&](int first, int last){
+    box_blur_rows(bmp, tmp, r, first, last);
+  });
+
+  const int numBlocks = (size.w + COLUMN_BLOCK - 1) / COLUMN_BLOCK;
+  parallel_for(numBlocks, min_items_per_range(COLUMN_BLOCK * size.h),
+    [&](int first, int last){
+      box_blur_columns(tmp, bmp, r, first, last);
+    });
 }
 
-Bitmap gaussian_blur_fast(const Bitmap& bmp, double r){
-  auto ch = separate_into_channels(bmp);
-  auto ch2 = ch;
-  const auto boxes = boxes_for_gauss(r, 3);
-  faux_gauss_blur(ch.r, ch2.r, bmp.GetSize(), boxes);
-  faux_gauss_blur(ch.g, ch2.g, bmp.GetSize(), boxes);
-  faux_gauss_blur(ch.b, ch2.b, bmp.GetSize(), boxes);
-  faux_gauss_blur(ch.a, ch2.a, bmp.GetSize(), boxes);
-  return combine_into_bitmap(ch2);
+Bitmap gaussian_blur_fast(const Bitmap& src, double sigma){
+  const IntSize size(src.GetSize());
+  Bitmap bmp(src);
+  if (size.w == 0 || size.h == 0){
+    return bmp;
+  }
+
+  // Blurred in place from multiple threads
+  bmp.Detach();
+  Bitmap tmp(size);
+  for (int box : boxes_for_gauss(sigma, 3)){
+    box_blur(bmp, tmp, std::min((box - 1) / 2, MAX_RADIUS));
+  }
+  return bmp;
 }
 
 } // namespace
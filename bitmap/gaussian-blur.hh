@@ -24,6 +24,10 @@ namespace faint {
 // Complexity: O(n * sigma).
 Bitmap gaussian_blur_exact(const Bitmap&, double sigma);
 
+// Returns the bitmap with the difference to its gaussian blur (see
+// gaussian_blur_exact) added, for sharpening (unsharp masking).
+Bitmap gaussian_sharpen_exact(const Bitmap&, double sigma);
+
 // Approximation of gaussian blur with consecutive box blurs.
 // Complexity: O(n) for n-pixels (unaffected by sigma).
 Bitmap gaussian_blur_fast(const Bitmap&, double sigma);
@@ -0,0 +1,56 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <cassert>
+#include "bitmap/color.hh"
+#include "bitmap/lazy-bitmap.hh"
+#include "geo/int-point.hh"
+#include "geo/int-rect.hh"
+#include "util/parallel.hh"
+
+namespace faint{
+
+Color get_color(const LazyBitmap& lazy, const IntPoint& pos){
+  uchar px[ByPP];
+  lazy.ReadPixels(pos.x, pos.y, 1, 1, px);
+  return Color(px[iR], px[iG], px[iB], px[iA]);
+}
+
+Bitmap get_subsampled(const LazyBitmap& lazy, const IntRect& r, int step){
+  assert(step >= 1);
+  assert(intersection(r, IntRect(IntPoint(0,0), lazy.GetSize())) == r);
+
+  Bitmap bmp(IntSize((r.w + step - 1) / step, (r.h + step - 1) / step));
+  const int w = bmp.m_w;
+  uchar* data = bmp.GetRaw();
+  const int stride = bmp.GetStride();
+  parallel_for(bmp.m_h, 16,
+    [&](int first, int last){
+      for (int y = first; y != last; y++){
+        lazy.ReadPixels(r.x, r.y + y * step, w, step, data + y * stride);
+      }
+    });
+  return bmp;
+}
+
+Bitmap get_region(const LazyBitmap& lazy, const IntRect& r){
+  return get_subsampled(lazy, r, 1);
+}
+
+Bitmap materialize(const LazyBitmap& lazy){
+  return get_region(lazy, IntRect(IntPoint(0,0), lazy.GetSize()));
+}
+
+} // namespace
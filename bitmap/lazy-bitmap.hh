@@ -0,0 +1,54 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_LAZY_BITMAP_HH
+#define FAINT_LAZY_BITMAP_HH
+#include "bitmap/bitmap.hh"
+#include "geo/int-size.hh"
+
+namespace faint{
+
+class IntRect;
+
+class LazyBitmap{
+  // Pixels which are read on demand, e.g. from a memory mapped file,
+  // so that only the viewed parts of a huge image need to be decoded
+  // and kept in memory.
+public:
+  virtual ~LazyBitmap() = default;
+  virtual IntSize GetSize() const = 0;
+
+  // Writes count pixels in the Bitmap pixel format to dst, starting
+  // at x, y and advancing step pixels to the right. The pixels must
+  // be inside the bitmap. May be called concurrently.
+  virtual void ReadPixels(int x, int y, int count, int step,
+    uchar* dst) const = 0;
+};
+
+Color get_color(const LazyBitmap&, const IntPoint&);
+
+// Reads the rectangle, which must be inside the lazy bitmap.
+Bitmap get_region(const LazyBitmap&, const IntRect&);
+
+// Reads every step:th pixel of every step:th row of the rectangle,
+// for a reduced preview without reading every pixel.
+Bitmap get_subsampled(const LazyBitmap&, const IntRect&, int step);
+
+// Reads the entire lazy bitmap.
+Bitmap materialize(const LazyBitmap&);
+
+} // namespace
+
+#endif
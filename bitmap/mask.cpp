@@ -29,7 +29,7 @@ auto* allocate_mask_data(const IntSize& size){
   }
 
   try{
-    return new bool[area(size)];
+    return new bool[area(size)](); // All unset
   }
   catch (const std::bad_alloc&){
     throw BitmapOutOfMemory("mask");
@@ -0,0 +1,137 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <cassert>
+#include <cstring> // memcmp
+#include "bitmap/draw.hh"
+#include "bitmap/pixel-tiles.hh"
+#include "geo/geo-func.hh"
+#include "geo/int-rect.hh"
+#include "geo/primitive.hh"
+
+namespace faint{
+
+static IntRect tile_rect(int tx, int ty, const IntSize& bitmapSize){
+  return intersection(
+    IntRect(IntPoint(tx * PIXEL_TILE_SIZE, ty * PIXEL_TILE_SIZE),
+      IntSize(PIXEL_TILE_SIZE, PIXEL_TILE_SIZE)),
+    IntRect(IntPoint(0,0), bitmapSize));
+}
+
+static bool differs(const Bitmap& before,
+  const Bitmap& after,
+  const IntRect& r)
+{
+  const uchar* p0 = before.GetRaw();
+  const uchar* p1 = after.GetRaw();
+  const int stride0 = before.GetStride();
+  const int stride1 = after.GetStride();
+  const size_t rowBytes = to_size_t(r.w * ByPP);
+
+  for (int y = r.y; y != r.y + r.h; y++){
+    if (memcmp(p0 + y * stride0 + r.x * ByPP,
+        p1 + y * stride1 + r.x * ByPP,
+        rowBytes) != 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+PixelTiles::PixelTiles(){}
+
+PixelTiles::PixelTiles(const Bitmap& bmp, const IntRect& r0)
+  : m_bitmapSize(bmp.GetSize())
+{
+  const IntRect r = intersection(r0, IntRect(IntPoint(0,0), m_bitmapSize));
+  if (empty(r)){
+    return;
+  }
+
+  const int tx0 = r.Left() / PIXEL_TILE_SIZE;
+  const int tx1 = r.Right() / PIXEL_TILE_SIZE;
+  const int ty0 = r.Top() / PIXEL_TILE_SIZE;
+  const int ty1 = r.Bottom() / PIXEL_TILE_SIZE;
+
+  for (int ty = ty0; ty <= ty1; ty++){
+    for (int tx = tx0; tx <= tx1; tx++){
+      AddTile(bmp, tile_rect(tx, ty, m_bitmapSize));
+    }
+  }
+}
+
+void PixelTiles::AddTile(const Bitmap& bmp, const IntRect& r){
+  m_tiles.emplace_back(r.TopLeft(), subbitmap(bmp, r));
+}
+
+bool PixelTiles::Empty() const{
+  return m_tiles.empty();
+}
+
+IntRect PixelTiles::GetBoundingRect() const{
+  if (m_tiles.empty()){
+    return IntRect::EmptyRect();
+  }
+
+  IntPoint tl(m_tiles.front().pos);
+  IntPoint br(tl);
+  for (const auto& tile : m_tiles){
+    tl = min_coords(tl, tile.pos);
+    br = max_coords(br, tile.pos + point_from_size(tile.bmp.GetSize()));
+  }
+  return IntRect(tl, br - IntPoint(1, 1));
+}
+
+size_t PixelTiles::GetMemoryUsage() const{
+  size_t bytes = 0;
+  for (const auto& tile : m_tiles){
+    bytes += to_size_t(tile.bmp.GetStride()) * to_size_t(tile.bmp.GetSize().h);
+  }
+  return bytes;
+}
+
+int PixelTiles::GetNumTiles() const{
+  return resigned(m_tiles.size());
+}
+
+void PixelTiles::Restore(Bitmap& bmp) const{
+  assert(m_tiles.empty() || bmp.GetSize() == m_bitmapSize);
+  for (const auto& tile : m_tiles){
+    blit(offsat(tile.bmp, tile.pos), onto(bmp));
+  }
+}
+
+PixelTiles changed_tiles(const Bitmap& before, const Bitmap& after){
+  assert(before.GetSize() == after.GetSize());
+  const IntSize sz(before.GetSize());
+
+  PixelTiles tiles;
+  tiles.m_bitmapSize = sz;
+
+  const int numX = (sz.w + PIXEL_TILE_SIZE - 1) / PIXEL_TILE_SIZE;
+  const int numY = (sz.h + PIXEL_TILE_SIZE - 1) / PIXEL_TILE_SIZE;
+  for (int ty = 0; ty != numY; ty++){
+    for (int tx = 0; tx != numX; tx++){
+      const IntRect r(tile_rect(tx, ty, sz));
+      if (differs(before, after, r)){
+        tiles.AddTile(before, r);
+      }
+    }
+  }
+  return tiles;
+}
+
+} // namespace
@@ -0,0 +1,77 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_PIXEL_TILES_HH
+#define FAINT_PIXEL_TILES_HH
+#include <vector>
+#include "bitmap/bitmap.hh"
+#include "geo/int-point.hh"
+#include "geo/int-size.hh"
+
+namespace faint{
+
+class IntRect;
+
+// The width and height of the tiles in a PixelTiles.
+const int PIXEL_TILE_SIZE = 64;
+
+class PixelTiles{
+  // Copies of the pixels in a region of a bitmap, stored as
+  // grid-aligned tiles, for restoring the region after it has been
+  // modified (e.g. for undo).
+public:
+  PixelTiles();
+
+  // Copies the tiles of the bitmap which intersect the rectangle.
+  PixelTiles(const Bitmap&, const IntRect&);
+
+  bool Empty() const;
+
+  // The rectangle covering all stored tiles.
+  IntRect GetBoundingRect() const;
+
+  // The number of bytes used for pixel data.
+  size_t GetMemoryUsage() const;
+
+  int GetNumTiles() const;
+
+  // Copies the stored tiles back into the bitmap, which must have the
+  // size of the bitmap the tiles were copied from.
+  void Restore(Bitmap&) const;
+private:
+  friend PixelTiles changed_tiles(const Bitmap&, const Bitmap&);
+  void AddTile(const Bitmap&, const IntRect&);
+
+  class Tile{
+  public:
+    Tile(const IntPoint& pos, Bitmap&& bmp)
+      : pos(pos),
+        bmp(std::move(bmp))
+    {}
+    IntPoint pos;
+    Bitmap bmp;
+  };
+
+  IntSize m_bitmapSize;
+  std::vector<Tile> m_tiles;
+};
+
+// Returns the tiles of the before-bitmap wherein any pixel differs
+// from the after-bitmap. The bitmaps must have the same size.
+PixelTiles changed_tiles(const Bitmap& before, const Bitmap& after);
+
+} // namespace
+
+#endif
@@ -0,0 +1,252 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <algorithm>
+#include "bitmap/point-ops.hh"
+#include "geo/primitive.hh"
+#include "geo/range.hh"
+#include "util/parallel.hh"
+
+namespace faint{
+
+using channel_lut_t = std::array<uchar, 256>;
+
+static channel_lut_t identity_lut(){
+  channel_lut_t lut;
+  for (int v = 0; v != 256; v++){
+    lut[to_size_t(v)] = static_cast<uchar>(v);
+  }
+  return lut;
+}
+
+template<typename FUNC>
+static channel_lut_t lut_from(const FUNC& f){
+  channel_lut_t lut;
+  for (int v = 0; v != 256; v++){
+    lut[to_size_t(v)] = f(static_cast<uchar>(v));
+  }
+  return lut;
+}
+
+PointOps& PointOps::BrightnessContrast(const brightness_contrast_t& v){
+  const double scaledBrightness = v.brightness * 255.0;
+  const channel_lut_t lut = lut_from([&](uchar c){
+    return color_from_double(c * v.contrast + scaledBrightness,
+      0.0, 0.0, 0.0).r;
+  });
+  AddLuts({{lut, lut, lut, identity_lut()}});
+  return *this;
+}
+
+static channel_lut_t balance_lut(const Interval& span){
+  // Stretches the interval to [0, 255]
+  const double A = static_cast<coord>(span.Lower());
+  const double B = static_cast<coord>(span.Upper());
+  const double L = 0.0;
+  const double U = 255.0;
+  const double X = (U-L) / (B-A);
+  const double Y = L - A*((U-L)/ (B-A));
+  return lut_from([&](uchar c){
+    return static_cast<uchar>(std::min(255.0, std::max(0.0, c * X + Y)));
+  });
+}
+
+PointOps& PointOps::ColorBalance(const color_range_t& r,
+  const color_range_t& g,
+  const color_range_t& b)
+{
+  // Note: The green and blue intervals are swapped, like in
+  // color_balance.
+  channel_luts_t luts;
+  luts[iR] = balance_lut(r.GetInterval());
+  luts[iG] = balance_lut(b.GetInterval());
+  luts[iB] = balance_lut(g.GetInterval());
+  luts[iA] = identity_lut();
+  AddLuts(luts);
+  return *this;
+}
+
+PointOps& PointOps::DesaturateSimple(){
+  AddMix([](uchar* p, int count){
+    for (int i = 0; i != count; i++, p += ByPP){
+      const uchar gray = static_cast<uchar>((p[iR] + p[iG] + p[iB]) / 3);
+      p[iR] = p[iG] = p[iB] = gray;
+    }
+  });
+  return *this;
+}
+
+PointOps& PointOps::DesaturateWeighted(){
+  // The weighted channel values, computed like desaturated_weighted
+  // but once per value.
+  auto weights = std::make_shared<std::array<std::array<double, 256>, 3>>();
+  for (int v = 0; v != 256; v++){
+    (*weights)[0][to_size_t(v)] = 0.3 * v;
+    (*weights)[1][to_size_t(v)] = 0.59 * v;
+    (*weights)[2][to_size_t(v)] = 0.11 * v;
+  }
+
+  AddMix([weights](uchar* p, int count){
+    const auto& w = *weights;
+    for (int i = 0; i != count; i++, p += ByPP){
+      const uchar gray = static_cast<uchar>(w[0][p[iR]] +
+        w[1][p[iG]] + w[2][p[iB]]);
+      p[iR] = p[iG] = p[iB] = gray;
+    }
+  });
+  return *this;
+}
+
+PointOps& PointOps::Invert(){
+  const channel_lut_t lut = lut_from([](uchar c){
+    return static_cast<uchar>(255 - c);
+  });
+  AddLuts({{lut, lut, lut, identity_lut()}});
+  return *this;
+}
+
+PointOps& PointOps::Sepia(int intensity){
+  const int depth = 20;
+  AddMix([intensity, depth](uchar* p, int count){
+    for (int i = 0; i != count; i++, p += ByPP){
+      const int gray = (p[iR] + p[iG] + p[iB]) / 3;
+      p[iR] = static_cast<uchar>(std::min(gray + depth * 2, 255));
+      p[iG] = static_cast<uchar>(std::min(gray + depth, 255));
+      p[iB] = static_cast<uchar>(std::max(gray - intensity, 0));
+    }
+  });
+  return *this;
+}
+
+PointOps& PointOps::SetAlpha(uchar alpha){
+  const channel_lut_t lut = identity_lut();
+  channel_lut_t alphaLut;
+  alphaLut.fill(alpha);
+  AddLuts({{lut, lut, lut, alphaLut}});
+  return *this;
+}
+
+PointOps& PointOps::Threshold(const threshold_range_t& range,
+  const Color& inside,
+  const Color& outside)
+{
+  // Whether each sum of the red, green and blue values is inside
+  const Interval interval(range.GetInterval());
+  auto isInside = std::make_shared<std::array<bool, 766>>();
+  for (int sum = 0; sum != 766; sum++){
+    (*isInside)[to_size_t(sum)] = interval.Has(sum);
+  }
+
+  AddMix([isInside, inside, outside](uchar* p, int count){
+    for (int i = 0; i != count; i++, p += ByPP){
+      const Color& c = (*isInside)[to_size_t(p[iR] + p[iG] + p[iB])] ?
+        inside : outside;
+      p[iR] = c.r;
+      p[iG] = c.g;
+      p[iB] = c.b;
+      p[iA] = c.a;
+    }
+  });
+  return *this;
+}
+
+static void apply_luts(const std::array<channel_lut_t, ByPP>& luts,
+  uchar* p,
+  int count)
+{
+  for (int i = 0; i != count; i++, p += ByPP){
+    p[0] = luts[0][p[0]];
+    p[1] = luts[1][p[1]];
+    p[2] = luts[2][p[2]];
+    p[3] = luts[3][p[3]];
+  }
+}
+
+void PointOps::Apply(Bitmap& bmp) const{
+  if (m_steps.empty()){
+    return;
+  }
+
+  // Each row is passed through all steps while in the cache.
+  const IntSize size(bmp.GetSize());
+  uchar* data = bmp.GetRaw();
+  for_row_ranges(0, size.h, size.w,
+    [&](int first, int last){
+      for (int y = first; y != last; y++){
+        uchar* row = data + y * bmp.GetStride();
+        for (const Step& step : m_steps){
+          if (step.luts != nullptr){
+            apply_luts(*step.luts, row, size.w);
+          }
+          else{
+            step.mix(row, size.w);
+          }
+        }
+      }
+    });
+}
+
+Color PointOps::Apply(const Color& c) const{
+  uchar p[ByPP];
+  p[iR] = c.r;
+  p[iG] = c.g;
+  p[iB] = c.b;
+  p[iA] = c.a;
+  for (const Step& step : m_steps){
+    if (step.luts != nullptr){
+      apply_luts(*step.luts, p, 1);
+    }
+    else{
+      step.mix(p, 1);
+    }
+  }
+  return Color(p[iR], p[iG], p[iB], p[iA]);
+}
+
+bool PointOps::Empty() const{
+  return m_steps.empty();
+}
+
+int PointOps::GetNumSteps() const{
+  return resigned(m_steps.size());
+}
+
+void PointOps::AddLuts(const channel_luts_t& luts){
+  if (!m_steps.empty() && m_steps.back().luts != nullptr){
+    // Combine with the preceding tables, as a new table since the
+    // preceding may be shared with a copy.
+    const channel_luts_t& prev = *m_steps.back().luts;
+    auto combined = std::make_shared<channel_luts_t>();
+    for (size_t c = 0; c != ByPP; c++){
+      for (size_t v = 0; v != 256; v++){
+        (*combined)[c][v] = luts[c][prev[c][v]];
+      }
+    }
+    m_steps.back().luts = combined;
+  }
+  else{
+    Step step;
+    step.luts = std::make_shared<channel_luts_t>(luts);
+    m_steps.push_back(step);
+  }
+}
+
+void PointOps::AddMix(const pixels_func& f){
+  Step step;
+  step.mix = f;
+  m_steps.push_back(step);
+}
+
+} // namespace
@@ -0,0 +1,83 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_POINT_OPS_HH
+#define FAINT_POINT_OPS_HH
+#include <array>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "bitmap/bitmap.hh"
+#include "bitmap/color.hh"
+#include "bitmap/filter.hh"
+
+namespace faint{
+
+class PointOps{
+  // A sequence of operations which change each pixel based only on
+  // its own color, applied together in a single pass over the bitmap.
+  //
+  // Consecutive operations on separate channels (e.g. invert,
+  // brightness and contrast) are combined into one lookup table per
+  // channel.
+public:
+  // The operations match the corresponding functions in filter.hh
+  PointOps& BrightnessContrast(const brightness_contrast_t&);
+  PointOps& ColorBalance(const color_range_t& r,
+    const color_range_t& g,
+    const color_range_t& b);
+  PointOps& DesaturateSimple();
+  PointOps& DesaturateWeighted();
+  PointOps& Invert();
+  PointOps& Sepia(int intensity);
+  PointOps& SetAlpha(uchar);
+  PointOps& Threshold(const threshold_range_t&,
+    const Color& inside,
+    const Color& outside);
+
+  // Applies all operations, in order, on multiple threads.
+  void Apply(Bitmap&) const;
+
+  // Applies all operations to a single color.
+  Color Apply(const Color&) const;
+
+  bool Empty() const;
+
+  // The number of steps applied to each pixel, after combining
+  // lookup tables.
+  int GetNumSteps() const;
+private:
+  // Lookup tables for each channel, indexed like the Bitmap bytes
+  // (iR, iG, iB, iA).
+  using channel_luts_t = std::array<std::array<uchar, 256>, ByPP>;
+
+  // Changes count pixels in place
+  using pixels_func = std::function<void(uchar*, int count)>;
+
+  void AddLuts(const channel_luts_t&);
+  void AddMix(const pixels_func&);
+
+  class Step{
+  public:
+    // Either lookup tables or a function mixing the channels.
+    std::shared_ptr<channel_luts_t> luts;
+    pixels_func mix;
+  };
+  std::vector<Step> m_steps;
+};
+
+} // namespace
+
+#endif
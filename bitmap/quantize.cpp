@@ -43,7 +43,9 @@
  *====================================================================*/
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <cstring> // memcpy
+#include <memory>
 #include "bitmap/bitmap.hh"
 #include "bitmap/color.hh"
 #include "bitmap/color-counting.hh"
@@ -169,7 +171,7 @@ struct ColorNode{
   {}
 
   ColRGB center;
-  int numSamples;
+  int64_t numSamples;
   int index;
   int numLeaves;
   bool isLeaf;
@@ -279,7 +281,10 @@ static ColRGB get_rgb_from_octcube(int cubeindex, int level){
   return rgb_from_ints(r,g,b);
 }
 
-static int pixels_per_cell(int numPixels, int numColors, int reservedColors){
+static int64_t pixels_per_cell(int64_t numPixels,
+  int numColors,
+  int reservedColors)
+{
   if (numColors > 0){
     return numPixels / numColors;
   }
@@ -295,41 +300,49 @@ static int pixels_per_cell(int numPixels, int numColors, int reservedColors){
   }
 }
 
-static Octree* generate_octree(const Bitmap& bmp,
-  int requestedNumColors,
-  int reservedColors,
-  const int CQ_NLEVELS)
+static int64_t add_samples(Octree& tree,
+  const Bitmap& bmp,
+  const Mask* skip)
 {
-  assert(128 <=  requestedNumColors && requestedNumColors <= 256);
-
   // Canonical index table
-  IndexTables tables(CQ_NLEVELS);
-
-  // The octtree (and color map, lol)
-  Octree* tree = new Octree(CQ_NLEVELS);
-  ColorList& colorMap = tree->colorMap;
-  const IntSize sz(bmp.GetSize());
-
-
-  // number of remaining pixels to be assigned
-  int numPixels = area(sz);
-
-  // Number of remaining color cells to use
-  int numColors = requestedNumColors - reservedColors - EXTRA_RESERVED_COLORS;
-
-  // Average number of pixels left for each color cell
-  int pixelsPerCell = numPixels / numColors;
+  IndexTables tables(tree.CQ_NLEVELS);
 
   // Accumulate the centers of each cluster at level CQ_NLEVELS
-  ColorNode*** colorNode_aa = tree->colorNode_aa;
-  ColorNode** cqca = colorNode_aa[CQ_NLEVELS];
+  ColorNode** cqca = tree.colorNode_aa[tree.CQ_NLEVELS];
+  const IntSize sz(bmp.GetSize());
+  int64_t numAdded = 0;
   for (int y = 0; y < sz.h; y++){
     for (int x = 0; x != sz.w; x++){
+      if (skip != nullptr && skip->Get(x, y)){
+        continue;
+      }
       int octIndex = tables.GetIndex(get_color_raw(bmp, x, y));
       ColorNode* cell = cqca[octIndex];
       cell->numSamples++;
+      numAdded++;
     }
   }
+  return numAdded;
+}
+
+static void generate_color_map(Octree& tree,
+  int64_t numPixels,
+  int requestedNumColors,
+  int reservedColors)
+{
+  assert(128 <=  requestedNumColors && requestedNumColors <= 256);
+  const int CQ_NLEVELS = tree.CQ_NLEVELS;
+  const size_t maxColors = to_size_t(requestedNumColors);
+  ColorList& colorMap = tree.colorMap;
+
+  // Number of remaining color cells to use
+  int numColors = requestedNumColors - reservedColors - EXTRA_RESERVED_COLORS;
+
+  // Average number of pixels left for each color cell
+  int64_t pixelsPerCell = numPixels / numColors;
+
+  ColorNode*** colorNode_aa = tree.colorNode_aa;
+  ColorNode** cqca = nullptr;
 
   const float thresholdFactor[] = {0.01f, 0.01f, 1.0f, 1.0f, 1.0f, 1.0f};
 
@@ -359,8 +372,8 @@ static Octree* generate_octree(const Bitmap& bmp,
         if (cqcsub->numSamples >= thresh * static_cast<float>(pixelsPerCell)){
           // Make it a true leaf
           cqcsub->isLeaf = true;
-          assert(colorMap.size() < 256);
-          if (colorMap.size() < 256){
+          assert(colorMap.size() < maxColors);
+          if (colorMap.size() < maxColors){
             // Assign the color index
             cqcsub->index = colorMap.size();
             ColRGB rgb = get_rgb_from_octcube(isub, level + 1);
@@ -385,7 +398,7 @@ static Octree* generate_octree(const Bitmap& bmp,
               cqc->numSamples += cqcsub->numSamples;
             }
           }
-          if (colorMap.size() < 256){
+          if (colorMap.size() < maxColors){
             // assign the color index
             cqc->index = colorMap.size();
             ColRGB rgb = get_rgb_from_octcube(i, level);
@@ -419,6 +432,18 @@ static Octree* generate_octree(const Bitmap& bmp,
       }
     }
   }
+}
+
+static Octree* generate_octree(const Bitmap& bmp,
+  const Mask* skip,
+  int requestedNumColors,
+  int reservedColors,
+  const int CQ_NLEVELS)
+{
+  // The octtree (and color map, lol)
+  Octree* tree = new Octree(CQ_NLEVELS);
+  const int64_t numPixels = add_samples(*tree, bmp, skip);
+  generate_color_map(*tree, numPixels, requestedNumColors, reservedColors);
   return tree;
 }
 
@@ -589,9 +614,8 @@ ColRGB first_unused(const std::vector<ColRGB>& sortedColors){
   return transparent;
 }
 
-static MappedColors simply_index_it(const Bitmap& bmp){
+static MappedColors simply_index_it(const Bitmap& bmp, const Mask& mask){
   assert(area(bmp.GetSize()) > 0);
-  const auto mask = mask_alpha_equal(bmp, 0);
   auto colors = unique_colors_rgb(bmp, mask);
   bool hasTransparent = mask.Any() && colors.size() < 256;
 
@@ -626,22 +650,99 @@ static MappedColors simply_index_it(const Bitmap& bmp){
   return {indexes, indexToColor, transparencyIndex};
 }
 
+static const int RESERVED_LEVEL_2 = 64; // To allow level 2 remainder CTEs
+
+static bool use_dithering(const Bitmap& bmp, Dithering dithering){
+  return dithering == Dithering::ON && (bmp.m_w >= 250 || bmp.m_h >= 250);
+}
+
+static MappedColors map_to_tree(const Bitmap& bmp,
+  const Octree& tree,
+  Dithering dithering)
+{
+  return use_dithering(bmp, dithering) ?
+    apply_dithered_quantization(bmp, tree) :
+    apply_quantization(bmp, tree);
+}
+
+static MappedColors with_transparency(MappedColors&& mapped,
+  const Mask& transparent)
+{
+  ColorList palette(mapped.palette);
+  const int index = resigned(palette.size());
+  assert(index < 256);
+
+  ColorList sorted(palette);
+  std::sort(begin(sorted), end(sorted));
+  palette.push_back(first_unused(sorted));
+
+  const IntSize sz(mapped.map.GetSize());
+  for (int y = 0; y != sz.h; y++){
+    for (int x = 0; x != sz.w; x++){
+      if (transparent.Get(x, y)){
+        mapped.map.Set(x, y, static_cast<uchar>(index));
+      }
+    }
+  }
+  return {mapped.map, palette, option(index)};
+}
+
 MappedColors quantized(const Bitmap& bmp, Dithering dithering, OctTreeDepth d){
   if (count_colors(bmp) <= 256){
-    return simply_index_it(bmp);
+    return simply_index_it(bmp, mask_alpha_equal(bmp, 0));
   }
 
-  const int CQ_NLEVELS = static_cast<int>(d);
+  std::unique_ptr<Octree> tree(generate_octree(bmp, nullptr, 256,
+    RESERVED_LEVEL_2, static_cast<int>(d)));
+  return map_to_tree(bmp, *tree, dithering);
+}
 
-  const int reserved = 64; // To allow level 2 remainder CTEs
-  Octree* tree = generate_octree(bmp, 256, reserved, CQ_NLEVELS);
+MappedColors quantized(const Bitmap& bmp,
+  const Mask& transparent,
+  Dithering dithering,
+  OctTreeDepth d)
+{
+  assert(transparent.GetSize() == bmp.GetSize());
+  if (count_colors(bmp) < 256){
+    return simply_index_it(bmp, transparent);
+  }
 
-  const bool useDithering = (dithering == Dithering::ON) &&
-    (bmp.m_w >= 250 || bmp.m_h >= 250);
+  // One color less, leaving room for the transparency index
+  std::unique_ptr<Octree> tree(generate_octree(bmp, &transparent, 255,
+    RESERVED_LEVEL_2, static_cast<int>(d)));
+  auto mapped = map_to_tree(bmp, *tree, dithering);
+  return transparent.Any() ?
+    with_transparency(std::move(mapped), transparent) :
+    mapped;
+}
 
-  return useDithering ?
-    apply_dithered_quantization(bmp, *tree) :
-    apply_quantization(bmp, *tree);
+SharedPalette::SharedPalette(OctTreeDepth d)
+  : m_tree(std::make_unique<Octree>(static_cast<int>(d)))
+{}
+
+SharedPalette::~SharedPalette() = default;
+
+void SharedPalette::Add(const Bitmap& bmp){
+  assert(!m_finished);
+  m_numPixels += add_samples(*m_tree, bmp, nullptr);
+}
+
+void SharedPalette::Finish(){
+  assert(!m_finished);
+  if (m_numPixels != 0){
+    generate_color_map(*m_tree, m_numPixels, 255, RESERVED_LEVEL_2);
+  }
+  m_finished = true;
+}
+
+MappedColors SharedPalette::Map(const Bitmap& bmp,
+  const Mask& transparent,
+  Dithering dithering) const
+{
+  assert(m_finished);
+  assert(transparent.GetSize() == bmp.GetSize());
+  return with_transparency(map_to_tree(bmp, *m_tree, dithering),
+    transparent);
 }
 
 Bitmap quantized_bmp(const Bitmap& bmp, Dithering dithering, OctTreeDepth d){
@@ -15,11 +15,16 @@
 
 #ifndef FAINT_QUANTIZE_HH
 #define FAINT_QUANTIZE_HH
+#include <cstdint>
+#include <memory>
 #include "bitmap/alpha-map.hh"
 #include "bitmap/color-list.hh"
 
 namespace faint{
 
+class Mask;
+class Octree;
+
 enum class Dithering{ON, OFF};
 
 enum class OctTreeDepth{
@@ -46,6 +51,42 @@ MappedColors quantized(const Bitmap&,
   Dithering,
   OctTreeDepth d=OctTreeDepth::FIVE);
 
+// Like quantized, but maps the pixels set in the mask to a
+// transparency index, e.g. for the pixels in a frame of an animation
+// which are unchanged from the previous frame.
+MappedColors quantized(const Bitmap&,
+  const Mask& transparent,
+  Dithering,
+  OctTreeDepth d=OctTreeDepth::FIVE);
+
+class SharedPalette{
+  // A palette created from the colors of several bitmaps, e.g. the
+  // frames of an animation, so that they can be mapped to the same
+  // colors without creating a palette for each.
+public:
+  explicit SharedPalette(OctTreeDepth d=OctTreeDepth::FIVE);
+  ~SharedPalette();
+
+  // Adds the colors of the bitmap to the palette.
+  void Add(const Bitmap&);
+
+  // Creates the palette from the added colors. Must be called once,
+  // after all bitmaps are added.
+  void Finish();
+
+  // Maps the bitmap to the palette. The last palette entry is a
+  // transparency index, used for the pixels set in the mask. Can be
+  // called concurrently.
+  MappedColors Map(const Bitmap&, const Mask& transparent, Dithering) const;
+
+  SharedPalette(const SharedPalette&) = delete;
+  SharedPalette& operator=(const SharedPalette&) = delete;
+private:
+  std::unique_ptr<Octree> m_tree;
+  int64_t m_numPixels = 0;
+  bool m_finished = false;
+};
+
 Bitmap quantized_bmp(const Bitmap&,
   Dithering,
   OctTreeDepth d=OctTreeDepth::FIVE);
@@ -13,63 +13,152 @@
 // implied. See the License for the specific language governing
 // permissions and limitations under the License.
 
-#include "bitmap/color-ptr.hh"
-#include "bitmap/draw.hh" // For flip
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include "bitmap/draw.hh"
 #include "bitmap/scale-bilinear.hh"
-#include "geo/axis.hh" // For flip
 #include "geo/geo-func.hh"
+#include "geo/int-point.hh"
+#include "geo/int-rect.hh"
+#include "geo/int-size.hh"
+#include "geo/primitive.hh"
+#include "util/parallel.hh"
 
 namespace faint{
 
+// Fractional bits of the interpolation weights. With 12 bits, a
+// channel value weighted in both directions fits in 32 bits.
+static const int WEIGHT_BITS = 12;
+static const uint32_t WEIGHT_ONE = 1u << WEIGHT_BITS;
+
+class Sample{
+  // The two source pixels along an axis interpolated for a
+  // destination pixel, with the weight of the second.
+public:
+  int first;
+  int second;
+  uint32_t weight;
+};
+
+static std::vector<Sample> sample_table(int srcLength, int dstLength,
+  int first, int count)
+{
+  // Samples at (srcLength - 1) / dstLength source pixels per
+  // destination pixel, computed exactly with integers, for the
+  // destination pixels [first, first + count).
+  std::vector<Sample> samples(to_size_t(count));
+  for (int i = 0; i != count; i++){
+    const int64_t n = int64_t(srcLength - 1) * (first + i);
+    const int64_t remainder = n % dstLength;
+    Sample& s = samples[to_size_t(i)];
+    s.first = static_cast<int>(n / dstLength);
+    s.second = std::min(s.first + 1, srcLength - 1);
+    s.weight = static_cast<uint32_t>(
+      (remainder * 2 * WEIGHT_ONE + dstLength) / (2 * dstLength));
+  }
+  return samples;
+}
+
+static void interpolate_row(const uchar* srcRow,
+  const std::vector<Sample>& columns,
+  uint32_t* dst)
+{
+  // Interpolates a source row horizontally, giving channel values
+  // scaled by WEIGHT_ONE.
+  for (const Sample& s : columns){
+    const uchar* a = srcRow + s.first * ByPP;
+    const uchar* b = srcRow + s.second * ByPP;
+    const uint32_t wb = s.weight;
+    const uint32_t wa = WEIGHT_ONE - wb;
+    dst[0] = a[0] * wa + b[0] * wb;
+    dst[1] = a[1] * wa + b[1] * wb;
+    dst[2] = a[2] * wa + b[2] * wb;
+    dst[3] = a[3] * wa + b[3] * wb;
+    dst += ByPP;
+  }
+}
+
+static void blend_rows(const uint32_t* r0,
+  const uint32_t* r1,
+  uint32_t weight,
+  int count,
+  uchar* dst)
+{
+  // Interpolates two horizontally interpolated rows vertically. The
+  // loop is over contiguous arrays, so that it can be vectorized.
+  const uint32_t w1 = weight;
+  const uint32_t w0 = WEIGHT_ONE - weight;
+  const uint32_t half = 1u << (2 * WEIGHT_BITS - 1);
+  for (int i = 0; i != count; i++){
+    dst[i] = static_cast<uchar>(
+      (r0[i] * w0 + r1[i] * w1 + half) >> (2 * WEIGHT_BITS));
+  }
+}
+
 Bitmap scale_bilinear(const Bitmap& src, const IntSize& newSize){
   if (newSize == src.GetSize()){
     return src;
   }
 
-  Bitmap dst(newSize);
-  const coord x_ratio = floated(src.m_w - 1) / floated(newSize.w);
-  const coord y_ratio = floated(src.m_h - 1) / floated(newSize.h);
-  const uchar* data = src.m_data;
-
-  for (int j = 0; j != newSize.h; j++){
-    for (int i = 0; i != newSize.w; i++){
-      int xSrc = truncated(x_ratio * i);
-      int ySrc = truncated(y_ratio * j);
-      const coord x_diff = x_ratio * i - xSrc;
-      const coord y_diff = y_ratio * j - ySrc;
-      const int srcIndex = ySrc * src.m_row_stride + xSrc * ByPP;
-      const_color_ptr a(data + srcIndex);
-      const_color_ptr b(data + srcIndex + ByPP);
-      const_color_ptr c(data + srcIndex + src.m_row_stride);
-      const_color_ptr d(data + srcIndex + src.m_row_stride + ByPP);
-
-      const uchar blue = static_cast<uchar>((a.b)*(1-x_diff)*(1-y_diff) +
-        (b.b)*(x_diff)*(1-y_diff) +
-        (c.b)*(y_diff)*(1-x_diff) +
-        (d.b)*(x_diff*y_diff) + 0.5);
+  if (newSize.w <= 0 || newSize.h <= 0){
+    return Bitmap(newSize);
+  }
+  return scale_bilinear(src, newSize, IntRect(IntPoint(0,0), newSize));
+}
 
-      const uchar green = static_cast<uchar>(a.g*(1-x_diff)*(1-y_diff) +
-        b.g*(x_diff)*(1-y_diff) +
-        (c.g)*(y_diff)*(1-x_diff) +
-        (d.g)*(x_diff*y_diff) + 0.5);
+Bitmap scale_bilinear(const Bitmap& src, const IntSize& newSize,
+  const IntRect& region)
+{
+  assert(newSize.w > 0 && newSize.h > 0);
+  assert(intersection(region, IntRect(IntPoint(0,0), newSize)) == region);
+  if (newSize == src.GetSize()){
+    return subbitmap(src, region);
+  }
 
-      const uchar red = static_cast<uchar>(a.r * (1-x_diff)*(1-y_diff) +
-        b.r*(x_diff)*(1-y_diff) +
-        c.r*(y_diff)*(1-x_diff) +
-        (d.r)*(x_diff*y_diff) + 0.5);
+  const IntSize size(region.GetSize());
+  Bitmap dst(size);
+  const std::vector<Sample> columns(sample_table(src.m_w, newSize.w,
+    region.x, size.w));
+  const std::vector<Sample> rows(sample_table(src.m_h, newSize.h,
+    region.y, size.h));
+  const int rowValues = size.w * ByPP;
+  uchar* dstData = dst.GetRaw();
 
-      const uchar alpha = static_cast<uchar>(a.a * (1-x_diff)*(1-y_diff) +
-        b.a*(x_diff)*(1-y_diff) +
-        c.a*(y_diff)*(1-x_diff) +
-        (d.a)*(x_diff*y_diff) + 0.5);
+  for_row_ranges(0, size.h, size.w,
+    [&](int first, int last){
+      // Horizontally interpolated source rows, reused by consecutive
+      // destination rows sampling the same source rows.
+      std::vector<uint32_t> buffer0(to_size_t(rowValues));
+      std::vector<uint32_t> buffer1(to_size_t(rowValues));
+      uint32_t* r0 = buffer0.data();
+      uint32_t* r1 = buffer1.data();
+      int y0 = -1;
+      int y1 = -1;
 
-      uchar* rDst = dst.m_data + j * (dst.m_row_stride) + i * ByPP;
-      *(rDst + iR) = red;
-      *(rDst + iG) = green;
-      *(rDst + iB) = blue;
-      *(rDst + iA) = alpha;
-    }
-  }
+      for (int j = first; j != last; j++){
+        const Sample& s = rows[to_size_t(j)];
+        if (s.first != y0){
+          if (s.first == y1){
+            std::swap(r0, r1);
+            std::swap(y0, y1);
+          }
+          else{
+            interpolate_row(src.GetRaw() + s.first * src.m_row_stride,
+              columns, r0);
+            y0 = s.first;
+          }
+        }
+        if (s.second != y1){
+          interpolate_row(src.GetRaw() + s.second * src.m_row_stride,
+            columns, r1);
+          y1 = s.second;
+        }
+        blend_rows(r0, r1, s.weight, rowValues,
+          dstData + j * dst.m_row_stride);
+      }
+    });
 
   return dst;
 }
@@ -22,6 +22,11 @@ namespace faint{
 // Returns a scaled copy of the bitmap (using bilinear interpolation).
 Bitmap scale_bilinear(const Bitmap&, const IntSize& dstSize);
 
+// Returns the region of the bitmap scaled to dstSize (using bilinear
+// interpolation), without scaling the rest.
+Bitmap scale_bilinear(const Bitmap&, const IntSize& dstSize,
+  const IntRect& region);
+
 } // namespace
 
 #endif
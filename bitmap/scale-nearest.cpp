@@ -13,41 +13,76 @@
 // implied. See the License for the specific language governing
 // permissions and limitations under the License.
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
 #include "bitmap/scale-nearest.hh"
+#include "geo/geo-func.hh"
+#include "geo/int-point.hh"
+#include "geo/int-rect.hh"
+#include "geo/int-size.hh"
+#include "geo/primitive.hh"
+#include "util/parallel.hh"
 
 namespace faint{
 
+static std::vector<int> source_indices(int srcLength, int dstLength,
+  int first, int count)
+{
+  // The source pixel for the destination pixels [first, first +
+  // count) along an axis, in 16.16 fixed point.
+  const int64_t ratio = (int64_t(srcLength) << 16) / dstLength + 1;
+  std::vector<int> indices(to_size_t(count));
+  for (int i = 0; i != count; i++){
+    indices[to_size_t(i)] = static_cast<int>(
+      std::min(((first + i) * ratio) >> 16, int64_t(srcLength - 1)));
+  }
+  return indices;
+}
+
 Bitmap scale_nearest(const Bitmap& src, int scale){
   assert(scale > 0);
   return scale_nearest(src, src.GetSize() * scale);
 }
 
 Bitmap scale_nearest(const Bitmap& src, const IntSize& newSize){
+  return scale_nearest(src, newSize, IntRect(IntPoint(0,0), newSize));
+}
+
+Bitmap scale_nearest(const Bitmap& src, const IntSize& newSize,
+  const IntRect& region)
+{
   assert(newSize.w > 0 && newSize.h > 0);
-  const int w2 = newSize.w;
-  const int h2 = newSize.h;
-
-  Bitmap scaled(IntSize(w2, h2));
-  int x_ratio = (src.m_w << 16) / scaled.m_w + 1;
-  int y_ratio = (src.m_h << 16) / scaled.m_h + 1;
-  uchar* p_dst = scaled.m_data;
-  const uchar* p_src = src.m_data;
-
-  for (int j = 0; j < h2; j++){
-    for (int i = 0; i < w2; i++){
-      int x2 = ((i*x_ratio)>>16);
-      int y2 = ((j*y_ratio)>>16);
-
-      uchar* rDst = p_dst + j * (scaled.m_row_stride) + i * ByPP;
-      const uchar* rSrc = p_src + y2 * (src.m_row_stride) + x2 * ByPP;
-
-      *(rDst + 0) = *rSrc;
-      *(rDst + 1) = *(rSrc + 1);
-      *(rDst + 2) = *(rSrc + 2);
-      *(rDst + 3) = *(rSrc + 3);
-    }
-  }
+  assert(intersection(region, IntRect(IntPoint(0,0), newSize)) == region);
+  const IntSize size(region.GetSize());
+  Bitmap scaled(size);
+  const std::vector<int> columns(source_indices(src.m_w, newSize.w,
+    region.x, size.w));
+  const std::vector<int> rows(source_indices(src.m_h, newSize.h,
+    region.y, size.h));
+  const size_t rowBytes = to_size_t(size.w * ByPP);
+  uchar* dstData = scaled.GetRaw();
+
+  for_row_ranges(0, size.h, size.w,
+    [&](int first, int last){
+      for (int j = first; j != last; j++){
+        uchar* dstRow = dstData + j * scaled.m_row_stride;
+        const int y = rows[to_size_t(j)];
+        if (j != first && rows[to_size_t(j - 1)] == y){
+          // Same source row as the previous row (when enlarging).
+          memcpy(dstRow, dstRow - scaled.m_row_stride, rowBytes);
+          continue;
+        }
+
+        const uchar* srcRow = src.GetRaw() + y * src.m_row_stride;
+        for (int i = 0; i != size.w; i++){
+          memcpy(dstRow + i * ByPP, srcRow + columns[to_size_t(i)] * ByPP,
+            ByPP);
+        }
+      }
+    });
   return scaled;
 }
 
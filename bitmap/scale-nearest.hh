@@ -23,6 +23,10 @@ namespace faint{
 // interpolation).
 Bitmap scale_nearest(const Bitmap&, const IntSize&);
 
+// Returns the region of the bitmap scaled to the size (using nearest
+// neighbour interpolation), without scaling the rest.
+Bitmap scale_nearest(const Bitmap&, const IntSize&, const IntRect& region);
+
 // Returns a uniformly scaled copy of the bitmap (using nearest
 // neighbour interpolation).
 Bitmap scale_nearest(const Bitmap&, int scale);
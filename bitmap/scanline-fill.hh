@@ -0,0 +1,100 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_SCANLINE_FILL_HH
+#define FAINT_SCANLINE_FILL_HH
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "geo/int-point.hh"
+#include "geo/int-size.hh"
+
+namespace faint{
+
+template<typename INSIDE, typename SPAN_FUNC>
+void scanline_fill(const IntSize& size,
+  const IntPoint& seed,
+  const INSIDE& inside,
+  const SPAN_FUNC& onSpan)
+{
+  // Finds the 4-connected region around the seed of the positions
+  // for which inside(x, y) is true, and calls onSpan(y, x0, x1) for
+  // each horizontal span [x0, x1) of the region.
+  //
+  // Each position is reported once. The reported positions are
+  // recorded using one bit per position, and inside(x, y) is only
+  // called for unreported positions, so onSpan may alter what inside
+  // would return for the positions of the span.
+  if (seed.x < 0 || seed.y < 0 || seed.x >= size.w || seed.y >= size.h){
+    return;
+  }
+
+  std::vector<bool> visited(static_cast<size_t>(size.w) *
+    static_cast<size_t>(size.h), false);
+
+  auto index = [&](int x, int y){
+    return static_cast<std::ptrdiff_t>(y) * size.w + x;
+  };
+
+  auto available = [&](int x, int y){
+    return !visited[static_cast<size_t>(index(x, y))] && inside(x, y);
+  };
+
+  std::vector<IntPoint> seeds;
+  auto push_runs = [&](int y, int x0, int x1){
+    // Adds one seed for each run of available positions in row y
+    bool inRun = false;
+    for (int x = x0; x != x1; x++){
+      const bool ok = available(x, y);
+      if (ok && !inRun){
+        seeds.emplace_back(x, y);
+      }
+      inRun = ok;
+    }
+  };
+
+  seeds.push_back(seed);
+  while (!seeds.empty()){
+    const IntPoint p = seeds.back();
+    seeds.pop_back();
+    if (!available(p.x, p.y)){
+      continue;
+    }
+
+    int x0 = p.x;
+    while (x0 > 0 && available(x0 - 1, p.y)){
+      x0--;
+    }
+    int x1 = p.x + 1;
+    while (x1 < size.w && available(x1, p.y)){
+      x1++;
+    }
+
+    std::fill(visited.begin() + index(x0, p.y),
+      visited.begin() + index(x1, p.y), true);
+    onSpan(p.y, x0, x1);
+
+    if (p.y > 0){
+      push_runs(p.y - 1, x0, x1);
+    }
+    if (p.y + 1 < size.h){
+      push_runs(p.y + 1, x0, x1);
+    }
+  }
+}
+
+} // namespace
+
+#endif
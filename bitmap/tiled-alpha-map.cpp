@@ -0,0 +1,201 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <algorithm>
+#include <cassert>
+#include <cstring> // memcpy
+#include "bitmap/brush.hh"
+#include "bitmap/tiled-alpha-map.hh"
+#include "geo/int-point.hh"
+#include "geo/int-rect.hh"
+#include "geo/measure.hh"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+  (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FAINT_ALPHA_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace faint{
+
+static int num_tiles(int length){
+  return (length + ALPHA_TILE_SIZE - 1) / ALPHA_TILE_SIZE;
+}
+
+static void add_saturated(uchar* dst, const uchar* src, int n){
+  int i = 0;
+  #ifdef FAINT_ALPHA_SSE2
+  for (; i + 16 <= n; i += 16){
+    __m128i* d = reinterpret_cast<__m128i*>(dst + i);
+    const __m128i* s = reinterpret_cast<const __m128i*>(src + i);
+    _mm_storeu_si128(d, _mm_adds_epu8(_mm_loadu_si128(d),
+      _mm_loadu_si128(s)));
+  }
+  #endif
+  for (; i != n; i++){
+    dst[i] = static_cast<uchar>(std::min(int(dst[i]) + src[i], 255));
+  }
+}
+
+TiledAlphaMap::TiledAlphaMap(const IntSize& size)
+  : m_size(0,0),
+    m_numX(0),
+    m_numY(0)
+{
+  Reset(size);
+}
+
+IntRect TiledAlphaMap::Add(const IntPoint& topLeft, const Brush& b){
+  const IntSize brushSize(b.GetSize());
+  const IntRect r(intersection(IntRect(topLeft, brushSize),
+    IntRect(IntPoint(0,0), m_size)));
+  if (empty(r)){
+    return r;
+  }
+
+  const uchar* brushData = b.GetRaw();
+  for (int ty = r.Top() / ALPHA_TILE_SIZE;
+       ty <= r.Bottom() / ALPHA_TILE_SIZE; ty++)
+  {
+    for (int tx = r.Left() / ALPHA_TILE_SIZE;
+         tx <= r.Right() / ALPHA_TILE_SIZE; tx++)
+    {
+      const IntRect tileRect(TileRect(tx, ty));
+      auto& tile = m_tiles[to_size_t(ty * m_numX + tx)];
+      if (tile == nullptr){
+        tile = std::make_unique<AlphaMap>(tileRect.GetSize());
+      }
+
+      const IntRect c(intersection(r, tileRect));
+      uchar* tileData = tile->GetRaw();
+      for (int y = c.Top(); y <= c.Bottom(); y++){
+        add_saturated(
+          tileData + (y - tileRect.y) * tileRect.w + (c.x - tileRect.x),
+          brushData + (y - topLeft.y) * brushSize.w + (c.x - topLeft.x),
+          c.w);
+      }
+    }
+  }
+  return r;
+}
+
+Optional<IntRect> TiledAlphaMap::BoundingRect() const{
+  Optional<IntRect> bounds;
+  for (int ty = 0; ty != m_numY; ty++){
+    for (int tx = 0; tx != m_numX; tx++){
+      if (m_tiles[to_size_t(ty * m_numX + tx)] != nullptr){
+        const IntRect r(TileRect(tx, ty));
+        bounds.Set(bounds.IsSet() ? bounding_rect(bounds.Get(), r) : r);
+      }
+    }
+  }
+  return bounds;
+}
+
+uchar TiledAlphaMap::Get(int x, int y) const{
+  assert(0 <= x && x < m_size.w && 0 <= y && y < m_size.h);
+  const int tx = x / ALPHA_TILE_SIZE;
+  const int ty = y / ALPHA_TILE_SIZE;
+  const auto& tile = m_tiles[to_size_t(ty * m_numX + tx)];
+  return tile == nullptr ? uchar(0) :
+    tile->Get(x - tx * ALPHA_TILE_SIZE, y - ty * ALPHA_TILE_SIZE);
+}
+
+int TiledAlphaMap::GetNumTiles() const{
+  return resigned(std::count_if(begin(m_tiles), end(m_tiles),
+    [](const std::unique_ptr<AlphaMap>& tile){
+      return tile != nullptr;
+    }));
+}
+
+IntSize TiledAlphaMap::GetSize() const{
+  return m_size;
+}
+
+void TiledAlphaMap::Reset(const IntSize& size){
+  m_size = size;
+  m_numX = num_tiles(size.w);
+  m_numY = num_tiles(size.h);
+  m_tiles.clear();
+  m_tiles.resize(to_size_t(m_numX * m_numY));
+}
+
+AlphaMap TiledAlphaMap::SubCopy(const IntRect& r) const{
+  assert(0 <= r.x && 0 <= r.y &&
+    r.x + r.w <= m_size.w &&
+    r.y + r.h <= m_size.h);
+
+  AlphaMap a(r.GetSize());
+  uchar* dst = a.GetRaw();
+  VisitTiles(r, [&](const AlphaMapRef&, const IntPoint& pos){
+    const int tx = pos.x / ALPHA_TILE_SIZE;
+    const int ty = pos.y / ALPHA_TILE_SIZE;
+    const IntRect tileRect(TileRect(tx, ty));
+    const IntRect c(intersection(r, tileRect));
+    const uchar* src = m_tiles[to_size_t(ty * m_numX + tx)]->GetRaw();
+    for (int y = c.Top(); y <= c.Bottom(); y++){
+      memcpy(dst + (y - r.y) * r.w + (c.x - r.x),
+        src + (y - tileRect.y) * tileRect.w + (c.x - tileRect.x),
+        to_size_t(c.w));
+    }
+  });
+  return a;
+}
+
+void TiledAlphaMap::VisitTiles(const IntRect& r0,
+  const visit_alpha_tile_func& f) const
+{
+  const IntRect r(intersection(r0, IntRect(IntPoint(0,0), m_size)));
+  if (empty(r)){
+    return;
+  }
+
+  for (int ty = r.Top() / ALPHA_TILE_SIZE;
+       ty <= r.Bottom() / ALPHA_TILE_SIZE; ty++)
+  {
+    for (int tx = r.Left() / ALPHA_TILE_SIZE;
+         tx <= r.Right() / ALPHA_TILE_SIZE; tx++)
+    {
+      const auto& tile = m_tiles[to_size_t(ty * m_numX + tx)];
+      if (tile != nullptr){
+        f(tile->FullReference(),
+          IntPoint(tx * ALPHA_TILE_SIZE, ty * ALPHA_TILE_SIZE));
+      }
+    }
+  }
+}
+
+IntRect TiledAlphaMap::TileRect(int tx, int ty) const{
+  return intersection(
+    IntRect(IntPoint(tx * ALPHA_TILE_SIZE, ty * ALPHA_TILE_SIZE),
+      IntSize(ALPHA_TILE_SIZE, ALPHA_TILE_SIZE)),
+    IntRect(IntPoint(0,0), m_size));
+}
+
+IntRect stroke(TiledAlphaMap& data, const UpperLeft& p0, const UpperLeft& p1,
+  const Brush& b)
+{
+  Optional<IntRect> changed;
+  stroke_steps(p0, p1,
+    [&](const IntPoint& pos){
+      const IntRect r(data.Add(pos, b));
+      if (!empty(r)){
+        changed.Set(changed.IsSet() ? bounding_rect(changed.Get(), r) : r);
+      }
+    });
+  return changed.Or(IntRect::EmptyRect());
+}
+
+} // namespace
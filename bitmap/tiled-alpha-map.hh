@@ -0,0 +1,85 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_TILED_ALPHA_MAP_HH
+#define FAINT_TILED_ALPHA_MAP_HH
+#include <functional>
+#include <memory>
+#include <vector>
+#include "bitmap/alpha-map.hh"
+#include "geo/int-size.hh"
+
+namespace faint{
+
+class Brush;
+class IntPoint;
+class IntRect;
+
+// The width and height of the tiles in a TiledAlphaMap.
+const int ALPHA_TILE_SIZE = 64;
+
+using visit_alpha_tile_func =
+  std::function<void(const AlphaMapRef&, const IntPoint&)>;
+
+class TiledAlphaMap{
+  // A sparse AlphaMap, split into grid-aligned tiles which are
+  // allocated when first added to. Unallocated tiles are all zero.
+  //
+  // Used for brush strokes, which often cover a small part of large
+  // images.
+public:
+  explicit TiledAlphaMap(const IntSize&);
+
+  // Adds the brush values with the upper left corner of the brush at
+  // the given position, saturating at 255. Returns the affected
+  // (clipped) rectangle.
+  IntRect Add(const IntPoint&, const Brush&);
+
+  // The rectangle covering all allocated tiles.
+  Optional<IntRect> BoundingRect() const;
+
+  uchar Get(int x, int y) const;
+  int GetNumTiles() const;
+  IntSize GetSize() const;
+
+  // Resizes the map and frees all tiles.
+  void Reset(const IntSize&);
+
+  // Returns a dense copy of the rectangle, which must be inside the
+  // map.
+  AlphaMap SubCopy(const IntRect&) const;
+
+  // Calls the function with each allocated tile intersecting the
+  // rectangle, and the tile position.
+  void VisitTiles(const IntRect&, const visit_alpha_tile_func&) const;
+
+  TiledAlphaMap& operator=(const TiledAlphaMap&) = delete;
+private:
+  IntRect TileRect(int tx, int ty) const;
+
+  IntSize m_size;
+  int m_numX;
+  int m_numY;
+  std::vector<std::unique_ptr<AlphaMap>> m_tiles;
+};
+
+// Brush stroke between from and to, like stroke for an AlphaMap.
+// Returns the rectangle affected by the stroke.
+IntRect stroke(TiledAlphaMap&, const UpperLeft& from, const UpperLeft& to,
+  const Brush&);
+
+} // namespace
+
+#endif
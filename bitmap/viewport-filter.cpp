@@ -0,0 +1,91 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <algorithm>
+#include "bitmap/draw.hh"
+#include "bitmap/scale-bilinear.hh"
+#include "bitmap/viewport-filter.hh"
+#include "geo/int-rect.hh"
+
+namespace faint{
+
+static int align_down(int v, int align){
+  return (v / align) * align;
+}
+
+static int align_up(int v, int align){
+  return ((v + align - 1) / align) * align;
+}
+
+static IntRect region_to_filter(const IntRect& visible,
+  const ViewportFilter& filter)
+{
+  const IntRect r = inflated(visible, filter.margin);
+  const int align = std::max(filter.align, 1);
+  const IntPoint topLeft(align_down(std::max(r.x, 0), align),
+    align_down(std::max(r.y, 0), align));
+  const IntPoint bottomRight(align_up(r.x + r.w, align),
+    align_up(r.y + r.h, align));
+  return IntRect(topLeft, IntSize(bottomRight.x - topLeft.x,
+    bottomRight.y - topLeft.y));
+}
+
+Optional<FilteredRegion> filter_viewport(const Bitmap& src,
+  const IntRect& visible,
+  coord zoom,
+  const ViewportFilter& filter,
+  const std::function<bool()>& cancelled)
+{
+  const IntRect bmpRect(IntPoint(0, 0), src.GetSize());
+  const IntRect r = intersection(visible, bmpRect);
+  if (empty(r)){
+    return option(FilteredRegion{Bitmap(), IntPoint(0, 0)});
+  }
+
+  const IntRect extended = intersection(region_to_filter(r, filter),
+    bmpRect);
+  Bitmap region = subbitmap(src, extended);
+
+  const coord scale = filter.scalable ? std::min(zoom, 1.0) : 1.0;
+  if (scale < 1.0){
+    const IntSize scaledSize(
+      std::max(1, static_cast<int>(extended.w * scale + 0.5)),
+      std::max(1, static_cast<int>(extended.h * scale + 0.5)));
+    Bitmap scaled = scale_bilinear(region, scaledSize);
+    if (cancelled()){
+      return {};
+    }
+    filter.apply(scaled, scale);
+    if (cancelled()){
+      return {};
+    }
+    region = scale_bilinear(scaled, extended.GetSize());
+  }
+  else{
+    filter.apply(region, 1.0);
+  }
+
+  if (cancelled()){
+    return {};
+  }
+
+  if (extended == r){
+    return option(FilteredRegion{std::move(region), r.TopLeft()});
+  }
+  const IntRect visiblePart(r.TopLeft() - extended.TopLeft(), r.GetSize());
+  return option(FilteredRegion{subbitmap(region, visiblePart), r.TopLeft()});
+}
+
+} // namespace
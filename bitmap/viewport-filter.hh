@@ -0,0 +1,69 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_VIEWPORT_FILTER_HH
+#define FAINT_VIEWPORT_FILTER_HH
+#include <functional>
+#include "bitmap/bitmap.hh"
+#include "geo/int-point.hh"
+#include "geo/primitive.hh"
+#include "util/optional.hh"
+
+namespace faint{
+
+class IntRect;
+
+class ViewportFilter{
+  // A filter for previews of the visible part of an image.
+public:
+  // Applies the filter to a region, which is scaled by the given
+  // factor (at most 1) relative to the image.
+  std::function<void(Bitmap&, coord scale)> apply;
+
+  // Pixels around the visible part which affect the result, e.g. the
+  // radius of a blur.
+  int margin = 0;
+
+  // Filtered regions are extended to multiples of this (e.g. for
+  // pixelize, to keep the same blocks as for the full image).
+  int align = 1;
+
+  // False if the filter must be applied at full resolution.
+  bool scalable = true;
+};
+
+class FilteredRegion{
+  // The filtered visible part of a bitmap, and its position in the
+  // bitmap.
+public:
+  Bitmap bitmap;
+  IntPoint topLeft;
+};
+
+// Returns the visible rectangle of the bitmap filtered. Only the
+// visible part is returned, so that a preview does not copy the full
+// image on every change. When zoomed out, a scalable filter is
+// applied at the display resolution and the result is scaled back up.
+//
+// Returns nothing if cancelled before done.
+Optional<FilteredRegion> filter_viewport(const Bitmap&,
+  const IntRect& visible,
+  coord zoom,
+  const ViewportFilter&,
+  const std::function<bool()>& cancelled);
+
+} // namespace
+
+#endif
@@ -46,8 +46,8 @@ def _link(files, opts, out, err, debug, cc):
         out_name = opts.get_out_name()
         lib_paths = " ".join(["-L%s" % p for p in opts.lib_paths])
 
-        cmd = (cc + " -std=c++17 -g -o %s " % out_name +
-               " ".join(files) + " -lpng " + wxlibs + " " + lib_paths +
+        cmd = (cc + " -std=c++17 -pthread -g -o %s " % out_name +
+               " ".join(files) + " -lpng -lz " + wxlibs + " " + lib_paths +
                " -l python3.8 -O2")
 
         linker = subprocess.Popen(cmd, stdout=out, stderr=err, shell=True)
@@ -26,6 +26,7 @@ CC_OPTIONS_COMMON = [
     "Wno-strict-aliasing", # No aliasing warnings
     "Wno-sign-conversion", # No sign conversion warnings
     "std=c++17", # C++17-conformance
+    "pthread", # Thread support (std::thread)
     "c", # Do not invoke linker
 ]
 
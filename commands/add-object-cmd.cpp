@@ -16,6 +16,7 @@
 #include <memory>
 #include "commands/add-object-cmd.hh"
 #include "commands/command.hh"
+#include "geo/int-rect.hh"
 #include "objects/object.hh"
 #include "util/convenience.hh"
 
@@ -52,6 +53,10 @@ public:
     context.Remove(m_object.get());
   }
 
+  Optional<IntRect> GetChangedObjectsRect() const override{
+    return option(m_object->GetRefreshRect());
+  }
+
   utf8_string Name() const override{
     return m_name + " " + m_object->GetType();
   }
@@ -17,6 +17,7 @@
 #include <memory>
 #include "bitmap/bitmap.hh"
 #include "bitmap/draw.hh" // subbitmap
+#include "bitmap/pixel-tiles.hh"
 #include "commands/bitmap-cmd.hh"
 #include "commands/command.hh"
 #include "geo/geo-func.hh"
@@ -74,12 +75,45 @@ private:
   }
 };
 
+class BmpTargetChangedPixels final : public BmpTargetBase {
+public:
+  explicit BmpTargetChangedPixels(BitmapCommandPtr cmd)
+    : BmpTargetBase(CommandType::RASTER, std::move(cmd))
+  {}
+
+  Optional<IntRect> GetChangedRect() const override{
+    return option(m_oldPixels.GetBoundingRect());
+  }
+
+  bool RestoresRaster() const override{
+    return true;
+  }
+private:
+  void DoBmp(BitmapCommand& cmd, CommandContext& ctx) override{
+    Bitmap& bmp = ctx.GetRawBitmap();
+    const Bitmap before(bmp);
+    cmd.Do(bmp);
+    m_oldPixels = changed_tiles(before, bmp);
+  }
+
+  void UndoBmp(CommandContext& ctx) override{
+    m_oldPixels.Restore(ctx.GetRawBitmap());
+  }
+
+  // The pixels overwritten by the command, for undo.
+  PixelTiles m_oldPixels;
+};
+
 class BmpTargetRectangle final : public BmpTargetBase {
 public:
   explicit BmpTargetRectangle(BitmapCommandPtr cmd, const IntRect& rect)
     : BmpTargetBase(CommandType::RASTER, std::move(cmd)),
       m_rect(rect)
   {}
+
+  Optional<IntRect> GetChangedRect() const override{
+    return option(m_rect);
+  }
 private:
   void DoBmp(BitmapCommand& cmd, CommandContext& ctx) override{
     Bitmap bmp(subbitmap(ctx.GetRawBitmap(), m_rect));
@@ -132,6 +166,10 @@ CommandPtr target_full_image(BitmapCommandPtr bmpCmd){
   return std::make_unique<BmpTargetImage>(std::move(bmpCmd));
 }
 
+CommandPtr target_changed_pixels(BitmapCommandPtr bmpCmd){
+  return std::make_unique<BmpTargetChangedPixels>(std::move(bmpCmd));
+}
+
 CommandPtr target_floating_selection(BitmapCommandPtr bmpCmd){
   return std::make_unique<BmpTargetSelection>(std::move(bmpCmd));
 }
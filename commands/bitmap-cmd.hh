@@ -38,6 +38,12 @@ using BitmapCommandPtr = std::unique_ptr<BitmapCommand>;
 
 // Wrappers for assigning targets for a BitmapCommand.
 CommandPtr target_full_image(BitmapCommandPtr);
+
+// Targets the full image, but keeps the pixels changed by the command
+// so that it can be undone without reapplying earlier commands.
+// Suitable for commands which typically change a small part of the
+// image, like fills.
+CommandPtr target_changed_pixels(BitmapCommandPtr);
 CommandPtr target_floating_selection(BitmapCommandPtr);
 CommandPtr target_rectangle(BitmapCommandPtr, const IntRect&);
 
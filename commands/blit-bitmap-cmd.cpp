@@ -14,10 +14,12 @@
 // permissions and limitations under the License.
 
 #include "bitmap/bitmap.hh"
+#include "bitmap/pixel-tiles.hh"
 #include "commands/blit-bitmap-cmd.hh"
 #include "commands/command.hh"
 #include "geo/geo-func.hh"
 #include "geo/int-point.hh"
+#include "geo/int-rect.hh"
 #include "rendering/faint-dc.hh"
 #include "text/utf8-string.hh"
 #include "util/default-settings.hh"
@@ -33,14 +35,29 @@ public:
   {}
 
   void Do(CommandContext& context) override{
+    m_oldPixels = PixelTiles(context.GetRawBitmap(),
+      IntRect(m_pos, m_bmp.GetSize()));
     context.GetDC().Blit(m_bmp, floated(m_pos), default_bitmap_settings());
   }
 
+  Optional<IntRect> GetChangedRect() const override{
+    return option(IntRect(m_pos, m_bmp.GetSize()));
+  }
+
   utf8_string Name() const override{
     return "Blit Bitmap";
   }
+
+  bool RestoresRaster() const override{
+    return true;
+  }
+
+  void Undo(CommandContext& context) override{
+    m_oldPixels.Restore(context.GetRawBitmap());
+  }
 private:
   Bitmap m_bmp;
+  PixelTiles m_oldPixels;
   IntPoint m_pos;
 };
 
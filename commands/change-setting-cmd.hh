@@ -16,6 +16,7 @@
 #ifndef FAINT_CHANGE_SETTING_CMD_HH
 #define FAINT_CHANGE_SETTING_CMD_HH
 #include "commands/command.hh"
+#include "geo/int-rect.hh"
 #include "objects/object.hh"
 #include "text/formatting.hh"
 
@@ -43,6 +44,10 @@ public:
     m_object->Set(m_setting, m_newValue);
   }
 
+  Optional<IntRect> GetChangedObjectsRect() const override{
+    return option(m_object->GetRefreshRect());
+  }
+
   void Undo(CommandContext&) override{
     m_object->Set(m_setting, m_oldValue);
   }
@@ -17,6 +17,8 @@
 #include <memory>
 #include "commands/command.hh"
 #include "commands/command-bunch.hh"
+#include "geo/int-rect.hh"
+#include "geo/measure.hh"
 #include "text/utf8-string.hh"
 #include "util/iter.hh"
 #include "util/type-util.hh"
@@ -49,6 +51,19 @@ public:
     }
   }
 
+  Optional<IntRect> GetChangedObjectsRect() const override{
+    Optional<IntRect> changed;
+    for (const auto& cmd : m_commands){
+      auto r = cmd->GetChangedObjectsRect();
+      if (r.NotSet()){
+        return {};
+      }
+      changed.Set(changed.IsSet() ?
+        bounding_rect(changed.Get(), r.Get()) : r.Get());
+    }
+    return changed;
+  }
+
   bool ShouldMerge(const Command& cmd, bool sameFrame) const override{
     if (!sameFrame){
       return false;
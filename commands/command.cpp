@@ -15,6 +15,7 @@
 
 #include <cassert>
 #include "commands/command.hh"
+#include "geo/int-rect.hh"
 #include "geo/point.hh"
 
 namespace faint{
@@ -39,6 +40,14 @@ bool somewhat_reversible(CommandType t){
   return t != CommandType::RASTER;
 }
 
+bool fully_reversible(const Command& cmd){
+  return fully_reversible(cmd.Type()) || cmd.RestoresRaster();
+}
+
+bool somewhat_reversible(const Command& cmd){
+  return somewhat_reversible(cmd.Type()) || cmd.RestoresRaster();
+}
+
 Command::Command(CommandType type){
   m_type = type;
 }
@@ -53,6 +62,14 @@ void Command::DoRaster(CommandContext& context){
   Do(context);
 }
 
+Optional<IntRect> Command::GetChangedRect() const{
+  return {};
+}
+
+Optional<IntRect> Command::GetChangedObjectsRect() const{
+  return {};
+}
+
 CommandPtr Command::GetDWIM(){
   assert(false);
   return nullptr;
@@ -78,6 +95,10 @@ bool Command::ModifiesState() const{
   return true;
 }
 
+bool Command::RestoresRaster() const{
+  return false;
+}
+
 Point Command::Translate(const Point& p) const{
   return p;
 }
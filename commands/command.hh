@@ -21,6 +21,7 @@
 #include "util/id-types.hh"
 #include "util/index.hh"
 #include "util/objects.hh"
+#include "util/optional.hh"
 #include "util/pending.hh"
 
 namespace faint{
@@ -30,6 +31,7 @@ class Command;
 class FaintDC;
 class Image;
 class IntPoint;
+class IntRect;
 class IntSize;
 class Object;
 class Point;
@@ -45,6 +47,12 @@ bool affects_raster(const CommandPtr&);
 bool fully_reversible(CommandType);
 bool somewhat_reversible(CommandType);
 
+// Like the CommandType-variants, but also true for raster commands
+// which can restore the pixels they changed (see
+// Command::RestoresRaster).
+bool fully_reversible(const Command&);
+bool somewhat_reversible(const Command&);
+
 class CommandContext{
   // Interface passed to Commands to let them modify an image.
   // Note: Anything the CommandContext returns by reference
@@ -98,6 +106,17 @@ public:
   virtual bool ShouldMerge(const Command&, bool sameFrame) const;
   virtual void Merge(CommandPtr);
 
+  // The region of the image wherein the command changes pixels, if
+  // known. Used for updating cached renderings of the image after
+  // the command is applied or undone.
+  virtual Optional<IntRect> GetChangedRect() const;
+
+  // The region of the image wherein the objects changed by the command
+  // are drawn after it is applied or undone, if known. Used for
+  // updating cached flattened images (together with the regions of
+  // moved, added and removed objects, which are found by comparison).
+  virtual Optional<IntRect> GetChangedObjectsRect() const;
+
   // "Do What I Mean" - returns an alternate command if available.
   // Should only be called after HasDWIM() returns true
   virtual CommandPtr GetDWIM();
@@ -110,6 +129,10 @@ public:
   virtual bool ModifiesState() const;
   virtual utf8_string Name() const = 0;
 
+  // True if Undo(...) restores the pixels changed by the command, so
+  // that undoing it does not require reapplying earlier commands.
+  virtual bool RestoresRaster() const;
+
   // Commands that change the image size (e.g. cropping, scaling) can
   // translate a point, expressed in image coordinates, relative to
   // the transformation.
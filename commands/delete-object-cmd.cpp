@@ -15,6 +15,7 @@
 
 #include "commands/command.hh"
 #include "commands/delete-object-cmd.hh"
+#include "geo/int-rect.hh"
 #include "objects/object.hh"
 #include "text/formatting.hh"
 
@@ -33,6 +34,10 @@ public:
     context.Remove(m_object);
   }
 
+  Optional<IntRect> GetChangedObjectsRect() const override{
+    return option(m_object->GetRefreshRect());
+  }
+
   utf8_string Name() const override{
     return space_sep(m_name, m_object->GetType());
   }
@@ -15,6 +15,7 @@
 
 #include "commands/command.hh"
 #include "commands/order-object-cmd.hh"
+#include "geo/int-rect.hh"
 #include "objects/object.hh"
 #include "text/formatting.hh"
 
@@ -41,6 +42,10 @@ public:
     context.SetObjectZ(m_object, m_newZ.Get());
   }
 
+  Optional<IntRect> GetChangedObjectsRect() const override{
+    return option(m_object->GetRefreshRect());
+  }
+
   utf8_string Name() const override{
     return space_sep(m_object->GetType(), forward_or_back_str(m_newZ, m_oldZ));
   }
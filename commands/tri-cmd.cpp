@@ -15,6 +15,7 @@
 
 #include "commands/command.hh"
 #include "commands/tri-cmd.hh"
+#include "geo/int-rect.hh"
 #include "objects/object.hh"
 #include "util/append-command-type.hh"
 
@@ -42,6 +43,10 @@ public:
     m_object->SetTri(m_new);
   }
 
+  Optional<IntRect> GetChangedObjectsRect() const override{
+    return option(m_object->GetRefreshRect());
+  }
+
   bool ShouldMerge(const Command& cmd, bool sameFrame) const override{
     if (!m_mergable || !sameFrame){
       return false;
@@ -95,18 +95,15 @@ static Bitmap read_bmp_or_throw(const FilePath& filePath){
       "Failed reading color table.");
     in.seekg(bitmapFileHeader.dataOffset);
 
-    auto alphaMap = or_throw(read_8bipp_BI_RGB(in, bmpSize),
+    return or_throw(read_8bipp_BI_RGB(in, bmpSize, colorList),
       "Failed reading 8-bits-per-pixel data");
-
-    return bitmap_from_indexed_colors(alphaMap, colorList);
   }
   else{
     // No palette
     in.seekg(bitmapFileHeader.dataOffset);
     if (bitmapInfoHeader.bitsPerPixel == 8){
-      auto alphaMap = or_throw(read_8bipp_BI_RGB(in, bmpSize),
+      return or_throw(read_8bipp_BI_RGB(in, bmpSize, grayscale_color_table()),
         "Failed reading 8-bits-per-pixel data");
-      return bitmap_from_indexed_colors(alphaMap, grayscale_color_table());
     }
     else if (bitmapInfoHeader.bitsPerPixel == 24){
       return or_throw(read_24bipp_BI_RGB(in, bmpSize),
@@ -0,0 +1,249 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <array>
+#include <cstdio>
+#include <cstring> // memcpy
+#include "bitmap/color.hh"
+#include "formats/bmp/lazy-bmp.hh"
+#include "formats/bmp/serialize-bmp-pixel-data.hh"
+#include "formats/bmp/serialize-bmp-types.hh"
+#include "formats/faint-fopen.hh"
+#include "formats/mapped-file.hh"
+#include "util-wx/file-path.hh"
+
+namespace faint{
+
+// Bitmap pixel values for the 8-bits-per-pixel indexes
+using bmp_lut_t = std::array<uchar, 256 * ByPP>;
+
+class BmpCache : public LazyBitmap{
+  // The pixel data of a bmp, in a memory mapped cache file with the
+  // rows in the bmp pixel format.
+public:
+  BmpCache(std::unique_ptr<MappedFile>&& file,
+    const FilePath& path,
+    const BmpSizeAndOrder& bmpSize,
+    int bitsPerPixel,
+    const bmp_lut_t& lut)
+    : m_bitsPerPixel(bitsPerPixel),
+      m_bmpSize(bmpSize),
+      m_data(file->GetData()),
+      m_file(std::move(file)),
+      m_lut(lut),
+      m_path(path),
+      m_stride(to_size_t(bmp_row_stride(bitsPerPixel, bmpSize.size.w)))
+  {}
+
+  ~BmpCache() override{
+    m_file.reset();
+    faint_remove(m_path);
+  }
+
+  IntSize GetSize() const override{
+    return m_bmpSize.size;
+  }
+
+  void ReadPixels(int x, int y, int count, int step,
+    uchar* dst) const override
+  {
+    // Uses the same channel mappings as read_bmp.
+    const int h = m_bmpSize.size.h;
+    const uchar* row = m_data +
+      to_size_t(m_bmpSize.topDown ? y : h - y - 1) * m_stride;
+
+    if (m_bitsPerPixel == 8){
+      for (int i = 0; i != count; i++){
+        const uchar* c = m_lut.data() + row[x + i * step] * ByPP;
+        memcpy(dst + i * ByPP, c, ByPP);
+      }
+    }
+    else if (m_bitsPerPixel == 24){
+      for (int i = 0; i != count; i++){
+        const uchar* src = row + (x + i * step) * 3;
+        uchar* px = dst + i * ByPP;
+        px[iR] = src[2];
+        px[iG] = src[1];
+        px[iB] = src[0];
+        px[iA] = 255;
+      }
+    }
+    else{
+      for (int i = 0; i != count; i++){
+        const uchar* src = row + (x + i * step) * 4;
+        uchar* px = dst + i * ByPP;
+        px[iR] = src[3];
+        px[iG] = src[2];
+        px[iB] = src[1];
+        px[iA] = src[0];
+      }
+    }
+  }
+
+  BmpCache(const BmpCache&) = delete;
+  BmpCache& operator=(const BmpCache&) = delete;
+private:
+  int m_bitsPerPixel;
+  BmpSizeAndOrder m_bmpSize;
+  const uchar* m_data;
+  std::unique_ptr<MappedFile> m_file;
+  bmp_lut_t m_lut;
+  FilePath m_path;
+  size_t m_stride;
+};
+
+template<typename T>
+static Optional<T> struct_at(const MappedFile& file, size_t offset){
+  Buffer<StructInfo<T>::bytes> a;
+  if (file.GetSize() < offset + a.size()){
+    return {};
+  }
+  memcpy(a.data(), file.GetData() + offset, a.size());
+  return option(deserialize_struct<T>(a));
+}
+
+static void set_lut_entry(bmp_lut_t& lut, int index, const ColRGB& c){
+  uchar* px = lut.data() + index * ByPP;
+  px[iR] = c.r;
+  px[iG] = c.g;
+  px[iB] = c.b;
+  px[iA] = 255;
+}
+
+static Optional<bmp_lut_t> read_lut(const MappedFile& file,
+  const BitmapInfoHeader& h)
+{
+  // Indexes outside the color table are black, like in read_bmp.
+  bmp_lut_t lut = {};
+  if (h.paletteColors == 0){
+    for (int i = 0; i != 256; i++){
+      set_lut_entry(lut, i, grayscale_rgb(i));
+    }
+    return option(lut);
+  }
+
+  const size_t tableOffset =
+    struct_lengths<BitmapFileHeader, BitmapInfoHeader>();
+  const int numColors = static_cast<int>(h.paletteColors);
+  if (numColors > 256 || file.GetSize() < tableOffset + to_size_t(numColors * 4)){
+    return {};
+  }
+
+  for (int i = 0; i != 256; i++){
+    set_lut_entry(lut, i, ColRGB(0, 0, 0));
+  }
+
+  // blue, green, red, 0x00
+  const uchar* table = file.GetData() + tableOffset;
+  for (int i = 0; i != numColors; i++){
+    const uchar* entry = table + i * 4;
+    set_lut_entry(lut, i, ColRGB(entry[2], entry[1], entry[0]));
+  }
+  return option(lut);
+}
+
+static bool write_cache(const FilePath& cachePath,
+  const uchar* data,
+  size_t size)
+{
+  FILE* f = faint_fopen_write_binary(cachePath);
+  if (f == nullptr){
+    return false;
+  }
+  const bool written = fwrite(data, 1, size, f) == size;
+  return fclose(f) == 0 && written;
+}
+
+std::shared_ptr<LazyBitmap> lazy_bmp(const FilePath& path,
+  int minArea,
+  const cache_path_func& getCachePath)
+{
+  auto file = map_file(path);
+  if (file == nullptr){
+    return nullptr;
+  }
+
+  auto fileHeader = struct_at<BitmapFileHeader>(*file, 0);
+  auto infoHeader = struct_at<BitmapInfoHeader>(*file,
+    struct_lengths<BitmapFileHeader>());
+  if (fileHeader.NotSet() || infoHeader.NotSet()){
+    return nullptr;
+  }
+
+  const BitmapFileHeader& fh = fileHeader.Get();
+  const BitmapInfoHeader& h = infoHeader.Get();
+  if (fh.fileType != BITMAP_SIGNATURE ||
+    invalid_header_length(static_cast<int>(h.headerLen)) ||
+    h.compression != Compression::BI_RGB ||
+    h.colorPlanes != 1 ||
+    h.width <= 0 || h.height == 0)
+  {
+    return nullptr;
+  }
+
+  const int bitsPerPixel = h.bitsPerPixel;
+  if (bitsPerPixel != 8 && bitsPerPixel != 24 && bitsPerPixel != 32){
+    return nullptr;
+  }
+  if (bitsPerPixel != 8 && h.paletteColors != 0){
+    return nullptr;
+  }
+
+  const BmpSizeAndOrder bmpSize = get_size_and_order(h);
+  if (area_less(bmpSize.size, minArea)){
+    return nullptr;
+  }
+
+  const size_t stride = to_size_t(bmp_row_stride(bitsPerPixel,
+    bmpSize.size.w));
+  const size_t dataOffset = fh.dataOffset;
+  if (file->GetSize() < dataOffset ||
+    (file->GetSize() - dataOffset) / stride < to_size_t(bmpSize.size.h))
+  {
+    // Truncated pixel data
+    return nullptr;
+  }
+
+  bmp_lut_t lut = {};
+  if (bitsPerPixel == 8){
+    auto maybeLut = read_lut(*file, h);
+    if (maybeLut.NotSet()){
+      return nullptr;
+    }
+    lut = maybeLut.Get();
+  }
+
+  const Optional<FilePath> cachePath = getCachePath();
+  if (cachePath.NotSet()){
+    return nullptr;
+  }
+
+  std::unique_ptr<MappedFile> cache;
+  if (write_cache(cachePath.Get(), file->GetData() + dataOffset,
+    stride * to_size_t(bmpSize.size.h)))
+  {
+    file.reset();
+    cache = map_file(cachePath.Get());
+  }
+  if (cache == nullptr){
+    faint_remove(cachePath.Get());
+    return nullptr;
+  }
+
+  return std::make_shared<BmpCache>(std::move(cache), cachePath.Get(),
+    bmpSize, bitsPerPixel, lut);
+}
+
+} // namespace
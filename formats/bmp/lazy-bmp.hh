@@ -0,0 +1,49 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_LAZY_BMP_HH
+#define FAINT_LAZY_BMP_HH
+#include <memory>
+#include "bitmap/lazy-bitmap.hh"
+#include "formats/mapped-file.hh"
+
+namespace faint{
+
+class FilePath;
+
+// Memory maps an uncompressed 8, 24 or 32 bits-per-pixel bmp file with
+// at least minArea pixels, for reading the pixels on demand.
+//
+// Returns nullptr if the image is smaller, or if the file can not be
+// mapped or is not supported this way (e.g. compressed or truncated),
+// in which case read_bmp should be used instead.
+// Copies the pixel data of an uncompressed bmp-file with at least
+// minArea pixels to a cache file, which is memory mapped for reading
+// the pixels on demand. The cache file is removed when the LazyBitmap
+// is destroyed.
+//
+// The file itself is not kept mapped, since it may be overwritten
+// (e.g. when saving) while the LazyBitmap is used as the original
+// for undo and revert.
+//
+// Returns nullptr if the image is smaller or unsupported, in which
+// case read_bmp should be used instead.
+std::shared_ptr<LazyBitmap> lazy_bmp(const FilePath&,
+  int minArea,
+  const cache_path_func&);
+
+} // namespace
+
+#endif
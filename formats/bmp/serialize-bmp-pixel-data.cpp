@@ -15,6 +15,7 @@
 
 #include "bitmap/alpha-map.hh"
 #include "bitmap/bitmap.hh"
+#include "bitmap/color.hh"
 #include "formats/bmp/bmp-types.hh" // For BmpSizeAndOrder
 #include "bitmap/color-list.hh"
 #include "bitmap/quantize.hh"
@@ -48,85 +49,113 @@ static void write_color_table(BinaryWriter& out, const ColorList& l){
   }
 }
 
-Optional<AlphaMap> read_1bipp_BI_RGB(BinaryReader& in,
-  const BmpSizeAndOrder& bmpSize)
+template<typename FUNC>
+static bool read_rows(BinaryReader& in,
+  const BmpSizeAndOrder& bmpSize,
+  int rowBytes,
+  int padBytes,
+  const FUNC& convertRow)
 {
+  // Reads the pixel data one row at a time, and calls convertRow with
+  // the destination row index and the row data.
   const auto& size = bmpSize.size;
-  const int rowLength = bmp_row_stride<1>(size.w);
-  const int bufferLength = rowLength * size.h;
-
-  std::vector<char> pixelData(bufferLength);
-  in.read(pixelData.data(), bufferLength);
-  if (!in.good()){
-    return {};
-  }
-
-  AlphaMap alphaMap(size);
+  std::vector<char> row(static_cast<size_t>(rowBytes));
   for (int y = 0; y != size.h; y++){
-    for (int x = 0; x != size.w; x++){
-      unsigned int value =
-        static_cast<unsigned int>(pixelData[rowLength * y + x / 8]);
-      unsigned char paletteIndex = (value & (1 << (7 - x % 8))) == 0 ? 0 : 1;
-      const auto yDst = bmpSize.topDown ? y : size.h - y - 1;
-      alphaMap.Set(x, yDst, paletteIndex);
+    in.read(row.data(), rowBytes);
+    if (!in.good()){
+      return false;
     }
+    const int yDst = bmpSize.topDown ? y : size.h - y - 1;
+    convertRow(yDst, reinterpret_cast<const uchar*>(row.data()));
+    in.ignore(padBytes);
   }
-  return option(alphaMap);
+  return true;
 }
 
-Optional<AlphaMap> read_4bipp_BI_RGB(BinaryReader& in,
+Optional<AlphaMap> read_1bipp_BI_RGB(BinaryReader& in,
   const BmpSizeAndOrder& bmpSize)
 {
   const auto& size = bmpSize.size;
-  const int rowLength = bmp_row_stride<4>(size.w);
-  const int bufferLength = rowLength * size.h;
+  AlphaMap alphaMap(size);
+
+  const bool ok = read_rows(in, bmpSize, bmp_row_stride<1>(size.w), 0,
+    [&](int yDst, const uchar* row){
+      uchar* dst = alphaMap.GetRaw() + yDst * size.w;
+      for (int x = 0; x != size.w; x++){
+        dst[x] = (row[x / 8] & (1 << (7 - x % 8))) == 0 ? 0 : 1;
+      }
+    });
 
-  std::vector<char> pixelData(bufferLength);
-  in.read(pixelData.data(), bufferLength);
-  if (!in.good()){
+  if (!ok){
     return {};
   }
+  return Optional<AlphaMap>(std::move(alphaMap));
+}
 
+Optional<AlphaMap> read_4bipp_BI_RGB(BinaryReader& in,
+  const BmpSizeAndOrder& bmpSize)
+{
+  const auto& size = bmpSize.size;
   AlphaMap alphaMap(size);
-  for (int y = 0; y != size.h; y++){
-    for (int x = 0; x != size.w; x++){
-      unsigned int value =
-        static_cast<unsigned int>(pixelData[rowLength * y + x / 2]);
-      if (x % 2 != 0){
-        value <<= 4;
+
+  const bool ok = read_rows(in, bmpSize, bmp_row_stride<4>(size.w), 0,
+    [&](int yDst, const uchar* row){
+      uchar* dst = alphaMap.GetRaw() + yDst * size.w;
+      for (int x = 0; x != size.w; x++){
+        unsigned int value = row[x / 2];
+        if (x % 2 != 0){
+          value <<= 4;
+        }
+        dst[x] = static_cast<uchar>(value & 0xf);
       }
-      value &= 0xf;
+    });
 
-      const auto yDst = bmpSize.topDown ? y : size.h - y - 1;
-      alphaMap.Set(x, yDst, static_cast<uchar>(value));
-    }
+  if (!ok){
+    return {};
   }
-  return option(alphaMap);
+  return Optional<AlphaMap>(std::move(alphaMap));
 }
 
-Optional<AlphaMap> read_8bipp_BI_RGB(BinaryReader& in,
-  const BmpSizeAndOrder& bmpSize)
+Optional<Bitmap> read_8bipp_BI_RGB(BinaryReader& in,
+  const BmpSizeAndOrder& bmpSize,
+  const ColorList& colorTable)
 {
   const auto& size = bmpSize.size;
-  const int padBytes = bmp_row_padding<8>(size.w);
-  AlphaMap alphaMap(size);
 
-  for (int y = 0; y != size.h; y++){
-    for (int x = 0; x != size.w; x++){
-      // Fixme: Read full rows
-      char v;
-      in.read(&v, 1);
-      if (!in.good()){
-        return option(alphaMap); // Fixme
-        // return {};
+  // Indexes outside the color table are black
+  Color colors[256];
+  for (size_t i = 0; i != 256; i++){
+    colors[i] = i < colorTable.size() ?
+      with_alpha(colorTable[i], 255) :
+      Color(0, 0, 0, 255);
+  }
+
+  Bitmap bmp(size);
+  int rowsRead = 0;
+  const bool ok = read_rows(in, bmpSize, size.w, bmp_row_padding<8>(size.w),
+    [&](int yDst, const uchar* row){
+      uchar* dst = bmp.GetRaw() + yDst * bmp.GetStride();
+      for (int x = 0; x != size.w; x++){
+        const Color& c = colors[row[x]];
+        dst[x * ByPP + iR] = c.r;
+        dst[x * ByPP + iG] = c.g;
+        dst[x * ByPP + iB] = c.b;
+        dst[x * ByPP + iA] = c.a;
       }
+      rowsRead++;
+    });
 
-      const auto yDst = bmpSize.topDown ? y : size.h - y - 1;
-      alphaMap.Set(x, yDst, static_cast<unsigned char>(v));
+  if (!ok){
+    // Fixme: Signal the error instead. Truncated data is accepted, with
+    // the missing rows using the first color.
+    for (int y = rowsRead; y != size.h; y++){
+      const int yDst = bmpSize.topDown ? y : size.h - y - 1;
+      for (int x = 0; x != size.w; x++){
+        put_pixel_raw(bmp, x, yDst, colors[0]);
+      }
     }
-    in.ignore(padBytes);
   }
-  return option(alphaMap);
+  return Optional<Bitmap>(std::move(bmp));
 }
 
 Optional<Bitmap> read_24bipp_BI_RGB(BinaryReader& in,
@@ -134,25 +163,23 @@ Optional<Bitmap> read_24bipp_BI_RGB(BinaryReader& in,
 {
   const auto& size = bmpSize.size;
   Bitmap bmp(size);
-  const int padBytes = bmp_row_padding<24>(size.w);
-  for (int y = 0; y != bmp.m_h; y++){
-    for (int x = 0; x != bmp.m_w; x++){
-      // Fixme: Read full rows, or even whole image.
-      char bytes[3];
-      in.read(bytes, 3);
-      if (!in.good()){
-        return {};
+
+  const bool ok = read_rows(in, bmpSize, size.w * 3,
+    bmp_row_padding<24>(size.w),
+    [&](int yDst, const uchar* row){
+      uchar* dst = bmp.GetRaw() + yDst * bmp.GetStride();
+      for (int x = 0; x != size.w; x++, row += 3, dst += ByPP){
+        dst[iR] = row[2];
+        dst[iG] = row[1];
+        dst[iB] = row[0];
+        dst[iA] = 255;
       }
-      const auto yDst = bmpSize.topDown ? y : size.h - y - 1;
-      put_pixel_raw(bmp, x, yDst,
-        Color(static_cast<unsigned char>(bytes[2]),
-          static_cast<unsigned char>(bytes[1]),
-          static_cast<unsigned char>(bytes[0]),
-          255));
-    }
-    in.ignore(padBytes);
+    });
+
+  if (!ok){
+    return {};
   }
-  return option(bmp);
+  return Optional<Bitmap>(std::move(bmp));
 }
 
 Optional<Bitmap> read_32bipp_BI_RGB(BinaryReader& in,
@@ -160,25 +187,23 @@ Optional<Bitmap> read_32bipp_BI_RGB(BinaryReader& in,
 {
   const auto& size(bmpSize.size);
   Bitmap bmp(size);
-  const int padBytes = bmp_row_padding<32>(size.w);
 
-  for (int y = 0; y != bmp.m_h; y++){
-    for (int x = 0; x != bmp.m_w; x++){
-      char bytes[4];
-      in.read(bytes, 4);
-      if (!in.good()){
-        return {};
+  const bool ok = read_rows(in, bmpSize, size.w * 4,
+    bmp_row_padding<32>(size.w),
+    [&](int yDst, const uchar* row){
+      uchar* dst = bmp.GetRaw() + yDst * bmp.GetStride();
+      for (int x = 0; x != size.w; x++, row += 4, dst += ByPP){
+        dst[iR] = row[3];
+        dst[iG] = row[2];
+        dst[iB] = row[1];
+        dst[iA] = row[0];
       }
-      const auto yDst = bmpSize.topDown ? y : size.h - y - 1;
-      put_pixel_raw(bmp, x, yDst,
-        Color(static_cast<unsigned char>(bytes[3]),
-          static_cast<unsigned char>(bytes[2]),
-          static_cast<unsigned char>(bytes[1]),
-          static_cast<unsigned char>(bytes[0])));
-    }
-    in.ignore(padBytes);
+    });
+
+  if (!ok){
+    return {};
   }
-  return option(bmp);
+  return Optional<Bitmap>(std::move(bmp));
 }
 
 Optional<ColorList> read_color_table(BinaryReader& in, int numColors){
@@ -15,6 +15,9 @@
 
 #ifndef FAINT_SERIALIZE_BMP_PIXEL_DATA_HH
 #define FAINT_SERIALIZE_BMP_PIXEL_DATA_HH
+#include "bitmap/color-list.hh"
+#include "geo/geo-fwd.hh"
+#include "util/optional.hh"
 
 namespace faint{
 
@@ -48,7 +51,8 @@ int bmp_row_padding(int w){
 
 Optional<AlphaMap> read_1bipp_BI_RGB(BinaryReader&, const BmpSizeAndOrder&);
 Optional<AlphaMap> read_4bipp_BI_RGB(BinaryReader&, const BmpSizeAndOrder&);
-Optional<AlphaMap> read_8bipp_BI_RGB(BinaryReader&, const BmpSizeAndOrder&);
+Optional<Bitmap> read_8bipp_BI_RGB(BinaryReader&, const BmpSizeAndOrder&,
+  const ColorList&);
 Optional<Bitmap> read_24bipp_BI_RGB(BinaryReader&, const BmpSizeAndOrder&);
 Optional<Bitmap> read_32bipp_BI_RGB(BinaryReader&, const BmpSizeAndOrder&);
 Optional<ColorList> read_color_table(BinaryReader&, int numColors);
@@ -37,6 +37,11 @@ int faint_open(const FilePath& path, int oflag, int pmode){
   return _wopen(filename_u16.c_str(), oflag, pmode);
 }
 
+bool faint_remove(const FilePath& path){
+  const std::wstring filename_u16 = iostream_friendly(path);
+  return _wremove(filename_u16.c_str()) == 0;
+}
+
 } // namespace
 
 #else // Non-windows
@@ -58,6 +63,10 @@ int faint_open(const FilePath& path, int oflag, int pmode){
   return open(path.Str().c_str(), oflag, pmode);
 }
 
+bool faint_remove(const FilePath& path){
+  return std::remove(path.Str().c_str()) == 0;
+}
+
 } // namespace
 
 #endif
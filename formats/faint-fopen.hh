@@ -28,6 +28,9 @@ FILE* faint_fopen_read_binary(const FilePath&);
 // Returns a file handle.
 int faint_open(const FilePath&, int oflag, int pmode);
 
+// Deletes the file. Returns true on success.
+bool faint_remove(const FilePath&);
+
 } // namespace
 
 #endif
@@ -17,8 +17,9 @@
 #include "app/canvas.hh"
 #include "bitmap/bitmap.hh"
 #include "formats/bmp/file-bmp.hh"
+#include "formats/bmp/lazy-bmp.hh"
 #include "formats/format.hh"
-#include "formats/format-util.hh" // add_frame_or_set_error
+#include "formats/format-util.hh" // add_frame_or_set_error, create_cache_file
 #include "util/image-util.hh" // flatten
 
 namespace faint{
@@ -57,6 +58,12 @@ public:
   {}
 
   void Load(const FilePath& filePath, ImageProps& imageProps) override{
+    if (auto lazy = lazy_bmp(filePath, LAZY_LOAD_MIN_AREA,
+      create_cache_file))
+    {
+      imageProps.AddFrame(lazy, FrameInfo());
+      return;
+    }
     add_frame_or_set_error(read_bmp(filePath), imageProps);
   }
 
@@ -15,9 +15,9 @@
 
 #include "app/canvas.hh"
 #include "app/frame-iter.hh"
-#include "bitmap/quantize.hh"
 #include "formats/format.hh"
 #include "formats/gif/file-gif.hh"
+#include "formats/gif/gif-frames.hh"
 #include "text/formatting.hh"
 #include "util/generator-adapter.hh"
 #include "util/image.hh"
@@ -26,10 +26,6 @@
 
 namespace faint{
 
-static GifFrame to_gif_frame(const Image& f){
-  return {quantized(flatten(f), Dithering::ON), f.GetDelay()};
-}
-
 static auto find_mismatch(const std::vector<IntSize>& sizes){
   return find_if_iter(sizes, not_equal_to(sizes.front()));
 }
@@ -53,6 +49,19 @@ static std::vector<IntSize> get_frame_sizes(Canvas& canvas){
   return make_vector(canvas, get_size);
 }
 
+static std::vector<Delay> get_frame_delays(Canvas& canvas){
+  const auto get_delay = [](const auto& frame){return frame.GetDelay();};
+  return make_vector(canvas, get_delay);
+}
+
+static std::vector<GifFrame> to_gif_frames(Canvas& canvas){
+  return quantized_gif_frames(get_frame_delays(canvas),
+    [&](int index){
+      return flatten(canvas.GetFrame(Index(index)));
+    },
+    GifOptions());
+}
+
 class FormatGIF : public Format {
 public:
   FormatGIF()
@@ -69,7 +78,7 @@ public:
   SaveResult Save(const FilePath& filePath, Canvas& canvas) override{
     auto sizes = get_frame_sizes(canvas);
     return uniform_size(sizes) ?
-      write_gif(filePath, make_vector(canvas, to_gif_frame)) :
+      write_gif(filePath, to_gif_frames(canvas)) :
       fail_size_mismatch(sizes);
   }
 };
@@ -14,8 +14,9 @@
 // permissions and limitations under the License.
 
 #include "app/canvas.hh"
+#include "bitmap/lazy-bitmap.hh"
 #include "formats/format.hh"
-#include "formats/format-util.hh" // add_frame_or_set_error
+#include "formats/format-util.hh" // add_frame_or_set_error, create_cache_file
 #include "formats/png/file-png.hh"
 #include "util/image-props.hh"
 #include "util/image-util.hh" // flatten
@@ -36,6 +37,12 @@ public:
   {}
 
   void Load(const FilePath& filePath, ImageProps& imageProps) override{
+    if (auto lazy = lazy_png(filePath, LAZY_LOAD_MIN_AREA,
+      create_cache_file))
+    {
+      imageProps.AddFrame(lazy, FrameInfo());
+      return;
+    }
     add_frame_or_set_error(read_png(filePath), imageProps);
   }
 
@@ -13,6 +13,7 @@
 // implied. See the License for the specific language governing
 // permissions and limitations under the License.
 
+#include "wx/filename.h"
 #include "formats/format-util.hh"
 
 namespace faint{
@@ -27,4 +28,12 @@ void add_frame_or_set_error(OrError<Bitmap>&& obj, ImageProps& props){
     });
 }
 
+Optional<FilePath> create_cache_file(){
+  const wxString path = wxFileName::CreateTempFileName("faint");
+  if (path.empty()){
+    return {};
+  }
+  return option(FilePath::FromAbsoluteWx(wxFileName(path)));
+}
+
 } // namespace
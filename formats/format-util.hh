@@ -17,15 +17,26 @@
 #define FAINT_FORMAT_UTIL_HH
 
 #include "bitmap/bitmap.hh"
+#include "util-wx/file-path.hh"
 #include "util/image-props.hh"
+#include "util/optional.hh"
 #include "util/or-error.hh"
 
 namespace faint{
 
+// Images with at least this many pixels are read on demand when
+// loaded, if the format supports it, so that opening is fast and
+// memory is only used for the parts which are viewed.
+const int LAZY_LOAD_MIN_AREA = 64 * 1000 * 1000;
+
 // Adds the bitmap as a frame to the ImageProps, or sets the error to
 // the ImageProps.
 void add_frame_or_set_error(OrError<Bitmap>&&, ImageProps&) ;
 
+// Creates a uniquely named empty file in the temp directory, for
+// the pixels of lazily loaded images.
+Optional<FilePath> create_cache_file();
+
 } // namespace
 
 #endif
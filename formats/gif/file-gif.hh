@@ -19,6 +19,7 @@
 #include "bitmap/alpha-map.hh"
 #include "bitmap/quantize.hh"
 #include "formats/save-result.hh"
+#include "geo/int-point.hh"
 #include "util/delay.hh"
 
 namespace faint{
@@ -28,12 +29,32 @@ class ImageProps;
 
 void read_gif(const FilePath&, ImageProps&);
 
+// What happens to the area of a frame before the next frame is
+// drawn.
+enum class GifDisposal{
+  RESTORE_BACKGROUND, // Cleared to the (transparent) background
+  KEEP // Left as is, so that the next frame is drawn on top
+};
+
 struct GifFrame{
   GifFrame(const MappedColors& image, const Delay& delay)
     : image(image), delay(delay)
   {}
+
+  GifFrame(const MappedColors& image,
+    const Delay& delay,
+    const IntPoint& pos,
+    GifDisposal disposal)
+    : image(image), delay(delay), pos(pos), disposal(disposal)
+  {}
+
   MappedColors image;
   Delay delay;
+
+  // The position of the image in the gif. The first frame determines
+  // the gif size, and must be at 0,0.
+  IntPoint pos;
+  GifDisposal disposal = GifDisposal::RESTORE_BACKGROUND;
 };
 
 SaveResult write_gif(const FilePath&, const std::vector<GifFrame>&);
@@ -0,0 +1,201 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <algorithm>
+#include <cassert>
+#include <cstring> // memcmp
+#include <memory>
+#include "bitmap/bitmap.hh"
+#include "bitmap/color.hh"
+#include "bitmap/draw.hh"
+#include "bitmap/mask.hh"
+#include "formats/gif/gif-frames.hh"
+#include "geo/int-rect.hh"
+#include "util/parallel.hh"
+
+namespace faint{
+
+// Frames flattened ahead per thread, limiting the memory use.
+static const int FRAMES_PER_THREAD = 2;
+
+static bool row_differs(const Bitmap& a, const Bitmap& b, int y){
+  return memcmp(a.GetRaw() + y * a.GetStride(),
+    b.GetRaw() + y * b.GetStride(),
+    to_size_t(a.m_w * ByPP)) != 0;
+}
+
+static bool pixel_differs(const Bitmap& a, const Bitmap& b, int x, int y){
+  return get_color_raw(a, x, y) != get_color_raw(b, x, y);
+}
+
+static Optional<IntRect> changed_rect(const Bitmap& prev, const Bitmap& bmp){
+  assert(prev.GetSize() == bmp.GetSize());
+  int y0 = 0;
+  while (y0 != bmp.m_h && !row_differs(prev, bmp, y0)){
+    y0++;
+  }
+  if (y0 == bmp.m_h){
+    return {};
+  }
+
+  int y1 = bmp.m_h - 1;
+  while (!row_differs(prev, bmp, y1)){
+    y1--;
+  }
+
+  int x0 = bmp.m_w - 1;
+  int x1 = 0;
+  for (int y = y0; y <= y1; y++){
+    for (int x = 0; x < x0; x++){
+      if (pixel_differs(prev, bmp, x, y)){
+        x0 = x;
+        break;
+      }
+    }
+    for (int x = bmp.m_w - 1; x > x1; x--){
+      if (pixel_differs(prev, bmp, x, y)){
+        x1 = x;
+        break;
+      }
+    }
+  }
+  return IntRect(IntPoint(x0, y0), IntPoint(x1, y1));
+}
+
+static Mask unchanged_pixels(const Bitmap& prev,
+  const Bitmap& bmp,
+  const IntRect& r)
+{
+  Mask mask(r.GetSize());
+  for (int y = 0; y != r.h; y++){
+    for (int x = 0; x != r.w; x++){
+      mask.Set(x, y, !pixel_differs(prev, bmp, r.x + x, r.y + y));
+    }
+  }
+  return mask;
+}
+
+static GifFrame full_frame(const Bitmap& bmp,
+  const Delay& delay,
+  const SharedPalette* palette,
+  GifDisposal disposal)
+{
+  return {palette == nullptr ?
+      quantized(bmp, Dithering::ON) :
+      palette->Map(bmp, mask_alpha_equal(bmp, 0), Dithering::ON),
+    delay, IntPoint(0,0), disposal};
+}
+
+static GifFrame delta_frame(const Bitmap& prev,
+  const Bitmap& bmp,
+  const Delay& delay,
+  const SharedPalette* palette)
+{
+  // A single transparent pixel if nothing changed, since a frame
+  // can not be empty.
+  const IntRect r(changed_rect(prev, bmp).Or(
+    IntRect(IntPoint(0,0), IntSize(1,1))));
+
+  const Bitmap changed(subbitmap(bmp, r));
+  const Mask unchanged(unchanged_pixels(prev, bmp, r));
+  return {palette == nullptr ?
+      quantized(changed, unchanged, Dithering::ON) :
+      palette->Map(changed, unchanged, Dithering::ON),
+    delay, r.TopLeft(), GifDisposal::KEEP};
+}
+
+static bool all_opaque(const std::vector<Bitmap>& bitmaps){
+  return std::all_of(begin(bitmaps), end(bitmaps),
+    [](const Bitmap& bmp){
+      return fully_opaque(bmp);
+    });
+}
+
+static Optional<std::vector<GifFrame>> quantize_frames(
+  const std::vector<Delay>& delays,
+  const gif_bitmap_func& getBitmap,
+  const SharedPalette* palette,
+  bool delta)
+{
+  const int numFrames = resigned(delays.size());
+  const int batchSize = FRAMES_PER_THREAD * get_max_threads();
+
+  std::vector<GifFrame> frames;
+  frames.reserve(delays.size());
+  Bitmap prev;
+
+  for (int first = 0; first < numFrames; first += batchSize){
+    const int count = std::min(batchSize, numFrames - first);
+
+    std::vector<Bitmap> bitmaps;
+    for (int i = 0; i != count; i++){
+      bitmaps.push_back(getBitmap(first + i));
+    }
+    if (delta && !all_opaque(bitmaps)){
+      return {};
+    }
+
+    std::vector<Optional<GifFrame>> batch(to_size_t(count));
+    parallel_for(count, 1, [&](int i0, int i1){
+      for (int i = i0; i != i1; i++){
+        const Bitmap& bmp = bitmaps[to_size_t(i)];
+        const Delay& delay = delays[to_size_t(first + i)];
+        if (!delta){
+          batch[to_size_t(i)].Set(full_frame(bmp, delay, palette,
+            GifDisposal::RESTORE_BACKGROUND));
+        }
+        else if (first + i == 0){
+          batch[to_size_t(i)].Set(full_frame(bmp, delay, palette,
+            GifDisposal::KEEP));
+        }
+        else{
+          const Bitmap& prevBmp = i == 0 ? prev : bitmaps[to_size_t(i - 1)];
+          batch[to_size_t(i)].Set(delta_frame(prevBmp, bmp, delay, palette));
+        }
+      }
+    });
+
+    for (auto& frame : batch){
+      frames.push_back(frame.Take());
+    }
+    prev = std::move(bitmaps.back());
+  }
+  return Optional<std::vector<GifFrame>>(std::move(frames));
+}
+
+std::vector<GifFrame> quantized_gif_frames(const std::vector<Delay>& delays,
+  const gif_bitmap_func& getBitmap,
+  const GifOptions& options)
+{
+  std::unique_ptr<SharedPalette> palette;
+  if (options.sharedPalette){
+    palette = std::make_unique<SharedPalette>();
+    for (int i = 0; i != resigned(delays.size()); i++){
+      palette->Add(getBitmap(i));
+    }
+    palette->Finish();
+  }
+
+  if (options.deltaFrames && delays.size() > 1){
+    auto frames = quantize_frames(delays, getBitmap, palette.get(), true);
+    if (frames.IsSet()){
+      return frames.Take();
+    }
+    // A frame had transparency, use full frames instead.
+  }
+  return quantize_frames(delays, getBitmap, palette.get(), false).Take();
+}
+
+} // namespace
@@ -0,0 +1,49 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_GIF_FRAMES_HH
+#define FAINT_GIF_FRAMES_HH
+#include <functional>
+#include <vector>
+#include "formats/gif/file-gif.hh"
+
+namespace faint{
+
+class GifOptions{
+public:
+  // Crop each frame to the rectangle changed from the previous frame,
+  // with the unchanged pixels transparent. Only used if all frames
+  // are opaque, since a frame drawn on top of the previous can not
+  // make pixels transparent.
+  bool deltaFrames = true;
+
+  // Map all frames to one palette, written once as the global color
+  // table, instead of creating a palette for each frame.
+  bool sharedPalette = false;
+};
+
+using gif_bitmap_func = std::function<Bitmap(int index)>;
+
+// Quantizes the frames for write_gif, using multiple threads. The
+// function is called on the calling thread to get the bitmap for
+// each frame, in order, and may be called several times per frame.
+// The bitmaps must have the same size.
+std::vector<GifFrame> quantized_gif_frames(const std::vector<Delay>&,
+  const gif_bitmap_func&,
+  const GifOptions&);
+
+} // namespace
+
+#endif
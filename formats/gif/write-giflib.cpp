@@ -13,6 +13,7 @@
 // implied. See the License for the specific language governing
 // permissions and limitations under the License.
 
+#include <cassert>
 #include <memory>
 #include "formats/faint-fopen.hh"
 #include "formats/gif/write-giflib.hh"
@@ -78,6 +79,7 @@ GifWriteResult write_with_giflib(const FilePath& path,
     const auto& map = entry.image.map;
     const auto size = map.GetSize(); // Fixme: Max gif-size?
     if (first){
+      assert(entry.pos == IntPoint(0,0));
       const auto& globalColorList = v.front().image.palette;
       if (globalColorList.size() > 256){
         return GifWriteResult::ERROR_TOO_LARGE_PALETTE;
@@ -115,7 +117,7 @@ GifWriteResult write_with_giflib(const FilePath& path,
       }
     }
 
-    if (v.size() > 1){
+    if (first && v.size() > 1){
       // Netscape loop extension
       auto err = EGifPutExtensionLeader(gifFile, APPLICATION_EXT_FUNC_CODE);
       if (err == GIF_ERROR){
@@ -139,7 +141,8 @@ GifWriteResult write_with_giflib(const FilePath& path,
     }
 
     GraphicsControlBlock gcb;
-    gcb.DisposalMode = DISPOSE_BACKGROUND;
+    gcb.DisposalMode = entry.disposal == GifDisposal::KEEP ?
+      DISPOSE_DO_NOT : DISPOSE_BACKGROUND;
     gcb.UserInputFlag = false;
     gcb.DelayTime = entry.delay.Get().count();
     gcb.TransparentColor =
@@ -174,13 +177,14 @@ GifWriteResult write_with_giflib(const FilePath& path,
     colorMap.SortFlag = false; // Fixme: ?
     colorMap.Colors = colorPtr.get();
 
-    // Avoid specifying a palette for the first image - it would be
-    // identical to the global color map.
-    auto colorMapPtr = first ? nullptr : &colorMap;
+    // Avoid specifying a palette identical to the global color map,
+    // e.g. for the first image.
+    auto colorMapPtr = first || colorList == v.front().image.palette ?
+      nullptr : &colorMap;
 
     err = EGifPutImageDesc(gifFile,
-      0, // GifLeft
-      0, // GifTop
+      entry.pos.x, // GifLeft
+      entry.pos.y, // GifTop
       size.w, // GifWidth
       size.h, // GifHeight
       false, // GifInterlace
@@ -0,0 +1,144 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include "formats/mapped-file.hh"
+
+#ifdef _MSC_VER // Windows
+#include <windows.h>
+#include "util-wx/file-path.hh"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "formats/faint-fopen.hh"
+#endif
+
+namespace faint{
+
+#ifdef _MSC_VER // Windows
+
+class MappedFileImpl{
+public:
+  MappedFileImpl(HANDLE file, HANDLE mapping, const void* data, size_t size)
+    : file(file),
+      mapping(mapping),
+      data(static_cast<const unsigned char*>(data)),
+      size(size)
+  {}
+
+  ~MappedFileImpl(){
+    UnmapViewOfFile(data);
+    CloseHandle(mapping);
+    CloseHandle(file);
+  }
+
+  HANDLE file;
+  HANDLE mapping;
+  const unsigned char* data;
+  size_t size;
+};
+
+std::unique_ptr<MappedFile> map_file(const FilePath& path){
+  const std::wstring filename_u16 = iostream_friendly(path);
+  HANDLE file = CreateFileW(filename_u16.c_str(), GENERIC_READ,
+    FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE){
+    return nullptr;
+  }
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0){
+    CloseHandle(file);
+    return nullptr;
+  }
+
+  HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0,
+    nullptr);
+  if (mapping == nullptr){
+    CloseHandle(file);
+    return nullptr;
+  }
+
+  const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (data == nullptr){
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return nullptr;
+  }
+
+  return std::make_unique<MappedFile>(new MappedFileImpl(file, mapping, data,
+    static_cast<size_t>(size.QuadPart)));
+}
+
+#else // Non-windows
+
+class MappedFileImpl{
+public:
+  MappedFileImpl(void* data, size_t size)
+    : data(static_cast<const unsigned char*>(data)),
+      size(size)
+  {}
+
+  ~MappedFileImpl(){
+    munmap(const_cast<unsigned char*>(data), size);
+  }
+
+  const unsigned char* data;
+  size_t size;
+};
+
+std::unique_ptr<MappedFile> map_file(const FilePath& path){
+  const int fd = faint_open(path, O_RDONLY, 0);
+  if (fd == -1){
+    return nullptr;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0){
+    close(fd);
+    return nullptr;
+  }
+
+  const size_t size = static_cast<size_t>(st.st_size);
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  // The mapping remains valid after closing the descriptor.
+  close(fd);
+  if (data == MAP_FAILED){
+    return nullptr;
+  }
+  return std::make_unique<MappedFile>(new MappedFileImpl(data, size));
+}
+
+#endif
+
+MappedFile::MappedFile(MappedFileImpl* impl)
+  : m_impl(impl)
+{}
+
+MappedFile::~MappedFile(){
+  delete m_impl;
+}
+
+const unsigned char* MappedFile::GetData() const{
+  return m_impl->data;
+}
+
+size_t MappedFile::GetSize() const{
+  return m_impl->size;
+}
+
+} // namespace
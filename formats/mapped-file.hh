@@ -0,0 +1,54 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_MAPPED_FILE_HH
+#define FAINT_MAPPED_FILE_HH
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include "util/optional.hh"
+
+namespace faint{
+
+class FilePath;
+class MappedFileImpl;
+
+class MappedFile{
+  // A read-only memory mapping of a file. The operating system pages
+  // in the parts of the file which are accessed, so mapping even huge
+  // files is cheap.
+public:
+  explicit MappedFile(MappedFileImpl*);
+  ~MappedFile();
+
+  const unsigned char* GetData() const;
+  size_t GetSize() const;
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+private:
+  MappedFileImpl* m_impl;
+};
+
+// Maps the entire file for reading. Returns nullptr if the file could
+// not be opened or mapped, or is empty.
+std::unique_ptr<MappedFile> map_file(const FilePath&);
+
+// Returns the path for a new cache file, e.g. in the temp directory.
+using cache_path_func = std::function<Optional<FilePath>()>;
+
+} // namespace
+
+#endif
@@ -13,14 +13,17 @@
 // implied. See the License for the specific language governing
 // permissions and limitations under the License.
 
-#include "bitmap/bitmap-exception.hh"
+#include <cstring> // memcpy
+#include <vector>
+#include "bitmap/lazy-bitmap.hh"
+#include "formats/faint-fopen.hh"
+#include "formats/mapped-file.hh"
 #include "formats/png/file-png.hh"
 #include "formats/png/png-util.hh"
 #include "formats/png/read-libpng.hh"
 #include "formats/png/write-libpng.hh"
 #include "geo/limits.hh"
 #include "text/formatting.hh"
-#include <cstdint>
 
 namespace faint{
 
@@ -107,63 +110,38 @@ static utf8_string color_type_to_string(png_byte colorType){
   }
 }
 
-OrError<Bitmap_and_tEXt> read_png_meta(const FilePath& path){
-
-  // --
-  // Output parameters
-  png_byte* rows = nullptr;
-  png_uint_32 width;
-  png_uint_32 height;
-  png_byte colorType;
-  png_byte bitDepth;
-  int pngBitsPerPixel;
-  png_tEXt_map textChunks;
-  std::vector<png_color> palette;
-  std::vector<png_byte> paletteAlpha;
-  PngReadResult result = read_with_libpng(path,
-    &rows,
-    &width,
-    &height,
-    &colorType,
-    &bitDepth,
-    &pngBitsPerPixel,
-    palette,
-    paletteAlpha,
-    textChunks);
-  // --
-
-  if (result != PngReadResult::OK){
-    return to_string(result, path);
-  }
+static Optional<utf8_string> unsupported(const PngInfo& info){
+  const auto colorType = info.colorType;
+  const auto bitDepth = info.bitDepth;
+  const auto pngBitsPerPixel = info.bitsPerPixel;
 
   if (bitDepth != 8 && bitDepth != 16){
-    free(rows);
-    return {"Unsupported bit depth: " + str_int(bitDepth)};
+    return option(utf8_string("Unsupported bit depth: " + str_int(bitDepth)));
   }
 
   if (!rgb_or_rgba(colorType) && !gray_or_gray_alpha(colorType) &&
     !palettized(colorType))
   {
-    free(rows);
-    return {"Unsuppored png color-type: " + color_type_to_string(colorType)};
+    return option("Unsuppored png color-type: " +
+      color_type_to_string(colorType));
   }
 
   if (colorType == PNG_COLOR_TYPE_GRAY){
     if (pngBitsPerPixel != 8){
-      return {"Unsupported bits-per-pixel for PNG_COLOR_TYPE GRAY: " +
-          str_int(pngBitsPerPixel)};
+      return option("Unsupported bits-per-pixel for PNG_COLOR_TYPE GRAY: " +
+        str_int(pngBitsPerPixel));
     }
   }
   else if (colorType == PNG_COLOR_TYPE_GRAY_ALPHA){
     if (pngBitsPerPixel != 16){
-      return {"Unsupported bits-per-pixel for PNG_COLOR_TYPE_GRAY_ALPHA: " +
-          str_int(pngBitsPerPixel)};
+      return option("Unsupported bits-per-pixel for "
+        "PNG_COLOR_TYPE_GRAY_ALPHA: " + str_int(pngBitsPerPixel));
     }
   }
   else if (colorType == PNG_COLOR_TYPE_PALETTE){
     if (pngBitsPerPixel != 8){
-      return {"Unsupported bits-per-pixel for PNG_COLOR_TYPE_PALETTE; " +
-          str_int(pngBitsPerPixel)};
+      return option("Unsupported bits-per-pixel for "
+        "PNG_COLOR_TYPE_PALETTE; " + str_int(pngBitsPerPixel));
     }
   }
   else if (colorType == PNG_COLOR_TYPE_RGB_ALPHA){
@@ -171,126 +149,154 @@ OrError<Bitmap_and_tEXt> read_png_meta(const FilePath& path){
       pngBitsPerPixel != 32 &&
       pngBitsPerPixel != 24)
     {
-      return {"Unsupported bits-per-pixel: " + str_int(pngBitsPerPixel)};
+      return option("Unsupported bits-per-pixel: " + str_int(pngBitsPerPixel));
     }
   }
 
-  if (!can_represent<IntSize::value_type>(width)){
-    return {"Unsupported png-width"};
+  if (!can_represent<IntSize::value_type>(info.width)){
+    return option(utf8_string("Unsupported png-width"));
   }
 
-  if (!can_represent<IntSize::value_type>(height)){
-    return {"Unsupported png-height"};
+  if (!can_represent<IntSize::value_type>(info.height)){
+    return option(utf8_string("Unsupported png-height"));
   }
+  return no_option();
+}
 
-  try {
-    // Read the data into a faint-Bitmap
-    Bitmap bmp(IntSize(static_cast<int>(width), static_cast<int>(height)));
-    auto* p = bmp.GetRaw();
-    const auto bmpStride = bmp.GetStride();
-    const auto bmpByPP = ByPP;
-    const png_uint_32 PNG_ByPP = convert(pngBitsPerPixel / 8);
+OrError<Bitmap_and_tEXt> read_png_meta(const FilePath& path){
+  PngInfo info;
+  Bitmap bmp;
+  PngReadResult result = read_with_libpng(path,
+    info,
+    [](const PngInfo& info){
+      return unsupported(info).NotSet();
+    },
+    bmp);
 
-    if (gray_or_gray_alpha(colorType)){
-      // Read GRAY
+  if (result == PngReadResult::ERROR_UNSUPPORTED){
+    return unsupported(info).Get();
+  }
+  else if (result != PngReadResult::OK){
+    return to_string(result, path);
+  }
 
-      for (png_uint_32 y = 0; y < height; y++){
-        const auto* row = rows + y * width * PNG_ByPP;
-        for (png_uint_32 x = 0; x < width; x++){
-          auto i =  y * bmpStride + x * bmpByPP;
-          const png_byte v = row[x * PNG_ByPP];
-          p[i + faint::iR] = v;
-          p[i + faint::iG] = v;
-          p[i + faint::iB] = v;
-          p[i + faint::iA] = (colorType == PNG_COLOR_TYPE_GRAY_ALPHA) ?
-            row[x * PNG_ByPP + 1] : faint::CHANNEL_MAX;
-        }
-      }
+  return {Bitmap_and_tEXt(std::move(bmp), std::move(info.textChunks))};
+}
+
+OrError<Bitmap> read_png(const FilePath& p){
+  return read_png_meta(p).Visit(
+    [](Bitmap_and_tEXt& result){
+      return OrError<Bitmap>(std::move(result.bmp));
+    },
+    [](const utf8_string& error){
+      return OrError<Bitmap>(error);
+    });
+}
+
+class PngCache : public LazyBitmap{
+  // The pixels of a decoded png, in a memory mapped cache file with
+  // the rows in the Bitmap pixel format.
+public:
+  PngCache(const IntSize& size,
+    std::unique_ptr<MappedFile>&& file,
+    const FilePath& path)
+    : m_file(std::move(file)),
+      m_path(path),
+      m_size(size)
+  {}
+
+  ~PngCache() override{
+    m_file.reset();
+    faint_remove(m_path);
+  }
+
+  IntSize GetSize() const override{
+    return m_size;
+  }
+
+  void ReadPixels(int x, int y, int count, int step,
+    uchar* dst) const override
+  {
+    const uchar* row = m_file->GetData() +
+      (to_size_t(y) * to_size_t(m_size.w) + to_size_t(x)) * ByPP;
+    if (step == 1){
+      memcpy(dst, row, to_size_t(count * ByPP));
+      return;
     }
-    else if (rgb_or_rgba(colorType)){
-      // Read RGB or RGBA
-
-      if (PNG_ByPP == 3 || PNG_ByPP == 4){
-        for (png_uint_32 y = 0; y < height; y++){
-          const auto* row = rows + y * width * PNG_ByPP;
-          for (png_uint_32 x = 0; x < width; x++){
-            auto i =  y * bmpStride + x * bmpByPP;
-            p[i + faint::iR] = row[x * PNG_ByPP];
-            p[i + faint::iG] = row[x * PNG_ByPP + 1];
-            p[i + faint::iB] = row[x * PNG_ByPP + 2];
-            if (PNG_ByPP == 3){
-              p[i + faint::iA] = 255;
-            }
-            else{
-              p[i + faint::iA] = row[x * PNG_ByPP + 3];
-            }
-          }
-        }
-      }
-      else if (PNG_ByPP == 8){
-        // Note: Discards the least significant byte for each channel,
-        // since Faint-bitmaps use 4 ByPP.
-        for (png_uint_32 y = 0; y < height; y++){
-          const auto* row = rows + y * width * PNG_ByPP;
-          for (png_uint_32 x = 0; x < width; x++){
-            auto i =  y * bmpStride + x * bmpByPP;
-            const std::uint16_t r = std::uint16_t(row[x * PNG_ByPP + 0] << 8) |
-              std::uint16_t(row[x * PNG_ByPP + 1]);
-
-            const std::uint16_t g = std::uint16_t(row[x * PNG_ByPP + 2]) << 8  |
-              std::uint16_t(row[x * PNG_ByPP + 3]);
-
-            const std::uint16_t b = std::uint16_t(row[x * PNG_ByPP + 4]) << 8 |
-              std::uint16_t(row[x * PNG_ByPP + 5]);
-
-            const std::uint16_t a = std::uint16_t(row[x * PNG_ByPP + 6]) << 8 |
-              std::uint16_t(row[x * PNG_ByPP + 7]);
-
-            p[i + faint::iR] = r >> 8;
-            p[i + faint::iG] = g >> 8;
-            p[i + faint::iB] = b >> 8;
-            p[i + faint::iA] = a >> 8;
-          }
-        }
-      }
+    for (int i = 0; i != count; i++){
+      memcpy(dst + i * ByPP, row + i * step * ByPP, ByPP);
     }
-    else if (palettized(colorType)){
-
+  }
 
-      for (png_uint_32 y = 0; y < height; y++){
-        const auto* row = rows + y * width * PNG_ByPP;
+  PngCache(const PngCache&) = delete;
+  PngCache& operator=(const PngCache&) = delete;
+private:
+  std::unique_ptr<MappedFile> m_file;
+  FilePath m_path;
+  IntSize m_size;
+};
 
-        for (png_uint_32 x = 0; x < width; x++){
-          auto i = y * bmpStride + x * bmpByPP;
-          auto paletteIndex = row[x * PNG_ByPP]; // PNG_ByPP Should be 1 probably.
-          auto color = palette[paletteIndex];
+std::shared_ptr<LazyBitmap> lazy_png(const FilePath& path,
+  int minArea,
+  const cache_path_func& getCachePath)
+{
+  Optional<FilePath> cachePath;
+  FILE* f = nullptr;
+  std::vector<png_byte> row;
+  bool writeFailed = false;
+
+  auto write_row = [&](){
+    writeFailed = writeFailed || fwrite(row.data(), 1, row.size(), f) !=
+      row.size();
+  };
 
-          p[i + faint::iR] = color.red;
-          p[i + faint::iG] = color.green;
-          p[i + faint::iB] = color.blue;
-          p[i + faint::iA] = paletteIndex < paletteAlpha.size() ?
-            paletteAlpha[paletteIndex] :
-            255;
-        }
+  PngInfo info;
+  PngReadResult result = read_png_rows(path,
+    info,
+    [&](const PngInfo& info){
+      if (unsupported(info).IsSet() || info.interlaced ||
+        !can_represent<int>(info.width) || !can_represent<int>(info.height) ||
+        area_less(IntSize(static_cast<int>(info.width),
+          static_cast<int>(info.height)), minArea))
+      {
+        return false;
+      }
+      cachePath = getCachePath();
+      if (cachePath.NotSet()){
+        return false;
+      }
+      f = faint_fopen_write_binary(cachePath.Get());
+      row.resize(info.width * ByPP);
+      return f != nullptr;
+    },
+    [&](png_uint_32 y){
+      // The rows are requested in order, so the previous row is done.
+      if (y != 0){
+        write_row();
       }
+      return row.data();
+    });
+
+  if (f != nullptr){
+    if (result == PngReadResult::OK){
+      write_row();
     }
-    free(rows);
-    return {Bitmap_and_tEXt(std::move(bmp), std::move(textChunks))};
+    writeFailed = fclose(f) != 0 || writeFailed;
   }
-  catch (const BitmapException& e){
-    free(rows);
-    return {e.what()};
+
+  std::unique_ptr<MappedFile> file;
+  if (result == PngReadResult::OK && !writeFailed){
+    file = map_file(cachePath.Get());
+  }
+  if (file == nullptr){
+    if (cachePath.IsSet()){
+      faint_remove(cachePath.Get());
+    }
+    return nullptr;
   }
-}
 
-OrError<Bitmap> read_png(const FilePath& p){
-  return read_png_meta(p).Visit(
-    [](const Bitmap_and_tEXt& result){
-      return OrError<Bitmap>(result.bmp);
-    },
-    [](const utf8_string& error){
-      return OrError<Bitmap>(error);
-    });
+  return std::make_shared<PngCache>(IntSize(static_cast<int>(info.width),
+    static_cast<int>(info.height)), std::move(file), cachePath.Get());
 }
 
 static utf8_string to_string(PngWriteResult result, const FilePath& p){
@@ -321,10 +327,13 @@ static utf8_string to_string(PngWriteResult result, const FilePath& p){
     return failed_write_libpng("png_write_info");
   }
   else if (result == R::ERROR_WRITE_DATA){
-    return failed_write_libpng("png_write_image");
+    return failed_write_libpng("png_write_chunk (IDAT)");
   }
   else if (result == R::ERROR_WRITE_END){
-    return failed_write_libpng("png_write_end");
+    return failed_write_libpng("png_write_chunk (IEND)");
+  }
+  else if (result == R::ERROR_COMPRESS){
+    return failed_write("Compressing the image data failed.");
   }
   else if (result == R::ERROR_WRITE_TEXT_KEY_ENCODING){
     return failed_write(endline_sep("A specified tEXt-chunk key was not ascii.",
@@ -349,17 +358,27 @@ static utf8_string to_string(PngWriteResult result, const FilePath& p){
 SaveResult write_png(const FilePath& path,
   const Bitmap& bmp,
   PngColorType colorType,
-  const png_tEXt_map& textChunks)
+  const png_tEXt_map& textChunks,
+  const PngOptions& options)
 {
   PngWriteResult result = write_with_libpng(path, bmp,
     to_png_color_type(colorType),
-    textChunks);
+    textChunks,
+    options);
 
   return result == PngWriteResult::OK ?
     SaveResult::SaveSuccessful() :
     SaveResult::SaveFailed(to_string(result, path));
 }
 
+SaveResult write_png(const FilePath& path,
+  const Bitmap& bmp,
+  PngColorType colorType,
+  const png_tEXt_map& textChunks)
+{
+  return write_png(path, bmp, colorType, textChunks, PngOptions());
+}
+
 SaveResult write_png(const FilePath& path,
   const Bitmap& bmp,
   PngColorType colorType)
@@ -15,15 +15,21 @@
 
 #ifndef FAINT_FILE_PNG_HH
 #define FAINT_FILE_PNG_HH
+#include <functional>
 #include <map>
+#include <memory>
 #include "bitmap/bitmap.hh"
+#include "formats/mapped-file.hh"
 #include "formats/save-result.hh"
 #include "text/utf8-string.hh"
 #include "util-wx/file-path.hh"
+#include "util/optional.hh"
 #include "util/or-error.hh"
 
 namespace faint{
 
+class LazyBitmap;
+
 enum class PngColorType : int {
   MIN_VALUE = 0,
 
@@ -35,6 +41,29 @@ enum class PngColorType : int {
   MAX_VALUE = GRAY_ALPHA
 };
 
+// The filter applied to each row before compression. The values
+// match the png filter types, except ADAPTIVE which selects the
+// filter with the smallest sum of absolute differences per row.
+enum class PngFilter : int {
+  MIN_VALUE = 0,
+
+  NONE = MIN_VALUE,
+  SUB = 1,
+  UP = 2,
+  AVERAGE = 3,
+  PAETH = 4,
+  ADAPTIVE = 5,
+
+  MAX_VALUE = ADAPTIVE
+};
+
+class PngOptions{
+public:
+  // The zlib compression level, 0 (none) to 9 (best).
+  int compressionLevel = 6;
+  PngFilter filter = PngFilter::ADAPTIVE;
+};
+
 // Map of png tEXt keys to values
 using png_tEXt_map = std::map<utf8_string, utf8_string>;
 
@@ -55,6 +84,17 @@ OrError<Bitmap> read_png(const FilePath&);
 // value pairs.
 OrError<Bitmap_and_tEXt> read_png_meta(const FilePath&);
 
+// Decodes a non-interlaced png-file with at least minArea pixels to
+// an uncompressed cache file, which is memory mapped for reading the
+// pixels on demand. The cache file is removed when the LazyBitmap is
+// destroyed.
+//
+// Returns nullptr if the image is smaller, interlaced or unsupported,
+// or fails to decode, in which case read_png should be used instead.
+std::shared_ptr<LazyBitmap> lazy_png(const FilePath&,
+  int minArea,
+  const cache_path_func&);
+
 // Writes a Bitmap to a png-file.
 SaveResult write_png(const FilePath&, const
   Bitmap&,
@@ -67,6 +107,14 @@ SaveResult write_png(const FilePath&,
   PngColorType,
   const png_tEXt_map&);
 
+// Writes a Bitmap to a png-file with the given compression settings.
+// The image data is compressed in strips on multiple threads.
+SaveResult write_png(const FilePath&,
+  const Bitmap&,
+  PngColorType,
+  const png_tEXt_map&,
+  const PngOptions&);
+
 const utf8_string get_libpng_version();
 
 } // namespace
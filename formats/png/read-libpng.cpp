@@ -14,7 +14,9 @@
 // permissions and limitations under the License.
 
 #include <cstring> // std::strlen
+#include "bitmap/bitmap-exception.hh"
 #include "formats/faint-fopen.hh"
+#include "formats/png/png-util.hh"
 #include "formats/png/read-libpng.hh"
 
 #ifdef _MSC_VER
@@ -23,16 +25,80 @@
 
 namespace faint{
 
-PngReadResult read_with_libpng(const FilePath& path,
-  png_byte** rows,
-  png_uint_32* width,
-  png_uint_32* height,
-  png_byte* colorType,
-  png_byte* bitDepth,
-  int* bitsPerPixel,
-  std::vector<png_color>& palette,
-  std::vector<png_byte>& paletteAlpha,
-  std::map<utf8_string, utf8_string>& textChunks)
+class ReadStructGuard{
+  // Destroys the libpng read and info structs and closes the file
+  // when leaving the scope.
+public:
+  ReadStructGuard(png_structp& png_ptr, png_infop& info_ptr, FILE* f)
+    : m_png_ptr(png_ptr),
+      m_info_ptr(info_ptr),
+      m_file(f)
+  {}
+
+  ~ReadStructGuard(){
+    png_destroy_read_struct(&m_png_ptr, &m_info_ptr, nullptr);
+    fclose(m_file);
+  }
+
+  ReadStructGuard(const ReadStructGuard&) = delete;
+  ReadStructGuard& operator=(const ReadStructGuard&) = delete;
+private:
+  png_structp& m_png_ptr;
+  png_infop& m_info_ptr;
+  FILE* m_file;
+};
+
+static void read_text_chunks(png_structp png_ptr,
+  png_infop info_ptr,
+  png_tEXt_map& textChunks)
+{
+  png_textp textPtr;
+  int numText;
+  if (png_get_text(png_ptr, info_ptr, &textPtr, &numText) > 0){
+    for (int i = 0; i != numText; i++){
+      const auto& text(textPtr[i]);
+      auto len = std::strlen(text.key);
+      if (len == 0 || len > PNG_KEYWORD_MAX_LENGTH){
+        continue; // Fixme: Signal error
+      }
+      if (strlen(text.text) != text.text_length){
+        continue; // Fixme: Signal error
+      }
+      utf8_string key(text.key);
+      utf8_string value(text.text);
+
+      textChunks[key] = value;
+    }
+  }
+}
+
+static void set_bitmap_transforms(png_structp png_ptr, const PngInfo& info){
+  // Makes libpng output 8-bit rows in the pixel format of a Bitmap.
+  if (palettized(info.colorType)){
+    // Also expands the tRNS-chunk, if any, to alpha.
+    png_set_palette_to_rgb(png_ptr);
+  }
+  else if (gray_or_gray_alpha(info.colorType)){
+    png_set_gray_to_rgb(png_ptr);
+  }
+
+  if (info.bitDepth == 16){
+    // Discards the least significant byte for each channel.
+    png_set_strip_16(png_ptr);
+  }
+
+  // Opaque alpha for color types without alpha
+  png_set_filler(png_ptr, 0xff, PNG_FILLER_AFTER);
+
+  static_assert(iB == 0 && iG == 1 && iR == 2 && iA == 3,
+    "Unexpected Bitmap channel order");
+  png_set_bgr(png_ptr);
+}
+
+PngReadResult read_png_rows(const FilePath& path,
+  PngInfo& info,
+  const png_accept_func& accept,
+  const png_row_func& rowDst)
 {
   FILE* f = faint_fopen_read_binary(path);
   if (f == nullptr){
@@ -59,17 +125,15 @@ PngReadResult read_with_libpng(const FilePath& path,
     return PngReadResult::ERROR_CREATE_READ_STRUCT;
   }
 
-  png_infop info_ptr = png_create_info_struct(png_ptr);
+  png_infop info_ptr = nullptr;
+  ReadStructGuard guard(png_ptr, info_ptr, f);
+
+  info_ptr = png_create_info_struct(png_ptr);
   if (info_ptr == nullptr){
-    png_destroy_read_struct(&png_ptr, nullptr, nullptr);
-    fclose(f);
     return PngReadResult::ERROR_CREATE_INFO_STRUCT;
   }
 
   if (setjmp(png_jmpbuf(png_ptr))){
-    // Fixme: Pass end_info
-    png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
-    fclose(f);
     return PngReadResult::ERROR_INIT_IO;
   }
 
@@ -77,92 +141,80 @@ PngReadResult read_with_libpng(const FilePath& path,
   png_set_sig_bytes(png_ptr, 8);
   png_read_info(png_ptr, info_ptr);
 
-  png_textp textPtr;
-  int numText;
-  if (png_get_text(png_ptr, info_ptr, &textPtr, &numText) > 0){
-    for (int i = 0; i != numText; i++){
-      const auto& text(textPtr[i]);
-      auto len = std::strlen(text.key);
-      if (len == 0 || len > PNG_KEYWORD_MAX_LENGTH){
-        continue; // Fixme: Signal error
-      }
-      if (strlen(text.text) != text.text_length){
-        continue; // Fixme: Signal error
-      }
-      utf8_string key(text.key);
-      utf8_string value(text.text);
+  read_text_chunks(png_ptr, info_ptr, info.textChunks);
 
-      textChunks[key] = value;
-    }
-  }
+  info.width = png_get_image_width(png_ptr, info_ptr);
+  info.height = png_get_image_height(png_ptr, info_ptr);
+  info.colorType = png_get_color_type(png_ptr, info_ptr);
+  info.bitDepth = png_get_bit_depth(png_ptr, info_ptr);
+  info.bitsPerPixel = info.bitDepth * png_get_channels(png_ptr, info_ptr);
+  info.interlaced =
+    png_get_interlace_type(png_ptr, info_ptr) != PNG_INTERLACE_NONE;
 
-  *width = png_get_image_width(png_ptr, info_ptr);
-  *height = png_get_image_height(png_ptr, info_ptr);
+  if (!accept(info)){
+    return PngReadResult::ERROR_UNSUPPORTED;
+  }
 
-  *colorType = png_get_color_type(png_ptr, info_ptr);
-  *bitDepth = png_get_bit_depth(png_ptr, info_ptr);
-  *bitsPerPixel = *bitDepth * png_get_channels(png_ptr, info_ptr);
+  if (palettized(info.colorType)){
+    png_color* palette;
+    int numPalette = 0;
+    auto result = png_get_PLTE(png_ptr, info_ptr, &palette, &numPalette);
+    if (result != PNG_INFO_PLTE || numPalette == 0){
+      return PngReadResult::ERROR_READ_PALETTE;
+    }
+  }
 
-  png_set_interlace_handling(png_ptr); // Fixme: returned num_passes irrelevant?
+  set_bitmap_transforms(png_ptr, info);
+  const int passes = png_set_interlace_handling(png_ptr);
   png_read_update_info(png_ptr, info_ptr);
 
-  if (setjmp(png_jmpbuf(png_ptr))){
-    png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
-    fclose(f);
-    return PngReadResult::ERROR_READ_DATA;
-  }
-
   const auto rowBytes = png_get_rowbytes(png_ptr, info_ptr);
-  if (rowBytes == 0){
+  if (rowBytes != info.width * static_cast<png_uint_32>(ByPP)){
     return PngReadResult::ERROR_READ_DATA;
   }
 
-  *rows = (png_byte*) malloc(rowBytes * *height);
-  if (*rows == nullptr){
-    return PngReadResult::ERROR_MALLOC;
-  }
-  auto rowPointers = (png_byte**) malloc(sizeof(png_byte*) * (*height));
-  if (rowPointers == nullptr){
-    free(*rows);
-    return PngReadResult::ERROR_MALLOC;
-  }
-
-  for (png_uint_32 y = 0; y < (*height); y++){
-    rowPointers[y] = *rows + y * rowBytes;
+  if (setjmp(png_jmpbuf(png_ptr))){
+    return PngReadResult::ERROR_READ_DATA;
   }
 
-  png_read_image(png_ptr, rowPointers);
-  // Fixme: Read post-image-data
-  if (*colorType == PNG_COLOR_TYPE_PALETTE){
-    {
-      // Read palette
-      png_color* tempPalette;
-      int numPalette = 0;
-      auto result = png_get_PLTE(png_ptr, info_ptr, &tempPalette, &numPalette);
-
-      if (result != PNG_INFO_PLTE || numPalette == 0){
-        return PngReadResult::ERROR_READ_PALETTE;
-      }
-
-      palette.assign(tempPalette, tempPalette + numPalette);
-    }
-
-
-    if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS)){
-      // Read tRNS
-      int num_trans;
-      unsigned char* trans = nullptr;
-      png_color_16* trans_values = nullptr;
-      png_get_tRNS(png_ptr, info_ptr, &trans, &num_trans, &trans_values);
-
-      paletteAlpha.assign(trans, trans + num_trans);
+  // For interlaced images, libpng combines each pass with the
+  // earlier passes in the destination row.
+  for (int pass = 0; pass != passes; pass++){
+    for (png_uint_32 y = 0; y != info.height; y++){
+      png_read_row(png_ptr, rowDst(y), nullptr);
     }
   }
-
-  png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
-  fclose(f);
-  free(rowPointers);
+  // Fixme: Read post-image-data
   return PngReadResult::OK;
 }
 
+PngReadResult read_with_libpng(const FilePath& path,
+  PngInfo& info,
+  const png_accept_func& accept,
+  Bitmap& bmp)
+{
+  bool mallocFailed = false;
+  auto result = read_png_rows(path, info,
+    [&](const PngInfo& info){
+      if (!accept(info)){
+        return false;
+      }
+      try{
+        bmp = Bitmap(IntSize(static_cast<int>(info.width),
+          static_cast<int>(info.height)));
+      }
+      catch (const BitmapException&){
+        mallocFailed = true;
+        return false;
+      }
+      return true;
+    },
+    [&](png_uint_32 y){
+      // Decode directly into the Bitmap rows
+      return bmp.GetRaw() + y * static_cast<png_uint_32>(bmp.GetStride());
+    });
+
+  return mallocFailed ? PngReadResult::ERROR_MALLOC : result;
+}
+
 } // namespace
@@ -15,6 +15,7 @@
 
 #ifndef FAINT_READ_LIBPNG_HH
 #define FAINT_READ_LIBPNG_HH
+#include <functional>
 #include <png.h> // libpng
 #include "formats/png/file-png.hh"
 
@@ -29,19 +30,45 @@ enum class PngReadResult{
   ERROR_INIT_IO,
   ERROR_READ_DATA,
   ERROR_READ_PALETTE,
-  ERROR_MALLOC
+  ERROR_MALLOC,
+  ERROR_UNSUPPORTED
 };
 
+class PngInfo{
+  // The png header information, and the tEXt chunks preceding the
+  // image data.
+public:
+  png_uint_32 width = 0;
+  png_uint_32 height = 0;
+  png_byte colorType = 0;
+  png_byte bitDepth = 0;
+  int bitsPerPixel = 0;
+  bool interlaced = false;
+  png_tEXt_map textChunks;
+};
+
+// Returns true if the image described by the PngInfo should be read.
+using png_accept_func = std::function<bool(const PngInfo&)>;
+
+// Returns the destination for decoding row y, with room for width
+// pixels in the Bitmap pixel format. Called for each row in order,
+// and again for each pass for interlaced images.
+using png_row_func = std::function<png_bytep(png_uint_32 y)>;
+
+// Reads the png header into the PngInfo and, if accepted, decodes the
+// image directly into the Bitmap. Returns ERROR_UNSUPPORTED if not
+// accepted.
 PngReadResult read_with_libpng(const FilePath&,
-  png_byte** rows,
-  png_uint_32* width,
-  png_uint_32* height,
-  png_byte* colorType,
-  png_byte* bitDepth,
-  int* bitsPerPixel,
-  std::vector<png_color>& palette,
-  std::vector<png_byte>& paletteAlpha,
-  std::map<utf8_string, utf8_string>& textChunks);
+  PngInfo&,
+  const png_accept_func&,
+  Bitmap&);
+
+// Reads the png header into the PngInfo and, if accepted, decodes the
+// image one row at a time to the destinations from the png_row_func.
+PngReadResult read_png_rows(const FilePath&,
+  PngInfo&,
+  const png_accept_func&,
+  const png_row_func&);
 
 } // namespace
 
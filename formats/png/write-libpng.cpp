@@ -13,11 +13,19 @@
 // implied. See the License for the specific language governing
 // permissions and limitations under the License.
 
+#include <algorithm>
+#include <cassert>
+#include <cstdlib> // abs
+#include <cstring> // memcpy
+#include <vector>
 #include <png.h> // libpng
+#include <zlib.h>
 #include "formats/faint-fopen.hh"
 #include "formats/png/png-util.hh"
 #include "formats/png/write-libpng.hh"
 #include "geo/limits.hh"
+#include "geo/primitive.hh"
+#include "util/parallel.hh"
 
 #ifdef _MSC_VER
 #pragma warning(disable:4611) // _setjmp and C++-object destruction
@@ -25,15 +33,344 @@
 
 namespace faint{
 
+// The size of the deflate window. Each strip is compressed with the
+// filtered data preceding it as dictionary, so that the compression
+// is nearly as good as when compressing all data at once.
+static const size_t DEFLATE_WINDOW = 32768;
+
+// Approximate number of filtered bytes compressed per strip.
+static const size_t STRIP_BYTES = 256 * 1024;
+
+// Bytes per range for parallel_for when filtering rows.
+static const int MIN_BYTES_PER_RANGE = 64 * 1024;
+
+using png_bytes = std::vector<png_byte>;
+
 static png_byte gray_sum(int r, int g, int b){
   return static_cast<png_byte>((r + g + b) / 3);
 }
 
-static void free_rows(png_bytep* rowPointers, png_uint_32 height){
-  for (png_uint_32 y = 0; y != height; y++){
-    free(rowPointers[y]);
+static size_t png_bytes_per_pixel(int colorType){
+  switch (colorType){
+  case PNG_COLOR_TYPE_RGB_ALPHA: return 4;
+  case PNG_COLOR_TYPE_RGB: return 3;
+  case PNG_COLOR_TYPE_GRAY_ALPHA: return 2;
+  case PNG_COLOR_TYPE_GRAY: return 1;
+  }
+  assert(false); // Unsupported color type
+  return 4;
+}
+
+static void convert_row(const Bitmap& bmp,
+  int y,
+  int colorType,
+  png_byte* row)
+{
+  // Converts a row of the Bitmap to the png pixel format.
+  const uchar* src = bmp.GetRaw() + y * bmp.GetStride();
+  const uchar* end = src + bmp.GetSize().w * ByPP;
+
+  if (colorType == PNG_COLOR_TYPE_RGB_ALPHA){
+    for (; src != end; src += ByPP, row += 4){
+      row[0] = src[iR];
+      row[1] = src[iG];
+      row[2] = src[iB];
+      row[3] = src[iA];
+    }
+  }
+  else if (colorType == PNG_COLOR_TYPE_RGB){
+    for (; src != end; src += ByPP, row += 3){
+      row[0] = src[iR];
+      row[1] = src[iG];
+      row[2] = src[iB];
+    }
+  }
+  else if (colorType == PNG_COLOR_TYPE_GRAY_ALPHA){
+    for (; src != end; src += ByPP, row += 2){
+      row[0] = gray_sum(src[iR], src[iG], src[iB]);
+      row[1] = src[iA];
+    }
+  }
+  else{
+    assert(colorType == PNG_COLOR_TYPE_GRAY);
+    for (; src != end; src += ByPP, row += 1){
+      row[0] = gray_sum(src[iR], src[iG], src[iB]);
+    }
+  }
+}
+
+static png_byte paeth(int a, int b, int c){
+  const int p = a + b - c;
+  const int pa = std::abs(p - a);
+  const int pb = std::abs(p - b);
+  const int pc = std::abs(p - c);
+  if (pa <= pb && pa <= pc){
+    return static_cast<png_byte>(a);
   }
-  free(rowPointers);
+  return static_cast<png_byte>(pb <= pc ? b : c);
+}
+
+static void filter_row(PngFilter filter,
+  const png_byte* prev,
+  const png_byte* cur,
+  png_byte* out,
+  size_t rowBytes,
+  size_t bpp)
+{
+  // Writes the filter type followed by the filtered row to out.
+  assert(filter != PngFilter::ADAPTIVE);
+  *out++ = static_cast<png_byte>(filter);
+
+  auto left = [&](size_t i) -> int{
+    return i < bpp ? 0 : cur[i - bpp];
+  };
+
+  switch (filter){
+  case PngFilter::NONE:
+    memcpy(out, cur, rowBytes);
+    break;
+
+  case PngFilter::SUB:
+    for (size_t i = 0; i != rowBytes; i++){
+      out[i] = static_cast<png_byte>(cur[i] - left(i));
+    }
+    break;
+
+  case PngFilter::UP:
+    for (size_t i = 0; i != rowBytes; i++){
+      out[i] = static_cast<png_byte>(cur[i] - prev[i]);
+    }
+    break;
+
+  case PngFilter::AVERAGE:
+    for (size_t i = 0; i != rowBytes; i++){
+      out[i] = static_cast<png_byte>(cur[i] - (left(i) + prev[i]) / 2);
+    }
+    break;
+
+  case PngFilter::PAETH:
+    for (size_t i = 0; i != rowBytes; i++){
+      const int upLeft = i < bpp ? 0 : prev[i - bpp];
+      out[i] = static_cast<png_byte>(cur[i] - paeth(left(i), prev[i], upLeft));
+    }
+    break;
+
+  case PngFilter::ADAPTIVE:
+    break;
+  }
+}
+
+static size_t filter_cost(const png_byte* filtered, size_t rowBytes){
+  // The sum of the absolute values of the filtered bytes as signed
+  // values, the heuristic suggested by the png specification.
+  size_t sum = 0;
+  for (size_t i = 1; i <= rowBytes; i++){
+    sum += filtered[i] < 128 ? filtered[i] : 256u - filtered[i];
+  }
+  return sum;
+}
+
+static void filter_row_adaptive(const png_byte* prev,
+  const png_byte* cur,
+  png_byte* out,
+  png_byte* scratch,
+  size_t rowBytes,
+  size_t bpp)
+{
+  png_byte* best = out;
+  png_byte* candidate = scratch;
+
+  filter_row(PngFilter::NONE, prev, cur, best, rowBytes, bpp);
+  size_t bestCost = filter_cost(best, rowBytes);
+
+  for (auto filter : {PngFilter::SUB, PngFilter::UP, PngFilter::AVERAGE,
+    PngFilter::PAETH})
+  {
+    filter_row(filter, prev, cur, candidate, rowBytes, bpp);
+    const size_t cost = filter_cost(candidate, rowBytes);
+    if (cost < bestCost){
+      bestCost = cost;
+      std::swap(best, candidate);
+    }
+  }
+
+  if (best != out){
+    memcpy(out, best, rowBytes + 1);
+  }
+}
+
+static void filter_rows(const Bitmap& bmp,
+  int colorType,
+  PngFilter filter,
+  int first,
+  int last,
+  png_byte* filtered)
+{
+  // Converts and filters the rows [first, last) into filtered, which
+  // holds the filter type byte and filtered data for every row.
+  const size_t bpp = png_bytes_per_pixel(colorType);
+  const size_t rowBytes = to_size_t(bmp.GetSize().w) * bpp;
+
+  png_bytes prev(rowBytes, 0);
+  png_bytes cur(rowBytes);
+  png_bytes scratch(rowBytes + 1);
+
+  if (first != 0){
+    convert_row(bmp, first - 1, colorType, prev.data());
+  }
+
+  for (int y = first; y != last; y++){
+    convert_row(bmp, y, colorType, cur.data());
+    png_byte* out = filtered + to_size_t(y) * (rowBytes + 1);
+    if (filter == PngFilter::ADAPTIVE){
+      filter_row_adaptive(prev.data(), cur.data(), out, scratch.data(),
+        rowBytes, bpp);
+    }
+    else{
+      filter_row(filter, prev.data(), cur.data(), out, rowBytes, bpp);
+    }
+    std::swap(prev, cur);
+  }
+}
+
+class CompressedStrip{
+public:
+  png_bytes data;
+  uLong adler = 0;
+  size_t numBytes = 0;
+  bool ok = false;
+};
+
+static bool deflate_strip(const png_byte* filtered,
+  size_t offset,
+  size_t numBytes,
+  bool last,
+  const PngOptions& options,
+  CompressedStrip& strip)
+{
+  // Compresses a strip of the filtered data as raw deflate-data which
+  // can be concatenated with the preceding strip. Only the last strip
+  // terminates the deflate-stream.
+  const int strategy = options.filter == PngFilter::NONE ?
+    Z_DEFAULT_STRATEGY : Z_FILTERED;
+
+  z_stream z{};
+  if (deflateInit2(&z, options.compressionLevel, Z_DEFLATED, -15, 8,
+    strategy) != Z_OK)
+  {
+    return false;
+  }
+
+  const png_byte* src = filtered + offset;
+  const size_t dictBytes = std::min(offset, DEFLATE_WINDOW);
+  if (dictBytes != 0 && deflateSetDictionary(&z, src - dictBytes,
+    static_cast<uInt>(dictBytes)) != Z_OK)
+  {
+    deflateEnd(&z);
+    return false;
+  }
+
+  strip.data.resize(deflateBound(&z, numBytes) + 16);
+  z.next_in = const_cast<png_byte*>(src);
+  z.avail_in = static_cast<uInt>(numBytes);
+  z.next_out = strip.data.data();
+  z.avail_out = static_cast<uInt>(strip.data.size());
+
+  for (;;){
+    const int result = deflate(&z, last ? Z_FINISH : Z_SYNC_FLUSH);
+    if (result == Z_STREAM_END ||
+      (!last && result == Z_OK && z.avail_out != 0))
+    {
+      break;
+    }
+    if (result != Z_OK && result != Z_BUF_ERROR){
+      deflateEnd(&z);
+      return false;
+    }
+
+    // Out of output space
+    const size_t used = z.total_out;
+    strip.data.resize(strip.data.size() * 2);
+    z.next_out = strip.data.data() + used;
+    z.avail_out = static_cast<uInt>(strip.data.size() - used);
+  }
+
+  strip.data.resize(z.total_out);
+  deflateEnd(&z);
+  strip.adler = adler32(adler32(0L, Z_NULL, 0), src,
+    static_cast<uInt>(numBytes));
+  strip.numBytes = numBytes;
+  return true;
+}
+
+static png_bytes zlib_header(int level){
+  // CMF: deflate with a 32K window, FLG: compression level hint and
+  // check bits.
+  const int cmf = 0x78;
+  const int levelHint = level < 2 ? 0 :
+    level < 6 ? 1 :
+    level == 6 ? 2 : 3;
+  int flg = levelHint << 6;
+  flg += (31 - (cmf * 256 + flg) % 31) % 31;
+  return {static_cast<png_byte>(cmf), static_cast<png_byte>(flg)};
+}
+
+static bool compress_image_data(const Bitmap& bmp,
+  int colorType,
+  const PngOptions& options,
+  std::vector<CompressedStrip>& strips)
+{
+  // Filters the image rows and compresses them into a zlib-stream,
+  // split over the data of the strips, in parallel.
+  const IntSize size(bmp.GetSize());
+  const size_t rowBytes =
+    to_size_t(size.w) * png_bytes_per_pixel(colorType) + 1;
+
+  png_bytes filtered(rowBytes * to_size_t(size.h));
+  parallel_for(size.h, MIN_BYTES_PER_RANGE / resigned(rowBytes) + 1,
+    [&](int first, int last){
+      filter_rows(bmp, colorType, options.filter, first, last,
+        filtered.data());
+    });
+
+  const int rowsPerStrip =
+    std::max(1, resigned(STRIP_BYTES / rowBytes));
+  const int numStrips = (size.h + rowsPerStrip - 1) / rowsPerStrip;
+  strips.resize(to_size_t(numStrips));
+
+  parallel_for(numStrips, 1,
+    [&](int first, int last){
+      for (int i = first; i != last; i++){
+        const int y0 = i * rowsPerStrip;
+        const int y1 = std::min(y0 + rowsPerStrip, size.h);
+        auto& strip = strips[to_size_t(i)];
+        strip.ok = deflate_strip(filtered.data(),
+          to_size_t(y0) * rowBytes,
+          to_size_t(y1 - y0) * rowBytes,
+          i == numStrips - 1,
+          options,
+          strip);
+      }
+    });
+
+  uLong adler = adler32(0L, Z_NULL, 0);
+  for (const auto& strip : strips){
+    if (!strip.ok){
+      return false;
+    }
+    adler = adler32_combine(adler, strip.adler,
+      static_cast<z_off_t>(strip.numBytes));
+  }
+
+  auto header = zlib_header(options.compressionLevel);
+  auto& firstData = strips.front().data;
+  firstData.insert(begin(firstData), begin(header), end(header));
+
+  auto& lastData = strips.back().data;
+  for (int shift = 24; shift >= 0; shift -= 8){
+    lastData.push_back(static_cast<png_byte>((adler >> shift) & 0xff));
+  }
+  return true;
 }
 
 static PngWriteResult init_text_chunks(const png_tEXt_map& textChunks,
@@ -96,13 +433,45 @@ static PngWriteResult write_text_chunks(png_structp png_ptr,
   return result;
 }
 
+class WriteStructGuard{
+  // Destroys the libpng write and info structs when leaving the scope.
+public:
+  WriteStructGuard(png_structp& png_ptr, png_infop& info_ptr)
+    : m_png_ptr(png_ptr),
+      m_info_ptr(info_ptr)
+  {}
+
+  ~WriteStructGuard(){
+    png_destroy_write_struct(&m_png_ptr, &m_info_ptr);
+  }
+
+  WriteStructGuard(const WriteStructGuard&) = delete;
+  WriteStructGuard& operator=(const WriteStructGuard&) = delete;
+private:
+  png_structp& m_png_ptr;
+  png_infop& m_info_ptr;
+};
+
 PngWriteResult write_with_libpng(const FilePath& path,
   const Bitmap& bmp,
   const int colorType,
-  const png_tEXt_map& textChunks)
+  const png_tEXt_map& textChunks,
+  const PngOptions& options)
 {
   assert(bitmap_ok(bmp));
   assert(rgb_or_rgba(colorType) || gray_or_gray_alpha(colorType));
+  assert(options.compressionLevel >= 0 && options.compressionLevel <= 9);
+
+  auto size(bmp.GetSize());
+  assert(size.w != 0 && size.h != 0);
+
+  // Compress the image data up front, instead of letting libpng
+  // compress it row by row, so that strips can be compressed in
+  // parallel.
+  std::vector<CompressedStrip> strips;
+  if (!compress_image_data(bmp, colorType, options, strips)){
+    return PngWriteResult::ERROR_COMPRESS;
+  }
 
   png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING,
     nullptr, nullptr, nullptr);
@@ -111,12 +480,15 @@ PngWriteResult write_with_libpng(const FilePath& path,
     return PngWriteResult::ERROR_CREATE_WRITE_STRUCT;
   }
 
+  png_infop info_ptr = nullptr;
+  WriteStructGuard guard(png_ptr, info_ptr);
+
   FILE* f = faint_fopen_write_binary(path);
   if (!f){
     return PngWriteResult::ERROR_OPEN_FILE;
   }
 
-  png_infop info_ptr = png_create_info_struct(png_ptr);
+  info_ptr = png_create_info_struct(png_ptr);
   if (info_ptr == nullptr){
     fclose(f);
     return PngWriteResult::ERROR_CREATE_INFO_STRUCT;
@@ -135,8 +507,6 @@ PngWriteResult write_with_libpng(const FilePath& path,
     return PngWriteResult::ERROR_WRITE_HEADER;
   }
 
-  auto size(bmp.GetSize());
-  assert(size.w != 0 && size.h != 0);
   const png_uint_32 width = convert(size.w);
   const png_uint_32 height = convert(size.h);
   const png_byte bitDepth = 8;
@@ -161,85 +531,23 @@ PngWriteResult write_with_libpng(const FilePath& path,
 
   png_write_info(png_ptr, info_ptr);
 
-  // Create raw-data arrays for libpng from the Bitmap.
-  png_byte** rowPointers = (png_bytep*) malloc(sizeof(png_bytep) * height);
-  const auto bytesPerRow = png_get_rowbytes(png_ptr, info_ptr);
-
-  if (rgb_or_rgba(colorType)){
-    // Write RGB or RGBA
-
-    const int PNG_ByPP = colorType == PNG_COLOR_TYPE_RGBA ? 4 : 3;
-    assert((width - 1) * PNG_ByPP + (PNG_ByPP - 1) < bytesPerRow);
-
-    const auto* src = bmp.GetRaw();
-    const png_uint_32 stride = convert(bmp.GetStride());
-    const png_uint_32 srcByPP = convert(ByPP);
-    for (png_uint_32 y = 0; y != height; y++){
-      auto row = (png_byte*) malloc(bytesPerRow);
-      rowPointers[y] = row;
-      for (png_uint_32 x = 0; x != width; x++){
-        // Fill the row with the bitmap-data
-        auto i = y * stride + x * srcByPP;
-        row[x * PNG_ByPP] = src[i + faint::iR];
-        row[x * PNG_ByPP + 1] = src[i + faint::iG];
-        row[x * PNG_ByPP + 2] = src[i + faint::iB];
-
-        if (PNG_ByPP == 4){
-          row[x * PNG_ByPP + 3] = src[i + faint::iA];
-        }
-      }
-    }
-  }
-
-  else if (gray_or_gray_alpha(colorType)){
-    // Write gray-scale
-
-    const int PNG_ByPP = colorType == PNG_COLOR_TYPE_GRAY_ALPHA ? 2 : 1;
-    assert((width - 1) * PNG_ByPP + (PNG_ByPP - 1) < bytesPerRow);
-
-    const auto* src = bmp.GetRaw();
-    const png_uint_32 stride = convert(bmp.GetStride());
-    const png_uint_32 srcByPP = convert(ByPP);
-
-    for (png_uint_32 y = 0; y != height; y++){
-      auto row = (png_byte*) malloc(bytesPerRow);
-      rowPointers[y] = row;
-
-      for (png_uint_32 x = 0; x != width; x++){
-        // Fill the row with the bitmap-data
-        const auto i = y * stride + x * srcByPP;
-
-        row[x * PNG_ByPP] = gray_sum(src[i + faint::iR],
-          src[i + faint::iG],
-          src[i + faint::iB]);
-        if (PNG_ByPP == 2){
-          row[x * PNG_ByPP + 1] = src[i + faint::iA];
-        }
-      }
-    }
-  }
-  else{
-    // Color type was checked earlier, so just assert.
-    assert(false); // Unsupported color type
-  }
-
-  // Write the image data
+  // Write the image data, one IDAT-chunk per strip
   if (setjmp(png_jmpbuf(png_ptr))){
-    free_rows(rowPointers, height);
     fclose(f);
     return PngWriteResult::ERROR_WRITE_DATA;
   }
-  png_write_image(png_ptr, rowPointers);
+  for (const auto& strip : strips){
+    png_write_chunk(png_ptr, (png_const_bytep)"IDAT",
+      strip.data.data(), strip.data.size());
+  }
 
   // Write end
   if (setjmp(png_jmpbuf(png_ptr))){
-    free_rows(rowPointers, height);
     fclose(f);
     return PngWriteResult::ERROR_WRITE_END;
   }
-  png_write_end(png_ptr, nullptr);
+  png_write_chunk(png_ptr, (png_const_bytep)"IEND", nullptr, 0);
 
-  free_rows(rowPointers, height);
   fclose(f);
   return PngWriteResult::OK;
 }
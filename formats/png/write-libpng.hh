@@ -29,6 +29,7 @@ enum class PngWriteResult{
   ERROR_WRITE_HEADER,
   ERROR_WRITE_DATA,
   ERROR_WRITE_END,
+  ERROR_COMPRESS,
   ERROR_WRITE_TEXT_KEY_ENCODING,
   ERROR_WRITE_TEXT_VALUE_ENCODING,
   ERROR_WRITE_TEXT_KEY_EMPTY,
@@ -40,7 +41,8 @@ enum class PngWriteResult{
 PngWriteResult write_with_libpng(const FilePath& path,
   const Bitmap&,
   const int colorType,
-  const png_tEXt_map& textChunks);
+  const png_tEXt_map& textChunks,
+  const PngOptions&);
 
 } // namespace faint
 
@@ -0,0 +1,217 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include "geo/bezier.hh"
+#include "geo/flat-path.hh"
+#include "geo/measure.hh"
+
+namespace faint{
+
+static int bezier_segments(const Point& from, const CubicBezier& b){
+  // Segments for a chord error well below a pixel, based on the
+  // length of the control polygon.
+  const coord length = distance(from, b.c) + distance(b.c, b.d) +
+    distance(b.d, b.p);
+  return std::max(4, std::min(128, static_cast<int>(length / 4.0) + 1));
+}
+
+Optional<polylines_t> flatten(const std::vector<PathPt>& path){
+  polylines_t polylines;
+  bool hasArc = false;
+  Point current(0, 0);
+
+  auto add_point = [&](const Point& p){
+    if (polylines.empty()){
+      polylines.emplace_back();
+      polylines.back().points.push_back(current);
+    }
+    if (p != polylines.back().points.back()){
+      polylines.back().points.push_back(p);
+    }
+    current = p;
+  };
+
+  for (const PathPt& pt : path){
+    pt.Visit(
+      [&](const ArcTo&){
+        hasArc = true;
+      },
+      [&](const Close&){
+        if (!polylines.empty()){
+          auto& pts = polylines.back().points;
+          if (pts.size() > 1 && pts.back() == pts.front()){
+            pts.pop_back();
+          }
+          polylines.back().closed = true;
+          const Point start = pts.front();
+          polylines.emplace_back();
+          polylines.back().points.push_back(start);
+          current = start;
+        }
+      },
+      [&](const CubicBezier& b){
+        const Point from(current);
+        const int n = bezier_segments(from, b);
+        for (int i = 1; i <= n; i++){
+          add_point(bezier_point(i / static_cast<coord>(n), from, b));
+        }
+      },
+      [&](const LineTo& l){
+        add_point(l.p);
+      },
+      [&](const MoveTo& m){
+        polylines.emplace_back();
+        polylines.back().points.push_back(m.p);
+        current = m.p;
+      });
+  }
+
+  if (hasArc){
+    return {};
+  }
+
+  polylines.erase(std::remove_if(begin(polylines), end(polylines),
+    [](const Polyline& p){
+      return p.points.size() < 2;
+    }), end(polylines));
+  return option(polylines);
+}
+
+bool inside_polylines(const polylines_t& polylines,
+  const Point& p,
+  bool evenOdd)
+{
+  int winding = 0;
+  int crossings = 0;
+  for (const Polyline& polyline : polylines){
+    const auto& pts = polyline.points;
+    for (size_t i = 0; i != pts.size(); i++){
+      const Point& a = pts[i];
+      const Point& b = pts[(i + 1) % pts.size()];
+      if ((a.y <= p.y) == (b.y <= p.y)){
+        continue;
+      }
+
+      // The x-coordinate where the edge crosses the horizontal line
+      // through the point.
+      const coord x = a.x + (p.y - a.y) * (b.x - a.x) / (b.y - a.y);
+      if (x > p.x){
+        crossings++;
+        winding += b.y > a.y ? 1 : -1;
+      }
+    }
+  }
+  return evenOdd ? crossings % 2 == 1 : winding != 0;
+}
+
+static coord distance_sq(const Point& p0, const Point& p1){
+  const coord dx = p1.x - p0.x;
+  const coord dy = p1.y - p0.y;
+  return dx * dx + dy * dy;
+}
+
+static Point unit_direction(const Point& from, const Point& to){
+  const coord length = distance(from, to);
+  return length == 0.0 ? Point(0, 0) : (to - from) / length;
+}
+
+static bool in_miter(const Point& prev,
+  const Point& v,
+  const Point& next,
+  const Point& p,
+  coord halfWidth)
+{
+  // Cairo's default miter limit
+  const coord miterLimit = 10.0;
+
+  const Point d0 = unit_direction(prev, v);
+  const Point d1 = unit_direction(v, next);
+  const coord cross = d0.x * d1.y - d0.y * d1.x;
+  const coord cosTurn = d0.x * d1.x + d0.y * d1.y;
+  if (std::fabs(cross) < 1e-9 ||
+    (1.0 + cosTurn) * miterLimit * miterLimit < 2.0)
+  {
+    // Straight or beveled, the round join covers the join
+    return false;
+  }
+
+  // The normals on the outer side of the turn
+  const coord s = cross > 0 ? -1.0 : 1.0;
+  const Point n0(-s * d0.y, s * d0.x);
+  const Point n1(-s * d1.y, s * d1.x);
+  const Point tip = v + (n0 + n1) * (halfWidth / (1.0 + cosTurn));
+
+  Polyline miter;
+  miter.points = {v, v + n0 * halfWidth, tip, v + n1 * halfWidth};
+  return inside_polylines({miter}, p, false);
+}
+
+bool on_stroke(const polylines_t& polylines,
+  const Point& p,
+  coord lineWidth,
+  bool buttCaps,
+  bool miterJoins)
+{
+  const coord halfWidth = lineWidth / 2.0;
+  const coord maxDistSq = halfWidth * halfWidth;
+
+  for (const Polyline& polyline : polylines){
+    const auto& pts = polyline.points;
+    const size_t n = pts.size();
+    const size_t numSegments = polyline.closed ? n : n - 1;
+
+    for (size_t i = 0; i != numSegments; i++){
+      const Point& a = pts[i];
+      const Point& b = pts[(i + 1) % n];
+      const coord lengthSq = distance_sq(a, b);
+      if (lengthSq == 0.0 && buttCaps){
+        continue;
+      }
+
+      coord t = lengthSq == 0.0 ? 0.0 :
+        ((p.x - a.x) * (b.x - a.x) + (p.y - a.y) * (b.y - a.y)) / lengthSq;
+
+      const bool beforeStart = !polyline.closed && i == 0 && t < 0.0;
+      const bool afterEnd = !polyline.closed && i == numSegments - 1 &&
+        t > 1.0;
+      if (buttCaps && (beforeStart || afterEnd)){
+        continue;
+      }
+
+      t = std::max(0.0, std::min(1.0, t));
+      const Point closest(a.x + t * (b.x - a.x), a.y + t * (b.y - a.y));
+      if (distance_sq(p, closest) <= maxDistSq){
+        return true;
+      }
+    }
+
+    if (miterJoins){
+      const size_t first = polyline.closed ? 0 : 1;
+      const size_t last = polyline.closed ? n : n - 1;
+      for (size_t i = first; i < last; i++){
+        if (in_miter(pts[(i + n - 1) % n], pts[i], pts[(i + 1) % n], p,
+          halfWidth))
+        {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+} // namespace
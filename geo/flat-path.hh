@@ -0,0 +1,55 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_FLAT_PATH_HH
+#define FAINT_FLAT_PATH_HH
+#include <vector>
+#include "geo/pathpt.hh"
+#include "util/optional.hh"
+
+namespace faint{
+
+class Polyline{
+  // Points connected by line segments, for example a flattened
+  // sub-path.
+public:
+  std::vector<Point> points;
+  bool closed = false;
+};
+
+using polylines_t = std::vector<Polyline>;
+
+// Returns the sub-paths of the path, with curves approximated by line
+// segments. Not set for paths with arcs.
+Optional<polylines_t> flatten(const std::vector<PathPt>&);
+
+// True if the point is inside the area the polylines would fill (each
+// implicitly closed), using either the even-odd or non-zero winding
+// rule.
+bool inside_polylines(const polylines_t&, const Point&, bool evenOdd);
+
+// True if the point is within the stroke of the polylines when drawn
+// with the line width. With butt caps, the stroke does not extend past
+// the ends of open polylines. Joins are round, or mitered (with
+// Cairo's default miter limit) if miterJoins. Dashes are ignored.
+bool on_stroke(const polylines_t&,
+  const Point&,
+  coord lineWidth,
+  bool buttCaps,
+  bool miterJoins);
+
+} // namespace
+
+#endif
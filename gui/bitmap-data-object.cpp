@@ -44,7 +44,7 @@ Bitmap FaintBitmapDataObject::GetBitmap() const{
 bool FaintBitmapDataObject::GetDataHere(void *buf) const{
   bmp_info info = {m_bmp.m_row_stride, m_bmp.m_w, m_bmp.m_h};
   memcpy(buf, &info, sizeof(bmp_info));
-  memcpy(((char*)buf) + sizeof(bmp_info), m_bmp.m_data,
+  memcpy(((char*)buf) + sizeof(bmp_info), m_bmp.GetRaw(),
     to_size_t(m_bmp.m_h * m_bmp.m_row_stride));
   return true;
 }
@@ -64,7 +64,7 @@ bool FaintBitmapDataObject::SetData(size_t len, const void* buf){
   }
 
   m_bmp = Bitmap(IntSize(info.width, info.height), info.stride);
-  memcpy(m_bmp.m_data, ((char*)buf) + sizeof(bmp_info), len - sizeof(bmp_info));
+  memcpy(m_bmp.GetRaw(), ((char*)buf) + sizeof(bmp_info), len - sizeof(bmp_info));
   return true;
 }
 
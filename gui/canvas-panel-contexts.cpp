@@ -475,6 +475,10 @@ public:
     return m_toolInterface;
   }
 
+  IntRect GetVisibleImageRect() const override{
+    return m_canvas.GetVisibleImageRect();
+  }
+
   coord GetZoom() const override{
     return m_canvas.GetZoom();
   }
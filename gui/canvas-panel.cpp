@@ -629,6 +629,16 @@ utf8_string CanvasPanel::GetUndoName() const{
     });
 }
 
+IntRect CanvasPanel::GetVisibleImageRect() const{
+  const auto& geo = m_state.geo;
+  const coord zoom = geo.Scale();
+  const IntRect visible(
+    floored((geo.pos - point_from_size(geo.border)) / zoom),
+    truncated(to_faint(GetSize()) / zoom) + IntSize(1, 1));
+  return intersection(visible,
+    IntRect(IntPoint(0,0), m_images.Active().GetSize()));
+}
+
 coord CanvasPanel::GetZoom() const{
   return m_state.geo.zoom.GetScaleFactor();
 }
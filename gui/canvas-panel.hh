@@ -113,6 +113,7 @@ public:
   Point GetRelativeMousePos();
   Index GetSelectedFrame() const;
   utf8_string GetUndoName() const;
+  IntRect GetVisibleImageRect() const;
   coord GetZoom() const;
   const ZoomLevel& GetZoomLevel() const;
   bool Has(const ObjectId&);
@@ -17,6 +17,7 @@
 #define FAINT_COMMAND_DIALOG_HH
 #include <functional>
 #include "commands/bitmap-cmd.hh"
+#include "geo/primitive.hh"
 #include "util/template-fwd.hh"
 
 class wxWindow;
@@ -26,6 +27,8 @@ namespace faint{
 class Canvas;
 class Command;
 class DialogContext;
+class IntPoint;
+class IntRect;
 
 class DialogFeedback{
   // Context for letting dialogs show feedback on a Bitmap
@@ -36,6 +39,13 @@ public:
   virtual const Bitmap& GetBitmap() = 0;
   virtual void SetBitmap(const Bitmap&) = 0;
   virtual void SetBitmap(Bitmap&&) = 0;
+
+  // Replaces a part of the feedback bitmap.
+  virtual void SetBitmapRegion(const Bitmap&, const IntPoint& topLeft) = 0;
+
+  // The part of the bitmap in view, in bitmap coordinates.
+  virtual IntRect GetVisibleRect() = 0;
+  virtual coord GetZoom() = 0;
 };
 
 using bmp_dialog_func = std::function<BitmapCommandPtr(
@@ -21,6 +21,7 @@
 #include "gui/accelerator-entry.hh"
 #include "gui/command-dialog.hh"
 #include "gui/dialog-context.hh"
+#include "gui/filter-preview.hh"
 #include "gui/slider.hh"
 #include "gui/ui-constants.hh"
 #include "util/accessor.hh"
@@ -33,10 +34,6 @@
 
 namespace faint{
 
-static bool enable_preview_default(const Bitmap& bmp){
-  return (bmp.m_w * bmp.m_h) < (1024 * 1024);
-}
-
 class BrightnessContrastDialog : public wxDialog {
 public:
   BrightnessContrastDialog(wxWindow& parent,
@@ -49,14 +46,13 @@ public:
       wxDefaultSize,
       wxDEFAULT_DIALOG_STYLE | wxWANTS_CHARS | wxRESIZE_BORDER),
       m_bitmap(feedback.GetBitmap()),
-      m_feedback(feedback),
+      m_preview(*this, feedback, m_bitmap),
       m_sliderCursors(sliderCursors)
   {
     using namespace layout;
 
     // Create the member-controls in intended tab-order (placement follows)
-    m_enablePreview = create_checkbox(this, "&Preview",
-      enable_preview_default(m_bitmap),
+    m_enablePreview = create_checkbox(this, "&Preview", true,
       [&](){
         if (!PreviewEnabled()){
           ResetPreview();
@@ -138,18 +134,25 @@ private:
   }
 
   void ResetPreview(){
-    m_feedback.SetBitmap(m_bitmap);
+    m_preview.Reset();
   }
 
   void UpdatePreview(){
-    m_feedback.SetBitmap(brightness_and_contrast(m_bitmap, GetValues()));
+    ViewportFilter filter;
+    // A point operation is cheap enough at full resolution, and gives
+    // the exact result without scaling artifacts.
+    filter.scalable = false;
+    filter.apply = [values = GetValues()](Bitmap& bmp, coord){
+      bmp = brightness_and_contrast(bmp, values);
+    };
+    m_preview.Update(filter);
   }
 
   Bitmap m_bitmap;
+  FilterPreview m_preview;
   Slider* m_brightnessSlider = nullptr;
   Slider* m_contrastSlider = nullptr;
   wxCheckBox* m_enablePreview = nullptr;
-  DialogFeedback& m_feedback;
   const SliderCursors& m_sliderCursors;
 };
 
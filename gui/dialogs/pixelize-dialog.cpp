@@ -15,8 +15,9 @@
 
 #include "wx/dialog.h"
 #include "wx/sizer.h"
-#include "bitmap/bitmap-templates.hh"
+#include "bitmap/filter.hh"
 #include "gui/dialog-context.hh"
+#include "gui/filter-preview.hh"
 #include "gui/slider.hh"
 #include "util/accessor.hh"
 #include "util-wx/fwd-wx.hh"
@@ -28,10 +29,6 @@
 
 namespace faint{
 
-static bool enable_preview_default(const Bitmap& bmp){
-  return area(bmp.GetSize()) < area({2000, 2000});
-}
-
 class PixelizeDialog : public wxDialog {
 public:
   PixelizeDialog(wxWindow& parent,
@@ -40,16 +37,15 @@ public:
     : wxDialog(&parent, wxID_ANY, "Pixelize", wxDefaultPosition, wxDefaultSize,
       wxDEFAULT_DIALOG_STYLE | wxWANTS_CHARS | wxRESIZE_BORDER),
       m_bitmap(feedback.GetBitmap()),
+      m_preview(*this, feedback, m_bitmap),
       m_pixelSizeSlider(nullptr),
       m_enablePreview(nullptr),
-      m_feedback(feedback),
       m_sliderCursors(sliderCursors)
   {
     using namespace layout;
 
     // Create the member-controls in intended tab-order (placement follows)
-    m_enablePreview = create_checkbox(this, "&Preview",
-      enable_preview_default(m_bitmap),
+    m_enablePreview = create_checkbox(this, "&Preview", true,
       [&](){
         if (PreviewEnabled()){
           UpdatePreview();
@@ -111,18 +107,26 @@ private:
   }
 
   void ResetPreview(){
-    m_feedback.SetBitmap(m_bitmap);
+    m_preview.Reset();
   }
 
   void UpdatePreview(){
-    m_feedback.SetBitmap(onto_new(pixelize, m_bitmap,
-      m_pixelSizeSlider->GetValue()));
+    // Pixelized at full resolution, with the blocks aligned as for
+    // the full image.
+    const int width = m_pixelSizeSlider->GetValue();
+    ViewportFilter filter;
+    filter.align = width;
+    filter.scalable = false;
+    filter.apply = [width](Bitmap& bmp, coord){
+      pixelize(bmp, pixelize_range_t(width));
+    };
+    m_preview.Update(filter);
   }
 
   Bitmap m_bitmap;
+  FilterPreview m_preview;
   Slider* m_pixelSizeSlider;
   wxCheckBox* m_enablePreview;
-  DialogFeedback& m_feedback;
   const SliderCursors& m_sliderCursors;
 };
 
@@ -14,6 +14,7 @@
 // permissions and limitations under the License.
 
 #include <algorithm>
+#include <cmath>
 #include "wx/dialog.h"
 #include "wx/sizer.h"
 #include "bitmap/bitmap-templates.hh"
@@ -21,6 +22,7 @@
 #include "bitmap/gaussian-blur.hh"
 #include "commands/function-cmd.hh"
 #include "gui/dialog-context.hh"
+#include "gui/filter-preview.hh"
 #include "gui/slider.hh"
 #include "util/accessor.hh"
 #include "util-wx/fwd-wx.hh"
@@ -32,10 +34,6 @@
 
 namespace faint{
 
-static bool enable_preview_default(const Bitmap& bmp){
-  return (bmp.m_w * bmp.m_h) < (1024 * 1024);
-}
-
 class SharpnessDialog : public wxDialog {
 public:
   SharpnessDialog(wxWindow& parent,
@@ -44,14 +42,13 @@ public:
     : wxDialog(&parent, wxID_ANY, "Sharpness", wxDefaultPosition, wxDefaultSize,
         wxDEFAULT_DIALOG_STYLE | wxWANTS_CHARS | wxRESIZE_BORDER),
       m_bitmap(feedback.GetBitmap()),
+      m_preview(*this, feedback, m_bitmap),
       m_enablePreview(nullptr),
-      m_feedback(feedback),
       m_sharpnessSlider(nullptr),
       m_sliderCursors(sliderCursors)
   {
     // Create the member-controls in intended tab-order (placement follows)
-    m_enablePreview = create_checkbox(this, "&Preview",
-      enable_preview_default(m_bitmap),
+    m_enablePreview = create_checkbox(this, "&Preview", true,
       [&](){
         if (PreviewEnabled()){
           UpdatePreview();
@@ -114,27 +111,31 @@ private:
   }
 
   void ResetPreview(){
-    m_feedback.SetBitmap(m_bitmap);
+    m_preview.Reset();
   }
 
   void UpdatePreview(){
-    if (ValidSharpness()){
-      double sharpness = GetSharpness();
-      if (sharpness < 0){
-        m_feedback.SetBitmap(gaussian_blur_fast(m_bitmap, -sharpness));
-      }
-      else{
-        m_feedback.SetBitmap(unsharp_mask_fast(m_bitmap, sharpness));
-      }
-    }
-    else{
-      m_feedback.SetBitmap(m_bitmap);
+    if (!ValidSharpness()){
+      m_preview.Reset();
+      return;
     }
+
+    const coord sharpness = GetSharpness();
+    ViewportFilter filter;
+    filter.margin = static_cast<int>(std::ceil(3 * std::fabs(sharpness)));
+    filter.apply = [sharpness](Bitmap& bmp, coord scale){
+      // The blur radius is relative to the image, so it is scaled with
+      // the region.
+      bmp = sharpness < 0 ?
+        gaussian_blur_fast(bmp, -sharpness * scale) :
+        unsharp_mask_fast(bmp, sharpness * scale);
+    };
+    m_preview.Update(filter);
   }
 
   Bitmap m_bitmap;
+  FilterPreview m_preview;
   wxCheckBox* m_enablePreview;
-  DialogFeedback& m_feedback;
   Slider* m_sharpnessSlider;
   const SliderCursors& m_sliderCursors;
 };
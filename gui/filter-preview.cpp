@@ -0,0 +1,80 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include "wx/app.h"
+#include "wx/window.h"
+#include "bitmap/draw.hh"
+#include "geo/int-rect.hh"
+#include "gui/command-dialog.hh"
+#include "gui/filter-preview.hh"
+#include "util-wx/fwd-bind.hh"
+
+namespace faint{
+
+FilterPreview::FilterPreview(wxWindow& dialog,
+  DialogFeedback& feedback,
+  const Bitmap& original)
+  : m_feedback(feedback),
+    m_original(original),
+    m_worker([](){
+      // Causes an idle event on the GUI thread
+      wxWakeUpIdle();
+    })
+{
+  events::on_idle(dialog, [this](){
+    auto result = m_worker.TakeResult();
+    if (result.IsSet()){
+      ShowRegion(result.Take(), m_pendingTopLeft);
+    }
+  });
+}
+
+void FilterPreview::Update(const ViewportFilter& filter){
+  const IntRect visible(m_feedback.GetVisibleRect());
+  const coord zoom = m_feedback.GetZoom();
+  const Bitmap& original = m_original;
+
+  // Only the latest job gives a result, so its position can be kept
+  // here instead of passing it through the worker.
+  m_pendingTopLeft = intersection(visible,
+    IntRect(IntPoint(0, 0), original.GetSize())).TopLeft();
+  m_worker.Start([=, &original](const cancelled_func& cancelled){
+    auto region = filter_viewport(original, visible, zoom, filter,
+      cancelled);
+    return region.IsSet() ?
+      option(std::move(region.Get().bitmap)) :
+      Optional<Bitmap>();
+  });
+}
+
+void FilterPreview::Reset(){
+  m_worker.Cancel();
+  m_feedback.SetBitmap(m_original);
+  m_shownRect = IntRect();
+}
+
+void FilterPreview::ShowRegion(const Bitmap& bmp, const IntPoint& topLeft){
+  const IntRect rect(topLeft, bmp.GetSize());
+  if (!empty(m_shownRect) && m_shownRect != rect){
+    // Restore the part filtered by an earlier preview, e.g. before
+    // scrolling
+    m_feedback.SetBitmapRegion(subbitmap(m_original, m_shownRect),
+      m_shownRect.TopLeft());
+  }
+  m_feedback.SetBitmapRegion(bmp, topLeft);
+  m_shownRect = rect;
+}
+
+} // namespace
@@ -0,0 +1,59 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_FILTER_PREVIEW_HH
+#define FAINT_FILTER_PREVIEW_HH
+#include "bitmap/viewport-filter.hh"
+#include "geo/int-rect.hh"
+#include "util/preview-worker.hh"
+
+class wxWindow;
+
+namespace faint{
+
+class DialogFeedback;
+
+class FilterPreview{
+  // Shows previews of filters on the visible part of the bitmap of a
+  // DialogFeedback. The previews are computed on a background thread
+  // at display resolution, and set as the feedback bitmap from an
+  // idle handler of the dialog.
+public:
+  // The original bitmap must outlive the FilterPreview.
+  FilterPreview(wxWindow& dialog,
+    DialogFeedback&,
+    const Bitmap& original);
+
+  // Starts computing a preview, cancelling any earlier preview.
+  void Update(const ViewportFilter&);
+
+  // Cancels any preview and shows the original bitmap.
+  void Reset();
+
+  FilterPreview(const FilterPreview&) = delete;
+  FilterPreview& operator=(const FilterPreview&) = delete;
+private:
+  void ShowRegion(const Bitmap&, const IntPoint& topLeft);
+
+  DialogFeedback& m_feedback;
+  const Bitmap& m_original;
+  IntPoint m_pendingTopLeft;
+  IntRect m_shownRect;
+  PreviewWorker m_worker;
+};
+
+} // namespace
+
+#endif
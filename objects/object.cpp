@@ -31,6 +31,10 @@ void Object::ClearActive(){
   SetActive(false);
 }
 
+Optional<Color> Object::GetMaskColor(const Point&) const{
+  return {};
+}
+
 bool Object::Inactive() const{
   return !Active();
 }
@@ -83,6 +83,11 @@ public:
   virtual bool CyclicPoints() const = 0;
   virtual void Draw(FaintDC&, ExpressionContext&) = 0;
   virtual void DrawMask(FaintDC&, ExpressionContext&) = 0;
+
+  // Returns the color DrawMask would give the point, if this can be
+  // determined without rendering.
+  virtual Optional<Color> GetMaskColor(const Point&) const;
+
   virtual bool Extendable() const = 0;
 
   virtual coord GetArea() const = 0;
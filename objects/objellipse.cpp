@@ -13,7 +13,9 @@
 // implied. See the License for the specific language governing
 // permissions and limitations under the License.
 
+#include "bitmap/color.hh"
 #include "geo/arc.hh"
+#include "geo/flat-path.hh"
 #include "geo/geo-func.hh"
 #include "geo/geo-list-points.hh"
 #include "geo/int-rect.hh"
@@ -76,6 +78,19 @@ public:
     draw_ellipse_span(dc, m_tri, m_angleSpan, mask_settings_fill(m_settings));
   }
 
+  Optional<Color> GetMaskColor(const Point& p) const override{
+    if (!anti_aliasing(m_settings) || !m_angleSpan.Empty()){
+      return {};
+    }
+    return flatten(ellipse_as_path(m_tri)).Visit(
+      [&](const polylines_t& polylines){
+        return option(mask_color_fill(polylines, p, m_settings));
+      },
+      [](){
+        return Optional<Color>();
+      });
+  }
+
   AngleSpan GetAngleSpan() const{
     return m_angleSpan;
   }
@@ -15,7 +15,9 @@
 
 #include <algorithm>
 #include <cassert>
+#include "bitmap/color.hh"
 #include "geo/arrowhead.hh"
+#include "geo/flat-path.hh"
 #include "geo/geo-func.hh"
 #include "geo/int-rect.hh"
 #include "geo/line.hh"
@@ -57,6 +59,37 @@ public:
       mask_settings_line(m_settings));
   }
 
+  Optional<Color> GetMaskColor(const Point& p) const override{
+    if (!anti_aliasing(m_settings)){
+      return {};
+    }
+
+    // Mirrors FaintDC::PolyLine, which skips a duplicated last point
+    // and strokes the line only up to the arrowhead.
+    const std::vector<Point> pts(m_points.GetPointsDumb(m_tri));
+    const bool skipTwo = pts.size() > 2 &&
+      pts[pts.size() - 1] == pts[pts.size() - 2];
+    const size_t firstEnd = skipTwo ? pts.size() - 2 : pts.size() - 1;
+
+    Polyline line;
+    line.points.assign(begin(pts), begin(pts) + resigned(firstEnd));
+    if (m_settings.Get(ts_LineArrowhead) == LineArrowhead::FRONT){
+      const Point from(skipTwo ? pts[pts.size() - 3] : pts[pts.size() - 2]);
+      const Arrowhead a(get_arrowhead(LineSegment(from, pts.back()),
+        m_settings.Get(ts_LineWidth)));
+      Polyline head;
+      head.points = {a.P0(), a.P1(), a.P2()};
+      if (inside_polylines({head}, p, false)){
+        return option(mask_edge);
+      }
+      line.points.push_back(a.LineAnchor());
+    }
+    else{
+      line.points.push_back(pts.back());
+    }
+    return option(mask_color_line({line}, p, m_settings));
+  }
+
   coord GetArea() const override{
     return 0.0; // Fixme: Consider if ink-area more meaningful
   }
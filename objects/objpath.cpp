@@ -13,7 +13,9 @@
 // implied. See the License for the specific language governing
 // permissions and limitations under the License.
 
+#include "bitmap/color.hh"
 #include "geo/bezier.hh"
+#include "geo/flat-path.hh"
 #include "geo/geo-func.hh"
 #include "geo/int-rect.hh"
 #include "geo/measure.hh"
@@ -55,6 +57,17 @@ public:
     dc.Path(m_points.GetPoints(m_tri), mask_settings_fill(m_settings));
   }
 
+  Optional<Color> GetMaskColor(const Point& p) const override{
+    // Not set for paths with arcs, which are left to DrawMask
+    return flatten(m_points.GetPoints(m_tri)).Visit(
+      [&](const polylines_t& polylines){
+        return option(mask_color_fill(polylines, p, m_settings));
+      },
+      [](){
+        return Optional<Color>();
+      });
+  }
+
   coord GetArea() const override{
     return area(m_tri); // Fixme: Incorrect, need proper path area
   }
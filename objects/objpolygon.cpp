@@ -14,6 +14,8 @@
 // permissions and limitations under the License.
 
 #include <cassert>
+#include "bitmap/color.hh"
+#include "geo/flat-path.hh"
 #include "geo/geo-func.hh"
 #include "geo/int-rect.hh"
 #include "geo/measure.hh" // with_mid_points_cyclic
@@ -57,6 +59,19 @@ public:
       mask_settings_fill(m_settings));
   }
 
+  Optional<Color> GetMaskColor(const Point& p) const override{
+    if (!anti_aliasing(m_settings)){
+      return {};
+    }
+    Polyline polygon;
+    polygon.points = m_points.GetPointsDumb(m_tri);
+    polygon.closed = true;
+    if (polygon.points.size() <= 1){
+      return option(mask_outside);
+    }
+    return option(mask_color_fill({polygon}, p, m_settings));
+  }
+
   coord GetArea() const override{
     return area(m_tri); // Fixme: Incorrect, need proper polygon area
   }
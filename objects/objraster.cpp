@@ -110,7 +110,7 @@ void ObjRaster::Draw(FaintDC& dc){
   // Fixme #1: Should this be done inside FaintDC instead?
   // Fixme #2: Didn't I remove realigning of other objects?)
   Point shift(-0.5, -0.5);
-  dc.Blit(m_scaled, r.TopLeft() + shift, m_settings);
+  dc.Blit(m_scaled, r.TopLeft() + shift, m_settings, m_zoomCache);
 }
 
 void ObjRaster::DrawMask(FaintDC& dc, ExpressionContext&){
@@ -174,11 +174,13 @@ const Bitmap& ObjRaster::GetBitmap() const{
 void ObjRaster::SetBitmap(const Bitmap& bmp){
   m_bitmap = bmp;
   apply_transform(m_bitmap, m_tri, m_scaled);
+  m_zoomCache.Clear();
 }
 
 void ObjRaster::SetTri(const Tri& t){
   m_tri = t;
   apply_transform(m_bitmap, t, m_scaled);
+  m_zoomCache.Clear();
 }
 
 static CommandPtr crop_to_rect(const IntRect& r,
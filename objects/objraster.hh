@@ -19,6 +19,7 @@
 #include "commands/command-ptr.hh"
 #include "geo/tri.hh"
 #include "objects/standard-object.hh"
+#include "rendering/zoomed-bitmap-cache.hh"
 
 namespace faint{
 
@@ -45,6 +46,9 @@ private:
   Bitmap m_bitmap;
   Bitmap m_scaled;
   Tri m_tri;
+
+  // The zoomed regions of m_scaled drawn most recently.
+  ZoomedBitmapCache m_zoomCache;
 };
 
 Tri tri_for_bmp(const Point& topLeft, const Bitmap&);
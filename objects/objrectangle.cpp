@@ -14,7 +14,10 @@
 // permissions and limitations under the License.
 
 #include <algorithm>
+#include "bitmap/color.hh"
+#include "geo/flat-path.hh"
 #include "geo/geo-func.hh"
+#include "geo/geo-list-points.hh"
 #include "geo/int-rect.hh"
 #include "geo/line.hh"
 #include "geo/measure.hh"
@@ -50,6 +53,19 @@ public:
     dc.Rectangle(m_tri, mask_settings_fill(m_settings));
   }
 
+  Optional<Color> GetMaskColor(const Point& p) const override{
+    if (!anti_aliasing(m_settings) ||
+      m_settings.GetDefault(ts_RadiusX, 0.0) != 0.0)
+    {
+      return {};
+    }
+    const auto corners(points_clockwise(m_tri));
+    Polyline rect;
+    rect.points.assign(begin(corners), end(corners));
+    rect.closed = true;
+    return option(mask_color_fill({rect}, p, m_settings));
+  }
+
   coord GetArea() const override{
     return area(m_tri);
   }
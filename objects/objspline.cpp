@@ -13,6 +13,8 @@
 // implied. See the License for the specific language governing
 // permissions and limitations under the License.
 
+#include "bitmap/color.hh"
+#include "geo/flat-path.hh"
 #include "geo/geo-func.hh"
 #include "geo/int-rect.hh"
 #include "geo/points.hh"
@@ -45,6 +47,24 @@ public:
     dc.Spline(m_points.GetPointsDumb(m_tri), mask_settings_line(m_settings)) ;
   }
 
+  Optional<Color> GetMaskColor(const Point& p) const override{
+    const std::vector<Point> pts(m_points.GetPointsDumb(m_tri));
+    if (pts.size() <= 2){
+      return option(mask_outside);
+    }
+
+    // FaintDC::Spline also strokes a line to the last point
+    std::vector<PathPt> path(spline_to_svg_path(pts));
+    path.push_back(PathPt::LineTo(pts.back()));
+    return flatten(path).Visit(
+      [&](const polylines_t& polylines){
+        return option(mask_color_line(polylines, p, m_settings));
+      },
+      [](){
+        return Optional<Color>();
+      });
+  }
+
   coord GetArea() const override{
     return 0.0; // Fixme: Consider if ink area more useful
   }
@@ -27,6 +27,7 @@
 #include "rendering/render-text.hh"
 #include "rendering/text-info-dc.hh"
 #include "text/slice.hh"
+#include "text/split-memo.hh"
 #include "text/split-string.hh"
 #include "text/text-geo.hh"
 #include "text/text-expression.hh"
@@ -71,6 +72,13 @@ static utf8_string get_evaluated_string(const ExpressionContext& ctx,
     });
 }
 
+static SplitFont get_split_font(const Settings& s){
+  return SplitFont(s.Get(ts_FontFace),
+    s.Get(ts_FontSize),
+    s.GetDefault(ts_FontBold, false),
+    s.GetDefault(ts_FontItalic, false));
+}
+
 static LineSegment empty_text_caret(const Tri& tri, coord rowHeight){
   Tri caretTri(tri.P0(), tri.P1(), rowHeight);
   caretTri = offset_aligned(caretTri, 1.0, 0.0);
@@ -114,7 +122,8 @@ coord ObjText::BaselineOffset() const{
 
 size_t ObjText::CaretPos(const Point& imagePos) const{
   TextInfoDC info(m_settings);
-  const auto lines = split_string(info, m_textBuf.get(),
+  const auto& split = m_splitMemo.Get(info, m_textBuf,
+    get_split_font(m_settings),
     max_width_t(m_tri.Width()));
 
   const auto maxCaret = m_textBuf.size();
@@ -122,10 +131,13 @@ size_t ObjText::CaretPos(const Point& imagePos) const{
 
   return caret_index_from_pos(imagePos,
     m_tri,
-    lines,
+    split.lines,
     rowHeight,
     maxCaret,
-    [&](const utf8_string& s){return info.CumulativeTextWidth(s);});
+    [&](const utf8_string& line){
+      return split.CumulativeWidths(line,
+        [&](const utf8_string& s){return info.CumulativeTextWidth(s);});
+    });
 }
 
 Object* ObjText::Clone() const{
@@ -141,7 +153,7 @@ void ObjText::Draw(FaintDC& dc, ExpressionContext& ctx){
     m_caret = empty_text_caret(m_tri, m_rowHeight);
   }
 
-  auto lines = Split(textInfo, ctx);
+  const auto& lines = Split(textInfo, ctx);
   render_text(dc,
     lines,
     m_textBuf.get_sel_range(),
@@ -175,8 +187,8 @@ coord ObjText::GetArea() const{
 Rect ObjText::GetAutoSizedRect() const {
   TextInfoDC info(m_settings);
   // Fixme: Doesn't take expressions in account.
-  const auto textSize = text_extents(info,
-    split_string(info, m_textBuf.get(), no_option()));
+  const auto textSize = m_splitMemo.Get(info, m_textBuf,
+    get_split_font(m_settings), no_option()).Extents(info);
 
   return Rect(m_tri.P0(), floated(textSize));
 }
@@ -196,8 +208,10 @@ utf8_string ObjText::GetEvaluatedString(const ExpressionContext& ctx) const{
 
 std::vector<PathPt> ObjText::GetPath(const ExpressionContext& ctx) const{
   TextInfoDC textInfo(m_settings);
-  text_lines_t lines = split_string(textInfo, GetEvaluatedString(ctx),
-    m_settings.Get(ts_BoundedText) ? max_width_t(m_tri.Width()) : no_option());
+  const auto& lines = m_splitMemo.Get(textInfo, GetEvaluatedString(ctx),
+    get_split_font(m_settings),
+    m_settings.Get(ts_BoundedText) ?
+    max_width_t(m_tri.Width()) : no_option()).lines;
 
   Align align(m_settings.Get(ts_HorizontalAlign),
     m_settings.Get(ts_VerticalAlign));
@@ -223,17 +237,12 @@ IntRect ObjText::GetRefreshRect() const{
     return floiled(bounding_rect(m_tri));
   }
   else{
-    // Fixme: Slow.
     TextInfoDC info(m_settings);
-    text_lines_t lines = split_string(info, m_textBuf.get(), max_width_t());
-
-    int w = 0;
-    for (auto l : lines){
-      w = std::max(info.GetWidth(l.text), w);
-    }
+    const auto textSize = m_splitMemo.Get(info, m_textBuf,
+      get_split_font(m_settings), no_option()).Extents(info);
 
-    const int h = info.ComputeRowHeight() * resigned(lines.size());
-    return floiled(bounding_rect(Tri(m_tri.P0(), m_tri.GetAngle(), Size(w,h))));
+    return floiled(bounding_rect(Tri(m_tri.P0(), m_tri.GetAngle(),
+      floated(textSize))));
   }
 }
 
@@ -247,8 +256,8 @@ Tri ObjText::GetTri() const{
   }
   else{
     TextInfoDC info(m_settings);
-    const auto textSize = text_extents(info,
-      split_string(info, m_textBuf.get(), no_option()));
+    const auto textSize = m_splitMemo.Get(info, m_textBuf,
+      get_split_font(m_settings), no_option()).Extents(info);
 
     return Tri(m_tri.P0(), m_tri.GetAngle(), floated(textSize));
   }
@@ -308,17 +317,21 @@ bool ObjText::ShowSizeBox() const{
   return true;
 }
 
-text_lines_t ObjText::Split(const TextInfo& textInfo,
+const text_lines_t& ObjText::Split(const TextInfo& textInfo,
   ExpressionContext& ctx) const
 {
   const auto maxWidth = m_settings.Get(ts_BoundedText) ?
     max_width_t(m_tri.Width()) :
     max_width_t();
 
+  // The evaluated text is memoized by value, so that the lines are
+  // split again only if the values used by the expression change.
+  const auto font = get_split_font(m_settings);
   return (m_beingEdited || !m_settings.Get(ts_ParseExpressions)) ?
-    split_string(textInfo, m_textBuf.get(), maxWidth) :
-    split_string(textInfo, get_evaluated_string(ctx, m_expression, m_textBuf),
-      maxWidth);
+    m_splitMemo.Get(textInfo, m_textBuf, font, maxWidth).lines :
+    m_splitMemo.Get(textInfo,
+      get_evaluated_string(ctx, m_expression, m_textBuf),
+      font, maxWidth).lines;
 }
 
 text_lines_t split_evaluated(ExpressionContext& ctx, const ObjText& text){
@@ -20,6 +20,7 @@
 #include "geo/tri.hh"
 #include "objects/standard-object.hh"
 #include "text/text-buffer.hh"
+#include "text/split-memo.hh"
 #include "text/text-expression.hh"
 #include "text/text-line.hh"
 
@@ -58,13 +59,14 @@ public:
 private:
   ObjText(const ObjText&); // For Clone
   void Init();
-  text_lines_t Split(const TextInfo&, ExpressionContext&) const;
+  const text_lines_t& Split(const TextInfo&, ExpressionContext&) const;
   TextBuffer m_textBuf;
   bool m_beingEdited;
   LineSegment m_caret;
   mutable int m_rowHeight;
   mutable int m_lastFontSize;
   mutable utf8_string m_lastFontFace;
+  mutable SplitMemo m_splitMemo;
   Tri m_tri;
   Optional<parse_result_t> m_expression;
 };
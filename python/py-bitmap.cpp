@@ -13,6 +13,9 @@
 // implied. See the License for the specific language governing
 // permissions and limitations under the License.
 
+#include <cassert>
+#include <cstring> // memcpy
+#include <map>
 #include "bitmap/aa-line.hh"
 #include "bitmap/auto-crop.hh"
 #include "bitmap/bitmap.hh"
@@ -76,6 +79,105 @@ struct MappedType<Bitmap&>{
   }
 };
 
+class BufferExports{
+public:
+  int count = 0;
+  PixelPin pin;
+};
+
+// The exported buffers (see Bitmap_getbuffer) per Bitmap. The pixel
+// memory of a Bitmap with exported buffers must not be reallocated,
+// and is pinned so that copies do not share it.
+static std::map<const Bitmap*, BufferExports> g_bufferExports;
+
+static void add_buffer_export(Bitmap& bmp){
+  auto& exports = g_bufferExports[&bmp];
+  if (exports.count == 0){
+    exports.pin = bmp.Pin();
+  }
+  exports.count++;
+}
+
+static void remove_buffer_export(const Bitmap& bmp){
+  auto it = g_bufferExports.find(&bmp);
+  assert(it != end(g_bufferExports));
+  it->second.count--;
+  if (it->second.count == 0){
+    g_bufferExports.erase(it);
+  }
+}
+
+static void throw_if_exported(const Bitmap& bmp){
+  if (g_bufferExports.count(&bmp) != 0){
+    throw BufferError("Bitmap memory can not be reallocated "
+      "while its buffer is exported.");
+  }
+}
+
+// Replaces the pixels of dst with those of src. Copies into the
+// existing memory of an exported bitmap if the size is unchanged, so
+// that the exported buffers remain valid.
+static void replace_pixels(Bitmap& dst, Bitmap&& src){
+  if (g_bufferExports.count(&dst) != 0 && dst.GetSize() == src.GetSize()){
+    const size_t rowBytes = to_size_t(src.m_w * ByPP);
+    for (int y = 0; y != src.m_h; y++){
+      memcpy(dst.GetRaw() + y * dst.m_row_stride,
+        src.GetRaw() + y * src.m_row_stride,
+        rowBytes);
+    }
+  }
+  else{
+    throw_if_exported(dst);
+    dst = std::move(src);
+  }
+}
+
+class AllowThreads{
+  // Releases the global interpreter lock during its lifetime, for
+  // long running operations which do not use the Python API.
+public:
+  AllowThreads()
+    : m_state(PyEval_SaveThread())
+  {}
+
+  ~AllowThreads(){
+    PyEval_RestoreThread(m_state);
+  }
+
+  AllowThreads(const AllowThreads&) = delete;
+  AllowThreads& operator=(const AllowThreads&) = delete;
+private:
+  PyThreadState* m_state;
+};
+
+// Returns func(bmp), evaluated without holding the global interpreter
+// lock. The function gets a copy sharing the pixels, so that other
+// Python threads can modify or reallocate the bitmap meanwhile.
+template<typename FUNC>
+static Bitmap without_gil(const Bitmap& bmp, const FUNC& func){
+  const Bitmap copy(bmp);
+  AllowThreads allowThreads;
+  return func(copy);
+}
+
+// Calls func(bmp), which modifies the pixels in place, without
+// holding the global interpreter lock.
+template<typename FUNC>
+static void in_place_without_gil(Bitmap& bmp, const FUNC& func){
+  add_buffer_export(bmp);
+  try{
+    {
+      AllowThreads allowThreads;
+      func(bmp);
+    }
+    remove_buffer_export(bmp);
+  }
+  catch (...){
+    remove_buffer_export(bmp);
+    throw;
+  }
+}
+
 static void Bitmap_init(bitmapObject& self,
   const IntSize& size,
   const Optional<Paint>& bg)
@@ -84,6 +186,7 @@ static void Bitmap_init(bitmapObject& self,
     if (size.w <= 0 || size.h <= 0){
       throw ValueError("Negative size");
     }
+    throw_if_exported(self.bmp);
     self.bmp = Bitmap(size, bg.Or(Paint(color_white)));
   });
 }
@@ -227,11 +330,11 @@ bool Common_auto_crop(Bitmap& bmp){
     return false;
   },
   [&bmp](const IntRect& r){
-    bmp = subbitmap(bmp, r);
+    replace_pixels(bmp, subbitmap(bmp, r));
     return true;
   },
   [&bmp](const IntRect& r0, const IntRect&){
-    bmp = subbitmap(bmp, r0);
+    replace_pixels(bmp, subbitmap(bmp, r0));
     return true;
   });
 }
@@ -309,7 +412,13 @@ void Common_fill(Bitmap& bmp, const IntPoint& pos, const Paint& paint){
 
 template<>
 void Common_gaussian_blur(Bitmap& bmp, coord sigma){
-  gaussian_blur_fast(bmp, sigma);
+  if (sigma <= 0){
+    throw ValueError("Sigma must be > 0");
+  }
+  replace_pixels(bmp, without_gil(bmp,
+    [sigma](const Bitmap& src){
+      return gaussian_blur_fast(src, sigma);
+    }));
 }
 
 template<>
@@ -327,9 +436,20 @@ void Common_pixelize(Bitmap& bmp, const pixelize_range_t& width){
   pixelize(bmp, width);
 }
 
+template<>
+void Common_point_ops(Bitmap& bmp, const PointOps& ops){
+  in_place_without_gil(bmp,
+    [&ops](Bitmap& dst){
+      ops.Apply(dst);
+    });
+}
+
 template<>
 void Common_quantize(Bitmap& bmp){
-  quantize(bmp, Dithering::ON);
+  replace_pixels(bmp, without_gil(bmp,
+    [](const Bitmap& src){
+      return quantized_bmp(src, Dithering::ON);
+    }));
 }
 
 template<>
@@ -349,7 +469,12 @@ void Common_rotate(Bitmap& bmp, const Angle& angle, const Optional<Paint>& bg){
   if (bg.NotSet()){
     throw ValueError("No background specified!");
   }
-  bmp = rotate_bilinear(bmp, angle, bg.Get());
+  throw_if_exported(bmp);
+  const Paint& paint = bg.Get();
+  replace_pixels(bmp, without_gil(bmp,
+    [&](const Bitmap& src){
+      return rotate_bilinear(src, angle, paint);
+    }));
 }
 
 template<>
@@ -391,9 +516,10 @@ struct bitmap_size{
   static void Set(Bitmap& self, const IntSize& size){
     bmp_exception_to_py(
       [&](){
+        throw_if_exported(self);
         Bitmap temp(size, color_white);
         blit(at_top_left(self), onto(temp));
-        self = temp;
+        self = std::move(temp);
       });
   }
 };
@@ -401,6 +527,61 @@ struct bitmap_size{
 
 #include "generated/python/method-def/py-bitmap-method-def.hh"
 
+// Exposes the pixel memory as a writable (height, width, 4)-array of
+// unsigned bytes in BGRA-order, without copying.
+static int Bitmap_getbuffer(bitmapObject* self, Py_buffer* view, int flags){
+  view->obj = nullptr;
+  Bitmap& bmp = self->bmp;
+  if (!bitmap_ok(bmp)){
+    PyErr_SetString(PyExc_BufferError, "Operation attempted on bad bitmap.");
+    return -1;
+  }
+
+  const bool contiguous = bmp.m_row_stride == bmp.m_w * ByPP;
+  const bool fortran = (flags & PyBUF_F_CONTIGUOUS) == PyBUF_F_CONTIGUOUS;
+  const bool strided = (flags & PyBUF_STRIDES) == PyBUF_STRIDES;
+  if (fortran || (!contiguous && (!strided ||
+    (flags & PyBUF_ANY_CONTIGUOUS) == PyBUF_ANY_CONTIGUOUS ||
+    (flags & PyBUF_C_CONTIGUOUS) == PyBUF_C_CONTIGUOUS)))
+  {
+    PyErr_SetString(PyExc_BufferError,
+      "Bitmap buffer requires row strides.");
+    return -1;
+  }
+
+  // Shape followed by strides, freed in Bitmap_releasebuffer
+  Py_ssize_t* dims = new Py_ssize_t[6]{
+    bmp.m_h, bmp.m_w, ByPP,
+    bmp.m_row_stride, ByPP, 1};
+
+  add_buffer_export(bmp);
+  view->buf = bmp.GetRaw();
+  view->obj = reinterpret_cast<PyObject*>(self);
+  Py_INCREF(view->obj);
+  view->len = bmp.m_h * bmp.m_w * ByPP;
+  view->itemsize = 1;
+  view->readonly = 0;
+  view->format = (flags & PyBUF_FORMAT) == PyBUF_FORMAT ?
+    const_cast<char*>("B") : nullptr;
+  const bool shaped = (flags & PyBUF_ND) == PyBUF_ND;
+  view->ndim = shaped ? 3 : 1;
+  view->shape = shaped ? dims : nullptr;
+  view->strides = strided ? dims + 3 : nullptr;
+  view->suboffsets = nullptr;
+  view->internal = dims;
+  return 0;
+}
+
+static void Bitmap_releasebuffer(bitmapObject* self, Py_buffer* view){
+  delete[] static_cast<Py_ssize_t*>(view->internal);
+  remove_buffer_export(self->bmp);
+}
+
+static PyBufferProcs bitmap_buffer_procs = {
+  (getbufferproc)Bitmap_getbuffer,
+  (releasebufferproc)Bitmap_releasebuffer
+};
+
 PyTypeObject BitmapType = {
   PyVarObject_HEAD_INIT(nullptr, 0)
   "Bitmap", // tp_name
@@ -420,7 +601,7 @@ PyTypeObject BitmapType = {
   nullptr, // tp_str
   nullptr, // tp_getattro
   nullptr, // tp_setattro
-  nullptr, // tp_as_buffer
+  &bitmap_buffer_procs, // tp_as_buffer
   Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, // tp_flags
   // tp_doc
   "Bitmap for RGBA pixel data.",
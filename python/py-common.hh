@@ -19,6 +19,7 @@
 #include "bitmap/draw.hh"
 #include "bitmap/filter.hh"
 #include "bitmap/gaussian-blur.hh"
+#include "bitmap/point-ops.hh"
 #include "commands/blit-bitmap-cmd.hh"
 #include "commands/draw-object-cmd.hh"
 #include "commands/flip-rotate-cmd.hh"
@@ -292,6 +293,23 @@ void Common_pixelize(T target, const pixelize_range_t& width){
     target_full_image(get_pixelize_command(width)));
 }
 
+/* method: "point_ops(operations)\n
+Applies the per-pixel operations, in order, in a single pass over\n
+the image. Each operation is a tuple with a name and arguments:\n
+ ('brightness_contrast', brightness, contrast)\n
+ ('color_balance', (r0,r1), (g0,g1), (b0,b1))\n
+ ('desaturate',)\n
+ ('desaturate_weighted',)\n
+ ('invert',)\n
+ ('sepia', intensity)\n
+ ('set_alpha', a)\n
+ ('threshold', (low, high), c1, c2)" */
+template<typename T>
+void Common_point_ops(T target, const PointOps& ops){
+  py_common_run_command(target,
+    target_full_image(get_point_ops_command(ops)));
+}
+
 /* method: "erase_but_color(keptColor[,eraseColor])\n
 Replaces all colors, except keptColor, with eraseColor. Uses the
 current secondary color if keptColor is omitted." */
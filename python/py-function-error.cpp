@@ -106,6 +106,10 @@ MemoryError::MemoryError(const utf8_string& error)
   : PythonError(PyExc_MemoryError, error)
 {}
 
+BufferError::BufferError(const utf8_string& error)
+  : PythonError(PyExc_BufferError, error)
+{}
+
 PresetFunctionError::PresetFunctionError()
 {}
 
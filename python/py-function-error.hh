@@ -82,6 +82,11 @@ public:
   MemoryError(const utf8_string&);
 };
 
+class BufferError : public PythonError{
+public:
+  BufferError(const utf8_string&);
+};
+
 class PresetFunctionError{
   // Exception for errors in Python interface functions. Should be
   // thrown if a specific error has already been set with
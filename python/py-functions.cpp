@@ -107,19 +107,24 @@ static Frame get_object_frame(const BoundObject<Object>& obj){
   return Frame(*obj.ctx, *obj.canvas, obj.canvas->GetFrame(obj.frameId));
 }
 
-/* function: "write_png(bmp, path[, color_type, text_dict])\n
+/* function: "write_png(bmp, path[, color_type, text_dict, compression_level, filter])\n
 Writes the bitmap as a png at the given path.\n
 Raises OSError on failure.\n
 \n
 Optional parameters:\n
  - color_type: A constant from the png-module (e.g. png.RGB_ALPHA)\n
  - text_dict: A dictionary of key-strings to value-strings\n
-   for png tEXt meta-data."
+   for png tEXt meta-data.\n
+ - compression_level: The zlib compression level, 0-9 (default 6)\n
+ - filter: A filter constant from the png-module\n
+   (default png.FILTER_ADAPTIVE)"
 name: "write_png" */
 static void write_png_py(const FilePath& p,
   const Bitmap& bmp,
   const Optional<int>& rawColorType,
-  const Optional<png_tEXt_map>& maybeTextChunks)
+  const Optional<png_tEXt_map>& maybeTextChunks,
+  const Optional<int>& compressionLevel,
+  const Optional<int>& rawFilter)
 {
   const auto defaultType = static_cast<int>(PngColorType::RGB_ALPHA);
 
@@ -132,13 +137,24 @@ static void write_png_py(const FilePath& p,
         throw ValueError("color_type out of range.");
       });
 
-  auto r = maybeTextChunks.Visit(
-    [&](const png_tEXt_map& textChunks){
-      return write_png(p, bmp, colorType, textChunks);
-    },
-    [&](){
-      return write_png(p, bmp, colorType);
-    });
+  PngOptions options;
+  options.compressionLevel = compressionLevel.Or(options.compressionLevel);
+  if (options.compressionLevel < 0 || options.compressionLevel > 9){
+    throw ValueError("compression_level out of range.");
+  }
+
+  options.filter =
+    to_enum<PngFilter>(rawFilter.Or(static_cast<int>(options.filter))).Visit(
+      [](const PngFilter f){
+        return f;
+      },
+      []() -> PngFilter{
+        throw ValueError("filter out of range.");
+      });
+
+  auto r = write_png(p, bmp, colorType,
+    maybeTextChunks.Or(png_tEXt_map()),
+    options);
 
   if (!r.Successful()){
     throw OSError(r.ErrorDescription());
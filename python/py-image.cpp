@@ -31,6 +31,7 @@
 #include "bitmap/filter.hh"
 #include "bitmap/gaussian-blur.hh"
 #include "bitmap/quantize.hh"
+#include "geo/int-rect.hh"
 
 namespace faint{
 
@@ -99,6 +100,7 @@ static void Image_set_pixel(Image& self, const IntPoint& pt, const Color& c)
       Bitmap& bmp = self.ConvertColorSpanToBitmap(); // Fixme: Might throw
       put_pixel(bmp, pt, c);
     });
+  self.InvalidateRaster(IntRect(pt, IntSize(1, 1)));
 }
 
 static void Image_init(imageObject& self, PyObject* args){
@@ -176,6 +178,7 @@ void Common_desaturate(Image& image){
     [](ColorSpan& span){
       span.color = desaturated_simple(span.color);
     });
+  image.InvalidateRaster();
 }
 
 template<>
@@ -211,6 +214,10 @@ template<>
 void Common_pixelize(Image&, const pixelize_range_t&){
 }
 
+template<>
+void Common_point_ops(Image&, const PointOps&){
+}
+
 template<>
 void Common_quantize(Image&){
 }
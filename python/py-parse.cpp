@@ -21,6 +21,7 @@
 #include "bitmap/gradient.hh"
 #include "bitmap/paint.hh"
 #include "bitmap/pattern.hh"
+#include "bitmap/point-ops.hh"
 #include "geo/arc.hh"
 #include "geo/calibration.hh"
 #include "geo/int-rect.hh"
@@ -711,6 +712,95 @@ bool parse_flat(Paint& paint, PyObject* args, Py_ssize_t& n, Py_ssize_t len){
   throw TypeError(type_name(paint), n);
 }
 
+// Parses the arguments of the named point operation, throws
+// TypeError describing the expected arguments if missing or invalid.
+template<typename... T>
+static void parse_point_op_args(const utf8_string& name,
+  const char* expected,
+  PyObject* op,
+  Py_ssize_t& n,
+  Py_ssize_t len,
+  T&... args)
+{
+  if (len - n < static_cast<Py_ssize_t>(sizeof...(T)) ||
+    !(parse_item(args, op, n, len, true) && ...))
+  {
+    throw TypeError(space_sep(name, "requires", expected));
+  }
+}
+
+static void add_point_op(PointOps& ops, PyObject* op){
+  if (PyUnicode_Check(op) || !PySequence_Check(op)){
+    throw TypeError("Point operations must be tuples with a name and "
+      "arguments.");
+  }
+
+  const auto len = PySequence_Length(op);
+  Py_ssize_t n = 0;
+  utf8_string name;
+  if (len == 0 || !parse_item(name, op, n, len, true)){
+    throw TypeError("Point operations must start with a name.");
+  }
+
+  if (name == "brightness_contrast"){
+    coord brightness = 0.0;
+    coord contrast = 0.0;
+    parse_point_op_args(name, "brightness and contrast.", op, n, len,
+      brightness, contrast);
+    ops.BrightnessContrast(brightness_contrast_t(brightness, contrast));
+  }
+  else if (name == "color_balance"){
+    color_range_t r, g, b;
+    parse_point_op_args(name, "three intervals.", op, n, len, r, g, b);
+    ops.ColorBalance(r, g, b);
+  }
+  else if (name == "desaturate"){
+    ops.DesaturateSimple();
+  }
+  else if (name == "desaturate_weighted"){
+    ops.DesaturateWeighted();
+  }
+  else if (name == "invert"){
+    ops.Invert();
+  }
+  else if (name == "sepia"){
+    int intensity = 0;
+    parse_point_op_args(name, "an intensity.", op, n, len, intensity);
+    ops.Sepia(intensity);
+  }
+  else if (name == "set_alpha"){
+    StaticBoundedInt<0, 255> alpha;
+    parse_point_op_args(name, "an alpha value.", op, n, len, alpha);
+    ops.SetAlpha(static_cast<uchar>(alpha.GetValue()));
+  }
+  else if (name == "threshold"){
+    std::pair<double, double> range;
+    Color in, out;
+    parse_point_op_args(name, "(low, high), c1, c2.", op, n, len,
+      range, in, out);
+    const auto lower = constrained(Min(0.0), range.first, Max(1.0));
+    const auto upper = constrained(Min(0.0), range.second, Max(1.0));
+    ops.Threshold(fractional_bounded_interval<threshold_range_t>(lower, upper),
+      in, out);
+  }
+  else{
+    throw ValueError(space_sep("Unknown point operation:", quoted(name)));
+  }
+
+  if (n != len){
+    throw TypeError(space_sep("Too many arguments for", name));
+  }
+}
+
+bool parse_flat(PointOps& ops, PyObject* args, Py_ssize_t& n, Py_ssize_t len){
+  ops = PointOps();
+  for (; n != len; n++){
+    scoped_ref op(PySequence_GetItem(args, n));
+    add_point_op(ops, op.get());
+  }
+  return true;
+}
+
 bool parse_flat(IntLineSegment& line, PyObject* args, Py_ssize_t& n, Py_ssize_t len){
   throw_insufficient_args_if(len - n < 4, "line segment");
 
@@ -68,6 +68,7 @@ using type2type_t = typename type2type<T>::type;
 
 class ObjRaster;
 class ObjText;
+class PointOps;
 
 template<typename T>
 struct arg_traits{};
@@ -165,6 +166,7 @@ bool parse_flat(IntSize&, PyObject*, Py_ssize_t& n, Py_ssize_t len);
 bool parse_flat(Color&, PyObject*, Py_ssize_t& n, Py_ssize_t len);
 bool parse_flat(ColorStop&, PyObject*, Py_ssize_t& n, Py_ssize_t len);
 bool parse_flat(Paint&, PyObject*, Py_ssize_t& n, Py_ssize_t len);
+bool parse_flat(PointOps&, PyObject*, Py_ssize_t& n, Py_ssize_t len);
 bool parse_flat(IntLineSegment&, PyObject*, Py_ssize_t& n, Py_ssize_t len);
 bool parse_flat(IntPoint&, PyObject*, Py_ssize_t& n, Py_ssize_t len);
 bool parse_flat(LineSegment&, PyObject*, Py_ssize_t& n, Py_ssize_t len);
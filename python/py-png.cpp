@@ -35,6 +35,12 @@ static PyObject* create_png_module(){
   PyModule_AddIntConstant(module, "RGB_ALPHA", 1);
   PyModule_AddIntConstant(module, "GRAY", 2);
   PyModule_AddIntConstant(module, "GRAY_ALPHA", 3);
+  PyModule_AddIntConstant(module, "FILTER_NONE", 0);
+  PyModule_AddIntConstant(module, "FILTER_SUB", 1);
+  PyModule_AddIntConstant(module, "FILTER_UP", 2);
+  PyModule_AddIntConstant(module, "FILTER_AVERAGE", 3);
+  PyModule_AddIntConstant(module, "FILTER_PAETH", 4);
+  PyModule_AddIntConstant(module, "FILTER_ADAPTIVE", 5);
   return module;
 }
 
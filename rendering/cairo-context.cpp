@@ -13,14 +13,20 @@
 // implied. See the License for the specific language governing
 // permissions and limitations under the License.
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
+#include <map>
+#include <tuple>
+#include <utility>
 #include "bitmap/bitmap.hh"
 #include "bitmap/gradient.hh"
 #include "bitmap/paint.hh"
 #include "bitmap/pattern.hh"
 #include "geo/arc.hh"
 #include "geo/geo-func.hh"
+#include "geo/int-size.hh"
 #include "geo/pathpt.hh"
 #include "geo/rotated-size.hh"
 #include "geo/scale.hh"
@@ -32,6 +38,7 @@
 #include "util/index-iter.hh"
 #include "util/iter.hh"
 #include "util/make-vector.hh"
+#include "util/optional.hh"
 #include "util/setting-id.hh"
 #include "util/settings.hh"
 
@@ -57,32 +64,172 @@ static font_description_ptr_t get_font_description(const Settings& s){
   return fd;
 }
 
+// The number of fonts and text layouts kept by a PangoCache.
+static const int PANGO_FONT_CACHE_SIZE = 32;
+static const int PANGO_LAYOUT_CACHE_SIZE = 256;
+
+static std::atomic<int> g_fontHits(0);
+static std::atomic<int> g_fontMisses(0);
+static std::atomic<int> g_layoutHits(0);
+static std::atomic<int> g_layoutMisses(0);
+
+class FontKey{
+public:
+  explicit FontKey(const Settings& s)
+    : face(s.Get(ts_FontFace).str()),
+      size(s.Get(ts_FontSize)),
+      bold(s.GetDefault(ts_FontBold, false)),
+      italic(s.GetDefault(ts_FontItalic, false))
+  {}
+
+  bool operator<(const FontKey& other) const{
+    return std::tie(face, size, bold, italic) <
+      std::tie(other.face, other.size, other.bold, other.italic);
+  }
+
+  std::string face;
+  int size;
+  bool bold;
+  bool italic;
+};
+
+class CachedFont{
+public:
+  font_description_ptr_t description;
+  font_ptr_t font;
+  FontMetrics metrics;
+  unsigned int lastUse = 0;
+};
+
+class CachedLayout{
+public:
+  layout_ptr_t layout;
+
+  // Measurements of the text, valid while the layout serial is
+  // unchanged, i.e. until its context changes.
+  guint serial = 0;
+  Optional<IntSize> size;
+  std::vector<int> cumulativeWidths;
+  unsigned int lastUse = 0;
+};
+
+template<typename KEY, typename VALUE>
+static void evict_least_recently_used(std::map<KEY, VALUE>& entries){
+  entries.erase(std::min_element(begin(entries), end(entries),
+    [](const auto& e1, const auto& e2){
+      return e1.second.lastUse < e2.second.lastUse;
+    }));
+}
+
+class PangoCache{
+  // The most recently used font descriptions, loaded fonts with their
+  // metrics, and text layouts, so that text objects are not
+  // re-measured and re-laid out on every repaint and hit test.
+  //
+  // Pango uses a font map per thread, so each thread has its own
+  // cache (see get_pango_cache).
+public:
+  CachedFont& GetFont(const Settings& s){
+    FontKey key(s);
+    auto it = m_fonts.find(key);
+    if (it != m_fonts.end()){
+      g_fontHits++;
+      it->second.lastUse = ++m_useCount;
+      return it->second;
+    }
+
+    g_fontMisses++;
+    if (m_fonts.size() == to_size_t(PANGO_FONT_CACHE_SIZE)){
+      evict_least_recently_used(m_fonts);
+    }
+    CachedFont& font = m_fonts[key];
+    font.description = get_font_description(s);
+    auto fontMap(manage(pango_cairo_font_map_get_default()));
+    auto ctx(manage(pango_font_map_create_context(fontMap.get())));
+    font.font = manage(pango_font_map_load_font(fontMap.get(), ctx.get(),
+      font.description.get()));
+    auto metrics(manage(pango_font_get_metrics(font.font.get(), NULL)));
+    font.metrics.ascent =
+      pango_font_metrics_get_ascent(metrics.get()) / PANGO_SCALE;
+    font.metrics.descent =
+      pango_font_metrics_get_descent(metrics.get()) / PANGO_SCALE;
+    font.lastUse = ++m_useCount;
+    return font;
+  }
+
+  // Returns the layout for the text, updated for the current state of
+  // the Cairo context.
+  CachedLayout& GetLayout(cairo_ptr_t& cr, const Settings& s,
+    const utf8_string& text)
+  {
+    // Drawing and measuring use different font options, so these are
+    // part of the key, to not lay out the text again when alternating.
+    auto options(manage(cairo_font_options_create()));
+    cairo_get_font_options(cr.get(), options.get());
+    const LayoutKey key(FontKey(s), cairo_font_options_hash(options.get()),
+      text.str());
+    auto it = m_layouts.find(key);
+    if (it != m_layouts.end()){
+      g_layoutHits++;
+      CachedLayout& cached = it->second;
+      cached.lastUse = ++m_useCount;
+      pango_cairo_update_layout(cr.get(), cached.layout.get());
+      const guint serial = pango_layout_get_serial(cached.layout.get());
+      if (serial != cached.serial){
+        cached.serial = serial;
+        cached.size.Clear();
+        cached.cumulativeWidths.clear();
+      }
+      return cached;
+    }
+
+    g_layoutMisses++;
+    if (m_layouts.size() == to_size_t(PANGO_LAYOUT_CACHE_SIZE)){
+      evict_least_recently_used(m_layouts);
+    }
+    CachedFont& font = GetFont(s);
+    CachedLayout& cached = m_layouts[key];
+    cached.layout = manage(pango_cairo_create_layout(cr.get()));
+    pango_layout_set_font_description(cached.layout.get(),
+      font.description.get());
+    pango_layout_set_text(cached.layout.get(), text.c_str(), -1);
+    cached.serial = pango_layout_get_serial(cached.layout.get());
+    cached.lastUse = ++m_useCount;
+    return cached;
+  }
+
+private:
+  std::map<FontKey, CachedFont> m_fonts;
+  using LayoutKey = std::tuple<FontKey, unsigned long, std::string>;
+  std::map<LayoutKey, CachedLayout> m_layouts;
+  unsigned int m_useCount = 0;
+};
+
+static PangoCache& get_pango_cache(){
+  thread_local PangoCache cache;
+  return cache;
+}
+
 // Fixme: Should use this instead of getting extents of
 // a character (like 'M') for calculations.
-// Fixme: HOWEVER: Make this more efficient, see descent f.x
 static int get_font_ascent(const Settings& s){
-  auto fd(get_font_description(s));
-  auto fontMap(manage(pango_cairo_font_map_get_default()));
-  auto ctx(manage(pango_font_map_create_context(fontMap.get())));
-  auto font(manage(pango_font_map_load_font(fontMap.get(), ctx.get(),
-    fd.get())));
-  auto metrics(manage(pango_font_get_metrics(font.get(), NULL)));
-
-  int ascent = pango_font_metrics_get_ascent(metrics.get()) / PANGO_SCALE;
-  return ascent;
+  return get_pango_cache().GetFont(s).metrics.ascent;
 }
 
-// Fixme: Combine with get_font_ascent
-static int get_font_descent(const Settings& s){
-  auto fd(get_font_description(s));
-  auto fontMap(manage(pango_cairo_font_map_get_default()));
-  auto ctx(manage(pango_font_map_create_context(fontMap.get())));
-  auto font(manage(pango_font_map_load_font(fontMap.get(), ctx.get(),
-    fd.get())));
-  auto metrics(manage(pango_font_get_metrics(font.get(), NULL)));
+PangoCacheStats get_pango_cache_stats(){
+  PangoCacheStats stats;
+  stats.fontHits = g_fontHits;
+  stats.fontMisses = g_fontMisses;
+  stats.layoutHits = g_layoutHits;
+  stats.layoutMisses = g_layoutMisses;
+  return stats;
+}
 
-  int ascent = pango_font_metrics_get_descent(metrics.get()) / PANGO_SCALE;
-  return ascent;
+void reset_pango_cache_stats(){
+  g_fontHits = 0;
+  g_fontMisses = 0;
+  g_layoutHits = 0;
+  g_layoutMisses = 0;
 }
 
 static cairo_matrix_t faint_cairo_gradient_matrix(const LinearGradient& g,
@@ -114,6 +261,16 @@ static surface_ptr_t get_cairo_surface(Bitmap& bmp){
       bmp.m_row_stride));
 }
 
+static surface_ptr_t get_source_surface(const Bitmap& bmp){
+  // Only for reading, so does not detach shared pixels.
+  return manage(cairo_image_surface_create_for_data(
+      const_cast<uchar*>(bmp.GetRaw()),
+      CAIRO_FORMAT_ARGB32,
+      bmp.m_w,
+      bmp.m_h,
+      bmp.m_row_stride));
+}
+
 static pattern_ptr_t faint_cairo_linear_gradient(const LinearGradient& g){
   auto cg(manage(cairo_pattern_create_linear(0.0, 0.0, 1.0, 0.0)));
 
@@ -195,17 +352,15 @@ Bitmap cairo_gradient_bitmap(const Gradient& gradient,
   }
 }
 
-// Returns a new bitmap of Size sz, filled with bg which in_bmpSrc is
+// Returns a new bitmap of Size sz, filled with bg which bmpSrc is
 // transformed onto using the passed in transformation function.
 template<typename Func>
-Bitmap transform_copy(const Bitmap& in_bmpSrc, const IntSize& sz,
+Bitmap transform_copy(const Bitmap& bmpSrc, const IntSize& sz,
   const Paint& bg, const Point& offset, const Func& transform)
 {
-  // Needs non-const bitmap for source surface. Will not modify.
-  Bitmap& bmpSrc(const_cast<Bitmap&>(in_bmpSrc));
   Bitmap bmpDst(sz, bg);
   auto dstSurface(get_cairo_surface(bmpDst));
-  auto srcSurface(get_cairo_surface(bmpSrc));
+  auto srcSurface(get_source_surface(bmpSrc));
 
   auto cr(cairo_create(dstSurface));
 
@@ -373,6 +528,9 @@ public:
   explicit CairoContextImpl(Bitmap& bmp)
     : patternTri(Point(0,0), Point(100,0), 100.0)
   {
+    // Copies of the target must not share the pixels the surface
+    // draws on.
+    this->pin = bmp.Pin();
     this->surface = get_cairo_surface(bmp);
     this->cr = cairo_create(surface);
     this->srcBmp = nullptr;
@@ -391,6 +549,7 @@ public:
     delete this->radialGradient;
     delete this->pattern;
   }
+  PixelPin pin;
   cairo_ptr_t cr;
   surface_ptr_t surface;
 
@@ -460,16 +619,6 @@ void CairoContext::move_to(const Point& p){
   cairo_move_to(m_impl->cr, p.x, p.y);
 }
 
-static layout_ptr_t get_text_layout(cairo_ptr_t& cr,
-  font_description_ptr_t& fd,
-  const utf8_string& s)
-{
-  auto layout(manage(pango_cairo_create_layout(cr.get())));
-  pango_layout_set_font_description(layout, fd);
-  pango_layout_set_text(layout.get(), s.c_str(), -1);
-  return layout;
-}
-
 void CairoContext::pango_text(const Tri& t,
   const utf8_string& text,
   const Settings& s)
@@ -483,8 +632,8 @@ void CairoContext::pango_text(const Tri& t,
   cairo_font_options_set_hint_style(fontOptions.get(), CAIRO_HINT_STYLE_FULL);
   cairo_set_font_options(m_impl->cr.get(), fontOptions.get());
 
-  auto fd(get_font_description(s));
-  auto layout(get_text_layout(m_impl->cr, fd, text));
+  PangoLayout* layout =
+    get_pango_cache().GetLayout(m_impl->cr, s, text).layout.get();
 
   translate(t.P0());
   rotate(t.GetAngle());
@@ -495,7 +644,7 @@ void CairoContext::pango_text(const Tri& t,
   // Offset to anchor at the top of the text instead of the baseline.
   translate(Point(0, get_font_ascent(s)));
 
-  PangoLayoutLine* line = pango_layout_get_line_readonly(layout.get(), 0);
+  PangoLayoutLine* line = pango_layout_get_line_readonly(layout, 0);
 
   TextRenderStyle renderStyle = s.Get(ts_TextRenderStyle);
   bool renderAsPath = renderStyle == TextRenderStyle::CAIRO_PATH ||
@@ -529,9 +678,8 @@ std::vector<PathPt> CairoContext::get_text_path(const Tri& t,
 
   save();
   const Point p0(t.P0());
-  auto fd(get_font_description(s));
-
-  auto layout(get_text_layout(m_impl->cr, fd, text));
+  PangoLayout* layout =
+    get_pango_cache().GetLayout(m_impl->cr, s, text).layout.get();
 
   translate(p0);
   rotate(t.GetAngle());
@@ -546,7 +694,7 @@ std::vector<PathPt> CairoContext::get_text_path(const Tri& t,
   cairo_matrix_t mtx;
   cairo_get_matrix(m_impl->cr.get(), &mtx);
 
-  PangoLayoutLine* line = pango_layout_get_line(layout.get(), 0);
+  PangoLayoutLine* line = pango_layout_get_line(layout, 0);
   pango_cairo_layout_line_path(m_impl->cr.get(), line);
 
   std::vector<PathPt> path;
@@ -598,50 +746,43 @@ void CairoContext::new_sub_path(){
 IntSize CairoContext::pango_text_size(const utf8_string& text,
   const Settings& s) const
 {
-  auto fd(get_font_description(s));
-  auto layout(manage(pango_cairo_create_layout(m_impl->cr.get())));
-  pango_layout_set_font_description(layout, fd);
-  utf8_string useText;
-  if (text.size() > 1){
-    // Fixme: What's this?
-    useText = text.substr(0, text.size() - 2);
-  }
-  else{
-    useText = text;
+  CachedLayout& cached(get_pango_cache().GetLayout(m_impl->cr, s, text));
+  if (cached.size.NotSet()){
+    int w, h;
+    pango_layout_get_pixel_size(cached.layout.get(), &w, &h);
+    cached.size.Set(IntSize(w, h));
   }
-  pango_layout_set_text(layout.get(), text.c_str(), -1);
-
-  int w, h;
-  pango_layout_get_pixel_size(layout.get(), &w, &h);
-  return IntSize(w, h);
+  return cached.size.Get();
 }
 
 FontMetrics CairoContext::pango_font_metrics(const Settings& s) const{
-  auto fd(get_font_description(s));
-  FontMetrics m;
-  m.ascent = get_font_ascent(s);
-  m.descent = get_font_descent(s);
-  return m;
+  return get_pango_cache().GetFont(s).metrics;
 }
 
 std::vector<int> CairoContext::cumulative_text_width(const utf8_string& text,
   const Settings& s) const
 {
-  auto fd(get_font_description(s));
-  auto layout(manage(pango_cairo_create_layout(m_impl->cr.get())));
-  pango_layout_set_font_description(layout, fd);
-
-  std::vector<int> v;
-  v.push_back(0);
-  for (size_t i = 1; i <= text.size(); i++){
-    utf8_string substr(text.substr(0, i));
-
-    int w, h;
-    pango_layout_set_text(layout.get(), substr.c_str(), -1);
-    pango_layout_get_pixel_size(layout.get(), &w, &h);
-    v.push_back(w);
+  CachedLayout& cached(get_pango_cache().GetLayout(m_impl->cr, s, text));
+  if (cached.cumulativeWidths.empty()){
+    // Measures each prefix with a layout sharing the context of the
+    // cached layout.
+    auto layout(manage(pango_layout_new(
+      pango_layout_get_context(cached.layout.get()))));
+    pango_layout_set_font_description(layout.get(),
+      pango_layout_get_font_description(cached.layout.get()));
+
+    std::vector<int>& v(cached.cumulativeWidths);
+    v.push_back(0);
+    for (size_t i = 1; i <= text.size(); i++){
+      utf8_string substr(text.substr(0, i));
+
+      int w, h;
+      pango_layout_set_text(layout.get(), substr.c_str(), -1);
+      pango_layout_get_pixel_size(layout.get(), &w, &h);
+      v.push_back(w);
+    }
   }
-  return v;
+  return cached.cumulativeWidths;
 }
 
 void CairoContext::restore(){
@@ -768,7 +909,7 @@ void CairoContext::set_source_surface(const Pattern& pattern){
   // Fixme: Probably no need to copy bitmap AND pattern.
   // Just clone the pattern, and use GetBitmap(), storing the pointer
   m_impl->srcBmp = new Bitmap(pattern.GetBitmap()); // Fixme: check format
-  m_impl->srcSurface = get_cairo_surface(*(m_impl->srcBmp));
+  m_impl->srcSurface = get_source_surface(*(m_impl->srcBmp));
   m_impl->srcPattern.reset(cairo_pattern_create_for_surface(
     m_impl->srcSurface.get()));
   m_impl->pattern = new Pattern(pattern);
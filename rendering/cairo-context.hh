@@ -45,6 +45,18 @@ Bitmap cairo_gradient_bitmap(const Gradient&, const IntSize&);
 std::string get_cairo_version();
 std::string get_pango_version();
 
+struct PangoCacheStats{
+  int fontHits = 0;
+  int fontMisses = 0;
+  int layoutHits = 0;
+  int layoutMisses = 0;
+};
+
+// Hit and miss counts for the caches of fonts and text layouts used
+// for text by all CairoContexts, for profiling.
+PangoCacheStats get_pango_cache_stats();
+void reset_pango_cache_stats();
+
 class CairoContextImpl;
 class CairoContext{
 public:
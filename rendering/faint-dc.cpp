@@ -23,6 +23,7 @@
 #include "bitmap/draw.hh"
 #include "bitmap/scale-bilinear.hh"
 #include "bitmap/scale-nearest.hh"
+#include "bitmap/tiled-alpha-map.hh"
 #include "geo/arc.hh"
 #include "geo/arrowhead.hh"
 #include "geo/geo-func.hh"
@@ -39,6 +40,7 @@
 #include "rendering/cairo-context.hh"
 #include "rendering/faint-dc.hh"
 #include "rendering/filter-class.hh"
+#include "rendering/zoomed-bitmap-cache.hh"
 #include "text/utf8-string.hh"
 #include "util/default-settings.hh"
 #include "util/math-constants.hh"
@@ -397,6 +399,18 @@ void FaintDC::Arc(const Tri& tri, const AngleSpan& span, const Settings& s){
 
 void FaintDC::Blit(const Bitmap& bmp, const Point& topLeft,
   const Settings& settings)
+{
+  BlitZoomed(bmp, topLeft, settings, nullptr);
+}
+
+void FaintDC::Blit(const Bitmap& bmp, const Point& topLeft,
+  const Settings& settings, ZoomedBitmapCache& cache)
+{
+  BlitZoomed(bmp, topLeft, settings, &cache);
+}
+
+void FaintDC::BlitZoomed(const Bitmap& bmp, const Point& topLeft,
+  const Settings& settings, ZoomedBitmapCache* cache)
 {
   IntPoint imagePt(floored(topLeft * m_sc + m_origin));
   if (overextends(imagePt, m_bitmap)){
@@ -409,88 +423,91 @@ void FaintDC::Blit(const Bitmap& bmp, const Point& topLeft,
   if (bg.IsColor() && bgStyle  == BackgroundStyle::MASKED){
     Color bgCol(bg.GetColor());
     if (alphaBlend){
-      BitmapBlendAlphaMasked(bmp, bgCol, imagePt);
+      BitmapBlendAlphaMasked(bmp, bgCol, imagePt, cache);
     }
     else{
-      BitmapSetAlphaMasked(bmp, bgCol, imagePt);
+      BitmapSetAlphaMasked(bmp, bgCol, imagePt, cache);
     }
   }
   else{
     if (alphaBlend){
-      BitmapBlendAlpha(bmp, imagePt);
+      BitmapBlendAlpha(bmp, imagePt, cache);
     }
     else{
-      BitmapSetAlpha(bmp, imagePt);
+      BitmapSetAlpha(bmp, imagePt, cache);
     }
   }
 }
 
-void FaintDC::BitmapBlendAlpha(const Bitmap& drawnBitmap,
-  const IntPoint& topLeft)
+Optional<Bitmap> FaintDC::ZoomVisible(const Bitmap& bmp, IntPoint& topLeft,
+  ZoomedBitmapCache* cache) const
 {
-  if (m_sc < 1){
-    const Bitmap scaled(scale_bilinear(drawnBitmap,
-      rounded(drawnBitmap.GetSize() * Scale(m_sc))));
-    blend(offsat(scaled, topLeft), onto(m_bitmap));
-  }
-  else if (m_sc > 1){
-    const Bitmap scaled(scale_nearest(drawnBitmap, truncated(m_sc)));
-    blend(offsat(scaled, topLeft), onto(m_bitmap));
+  if (!(m_sc < 1) && !(m_sc > 1)){
+    return option(bmp);
   }
-  else{
-    blend(offsat(drawnBitmap, topLeft), onto(m_bitmap));
+
+  const IntSize size(m_sc < 1 ?
+    rounded(bmp.GetSize() * Scale(m_sc)) :
+    bmp.GetSize() * truncated(m_sc));
+
+  // Only the part inside the target is scaled, so that scaling at
+  // high zoom does not depend on the size of the zoomed bitmap.
+  const IntRect visible(intersection(IntRect(topLeft, size),
+    IntRect(IntPoint(0, 0), m_bitmap.GetSize())));
+  if (empty(visible)){
+    return no_option();
   }
+
+  const IntRect region(visible.TopLeft() - topLeft, visible.GetSize());
+  topLeft = visible.TopLeft();
+  auto zoomRegion = [&](){
+    return m_sc < 1 ?
+      scale_bilinear(bmp, size, region) :
+      scale_nearest(bmp, size, region);
+  };
+  return option(cache == nullptr ?
+    zoomRegion() :
+    cache->Get(bmp, m_sc, region, zoomRegion));
+}
+
+void FaintDC::BitmapBlendAlpha(const Bitmap& drawnBitmap,
+  const IntPoint& topLeft, ZoomedBitmapCache* cache)
+{
+  IntPoint pos(topLeft);
+  ZoomVisible(drawnBitmap, pos, cache).IfSet(
+    [&](const Bitmap& zoomed){
+      blend(offsat(zoomed, pos), onto(m_bitmap));
+    });
 }
 
 void FaintDC::BitmapBlendAlphaMasked(const Bitmap& drawnBitmap,
-  const Color& maskColor, const IntPoint& topLeft)
+  const Color& maskColor, const IntPoint& topLeft, ZoomedBitmapCache* cache)
 {
-  if (m_sc < 1){
-    const Bitmap scaled(scale_bilinear(drawnBitmap,
-      rounded(drawnBitmap.GetSize() * Scale(m_sc))));
-    blend_masked(offsat(scaled, topLeft), onto(m_bitmap), maskColor);
-  }
-  else if (m_sc > 1){
-    const Bitmap scaled(scale_nearest(drawnBitmap, truncated(m_sc)));
-    blend_masked(offsat(scaled, topLeft), onto(m_bitmap), maskColor);
-  }
-  else{
-    blend_masked(offsat(drawnBitmap, topLeft), onto(m_bitmap), maskColor);
-  }
+  IntPoint pos(topLeft);
+  ZoomVisible(drawnBitmap, pos, cache).IfSet(
+    [&](const Bitmap& zoomed){
+      blend_masked(offsat(zoomed, pos), onto(m_bitmap), maskColor);
+    });
 }
 
 void FaintDC::BitmapSetAlpha(const Bitmap& drawnBitmap,
-  const IntPoint& topLeft)
+  const IntPoint& topLeft, ZoomedBitmapCache* cache)
 {
-  if (m_sc < 1){
-    const Bitmap scaled(scale_bilinear(drawnBitmap,
-      rounded(drawnBitmap.GetSize() * Scale(m_sc))));
-    blit(offsat(scaled, topLeft), onto(m_bitmap));
-  }
-  else if (m_sc > 1){
-    const Bitmap scaled(scale_nearest(drawnBitmap, truncated(m_sc)));
-    blit(offsat(scaled, topLeft), onto(m_bitmap));
-  }
-  else{
-    blit(offsat(drawnBitmap, topLeft), onto(m_bitmap));
-  }
+  IntPoint pos(topLeft);
+  ZoomVisible(drawnBitmap, pos, cache).IfSet(
+    [&](const Bitmap& zoomed){
+      blit(offsat(zoomed, pos), onto(m_bitmap));
+    });
 }
 
 void FaintDC::BitmapSetAlphaMasked(const Bitmap& drawnBitmap,
-  const Color& maskColor, const IntPoint& topLeft)
+  const Color& maskColor, const IntPoint& topLeft, ZoomedBitmapCache* cache)
 {
-  if (m_sc < 1){
-    Bitmap scaled(scale_bilinear(drawnBitmap,
-      rounded(drawnBitmap.GetSize() * Scale(m_sc))));
-    blit_masked(offsat(scaled, topLeft), onto(m_bitmap), maskColor);
-  }
-  else if (m_sc > 1){
-    Bitmap scaled(scale_nearest(drawnBitmap, truncated(m_sc)));
-    blit_masked(offsat(scaled, topLeft), onto(m_bitmap), maskColor);
-  }
-  else{
-    blit_masked(offsat(drawnBitmap, topLeft), onto(m_bitmap), maskColor);
-  }
+  IntPoint pos(topLeft);
+  ZoomVisible(drawnBitmap, pos, cache).IfSet(
+    [&](const Bitmap& zoomed){
+      blit_masked(offsat(zoomed, pos), onto(m_bitmap), maskColor);
+    });
 }
 
 void FaintDC::Blend(const Offsat<AlphaMap>& alpha,
@@ -527,6 +544,46 @@ void FaintDC::Blend(const Offsat<AlphaMap>& alpha,
   }
 }
 
+void FaintDC::Blend(const TiledAlphaMap& alpha,
+  const IntPoint& anchor,
+  const Settings& s)
+{
+  const Paint paint(get_fg(s, m_origin, anchor));
+  const IntPoint imagePt(floored(m_origin));
+  auto f = get_filter(s);
+  if (f == nullptr && !paint.IsGradient()){
+    // Only the allocated tiles within the target need blending. The
+    // pattern is offset so that it is anchored as for a single map.
+    const IntRect r(floored(-m_origin), m_bitmap.GetSize());
+    alpha.VisitTiles(r, [&](const AlphaMapRef& tile, const IntPoint& pos){
+      const IntPoint tilePt(floored(floated(pos) * m_sc + m_origin));
+      blend(offsat(tile, tilePt), onto(m_bitmap),
+        offsat(paint, imagePt - tilePt));
+    });
+    return;
+  }
+
+  // Filters and gradients depend on the entire stroke
+  alpha.BoundingRect().IfSet([&](const IntRect& bounds){
+    const AlphaMap sub(alpha.SubCopy(bounds));
+    const IntPoint subPt(floored(floated(bounds.TopLeft()) * m_sc +
+      m_origin));
+
+    if (f == nullptr){
+      blend(offsat(sub.FullReference(), subPt), onto(m_bitmap), paint);
+      return;
+    }
+
+    Padding p(f->GetPadding());
+    Bitmap bmp(sub.GetSize() + p.GetSize(), color_transparent_white);
+    IntPoint offset(p.left, p.top);
+    blend(offsat(sub.FullReference(), offset), onto(bmp),
+      offsat(paint, imagePt - subPt));
+    f->Apply(bmp);
+    blend(offsat(bmp, subPt - offset), onto(m_bitmap));
+  });
+}
+
 void FaintDC::Clear(const Color& color){
   clear(m_bitmap, color);
 }
@@ -34,7 +34,9 @@ class CairoContext;
 class Color;
 class Filter;
 class Settings;
+class TiledAlphaMap;
 class utf8_string;
+class ZoomedBitmapCache;
 
 class category_faint_dc;
 using origin_t = Distinct<Point, category_faint_dc, 0>;
@@ -54,7 +56,13 @@ public:
   std::string ErrorString() const;
   void Arc(const Tri&, const AngleSpan&, const Settings&);
   void Blit(const Bitmap&, const Point& topLeft, const Settings&);
+
+  // Blits using the cache for the zoomed region of the bitmap, for
+  // bitmaps that are drawn repeatedly (e.g. raster objects).
+  void Blit(const Bitmap&, const Point& topLeft, const Settings&,
+    ZoomedBitmapCache&);
   void Blend(const Offsat<AlphaMap>&, const IntPoint& anchor, const Settings&);
+  void Blend(const TiledAlphaMap&, const IntPoint& anchor, const Settings&);
   void Clear(const Color&);
   void Ellipse(const Tri&, const Settings&);
   Color GetPixel(const Point&) const;
@@ -86,16 +94,28 @@ public:
   FaintDC(const FaintDC&) = delete;
   FaintDC& operator=(const FaintDC&) = delete;
 private:
-  void BitmapSetAlpha(const Bitmap&, const IntPoint&);
-  void BitmapSetAlphaMasked(const Bitmap&, const Color&, const IntPoint&);
-  void BitmapBlendAlpha(const Bitmap&, const IntPoint&);
-  void BitmapBlendAlphaMasked(const Bitmap&, const Color&, const IntPoint&);
+  void BitmapSetAlpha(const Bitmap&, const IntPoint&,
+    ZoomedBitmapCache* = nullptr);
+  void BitmapSetAlphaMasked(const Bitmap&, const Color&, const IntPoint&,
+    ZoomedBitmapCache* = nullptr);
+  void BitmapBlendAlpha(const Bitmap&, const IntPoint&,
+    ZoomedBitmapCache* = nullptr);
+  void BitmapBlendAlphaMasked(const Bitmap&, const Color&, const IntPoint&,
+    ZoomedBitmapCache* = nullptr);
+  void BlitZoomed(const Bitmap&, const Point&, const Settings&,
+    ZoomedBitmapCache*);
   void DrawRasterEllipse(const Tri&, const Settings&);
   void DrawRasterEllipse(const Tri&, const Filter&, const Settings&);
 
   void DrawRasterPolygon(const std::vector<Point>&, const Settings&);
   void DrawRasterPolyLine(const std::vector<Point>&, const Settings&);
   void DrawRasterRect(const Tri&, const Settings&);
+
+  // Returns the part of the bitmap inside the target when zoomed by
+  // the scale and placed at topLeft, and moves topLeft to the
+  // position of that part.
+  Optional<Bitmap> ZoomVisible(const Bitmap&, IntPoint& topLeft,
+    ZoomedBitmapCache*) const;
   void DrawRasterRect(const Tri&, const Filter&, const Settings&);
   Bitmap& m_bitmap;
   std::unique_ptr<CairoContext> m_cr;
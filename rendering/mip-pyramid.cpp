@@ -0,0 +1,146 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <algorithm>
+#include <cassert>
+#include "geo/geo-func.hh"
+#include "geo/int-point.hh"
+#include "geo/int-rect.hh"
+#include "rendering/mip-pyramid.hh"
+#include "util/image.hh"
+
+namespace faint{
+
+static IntSize halved(const IntSize& sz){
+  return {(sz.w + 1) / 2, (sz.h + 1) / 2};
+}
+
+// Sets the pixels in the rectangle of the half size bitmap to the
+// average of the corresponding 2x2 pixels in the source bitmap.
+static void halve_region(const Bitmap& src, Bitmap& dst, const IntRect& r){
+  const IntSize srcSize(src.GetSize());
+  const int srcStride = src.GetStride();
+  const int dstStride = dst.GetStride();
+  const uchar* srcData = src.GetRaw();
+  uchar* dstData = dst.GetRaw();
+
+  for (int y = r.y; y != r.y + r.h; y++){
+    const uchar* row0 = srcData + 2 * y * srcStride;
+    const uchar* row1 = srcData + std::min(2 * y + 1, srcSize.h - 1) *
+      srcStride;
+    uchar* out = dstData + y * dstStride + r.x * ByPP;
+
+    for (int x = r.x; x != r.x + r.w; x++){
+      const int x0 = 2 * x * ByPP;
+      const int x1 = std::min(2 * x + 1, srcSize.w - 1) * ByPP;
+      for (int c = 0; c != ByPP; c++){
+        const int sum = row0[x0 + c] + row0[x1 + c] +
+          row1[x0 + c] + row1[x1 + c];
+        out[c] = static_cast<uchar>((sum + 2) / 4);
+      }
+      out += ByPP;
+    }
+  }
+}
+
+const Bitmap& MipPyramid::GetLevel(const Image& image, int level){
+  assert(level > 0);
+  const Bitmap& bg = image.GetBackground().Get<Bitmap>().Get();
+  if (bg.GetSize() != m_imageSize){
+    m_levels.clear();
+    m_imageSize = bg.GetSize();
+  }
+
+  for (int i = 1; i <= level; i++){
+    Update(image, i);
+  }
+  return m_levels[to_size_t(level - 1)].bmp;
+}
+
+int MipPyramid::GetNumLevels() const{
+  return resigned(m_levels.size());
+}
+
+void MipPyramid::Update(const Image& image, int level){
+  const Bitmap& src = level == 1 ?
+    image.GetBackground().Get<Bitmap>().Get() :
+    m_levels[to_size_t(level - 2)].bmp;
+
+  const RasterChanges& changes = image.GetRasterChanges();
+  const int generation = changes.GetGeneration();
+
+  if (GetNumLevels() < level){
+    Level created;
+    created.bmp = Bitmap(halved(src.GetSize()));
+    created.generation = generation;
+    halve_region(src, created.bmp, rect_from_size(created.bmp.GetSize()));
+    m_levels.emplace_back(std::move(created));
+    return;
+  }
+
+  Level& l = m_levels[to_size_t(level - 1)];
+  if (l.generation == generation){
+    return;
+  }
+
+  // Recompute the tiles covering changed image pixels
+  const IntRect levelRect(rect_from_size(l.bmp.GetSize()));
+  const int factor = 1 << level;
+  for (int y = 0; y < levelRect.h; y += MIP_TILE_SIZE){
+    for (int x = 0; x < levelRect.w; x += MIP_TILE_SIZE){
+      const IntRect r(intersection(levelRect,
+        IntRect(IntPoint(x, y), IntSize(MIP_TILE_SIZE, MIP_TILE_SIZE))));
+      const IntRect imageRect(r.TopLeft() * factor, r.GetSize() * factor);
+      if (changes.ChangedSince(l.generation, imageRect)){
+        halve_region(src, l.bmp, r);
+      }
+    }
+  }
+  l.generation = generation;
+}
+
+MipPyramidCache::MipPyramidCache(int maxFrames)
+  : m_maxFrames(maxFrames)
+{
+  assert(m_maxFrames > 0);
+}
+
+const Bitmap& MipPyramidCache::GetLevel(const Image& image, int level){
+  auto it = m_pyramids.find(image.GetId());
+  if (it == m_pyramids.end()){
+    if (resigned(m_pyramids.size()) == m_maxFrames){
+      m_pyramids.erase(std::min_element(begin(m_pyramids), end(m_pyramids),
+        [](const auto& p1, const auto& p2){
+          return p1.second.lastUse < p2.second.lastUse;
+        }));
+    }
+    it = m_pyramids.emplace(image.GetId(), Entry()).first;
+  }
+
+  Entry& entry = it->second;
+  entry.lastUse = ++m_useCount;
+  return entry.pyramid.GetLevel(image, level);
+}
+
+int mip_level_for_zoom(coord zoom){
+  const int maxLevel = 16;
+  int level = 0;
+  while (level < maxLevel && zoom * (1 << (level + 1)) <= 1.0){
+    level++;
+  }
+  return level;
+}
+
+} // namespace
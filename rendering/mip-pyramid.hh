@@ -0,0 +1,89 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_MIP_PYRAMID_HH
+#define FAINT_MIP_PYRAMID_HH
+#include <map>
+#include <vector>
+#include "bitmap/bitmap.hh"
+#include "geo/primitive.hh"
+#include "util/id-types.hh"
+
+namespace faint{
+
+class Image;
+
+// The width and height, in level pixels, of the regions in which mip
+// levels are updated.
+const int MIP_TILE_SIZE = 128;
+
+class MipPyramid{
+  // Successively halved copies of an image background, for painting
+  // zoomed-out views from a small level instead of from the full
+  // size bitmap.
+  //
+  // Levels are built when first requested. Later requests only
+  // recompute the parts of the levels where the image reports
+  // changed pixels (see Image::GetRasterChanges).
+public:
+  // Returns the level of the image background, which must be a
+  // bitmap. Level 1 is half the size of the image (rounded up),
+  // level 2 a quarter and so on.
+  const Bitmap& GetLevel(const Image&, int level);
+
+  // The number of levels built so far.
+  int GetNumLevels() const;
+private:
+  void Update(const Image&, int level);
+
+  class Level{
+  public:
+    Bitmap bmp;
+    int generation = 0;
+  };
+
+  IntSize m_imageSize;
+  std::vector<Level> m_levels;
+};
+
+class MipPyramidCache{
+  // Mip pyramids for the most recently painted frames.
+public:
+  explicit MipPyramidCache(int maxFrames = 4);
+
+  // Returns the level of the pyramid for the image.
+  const Bitmap& GetLevel(const Image&, int level);
+
+  MipPyramidCache(const MipPyramidCache&) = delete;
+  MipPyramidCache& operator=(const MipPyramidCache&) = delete;
+private:
+  class Entry{
+  public:
+    MipPyramid pyramid;
+    unsigned int lastUse = 0;
+  };
+  int m_maxFrames;
+  std::map<FrameId, Entry> m_pyramids;
+  unsigned int m_useCount = 0;
+};
+
+// The pyramid level to use when painting at the zoom, i.e. the
+// smallest level that is not smaller than the zoomed image. Zero for
+// zooms above 50%, where the image itself should be used.
+int mip_level_for_zoom(coord zoom);
+
+} // namespace
+
+#endif
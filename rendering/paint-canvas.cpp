@@ -22,6 +22,7 @@
 #include "app/canvas-handle.hh"
 #include "bitmap/bitmap.hh"
 #include "bitmap/draw.hh"
+#include "bitmap/lazy-bitmap.hh"
 #include "bitmap/scale-bilinear.hh"
 #include "bitmap/scale-nearest.hh"
 #include "geo/canvas-geo.hh"
@@ -37,9 +38,11 @@
 #include "objects/object.hh"
 #include "rendering/extra-overlay.hh"
 #include "rendering/faint-dc.hh"
+#include "rendering/mip-pyramid.hh"
 #include "rendering/overlay.hh"
 #include "rendering/overlay-dc-wx.hh"
 #include "rendering/paint-canvas.hh"
+#include "rendering/scaled-tile-cache.hh"
 #include "tools/tool.hh"
 #include "tools/tool-wrapper.hh"
 #include "util-wx/convert-wx.hh"
@@ -204,14 +207,22 @@ struct PaintInfo{
   Rect imageCoordRect;
 };
 
+static void set_region(PaintInfo& info,
+  const IntSize& bmpSize,
+  const IntRect& viewRect,
+  const CanvasGeo& geo)
+{
+  info.bmpSize = bmpSize;
+  info.imageRegion = get_image_region(viewRect, bmpSize, geo);
+  info.imageCoordRect = view_to_image(viewRect, geo);
+}
+
 static void from_bitmap(PaintInfo& info,
   const Bitmap& bmp,
   const IntRect& viewRect,
   const CanvasGeo& geo)
 {
-  info.bmpSize = bmp.GetSize();
-  info.imageRegion = get_image_region(viewRect, info.bmpSize, geo);
-  info.imageCoordRect = view_to_image(viewRect, geo);
+  set_region(info, bmp.GetSize(), viewRect, geo);
   if (empty(info.imageRegion)){
     return;
   }
@@ -224,12 +235,127 @@ static void from_color(PaintInfo& info,
   const IntRect rView,
   const CanvasGeo& geo)
 {
-  info.bmpSize = size;
-  info.imageRegion = get_image_region(rView, size, geo);
-  info.imageCoordRect = view_to_image(rView, geo);
+  set_region(info, size, rView, geo);
   info.subBitmap = Bitmap(info.imageRegion.GetSize(), color);
 }
 
+static ScaledTileCache& get_tile_cache(){
+  static ScaledTileCache cache;
+  return cache;
+}
+
+static MipPyramidCache& get_mip_pyramids(){
+  static MipPyramidCache pyramids;
+  return pyramids;
+}
+
+// How the scaled background is created
+enum class ScaledFrom{
+  REGION, // Scaling the 1:1 image region (which may have been drawn on)
+  TILES, // Composing cached enlarged tiles
+  MIP_LEVEL, // Scaling the region of a smaller mip pyramid level
+  SUBSAMPLED // Scaling every n:th pixel of a lazily read region
+};
+
+static ScaledFrom get_scaled_from(const CanvasGeo& geo, bool anyBeforeZoom){
+  // The cached bitmaps can only be used when nothing is drawn onto
+  // the image before zooming.
+  const coord zoom = geo.zoom.GetScaleFactor();
+  if (anyBeforeZoom){
+    return ScaledFrom::REGION;
+  }
+  else if (zoom > 1.0){
+    return ScaledFrom::TILES;
+  }
+  else if (mip_level_for_zoom(zoom) > 0){
+    return ScaledFrom::MIP_LEVEL;
+  }
+  return ScaledFrom::REGION;
+}
+
+static IntRect align_to_mip_level(const IntRect& r,
+  int level,
+  const IntSize& imageSize)
+{
+  // Expand the region to whole mip level pixels, so that the scaled
+  // mip region matches the region exactly.
+  const int f = 1 << level;
+  const IntPoint topLeft((r.TopLeft() / f) * f);
+  const IntPoint bottomRight((r.BottomRight() / f + IntPoint(1, 1)) * f -
+    IntPoint(1, 1));
+  return intersection(IntRect(topLeft, bottomRight),
+    rect_from_size(imageSize));
+}
+
+static ScaledFrom from_lazy(PaintInfo& info,
+  const LazyBitmap& lazy,
+  const IntRect& viewRect,
+  const CanvasGeo& geo,
+  bool anyBeforeZoom)
+{
+  // Reads only the visible pixels, and when zoomed out only as many as
+  // a mip level would have.
+  set_region(info, lazy.GetSize(), viewRect, geo);
+  if (empty(info.imageRegion)){
+    return ScaledFrom::REGION;
+  }
+
+  const int level = mip_level_for_zoom(geo.zoom.GetScaleFactor());
+  if (anyBeforeZoom || level == 0){
+    info.subBitmap = get_region(lazy, info.imageRegion);
+    return ScaledFrom::REGION;
+  }
+
+  info.imageRegion = align_to_mip_level(info.imageRegion, level,
+    info.bmpSize);
+  info.subBitmap = get_subsampled(lazy, info.imageRegion, 1 << level);
+  return ScaledFrom::SUBSAMPLED;
+}
+
+static Bitmap scaled_from_mip_level(const Image& image,
+  const IntRect& region,
+  coord zoom)
+{
+  const int level = mip_level_for_zoom(zoom);
+  const Bitmap& mip = get_mip_pyramids().GetLevel(image, level);
+  const int f = 1 << level;
+  const IntRect mipRegion(intersection(rect_from_size(mip.GetSize()),
+    IntRect(region.TopLeft() / f,
+      IntSize((region.w + f - 1) / f, (region.h + f - 1) / f))));
+
+  return scale_bilinear(subbitmap(mip, mipRegion),
+    rounded(region.GetSize() * Scale(zoom)));
+}
+
+static Bitmap get_scaled(ScaledFrom scaledFrom,
+  const PaintInfo& info,
+  const Image& active,
+  const ZoomLevel& zoomLevel)
+{
+  const coord zoom = zoomLevel.GetScaleFactor();
+  switch (scaledFrom){
+  case ScaledFrom::TILES:
+    return get_tile_cache().GetScaled(active, info.imageRegion,
+      rounded(zoom));
+
+  case ScaledFrom::MIP_LEVEL:
+    return scaled_from_mip_level(active, info.imageRegion, zoom);
+
+  case ScaledFrom::SUBSAMPLED:
+    return scale_bilinear(info.subBitmap,
+      rounded(info.imageRegion.GetSize() * Scale(zoom)));
+
+  case ScaledFrom::REGION:
+    break;
+  }
+
+  return zoomLevel.At100() ?
+    info.subBitmap : (zoom > 1.0 ?
+      scale_nearest(info.subBitmap, rounded(zoom)):
+      scale_bilinear(info.subBitmap,
+        rounded(info.subBitmap.GetSize() * Scale(zoom))));
+}
+
 static void set_origin(wxDC& dc, const IntPoint& p){
   dc.SetDeviceOrigin(p.x, p.y);
 }
@@ -317,18 +443,45 @@ void paint_canvas(wxDC& paintDC,
   int objectHandleWidth,
   Drawable&& eo)
 {
+  // Raster tools and floating selections are drawn to the 1:1 bitmap
+  std::vector<Drawable*> drawables = {&tool, &eo};
+  const bool anyBeforeZoom = rasterSelection.Floating() ||
+    std::any_of(begin(drawables), end(drawables),
+      [layer](const Drawable* d){
+        return d->DrawBeforeZoom(layer);
+      });
+
   PaintInfo info;
+  ScaledFrom scaledFrom = ScaledFrom::REGION;
   if (auto bitmapMirage = weakBitmapMirage.lock()){
     // Use the bitmap mirage as the raster background (this is for
     // feedback from some operation in a dialog, e.g.
     // brightness/contrast).
     from_bitmap(info, *bitmapMirage, updateRegion, state.geo);
   }
+  else if (const LazyBitmap* lazy = active.GetLazyBackground()){
+    // A huge image which has not been read into a Bitmap.
+    scaledFrom = from_lazy(info, *lazy, updateRegion, state.geo,
+      anyBeforeZoom);
+  }
   else{
     active.GetBackground().Visit(
       [&](const Bitmap& bg){
         // Use the image background bitmap.
-        from_bitmap(info, bg, updateRegion, state.geo);
+        scaledFrom = get_scaled_from(state.geo, anyBeforeZoom);
+        if (scaledFrom == ScaledFrom::REGION){
+          from_bitmap(info, bg, updateRegion, state.geo);
+        }
+        else{
+          // The scaled bitmap is created from cached bitmaps instead
+          // of the 1:1 region.
+          set_region(info, bg.GetSize(), updateRegion, state.geo);
+          if (scaledFrom == ScaledFrom::MIP_LEVEL && !empty(info.imageRegion)){
+            info.imageRegion = align_to_mip_level(info.imageRegion,
+              mip_level_for_zoom(state.geo.zoom.GetScaleFactor()),
+              info.bmpSize);
+          }
+        }
       },
       [&](const ColorSpan& bg){
         // No raster background - create on the fly.
@@ -346,13 +499,6 @@ void paint_canvas(wxDC& paintDC,
   Overlays overlays;
 
   // Draw raster tool and floating selection to the 1:1 bitmap
-  std::vector<Drawable*> drawables = {&tool, &eo};
-  const bool anyBeforeZoom = rasterSelection.Floating() ||
-    std::any_of(begin(drawables), end(drawables),
-      [layer](const Drawable* d){
-        return d->DrawBeforeZoom(layer);
-      });
-
   if (anyBeforeZoom){
     FaintDC dc(info.subBitmap,
       origin_t(-floated(info.imageRegion.TopLeft())));
@@ -370,11 +516,7 @@ void paint_canvas(wxDC& paintDC,
 
   // Create a scaled bitmap for object graphics and overlays
   const coord zoom = state.geo.zoom.GetScaleFactor();
-  Bitmap scaled = state.geo.zoom.At100() ?
-    info.subBitmap : (zoom > 1.0 ?
-      scale_nearest(info.subBitmap, rounded(zoom)):
-      scale_bilinear(info.subBitmap,
-        rounded(info.subBitmap.GetSize() * Scale(zoom))));
+  Bitmap scaled = get_scaled(scaledFrom, info, active, state.geo.zoom);
 
   if (!bitmap_ok(scaled)){
     return paint_without_image(paintDC, updateRegion, state.geo,
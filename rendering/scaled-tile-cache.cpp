@@ -0,0 +1,143 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <algorithm>
+#include <cassert>
+#include <tuple>
+#include "bitmap/draw.hh"
+#include "bitmap/scale-nearest.hh"
+#include "geo/int-point.hh"
+#include "geo/int-rect.hh"
+#include "geo/primitive.hh"
+#include "rendering/scaled-tile-cache.hh"
+#include "util/image.hh"
+
+namespace faint{
+
+static size_t memory_usage(const Bitmap& bmp){
+  return to_size_t(bmp.GetStride()) * to_size_t(bmp.GetSize().h);
+}
+
+static IntRect tile_rect(int tx, int ty, int tileSize,
+  const IntSize& imageSize)
+{
+  return intersection(
+    IntRect(IntPoint(tx * tileSize, ty * tileSize),
+      IntSize(tileSize, tileSize)),
+    IntRect(IntPoint(0,0), imageSize));
+}
+
+int scaled_tile_image_size(int scale){
+  assert(scale > 0);
+  return std::max(SCALED_TILE_SIZE / scale, 1);
+}
+
+bool ScaledTileCache::TileKey::operator<(const TileKey& other) const{
+  return std::make_tuple(frame.Raw(), scale, x, y) <
+    std::make_tuple(other.frame.Raw(), other.scale, other.x, other.y);
+}
+
+ScaledTileCache::ScaledTileCache(size_t memoryBudget)
+  : m_memoryBudget(memoryBudget)
+{}
+
+Bitmap ScaledTileCache::GetScaled(const Image& image,
+  const IntRect& region,
+  int scale)
+{
+  assert(scale > 0);
+  const Bitmap& bg = image.GetBackground().Get<Bitmap>().Get();
+  assert(!empty(region));
+
+  Bitmap scaled(region.GetSize() * scale);
+  const int tileSize = scaled_tile_image_size(scale);
+  const int tx0 = region.Left() / tileSize;
+  const int tx1 = region.Right() / tileSize;
+  const int ty0 = region.Top() / tileSize;
+  const int ty1 = region.Bottom() / tileSize;
+
+  for (int ty = ty0; ty <= ty1; ty++){
+    for (int tx = tx0; tx <= tx1; tx++){
+      const Bitmap& tile = GetTile(image, bg,
+        TileKey{image.GetId(), scale, tx, ty});
+      const IntPoint tilePos(tx * tileSize, ty * tileSize);
+      blit(offsat(tile, (tilePos - region.TopLeft()) * scale),
+        onto(scaled));
+    }
+  }
+  return scaled;
+}
+
+void ScaledTileCache::Clear(){
+  m_tiles.clear();
+  m_memoryUsage = 0;
+}
+
+int ScaledTileCache::GetCount() const{
+  return resigned(m_tiles.size());
+}
+
+size_t ScaledTileCache::GetMemoryUsage() const{
+  return m_memoryUsage;
+}
+
+const Bitmap& ScaledTileCache::GetTile(const Image& image,
+  const Bitmap& bg,
+  const TileKey& key)
+{
+  const IntRect r(tile_rect(key.x, key.y, scaled_tile_image_size(key.scale),
+    bg.GetSize()));
+  const RasterChanges& changes = image.GetRasterChanges();
+
+  auto it = m_tiles.find(key);
+  if (it != m_tiles.end()){
+    Tile& tile = it->second;
+    if (tile.imageSize == bg.GetSize() &&
+      !changes.ChangedSince(tile.generation, r))
+    {
+      tile.generation = changes.GetGeneration();
+      tile.lastUse = ++m_useCount;
+      return tile.bmp;
+    }
+    m_memoryUsage -= memory_usage(tile.bmp);
+    m_tiles.erase(it);
+  }
+
+  Bitmap bmp(scale_nearest(subbitmap(bg, r), key.scale));
+  const size_t required = memory_usage(bmp);
+  while (!m_tiles.empty() && m_memoryUsage + required > m_memoryBudget){
+    EvictLeastRecentlyUsed();
+  }
+
+  Tile& tile = m_tiles[key];
+  tile.bmp = std::move(bmp);
+  tile.imageSize = bg.GetSize();
+  tile.generation = changes.GetGeneration();
+  tile.lastUse = ++m_useCount;
+  m_memoryUsage += required;
+  return tile.bmp;
+}
+
+void ScaledTileCache::EvictLeastRecentlyUsed(){
+  assert(!m_tiles.empty());
+  auto oldest = std::min_element(begin(m_tiles), end(m_tiles),
+    [](const auto& t1, const auto& t2){
+      return t1.second.lastUse < t2.second.lastUse;
+    });
+  m_memoryUsage -= memory_usage(oldest->second.bmp);
+  m_tiles.erase(oldest);
+}
+
+} // namespace
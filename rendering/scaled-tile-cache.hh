@@ -0,0 +1,93 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_SCALED_TILE_CACHE_HH
+#define FAINT_SCALED_TILE_CACHE_HH
+#include <map>
+#include "bitmap/bitmap.hh"
+#include "util/id-types.hh"
+
+namespace faint{
+
+class Image;
+class IntRect;
+
+// The width and height, in image pixels, of the tiles in a
+// ScaledTileCache.
+// The size of scaled tiles, in screen pixels. Tiles are sized in
+// screen pixels so that a tile uses about the same memory at any zoom,
+// e.g. at 40x a tile covers only 6x6 image pixels.
+const int SCALED_TILE_SIZE = 256;
+
+// The size of tiles in image pixels at the given scale.
+int scaled_tile_image_size(int scale);
+
+class ScaledTileCache{
+  // Enlarged (nearest neighbour) copies of grid-aligned tiles of image
+  // backgrounds, for painting zoomed-in views without rescaling the
+  // entire visible region on every paint (e.g. when scrolling or
+  // when only overlays changed).
+  //
+  // Tiles are reused until the image reports changed pixels within
+  // them (see Image::GetRasterChanges). The least recently used
+  // tiles are evicted when exceeding the memory budget.
+public:
+  explicit ScaledTileCache(size_t memoryBudget = 256 * 1024 * 1024);
+
+  // Returns the region of the image background scaled by the factor,
+  // composed from cached tiles. The image background must be a
+  // bitmap.
+  Bitmap GetScaled(const Image&, const IntRect& region, int scale);
+
+  void Clear();
+
+  // The number of cached tiles.
+  int GetCount() const;
+
+  // The total pixel memory used by cached tiles.
+  size_t GetMemoryUsage() const;
+
+  ScaledTileCache(const ScaledTileCache&) = delete;
+  ScaledTileCache& operator=(const ScaledTileCache&) = delete;
+private:
+  class TileKey{
+  public:
+    bool operator<(const TileKey&) const;
+    FrameId frame;
+    int scale;
+    int x;
+    int y;
+  };
+
+  class Tile{
+  public:
+    Bitmap bmp;
+    IntSize imageSize;
+    int generation = 0;
+    unsigned int lastUse = 0;
+  };
+
+  const Bitmap& GetTile(const Image&, const Bitmap& bg, const TileKey&);
+  void EvictLeastRecentlyUsed();
+
+  size_t m_memoryBudget;
+  size_t m_memoryUsage = 0;
+  std::map<TileKey, Tile> m_tiles;
+  unsigned int m_useCount = 0;
+};
+
+} // namespace
+
+#endif
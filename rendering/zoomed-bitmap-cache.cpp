@@ -0,0 +1,77 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <algorithm>
+#include "bitmap/draw.hh"
+#include "geo/geo-func.hh"
+#include "geo/int-point.hh"
+#include "rendering/zoomed-bitmap-cache.hh"
+
+namespace faint{
+
+static bool contains(const IntRect& outer, const IntRect& inner){
+  return intersection(outer, inner) == inner;
+}
+
+Bitmap ZoomedBitmapCache::Get(const Bitmap& src,
+  coord zoom,
+  const IntRect& region,
+  const zoom_func& zoomRegion)
+{
+  if (!IsSource(src)){
+    Clear();
+    m_source = src;
+  }
+
+  m_useCount++;
+  for (auto& entry : m_entries){
+    if (entry.zoom == zoom && contains(entry.region, region)){
+      entry.lastUse = m_useCount;
+      return entry.region == region ?
+        entry.bmp :
+        subbitmap(entry.bmp,
+          IntRect(region.TopLeft() - entry.region.TopLeft(),
+            region.GetSize()));
+    }
+  }
+
+  if (m_entries.size() == to_size_t(ZOOMED_BITMAP_CACHE_SIZE)){
+    m_entries.erase(std::min_element(begin(m_entries), end(m_entries),
+      [](const Entry& lhs, const Entry& rhs){
+        return lhs.lastUse < rhs.lastUse;
+      }));
+  }
+  m_entries.push_back({zoom, region, zoomRegion(), m_useCount});
+  return m_entries.back().bmp;
+}
+
+void ZoomedBitmapCache::Clear(){
+  m_source = Bitmap();
+  m_entries.clear();
+}
+
+int ZoomedBitmapCache::GetCount() const{
+  return resigned(m_entries.size());
+}
+
+bool ZoomedBitmapCache::IsSource(const Bitmap& bmp) const{
+  // The kept copy shares the pixels with the source, until the
+  // source is modified.
+  return bitmap_ok(m_source) &&
+    bmp.GetSize() == m_source.GetSize() &&
+    bmp.GetRaw() == m_source.GetRaw();
+}
+
+} // namespace
@@ -0,0 +1,68 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_ZOOMED_BITMAP_CACHE_HH
+#define FAINT_ZOOMED_BITMAP_CACHE_HH
+#include <functional>
+#include <vector>
+#include "bitmap/bitmap.hh"
+#include "geo/int-rect.hh"
+
+namespace faint{
+
+// The number of zoomed regions kept by a ZoomedBitmapCache.
+const int ZOOMED_BITMAP_CACHE_SIZE = 2;
+
+using zoom_func = std::function<Bitmap()>;
+
+class ZoomedBitmapCache{
+  // The most recently drawn zoomed regions of a bitmap, so that
+  // raster objects are not rescaled every time a zoomed canvas is
+  // repainted (e.g. when only the cursor or other objects changed).
+  //
+  // The cache keeps a copy sharing the pixels of the source bitmap.
+  // A modified or replaced bitmap has other pixels, which clears
+  // the cache.
+public:
+  // Returns the region of the bitmap zoomed by the factor, either
+  // from the cache, or from zoomRegion, which is then cached.
+  Bitmap Get(const Bitmap&,
+    coord zoom,
+    const IntRect& region,
+    const zoom_func& zoomRegion);
+
+  void Clear();
+
+  // The number of cached regions.
+  int GetCount() const;
+private:
+  bool IsSource(const Bitmap&) const;
+
+  class Entry{
+  public:
+    coord zoom;
+    IntRect region;
+    Bitmap bmp;
+    unsigned int lastUse;
+  };
+
+  Bitmap m_source;
+  std::vector<Entry> m_entries;
+  unsigned int m_useCount = 0;
+};
+
+} // namespace
+
+#endif
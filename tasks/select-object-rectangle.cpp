@@ -20,6 +20,7 @@
 #include "rendering/overlay.hh"
 #include "tasks/select-object-rectangle.hh"
 #include "tasks/standard-task.hh"
+#include "util/image.hh"
 #include "util/object-util.hh"
 #include "util/pos-info.hh"
 
@@ -104,7 +105,7 @@ public:
   }
 
   TaskResult MouseUp(const PosInfo& info) override{
-    const objects_t enclosed = get_intersected(info.canvas.GetObjects(),
+    const objects_t enclosed = info.canvas.GetImage().GetObjectsIntersecting(
       Rect(m_p0, m_p1));
     modify_selection(info, enclosed);
     return TaskResult::CHANGE;
@@ -243,10 +243,10 @@ static Color selection_or_image_color(const RasterSelection& selection,
 {
   return sel::visit(selection,
     [&image, &pos](const sel::Empty&){
-      return get_color(image.GetBackground(), pos);
+      return get_color(image, pos);
     },
     [&image, &pos](const sel::Rectangle&){
-      return get_color(image.GetBackground(), pos);
+      return get_color(image, pos);
     },
     [&pos](const sel::Floating& s){
       IntPoint offset = pos - s.TopLeft();
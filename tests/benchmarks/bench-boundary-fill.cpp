@@ -8,10 +8,15 @@
 #include "tests/test-util/file-handling.hh"
 #include "tests/test-util/bitmap-test-util.hh"
 #include "bitmap/bitmap-templates.hh"
+#include "bitmap/pattern.hh"
+#include "geo/int-rect.hh"
 #include <cassert>
 
 const int REPS = 10;
 
+// Repetitions for the large region cases
+const int LARGE_REPS = 2;
+
 void bench_boundary_fill(){
   using namespace faint;
 
@@ -30,4 +35,29 @@ void bench_boundary_fill(){
       boundary_fill(copy, fillOrigin,
         fill, borderColor);
     });
+
+  // A 49 megapixel region, with a boundary crossing most of it
+  const IntSize largeSize(7000, 7000);
+  Bitmap large(largeSize, color_white);
+  fill_rect_color(large, IntRect(IntPoint(0, 3500), IntSize(6000, 1)),
+    borderColor);
+
+  timed("boundary_fill large color", LARGE_REPS,
+    [&](){
+      copy = large;
+      boundary_fill(copy, IntPoint(10, 10), fill, borderColor);
+    });
+
+  const Paint pattern = Paint(Pattern(src));
+  timed("boundary_fill large pattern", LARGE_REPS,
+    [&](){
+      copy = large;
+      boundary_fill(copy, IntPoint(10, 10), pattern, borderColor);
+    });
+
+  timed("flood_fill large color", LARGE_REPS,
+    [&](){
+      copy = large;
+      flood_fill(copy, IntPoint(10, 10), fill);
+    });
 }
@@ -1,11 +1,57 @@
 // -*- coding: us-ascii-unix -*-
 #include "test-sys/bench.hh"
 #include "tests/test-util/file-handling.hh"
+#include "bitmap/bitmap.hh"
 #include "bitmap/color-counting.hh"
+#include "bitmap/mask.hh"
+#include "text/formatting.hh"
+#include "util/parallel.hh"
 
 const int REPS = 5;
+const int LARGE_REPS = 2;
 namespace {
   faint::color_counts_t out;
+  int outCount = 0;
+  size_t outUnique = 0;
+}
+
+static faint::Bitmap large_bitmap(const faint::IntSize& size){
+  // Many distinct colors, with some translucent pixels
+  using namespace faint;
+  Bitmap bmp(size);
+  for (int y = 0; y != size.h; y++){
+    for (int x = 0; x != size.w; x++){
+      put_pixel_raw(bmp, x, y, Color(
+        static_cast<uchar>(x * 255 / size.w),
+        static_cast<uchar>(y * 255 / size.h),
+        static_cast<uchar>((x * 7 + y * 13) % 256),
+        (x + y) % 64 == 0 ? 128 : 255));
+    }
+  }
+  return bmp;
+}
+
+static void timed_large(const faint::Bitmap& bmp, int threads){
+  using namespace faint;
+  set_max_threads(threads);
+  const IntSize sz(bmp.GetSize());
+  const auto suffix = no_sep(" ", str_int(sz.w), "x", str_int(sz.h), ", ",
+    str_int(get_max_threads()), " threads");
+
+  timed(no_sep("count_colors", suffix).c_str(), LARGE_REPS,
+    [&](){outCount = count_colors(bmp);});
+
+  timed(no_sep("add_color_counts", suffix).c_str(), LARGE_REPS,
+    [&](){
+      color_counts_t colors;
+      add_color_counts(bmp, colors);
+      out = colors;
+    });
+
+  const Mask exclude(sz);
+  timed(no_sep("unique_colors_rgb", suffix).c_str(), LARGE_REPS,
+    [&](){outUnique = unique_colors_rgb(bmp, exclude).size();});
+  set_max_threads(0);
 }
 
 void bench_color_counting(){
@@ -16,4 +62,12 @@ void bench_color_counting(){
     timed("count_colors", REPS, [&](){add_color_counts(bmp, colors);});
     out = colors;
   }
+
+  // 12 megapixels
+  const Bitmap large = large_bitmap(IntSize(4000, 3000));
+
+  // 1, 2, 4 and all hardware threads
+  for (int threads : {1, 2, 4, 0}){
+    timed_large(large, threads);
+  }
 }
@@ -0,0 +1,133 @@
+// -*- coding: us-ascii-unix -*-
+#include "test-sys/bench.hh"
+#include "tests/test-util/file-handling.hh"
+
+#include <algorithm>
+#include "bitmap/alpha-map.hh"
+#include "bitmap/bitmap.hh"
+#include "bitmap/bitmap-templates.hh"
+#include "bitmap/color.hh"
+#include "bitmap/draw.hh"
+#include "bitmap/paint.hh"
+#include "bitmap/pattern.hh"
+#include "geo/int-point.hh"
+#include "geo/int-size.hh"
+#include "text/formatting.hh"
+#include "util/parallel.hh"
+
+static faint::Bitmap bmp;
+
+const int REPS = 5;
+
+// The per-pixel implementations used before the composite kernels,
+// for comparison.
+
+static void previous_blend(const faint::Bitmap& src, faint::Bitmap& dst){
+  using namespace faint;
+  const int w = std::min(src.m_w, dst.m_w);
+  const int h = std::min(src.m_h, dst.m_h);
+  const uchar* srcData = src.GetRaw();
+  uchar* dstData = dst.GetRaw();
+  for (int y = 0; y != h; y++){
+    for (int x = 0; x != w; x++){
+      int srcPos = y * src.GetStride() + x * ByPP;
+      int dstPos = y * dst.GetStride() + x * ByPP;
+      float alpha = srcData[srcPos + iA];
+      for (int i : {iR, iG, iB}){
+        dstData[dstPos + i] = static_cast<uchar>((srcData[srcPos + i] *
+          alpha + dstData[dstPos + i] * (255 - alpha)) / 255);
+      }
+      dstData[dstPos + iA] =
+        std::max(srcData[srcPos + iA], dstData[dstPos + iA]);
+    }
+  }
+}
+
+static void previous_blend_color(const faint::AlphaMap& alphaMap,
+  faint::Bitmap& dst,
+  const faint::Color& c)
+{
+  using namespace faint;
+  const AlphaMapRef ref(alphaMap.FullReference());
+  uchar* dstData = dst.GetRaw();
+  for (int y = 0; y != std::min(ref.GetSize().h, dst.m_h); y++){
+    for (int x = 0; x != std::min(ref.GetSize().w, dst.m_w); x++){
+      int dstPos = y * dst.GetStride() + x * ByPP;
+      uchar alpha = ref.Get(x,y);
+      dstData[dstPos + iR] = static_cast<uchar>((c.r * alpha +
+          dstData[dstPos + iR] * (255 - alpha)) / 255);
+      dstData[dstPos + iG] = static_cast<uchar>((c.g * alpha +
+          dstData[dstPos + iG] * (255 - alpha)) / 255);
+      dstData[dstPos + iB] = static_cast<uchar>((c.b * alpha +
+          dstData[dstPos + iB] * (255 - alpha)) / 255);
+      dstData[dstPos + iA] = static_cast<uchar>((c.a * alpha +
+          dstData[dstPos + iA] * (255 - alpha)) / 255);
+    }
+  }
+}
+
+static void previous_blend_pattern(const faint::AlphaMap& alphaMap,
+  faint::Bitmap& dst,
+  const faint::Pattern& p)
+{
+  using namespace faint;
+  const AlphaMapRef ref(alphaMap.FullReference());
+  Bitmap strokeMap(ref.GetSize());
+  blend_pixels(strokeMap, ColorFromPattern(p),
+    [&](int x, int y){return ref.Get(x,y);});
+  previous_blend(strokeMap, dst);
+}
+
+static faint::AlphaMap varied_alpha_map(const faint::IntSize& size){
+  faint::AlphaMap alphaMap(size);
+  for (int y = 0; y != size.h; y++){
+    for (int x = 0; x != size.w; x++){
+      alphaMap.Set(x, y, static_cast<faint::uchar>((x + y * 3) % 256));
+    }
+  }
+  return alphaMap;
+}
+
+template<typename FUNC>
+static void timed_composite(const char* name, int threads,
+  const FUNC& func)
+{
+  using namespace faint;
+  set_max_threads(threads);
+  auto title = no_sep(name, ", ", str_int(get_max_threads()), " threads");
+  Bitmap dst(bmp.GetSize(), color_white);
+  timed(title.c_str(), REPS, [&](){func(dst);});
+  set_max_threads(0);
+}
+
+void bench_composite(){
+  using namespace faint;
+  bmp = load_test_image(FileName("gauss-source.png"));
+  const AlphaMap alphaMap(varied_alpha_map(bmp.GetSize()));
+  const Color color(10, 200, 30, 170);
+  const Pattern pattern(subbitmap(bmp, IntRect(IntPoint(0, 0),
+    IntSize(64, 64))));
+
+  timed_composite("previous blend", 1,
+    [&](Bitmap& dst){previous_blend(bmp, dst);});
+  timed_composite("previous blend color", 1,
+    [&](Bitmap& dst){previous_blend_color(alphaMap, dst, color);});
+  timed_composite("previous blend pattern", 1,
+    [&](Bitmap& dst){previous_blend_pattern(alphaMap, dst, pattern);});
+
+  // 1 and all hardware threads
+  for (int threads : {1, 0}){
+    timed_composite("blend", threads,
+      [&](Bitmap& dst){blend(at_top_left(bmp), onto(dst));});
+    timed_composite("blend color", threads,
+      [&](Bitmap& dst){
+        blend(offsat(alphaMap.FullReference(), IntPoint(0, 0)),
+          onto(dst), Paint(color));
+      });
+    timed_composite("blend pattern", threads,
+      [&](Bitmap& dst){
+        blend(offsat(alphaMap.FullReference(), IntPoint(0, 0)),
+          onto(dst), Paint(pattern));
+      });
+  }
+}
@@ -1,12 +1,111 @@
 // -*- coding: us-ascii-unix -*-
+#include <fstream>
+#include <string>
 #include "wx/bitmap.h"
 #include "test-sys/bench.hh"
 #include "bitmap/bitmap.hh"
 #include "bitmap/color.hh"
+#include "formats/bmp/file-bmp.hh"
+#include "formats/png/file-png.hh"
 #include "tests/test-util/file-handling.hh"
+#include "text/formatting.hh"
 #include "util-wx/convert-wx.hh"
 
 const int REPS = 1000;
+const int LOAD_REPS = 3;
+
+static void reset_peak_memory(){
+#ifdef __linux__
+  // Resets the peak resident set size (VmHWM)
+  std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+}
+
+static long peak_memory_kb(){
+  // The peak resident set size, or -1 if not available.
+#ifdef __linux__
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)){
+    if (line.compare(0, 6, "VmHWM:") == 0){
+      return std::stol(line.substr(6));
+    }
+  }
+#endif
+  return -1;
+}
+
+static faint::Bitmap large_bitmap(const faint::IntSize& size){
+  using namespace faint;
+  Bitmap bmp(size);
+  for (int y = 0; y != size.h; y++){
+    for (int x = 0; x != size.w; x++){
+      put_pixel_raw(bmp, x, y, Color(
+        static_cast<uchar>(x * 255 / size.w),
+        static_cast<uchar>(y * 255 / size.h),
+        static_cast<uchar>((x * 7 + y * 13) % 256),
+        255));
+    }
+  }
+  return bmp;
+}
+
+template<typename FUNC>
+static void timed_load(const std::string& name,
+  const faint::Bitmap& bmp,
+  const FUNC& load)
+{
+  // Times loading, and reports the peak memory increase while
+  // loading relative to the size of the loaded bitmap.
+  using namespace faint;
+  const IntSize sz(bmp.GetSize());
+  const auto fullName = no_sep(utf8_string(name), " ", str_int(sz.w), "x",
+    str_int(sz.h));
+
+  Bitmap loaded;
+  reset_peak_memory();
+  const long before = peak_memory_kb();
+  timed(fullName.str(), LOAD_REPS,
+    [&](){
+      loaded = Bitmap();
+      loaded = load();
+    });
+  const long after = peak_memory_kb();
+
+  if (before != -1 && after != -1){
+    const double bitmapKb = bmp.GetStride() * sz.h / 1024.0;
+    std::cout << fullName.str() << ": peak memory " <<
+      static_cast<double>(after - before) / bitmapKb << " x bitmap size" <<
+      std::endl;
+  }
+}
+
+static void timed_large_load(){
+  using namespace faint;
+  const Bitmap bmp(large_bitmap(IntSize(4000, 3000)));
+
+  const auto pngPath = get_test_save_path(FileName("bench-large.png"));
+  write_png(pngPath, bmp, PngColorType::RGB_ALPHA);
+  timed_load("read_png", bmp,
+    [&](){
+      return read_png(pngPath).Visit(
+        [](Bitmap& loaded){return std::move(loaded);},
+        [](const utf8_string&){return Bitmap();});
+    });
+
+  for (auto quality : {BitmapQuality::COLOR_24BIT, BitmapQuality::GRAY_8BIT}){
+    const bool gray = quality == BitmapQuality::GRAY_8BIT;
+    const auto bmpPath = get_test_save_path(
+      FileName(gray ? "bench-large-8.bmp" : "bench-large-24.bmp"));
+    write_bmp(bmpPath, bmp, quality);
+    timed_load(gray ? "read_bmp 8bipp" : "read_bmp 24bipp", bmp,
+      [&](){
+        return read_bmp(bmpPath).Visit(
+          [](Bitmap& loaded){return std::move(loaded);},
+          [](const utf8_string&){return Bitmap();});
+      });
+  }
+}
 
 void bench_convert_bmp(){
   using namespace faint;
@@ -31,4 +130,6 @@ void bench_convert_bmp(){
     [&](){
       imageWxConv = to_wx_image(bmpConv);
     });
+
+  timed_large_load();
 }
@@ -5,30 +5,40 @@
 #include "bitmap/bitmap.hh"
 #include "bitmap/gaussian-blur.hh"
 #include "text/formatting.hh"
+#include "util/parallel.hh"
 
 static faint::Bitmap bmp;
 
 const int REPS = 5;
 
-static void timed_gaussian_blur_exact(int sigma){
+static void timed_gaussian_blur_exact(int sigma, int threads){
   using namespace faint;
-  auto title = no_sep("gaussian_blur_exact(", str_int(sigma), ")");
+  set_max_threads(threads);
+  auto title = no_sep("gaussian_blur_exact(", str_int(sigma), "), ",
+    str_int(get_max_threads()), " threads");
   timed(title.c_str(), REPS, [&](){gaussian_blur_exact(bmp, sigma);});
+  set_max_threads(0);
 }
 
-static void timed_gaussian_blur_fast(int sigma){
+static void timed_gaussian_blur_fast(int sigma, int threads){
   using namespace faint;
-  auto title = no_sep("gaussian_blur_fast(", str_int(sigma), ")");
+  set_max_threads(threads);
+  auto title = no_sep("gaussian_blur_fast(", str_int(sigma), "), ",
+    str_int(get_max_threads()), " threads");
   timed(title.c_str(), REPS, [&](){gaussian_blur_fast(bmp, sigma);});
+  set_max_threads(0);
 }
 
 void bench_gaussian_blur(){
   using namespace faint;
   bmp = load_test_image(FileName("gauss-source.png"));
-  timed_gaussian_blur_exact(1);
-  timed_gaussian_blur_exact(5);
-  timed_gaussian_blur_exact(10);
-  timed_gaussian_blur_fast(1);
-  timed_gaussian_blur_fast(5);
-  timed_gaussian_blur_fast(10);
+  // 1, 2, 4 and all hardware threads
+  for (int threads : {1, 2, 4, 0}){
+    timed_gaussian_blur_exact(1, threads);
+    timed_gaussian_blur_exact(5, threads);
+    timed_gaussian_blur_exact(10, threads);
+    timed_gaussian_blur_fast(1, threads);
+    timed_gaussian_blur_fast(5, threads);
+    timed_gaussian_blur_fast(10, threads);
+  }
 }
@@ -0,0 +1,51 @@
+// -*- coding: us-ascii-unix -*-
+#include "test-sys/bench.hh"
+#include "tests/test-util/file-handling.hh"
+
+#include "bitmap/bitmap.hh"
+#include "bitmap/scale-bilinear.hh"
+#include "bitmap/scale-nearest.hh"
+#include "geo/geo-func.hh"
+#include "geo/int-size.hh"
+#include "geo/scale.hh"
+#include "text/formatting.hh"
+#include "util/parallel.hh"
+
+static faint::Bitmap bmp;
+
+const int REPS = 5;
+
+static void timed_scale_bilinear(faint::coord scaleFactor, int threads){
+  using namespace faint;
+  set_max_threads(threads);
+  const Scale scale(scaleFactor);
+  const IntSize size(rounded(bmp.GetSize() * scale));
+  auto title = no_sep("scale_bilinear(", str(scale), "), ",
+    str_int(get_max_threads()), " threads");
+  timed(title.c_str(), REPS, [&](){scale_bilinear(bmp, size);});
+  set_max_threads(0);
+}
+
+static void timed_scale_nearest(faint::coord scaleFactor, int threads){
+  using namespace faint;
+  set_max_threads(threads);
+  const Scale scale(scaleFactor);
+  const IntSize size(rounded(bmp.GetSize() * scale));
+  auto title = no_sep("scale_nearest(", str(scale), "), ",
+    str_int(get_max_threads()), " threads");
+  timed(title.c_str(), REPS, [&](){scale_nearest(bmp, size);});
+  set_max_threads(0);
+}
+
+void bench_scale(){
+  using namespace faint;
+  bmp = load_test_image(FileName("gauss-source.png"));
+
+  // 1, 2, 4 and all hardware threads
+  for (int threads : {1, 2, 4, 0}){
+    for (coord scale : {0.5, 2.0, 8.0}){
+      timed_scale_bilinear(scale, threads);
+      timed_scale_nearest(scale, threads);
+    }
+  }
+}
@@ -40,6 +40,15 @@ public:
 
   void SetBitmap(const Bitmap&) override{}
   void SetBitmap(Bitmap&&) override{}
+  void SetBitmapRegion(const Bitmap&, const IntPoint&) override{}
+
+  IntRect GetVisibleRect() override{
+    return IntRect(IntPoint(0, 0), m_bitmap.GetSize());
+  }
+
+  coord GetZoom() override{
+    return 1.0;
+  }
 
 private:
   Bitmap m_bitmap;
@@ -121,6 +121,38 @@ class TestBitmap(unittest.TestCase):
         b1.boundary_fill((2, 3), (0,0,0), (255,0,0))
         b1.boundary_fill((2, 3), Pattern(Bitmap((10,10))), (255,0,0))
 
+    def test_buffer(self):
+        bmp = Bitmap((3, 2), (10, 20, 30, 40))
+        view = memoryview(bmp)
+        self.assertEqual(view.shape, (2, 3, 4))
+        self.assertEqual(view.format, "B")
+        self.assertFalse(view.readonly)
+
+        # BGRA
+        self.assertEqual(view[1, 2, 0], 30)
+        self.assertEqual(view[1, 2, 1], 20)
+        self.assertEqual(view[1, 2, 2], 10)
+        self.assertEqual(view[1, 2, 3], 40)
+
+        # Writes affect the bitmap
+        view[0, 1, 0] = 255
+        self.assertEqual(bmp.get_pixel(1, 0), (10, 20, 255, 40))
+
+        # The memory can not be reallocated while exported
+        with self.assertRaises(BufferError):
+            bmp.rotate(1.0, (255, 0, 255))
+        with self.assertRaises(BufferError):
+            bmp.size = (4, 4)
+
+        # Same-size operations update the exported memory
+        bmp.invert()
+        self.assertEqual(view[0, 0, 2], 245)
+        bmp.gaussian_blur(1.0)
+
+        view.release()
+        bmp.size = (4, 4)
+        self.assertEqual(bmp.get_size(), (4, 4))
+
     def test_draw_objects(self):
         out_dir = py_tests.make_test_dir(self)
         b1 = Bitmap((20, 20))
@@ -150,3 +182,75 @@ class TestBitmap(unittest.TestCase):
         b2 = faint.bitmap_from_png_string(encoded)
 
         self.assertEqual(b1, b2)
+
+
+    def test_point_ops(self):
+        from copy import copy
+
+        src = Bitmap((16, 8))
+        for y in range(8):
+            for x in range(16):
+                src.set_pixel((x, y), (x * 16, y * 32, (x + y) * 10, 200))
+
+        # A chain of operations matches the individual methods
+        expected = copy(src)
+        expected.invert()
+        expected.color_balance((10, 200), (0, 128), (50, 250))
+        expected.sepia(30)
+        expected.desaturate_weighted()
+        expected.set_alpha(128)
+        expected.invert()
+        expected.set_threshold((0.2, 0.8), (255, 0, 255), (0, 255, 255))
+
+        bmp = copy(src)
+        bmp.point_ops([('invert',),
+                       ('color_balance', (10, 200), (0, 128), (50, 250)),
+                       ('sepia', 30),
+                       ('desaturate_weighted',),
+                       ('set_alpha', 128),
+                       ('invert',),
+                       ('threshold', (0.2, 0.8), (255, 0, 255),
+                        (0, 255, 255))])
+        self.assertEqual(bmp, expected)
+
+        expected = copy(src)
+        expected.desaturate()
+        bmp = copy(src)
+        bmp.point_ops([('desaturate',)])
+        self.assertEqual(bmp, expected)
+
+        # Brightness and contrast has no separate method
+        bmp = Bitmap((1, 1), (100, 100, 100))
+        bmp.point_ops([('brightness_contrast', 0.0, 2.0)])
+        self.assertEqual(bmp.get_pixel(0, 0), (200, 200, 200, 255))
+
+        # An empty chain leaves the bitmap unchanged
+        bmp = copy(src)
+        bmp.point_ops([])
+        self.assertEqual(bmp, src)
+
+        # Operations must be tuples starting with a name
+        with self.assertRaises(TypeError):
+            bmp.point_ops(['invert'])
+        with self.assertRaises(TypeError):
+            bmp.point_ops([()])
+        with self.assertRaises(TypeError):
+            bmp.point_ops([(1,)])
+
+        # Missing, invalid or extra arguments
+        with self.assertRaises(TypeError):
+            bmp.point_ops([('sepia',)])
+        with self.assertRaises(TypeError):
+            bmp.point_ops([('sepia', 'a lot')])
+        with self.assertRaises(TypeError):
+            bmp.point_ops([('color_balance', (0, 100), (0, 100))])
+        with self.assertRaises(TypeError):
+            bmp.point_ops([('invert', 1)])
+        with self.assertRaises(ValueError):
+            bmp.point_ops([('set_alpha', 256)])
+
+        with self.assertRaises(ValueError):
+            bmp.point_ops([('blur', 1.0)])
+
+        # Nothing is applied if any operation is invalid
+        self.assertEqual(bmp, src)
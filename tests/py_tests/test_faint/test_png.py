@@ -38,6 +38,27 @@ class TestPng(unittest.TestCase):
         self.assertEqual(read_tEXt, written_tEXt)
 
 
+    def test_compression_options(self):
+        out_dir = py_tests.make_test_dir(self)
+
+        b1 = faint.Bitmap((50,70))
+        b1.set_pixel((0,0),(255,0,255))
+
+        fn = os.path.join(out_dir, "b1.png")
+        for level in (0, 9):
+            for f in (png.FILTER_NONE, png.FILTER_PAETH,
+                      png.FILTER_ADAPTIVE):
+                faint.write_png(fn, b1, png.RGB, {}, level, f)
+                b2, tEXt = faint.read_png(fn)
+                self.assertEqual(b2.get_pixel(0,0), (255,0,255,255))
+
+        with self.assertRaises(ValueError):
+            faint.write_png(fn, b1, png.RGB, {}, 10)
+
+        with self.assertRaises(ValueError):
+            faint.write_png(fn, b1, png.RGB, {}, 6, 6)
+
+
     def test_bad_args(self):
         out_dir = py_tests.make_test_dir(self)
 
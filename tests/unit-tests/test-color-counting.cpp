@@ -1,5 +1,7 @@
 // -*- coding: us-ascii-unix -*-
 #include <algorithm> // std::sort
+#include <map>
+#include <set>
 #include "test-sys/test.hh"
 #include "tests/test-util/print-objects.hh"
 #include "tests/test-util/text-bitmap.hh"
@@ -11,6 +13,7 @@
 #include "geo/int-size.hh"
 #include "util/generator-adapter.hh" // sorted
 #include "util/make-vector.hh"
+#include "util/parallel.hh"
 
 void test_color_counting(){
   using namespace faint;
@@ -73,7 +76,44 @@ void test_color_counting(){
       " # "
       "#  "
       "   ");
-    // auto v = unique_colors_rgb(img.bitmap, img.mask);
-    // EQUAL(v, key);
+    auto v = unique_colors_rgb(img.bitmap, img.mask);
+    VERIFY(v == key);
+  }
+
+  {
+    // Large bitmaps are counted in shards
+    set_max_threads(3);
+    Bitmap bmp(IntSize(700, 400));
+    Mask exclude(bmp.GetSize());
+    std::map<color_hash, int> expected;
+    std::set<ColRGB> expectedRgb;
+    for (int y = 0; y != 400; y++){
+      for (int x = 0; x != 700; x++){
+        const Color c(static_cast<uchar>(x % 256),
+          static_cast<uchar>(y % 256),
+          static_cast<uchar>((x / 256) * 50),
+          (x + y) % 7 == 0 ? 128 : 255);
+        put_pixel_raw(bmp, x, y, c);
+        expected[to_hash(c)]++;
+        exclude.Set(x, y, x < 10);
+        if (x >= 10){
+          expectedRgb.insert(strip_alpha(c));
+        }
+      }
+    }
+
+    EQUAL(count_colors(bmp), resigned(expected.size()));
+
+    color_counts_t colorCounts;
+    add_color_counts(bmp, colorCounts);
+    EQUAL(colorCounts.size(), expected.size());
+    VERIFY(std::all_of(begin(expected), end(expected),
+      [&](const auto& item){
+        return colorCounts.at(item.first) == item.second;
+      }));
+
+    auto v = unique_colors_rgb(bmp, exclude);
+    VERIFY(v == std::vector<ColRGB>(begin(expectedRgb), end(expectedRgb)));
+    set_max_threads(0);
   }
 }
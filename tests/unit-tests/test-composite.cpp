@@ -0,0 +1,197 @@
+// -*- coding: us-ascii-unix -*-
+#include <algorithm>
+#include "test-sys/test.hh"
+#include "tests/test-util/print-objects.hh"
+#include "bitmap/alpha-map.hh"
+#include "bitmap/bitmap.hh"
+#include "bitmap/bitmap-templates.hh"
+#include "bitmap/color.hh"
+#include "bitmap/composite.hh"
+#include "bitmap/draw.hh"
+#include "bitmap/paint.hh"
+#include "bitmap/pattern.hh"
+#include "geo/int-point.hh"
+#include "geo/int-rect.hh"
+#include "geo/int-size.hh"
+
+using faint::Bitmap;
+using faint::Color;
+using faint::IntPoint;
+
+static int blended(int src, int dst, int alpha){
+  return (src * alpha + dst * (255 - alpha)) / 255;
+}
+
+static Color varied_color(int x, int y, int seed){
+  return faint::color_from_ints((x * 7 + y * 3 + seed) % 256,
+    (x + y * 11 + seed * 5) % 256,
+    (x * 13 + y + seed * 3) % 256,
+    (x * 5 + y * 17 + seed) % 256);
+}
+
+static Bitmap varied_bitmap(const faint::IntSize& size, int seed){
+  Bitmap bmp(size);
+  for (int y = 0; y != size.h; y++){
+    for (int x = 0; x != size.w; x++){
+      faint::put_pixel_raw(bmp, x, y, varied_color(x, y, seed));
+    }
+  }
+  return bmp;
+}
+
+template<typename FUNC>
+static Bitmap expected_composite(const Bitmap& src, const IntPoint& offset,
+  Bitmap dst,
+  const FUNC& func)
+{
+  // Applies func(srcColor, dstColor) for each overlapping pixel
+  for (int y = 0; y != src.m_h; y++){
+    for (int x = 0; x != src.m_w; x++){
+      const IntPoint p(x + offset.x, y + offset.y);
+      if (faint::point_in_bitmap(dst, p)){
+        faint::put_pixel(dst, p, func(faint::get_color_raw(src, x, y),
+          faint::get_color(dst, p)));
+      }
+    }
+  }
+  return dst;
+}
+
+static Color blended_color(const Color& s, const Color& d){
+  return faint::color_from_ints(blended(s.r, d.r, s.a),
+    blended(s.g, d.g, s.a),
+    blended(s.b, d.b, s.a),
+    std::max(s.a, d.a));
+}
+
+void test_composite(){
+  using namespace faint;
+
+  // The row kernels match the per-channel formula for all alpha
+  // values, including the scalar tail.
+  const int n = 256 * 3 + 3;
+  const Bitmap src(varied_bitmap(IntSize(n, 1), 1));
+  const Bitmap dst(varied_bitmap(IntSize(n, 1), 2));
+  std::vector<uchar> alpha(n);
+  for (int i = 0; i != n; i++){
+    alpha[to_size_t(i)] = static_cast<uchar>(i % 256);
+  }
+
+  {
+    Bitmap bmp(dst);
+    blend_row(src.GetRaw(), bmp.GetRaw(), n);
+    bool ok = true;
+    for (int x = 0; x != n; x++){
+      ok = ok && get_color_raw(bmp, x, 0) ==
+        blended_color(get_color_raw(src, x, 0), get_color_raw(dst, x, 0));
+    }
+    VERIFY(ok);
+  }
+
+  {
+    const Color c(10, 200, 30, 170);
+    Bitmap bmp(dst);
+    blend_color_row(c, alpha.data(), bmp.GetRaw(), n);
+    bool ok = true;
+    for (int x = 0; x != n; x++){
+      const Color d(get_color_raw(dst, x, 0));
+      const int a = alpha[to_size_t(x)];
+      ok = ok && get_color_raw(bmp, x, 0) == color_from_ints(
+        blended(c.r, d.r, a), blended(c.g, d.g, a),
+        blended(c.b, d.b, a), blended(c.a, d.a, a));
+    }
+    VERIFY(ok);
+  }
+
+  {
+    Bitmap bmp(dst);
+    blend_alpha_row(src.GetRaw(), alpha.data(), bmp.GetRaw(), n);
+    bool ok = true;
+    for (int x = 0; x != n; x++){
+      const Color s(get_color_raw(src, x, 0));
+      const Color d(get_color_raw(dst, x, 0));
+      const uchar a = alpha[to_size_t(x)];
+      ok = ok && get_color_raw(bmp, x, 0) ==
+        blended_color(Color(s.r, s.g, s.b, a), d);
+    }
+    VERIFY(ok);
+  }
+
+  const Bitmap large(varied_bitmap(IntSize(301, 203), 3));
+  const Bitmap overlay(varied_bitmap(IntSize(257, 131), 4));
+  const Color mask(get_color_raw(overlay, 5, 7));
+  for (const IntPoint& offset : {IntPoint(0, 0), IntPoint(-13, 21),
+      IntPoint(50, -9), IntPoint(100, 150)})
+  {
+    // Blending and blitting bitmaps, clipped to the target, also
+    // when split over threads.
+    {
+      Bitmap bmp(large);
+      blend(offsat(overlay, offset), onto(bmp));
+      VERIFY(bmp == expected_composite(overlay, offset, large,
+        blended_color));
+    }
+
+    {
+      Bitmap bmp(large);
+      blend_masked(offsat(overlay, offset), onto(bmp), mask);
+      VERIFY(bmp == expected_composite(overlay, offset, large,
+        [&](const Color& s, const Color& d){
+          return s.a == 0 || s == mask ? d :
+            Color(strip_alpha(blended_color(s, d)), d.a);
+        }));
+    }
+
+    {
+      Bitmap bmp(large);
+      blit_masked(offsat(overlay, offset), onto(bmp), mask);
+      VERIFY(bmp == expected_composite(overlay, offset, large,
+        [&](const Color& s, const Color& d){
+          return s == mask ? d : s;
+        }));
+    }
+
+    // Blending a color or a pattern using an alpha map
+    AlphaMap alphaMap(overlay.GetSize());
+    for (int y = 0; y != overlay.m_h; y++){
+      for (int x = 0; x != overlay.m_w; x++){
+        alphaMap.Set(x, y, get_color_raw(overlay, x, y).a);
+      }
+    }
+
+    {
+      const Color c(10, 200, 30, 170);
+      Bitmap bmp(large);
+      blend(offsat(alphaMap.FullReference(), offset), onto(bmp), Paint(c));
+      VERIFY(bmp == expected_composite(overlay, offset, large,
+        [&](const Color& s, const Color& d){
+          return color_from_ints(blended(c.r, d.r, s.a),
+            blended(c.g, d.g, s.a),
+            blended(c.b, d.b, s.a),
+            blended(c.a, d.a, s.a));
+        }));
+    }
+
+    {
+      const Pattern pattern(varied_bitmap(IntSize(17, 9), 5),
+        IntPoint(-3, 4), object_aligned_t(false));
+      const Pattern moved(offsat(pattern, offset));
+      Bitmap expectedStroke(overlay.GetSize());
+      for (int y = 0; y != overlay.m_h; y++){
+        for (int x = 0; x != overlay.m_w; x++){
+          const IntPoint anchor(moved.GetAnchor());
+          const Color c(get_color_modulo_raw(moved.GetBitmap(),
+            x + anchor.x, y + anchor.y));
+          put_pixel_raw(expectedStroke, x, y,
+            Color(strip_alpha(c), alphaMap.Get(x, y)));
+        }
+      }
+
+      Bitmap bmp(large);
+      blend(offsat(alphaMap.FullReference(), offset), onto(bmp),
+        Paint(pattern));
+      VERIFY(bmp == expected_composite(expectedStroke, offset, large,
+        blended_color));
+    }
+  }
+}
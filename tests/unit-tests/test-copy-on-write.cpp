@@ -0,0 +1,104 @@
+// -*- coding: us-ascii-unix -*-
+#include "test-sys/test.hh"
+#include "tests/test-util/print-objects.hh"
+#include "bitmap/bitmap.hh"
+#include "bitmap/color.hh"
+#include "bitmap/draw.hh"
+#include "geo/int-point.hh"
+#include "geo/int-rect.hh"
+#include "geo/int-size.hh"
+
+void test_copy_on_write(){
+  using namespace faint;
+
+  const Bitmap original(IntSize(20, 10), color_white);
+  NOT(original.IsShared());
+
+  {
+    // Copies share the pixels until modified
+    Bitmap copy(original);
+    VERIFY(copy.IsShared());
+    VERIFY(original.IsShared());
+    const Bitmap& constCopy(copy);
+    VERIFY(constCopy.GetRaw() == original.GetRaw());
+    VERIFY(copy == original);
+
+    put_pixel(copy, IntPoint(1, 1), color_red);
+    NOT(copy.IsShared());
+    NOT(original.IsShared());
+    EQUAL(get_color(copy, IntPoint(1, 1)), color_red);
+    EQUAL(get_color(original, IntPoint(1, 1)), color_white);
+    VERIFY(copy != original);
+  }
+
+  {
+    // Drawing via DstBmp detaches the target
+    Bitmap copy(original);
+    fill_rect_color(copy, IntRect(IntPoint(0, 0), IntSize(5, 5)),
+      color_blue);
+    NOT(copy.IsShared());
+    EQUAL(get_color(copy, IntPoint(4, 4)), color_blue);
+    EQUAL(get_color(original, IntPoint(4, 4)), color_white);
+  }
+
+  {
+    // Assignment shares, the source keeps its pixels when the
+    // target is modified.
+    Bitmap source(original);
+    Bitmap target(IntSize(5, 5));
+    target = source;
+    VERIFY(target.IsShared());
+    put_pixel(target, IntPoint(0, 0), color_green);
+    EQUAL(get_color(source, IntPoint(0, 0)), color_white);
+
+    // Moving keeps the pixels
+    const uchar* pixels = static_cast<const Bitmap&>(target).GetRaw();
+    Bitmap moved(std::move(target));
+    VERIFY(static_cast<const Bitmap&>(moved).GetRaw() == pixels);
+    NOT(moved.IsShared());
+  }
+
+  {
+    // Pinned pixels are not shared with copies
+    Bitmap bmp(original);
+    VERIFY(bmp.IsShared());
+    uchar* raw = nullptr;
+    {
+      PixelPin pin = bmp.Pin();
+      NOT(bmp.IsShared());
+      raw = bmp.GetRaw();
+
+      Bitmap copy(bmp);
+      NOT(copy.IsShared());
+      raw[0] = 0;
+      EQUAL(get_color(copy, IntPoint(0, 0)), color_white);
+      VERIFY(bmp.GetRaw() == raw);
+    }
+
+    // Shared again after unpinning
+    Bitmap copy(bmp);
+    VERIFY(copy.IsShared());
+    VERIFY(static_cast<const Bitmap&>(copy).GetRaw() == raw);
+  }
+
+  {
+    // A sub-bitmap covering the whole bitmap shares the pixels
+    const IntRect all(IntPoint(0, 0), original.GetSize());
+    VERIFY(subbitmap(original, all).IsShared());
+    const IntRect part(IntPoint(1, 1), IntSize(2, 2));
+    NOT(subbitmap(original, part).IsShared());
+  }
+
+  {
+    // Detaching
+    Bitmap copy(original);
+    copy.Detach();
+    NOT(copy.IsShared());
+    VERIFY(copy == original);
+
+    Bitmap invalid;
+    invalid.Detach();
+    NOT(invalid.IsShared());
+    VERIFY(invalid.Pin() == nullptr);
+  }
+}
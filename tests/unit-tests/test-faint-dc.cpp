@@ -1,11 +1,13 @@
 // -*- coding: us-ascii-unix -*-
 #include "test-sys/test.hh"
+#include "tests/test-util/print-objects.hh"
 #include "tests/test-util/text-bitmap.hh"
 #include "bitmap/color.hh"
 #include "bitmap/draw.hh"
 #include "geo/int-rect.hh"
 #include "geo/pathpt.hh"
 #include "geo/tri.hh"
+#include "rendering/cairo-context.hh"
 #include "rendering/faint-dc.hh"
 #include "util/default-settings.hh"
 #include "util/settings.hh"
@@ -30,6 +32,24 @@ void test_faint_dc(){
     }
   }
 
+  {
+    // Text measurements are cached
+    Bitmap bmp(IntSize(100,100), color_magenta);
+    FaintDC dc(bmp);
+    const Settings s(default_text_settings());
+    const IntSize size(dc.TextSize("Cached", s));
+    const FontMetrics metrics(dc.GetFontMetrics(s));
+
+    reset_pango_cache_stats();
+    EQUAL(dc.TextSize("Cached", s), size);
+    EQUAL(dc.GetFontMetrics(s).ascent, metrics.ascent);
+    const PangoCacheStats stats(get_pango_cache_stats());
+    EQUAL(stats.layoutHits, 1);
+    EQUAL(stats.layoutMisses, 0);
+    EQUAL(stats.fontHits, 1);
+    EQUAL(stats.fontMisses, 0);
+  }
+
   {
     // Test "Blit"
     Bitmap bg({10,10}, color_magenta);
@@ -2,6 +2,7 @@
 #include "test-sys/test.hh"
 #include "bitmap/draw.hh" // set_alpha
 #include "bitmap/filter.hh" // desaturated_simple
+#include "bitmap/color.hh"
 #include "formats/png/file-png.hh"
 #include "tests/test-util/file-handling.hh"
 #include "text/utf8-string.hh"
@@ -139,4 +140,39 @@ void test_file_png(){
         ABORT_TEST(error.c_str());
       });
   }
+
+  { // Compression options, multiple strips
+
+    // Tall enough to be compressed as several strips
+    Bitmap bmp(IntSize(300, 1000));
+    for (int y = 0; y != 1000; y++){
+      for (int x = 0; x != 300; x++){
+        put_pixel_raw(bmp, x, y, Color(static_cast<uchar>(x ^ y),
+          static_cast<uchar>(x * y), static_cast<uchar>(y),
+          static_cast<uchar>(255 - x % 7)));
+      }
+    }
+
+    for (int level : {0, 1, 6, 9}){
+      for (int filter = 0; filter <= 5; filter++){
+        PngOptions options;
+        options.compressionLevel = level;
+        options.filter = static_cast<PngFilter>(filter);
+
+        auto out = get_test_save_path(
+          suffix_u8_chars(FileName("out-options.png")));
+        const auto result = write_png(out, bmp, PngColorType::RGB_ALPHA,
+          png_tEXt_map(), options);
+        ABORT_IF(!result.Successful());
+
+        read_png(out).Visit(
+          [&](const Bitmap& bmp2){
+            VERIFY(bmp == bmp2);
+          },
+          [](const utf8_string& error){
+            ABORT_TEST(error.c_str());
+          });
+      }
+    }
+  }
 }
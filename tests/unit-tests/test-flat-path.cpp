@@ -0,0 +1,98 @@
+// -*- coding: us-ascii-unix -*-
+#include "test-sys/test.hh"
+#include "tests/test-util/print-objects.hh"
+#include "bitmap/color.hh"
+#include "geo/flat-path.hh"
+#include "geo/geo-list-points.hh"
+#include "geo/tri.hh"
+#include "objects/object.hh"
+#include "objects/objrectangle.hh"
+#include "util/default-settings.hh"
+#include "util/object-util.hh"
+#include "util/setting-id.hh"
+#include "util/setting-util.hh"
+
+void test_flat_path(){
+  using namespace faint;
+
+  {
+    // Flattening
+    const std::vector<PathPt> path = {
+      PathPt::MoveTo(Point(0, 0)),
+      PathPt::LineTo(Point(10, 0)),
+      PathPt::LineTo(Point(10, 10)),
+      PathPt::PathCloser(),
+      PathPt::MoveTo(Point(20, 0)),
+      PathPt::CubicBezierTo(Point(40, 0), Point(20, 20), Point(40, 20))};
+
+    const polylines_t polylines = flatten(path).Get();
+    EQUAL(polylines.size(), 2);
+    EQUAL(polylines[0].points.size(), 3);
+    VERIFY(polylines[0].closed);
+    NOT(polylines[1].closed);
+    VERIFY(polylines[1].points.size() > 4);
+    EQUAL(polylines[1].points.back(), Point(40, 0));
+
+    // Arcs are not flattened
+    const std::vector<PathPt> arc = {
+      PathPt::MoveTo(Point(0, 0)),
+      PathPt::Arc(Radii(5, 5), Angle::Zero(), 0, 1, Point(10, 0))};
+    VERIFY(flatten(arc).NotSet());
+  }
+
+  {
+    // Fill rules
+    Polyline outer;
+    outer.points = {Point(0, 0), Point(30, 0), Point(30, 30), Point(0, 30)};
+    Polyline inner;
+    inner.points = {Point(10, 10), Point(20, 10), Point(20, 20), Point(10, 20)};
+
+    const polylines_t polylines = {outer, inner};
+    VERIFY(inside_polylines(polylines, Point(5, 5), false));
+    VERIFY(inside_polylines(polylines, Point(5, 5), true));
+    VERIFY(inside_polylines(polylines, Point(15, 15), false));
+    NOT(inside_polylines(polylines, Point(15, 15), true));
+    NOT(inside_polylines(polylines, Point(35, 15), false));
+  }
+
+  {
+    // Strokes
+    Polyline line;
+    line.points = {Point(0, 0), Point(10, 0), Point(10, 10)};
+    const polylines_t polylines = {line};
+
+    VERIFY(on_stroke(polylines, Point(5, 1.5), 4.0, true, false));
+    NOT(on_stroke(polylines, Point(5, 2.5), 4.0, true, false));
+
+    // Caps
+    VERIFY(on_stroke(polylines, Point(-1, 0), 4.0, false, false));
+    NOT(on_stroke(polylines, Point(-1, 0), 4.0, true, false));
+
+    // Joins
+    NOT(on_stroke(polylines, Point(11.8, -1.8), 4.0, true, false));
+    VERIFY(on_stroke(polylines, Point(11.8, -1.8), 4.0, true, true));
+  }
+
+  {
+    // Mask colors matching mask_settings_fill
+    Settings s(default_rectangle_settings());
+    s.Set(ts_LineWidth, 2.0);
+    s.Set(ts_AntiAlias, true);
+    s.Set(ts_FillStyle, FillStyle::BORDER);
+    ObjectPtr rect(create_rectangle_object(
+      Tri(Point(0, 0), Point(20, 0), Point(0, 20)), s));
+
+    EQUAL(rect->GetMaskColor(Point(0.5, 10)).Get(), mask_edge);
+    EQUAL(rect->GetMaskColor(Point(10, 10)).Get(), mask_no_fill);
+    EQUAL(rect->GetMaskColor(Point(25, 10)).Get(), mask_outside);
+
+    rect->Set(ts_FillStyle, FillStyle::FILL);
+    EQUAL(rect->GetMaskColor(Point(10, 10)).Get(), mask_fill);
+    EQUAL(rect->GetMaskColor(Point(0.5, 10)).Get(), mask_fill);
+    EQUAL(rect->GetMaskColor(Point(-0.5, 10)).Get(), mask_outside);
+
+    // Rounded rectangles are left to DrawMask
+    rect->Set(ts_RadiusX, 5.0);
+    VERIFY(rect->GetMaskColor(Point(10, 10)).NotSet());
+  }
+}
@@ -0,0 +1,84 @@
+// -*- coding: us-ascii-unix -*-
+#include <vector>
+#include "test-sys/test.hh"
+#include "tests/test-util/print-objects.hh"
+#include "bitmap/bitmap.hh"
+#include "bitmap/color.hh"
+#include "bitmap/draw.hh"
+#include "geo/int-point.hh"
+#include "geo/int-rect.hh"
+#include "geo/int-size.hh"
+#include "geo/point.hh"
+#include "geo/tri.hh"
+#include "objects/object.hh"
+#include "objects/objrectangle.hh"
+#include "rendering/faint-dc.hh"
+#include "util/default-settings.hh"
+#include "util/flatten-cache.hh"
+#include "util/image.hh"
+#include "util/setting-id.hh"
+
+namespace{
+
+using namespace faint;
+
+Bitmap flatten_all(const Image& image){
+  // Reference flattening, drawing everything
+  Bitmap bmp(image.GetBackground().Get<Bitmap>().Get());
+  FaintDC dc(bmp);
+  for (Object* obj : image.GetObjects()){
+    obj->Draw(dc, image.GetExpressionContext());
+  }
+  return bmp;
+}
+
+ObjectPtr filled_rect(const Point& p, const Color& c){
+  Settings s(default_rectangle_settings());
+  s.Set(ts_FillStyle, FillStyle::FILL);
+  s.Set(ts_Fg, Paint(c));
+  return create_rectangle_object(
+    Tri(p, p + Point(40, 0), p + Point(0, 30)), s);
+}
+
+} // namespace
+
+void test_flatten_cache(){
+  using namespace faint;
+  const int T = FLATTEN_TILE_SIZE;
+
+  Image image;
+  image.SetBitmap(Bitmap(IntSize(3 * T + 7, 2 * T + 3), color_white));
+  ObjectPtr r1(filled_rect(Point(10, 10), color_red));
+  ObjectPtr r2(filled_rect(Point(T - 20, T - 10), color_blue));
+  image.Add(r1.get());
+  image.Add(r2.get());
+  VERIFY(image.GetFlattened() == flatten_all(image));
+
+  // Background changed in-place
+  Bitmap& bg = image.GetBackground().Get<Bitmap>().Get();
+  put_pixel(bg, IntPoint(2 * T + 5, T + 1), color_black);
+  image.InvalidateRaster(IntRect(IntPoint(2 * T + 5, T + 1), IntSize(1, 1)));
+  VERIFY(image.GetFlattened() == flatten_all(image));
+
+  // Moved object, found without it being reported
+  r1->SetTri(translated(r1->GetTri(), Point(3 * T - 10, T)));
+  VERIFY(image.GetFlattened() == flatten_all(image));
+
+  // Changed color within the same region, reported by commands
+  r2->Set(ts_Fg, Paint(color_green));
+  image.ObjectsChanged(r2->GetRefreshRect());
+  VERIFY(image.GetFlattened() == flatten_all(image));
+
+  // Reordered, removed and added objects
+  image.SetObjectZ(r2.get(), 0);
+  VERIFY(image.GetFlattened() == flatten_all(image));
+  image.Remove(r1.get());
+  VERIFY(image.GetFlattened() == flatten_all(image));
+  ObjectPtr r3(filled_rect(Point(2 * T, 5), color_magenta));
+  image.Add(r3.get());
+  VERIFY(image.GetFlattened() == flatten_all(image));
+
+  // Resized background
+  image.SetBitmap(Bitmap(IntSize(T, T), color_gray));
+  VERIFY(image.GetFlattened() == flatten_all(image));
+}
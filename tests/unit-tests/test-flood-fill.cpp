@@ -0,0 +1,85 @@
+// -*- coding: us-ascii-unix -*-
+#include "test-sys/test.hh"
+#include "tests/test-util/print-objects.hh"
+#include "tests/test-util/text-bitmap.hh"
+#include "bitmap/color.hh"
+#include "bitmap/draw.hh"
+#include "bitmap/pattern.hh"
+
+void test_flood_fill(){
+  using namespace faint;
+
+  // Regions which must be filled back up and to the left from lower
+  // rows.
+  const std::string s =
+    "..#....#.."
+    "..#.##.#.."
+    "....#....."
+    "#####.####"
+    ".#...#...."
+    ".#.#.#.##."
+    "...#...#..";
+
+  const std::map<char, Color> colors = {
+    {'.', color_white},
+    {'#', color_black}};
+
+  {
+    // Color
+    Bitmap bmp(create_bitmap({10,7}, s, colors));
+    flood_fill(bmp, {9,0}, Paint(color_red));
+    FWD(check(bmp,
+      "RR#RRRR#RR"
+      "RR#R##R#RR"
+      "RRRR#RRRRR"
+      "#####R####"
+      ".#...#...."
+      ".#.#.#.##."
+      "...#...#..",
+      {{'.', color_white},
+       {'#', color_black},
+       {'R', color_red}}));
+
+    // No change when filling with the target color
+    Bitmap same(create_bitmap({10,7}, s, colors));
+    flood_fill(same, {9,0}, Paint(color_white));
+    FWD(check(same, s, colors));
+  }
+
+  {
+    // Boundary fill with the same region
+    Bitmap bmp(create_bitmap({10,7}, s, colors));
+    boundary_fill(bmp, {9,6}, Paint(color_red), color_black);
+    FWD(check(bmp,
+      "..#....#.."
+      "..#.##.#.."
+      "....#....."
+      "#####.####"
+      "R#RRR#RRRR"
+      "R#R#R#R##R"
+      "RRR#RRR#RR",
+      {{'.', color_white},
+       {'#', color_black},
+       {'R', color_red}}));
+  }
+
+  {
+    // Pattern, including pixels with the target color
+    Bitmap patBmp(create_bitmap({2,1}, "w.",
+      {{'w', color_white}, {'.', color_blue}}));
+    Bitmap bmp(create_bitmap({10,7}, s, colors));
+    flood_fill(bmp, {0,6}, Paint(Pattern(patBmp)));
+    FWD(check(bmp,
+      "..#....#.."
+      "..#.##.#.."
+      "....#....."
+      "#####.####"
+      "w#wBw#wBwB"
+      "w#w#w#w##B"
+      "wBw#wBw#wB",
+      {{'.', color_white},
+       {'#', color_black},
+       {'w', color_white},
+       {'B', color_blue}}));
+  }
+}
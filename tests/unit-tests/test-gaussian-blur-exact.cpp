@@ -0,0 +1,74 @@
+// -*- coding: us-ascii-unix -*-
+#include "test-sys/test.hh"
+#include "tests/test-util/print-objects.hh"
+#include "bitmap/bitmap.hh"
+#include "bitmap/color.hh"
+#include "bitmap/draw.hh"
+#include "bitmap/filter.hh"
+#include "bitmap/gaussian-blur.hh"
+#include "geo/int-point.hh"
+#include "geo/int-rect.hh"
+#include "geo/int-size.hh"
+#include "util/parallel.hh"
+
+void test_gaussian_blur_exact(){
+  using namespace faint;
+
+  {
+    // Uniform bitmaps are unaffected
+    const Bitmap uniform(IntSize(50, 20), Color(10, 20, 30, 40));
+    VERIFY(gaussian_blur_exact(uniform, 3.0) == uniform);
+    VERIFY(unsharp_mask_exact(uniform, 3.0) == uniform);
+    VERIFY(gaussian_blur_exact(uniform, 0.0) == uniform);
+  }
+
+  {
+    // Blurring spreads a pixel symmetrically
+    Bitmap bmp(IntSize(41, 41), color_black);
+    put_pixel(bmp, IntPoint(20, 20), color_white);
+    const Bitmap blurred = gaussian_blur_exact(bmp, 2.0);
+    const Color center = get_color(blurred, IntPoint(20, 20));
+    VERIFY(center.r > 0 && center.r < 255);
+    EQUAL(get_color(blurred, IntPoint(17, 20)),
+      get_color(blurred, IntPoint(23, 20)));
+    EQUAL(get_color(blurred, IntPoint(20, 17)),
+      get_color(blurred, IntPoint(20, 23)));
+    EQUAL(get_color(blurred, IntPoint(0, 0)), color_black);
+  }
+
+  {
+    // Kernels exceeding the bitmap size
+    const Bitmap tiny(IntSize(3, 2), color_red);
+    VERIFY(gaussian_blur_exact(tiny, 20.0) == tiny);
+  }
+
+  Bitmap bmp(IntSize(300, 200), color_white);
+  fill_rect_color(bmp, IntRect(IntPoint(50, 40), IntSize(120, 70)),
+    color_blue);
+  fill_rect_color(bmp, IntRect(IntPoint(140, 90), IntSize(100, 100)),
+    Color(255, 0, 0, 100));
+
+  {
+    // Identical results regardless of the number of threads
+    set_max_threads(1);
+    const Bitmap serial = gaussian_blur_exact(bmp, 4.5);
+    set_max_threads(4);
+    const Bitmap parallel = gaussian_blur_exact(bmp, 4.5);
+    set_max_threads(0);
+    VERIFY(serial == parallel);
+    VERIFY(serial != bmp);
+  }
+
+  {
+    // The unsharp mask adds the clamped difference from the blur
+    const Bitmap blurred = gaussian_blur_exact(bmp, 2.0);
+    const Bitmap sharpened = unsharp_mask_exact(bmp, 2.0);
+    for (const IntPoint& p : {IntPoint(49, 60), IntPoint(50, 60),
+        IntPoint(139, 95), IntPoint(140, 95), IntPoint(10, 10)})
+    {
+      const Color c = get_color(bmp, p);
+      EQUAL(get_color(sharpened, p),
+        add(c, subtract(c, get_color(blurred, p))));
+    }
+  }
+}
@@ -0,0 +1,130 @@
+// -*- coding: us-ascii-unix -*-
+#include "test-sys/test.hh"
+#include "tests/test-util/file-handling.hh"
+#include "tests/test-util/print-objects.hh"
+#include "bitmap/bitmap.hh"
+#include "bitmap/color.hh"
+#include "bitmap/draw.hh"
+#include "formats/gif/gif-frames.hh"
+#include "geo/int-rect.hh"
+#include "util/image-props.hh"
+#include "util/parallel.hh"
+
+namespace{
+
+faint::Bitmap test_frame(const faint::IntPoint& pos, const faint::Color& bg){
+  using namespace faint;
+  Bitmap bmp(IntSize(40, 30), bg);
+  fill_rect_color(bmp, IntRect(pos, IntSize(5, 4)), color_red);
+  return bmp;
+}
+
+void check_reloaded(const faint::FilePath& path,
+  const std::vector<faint::Bitmap>& bitmaps)
+{
+  using namespace faint;
+  ImageProps props;
+  read_gif(path, props);
+  ABORT_IF(props.GetNumFrames().Get() != resigned(bitmaps.size()));
+  for (int i = 0; i != props.GetNumFrames().Get(); i++){
+    VERIFY(props.GetFrame(Index(i)).GetBackground().Expect<Bitmap>() ==
+      bitmaps[to_size_t(i)]);
+  }
+}
+
+} // namespace
+
+void test_gif_frames(){
+  using namespace faint;
+
+  const std::vector<Delay> delays = {
+    Delay(10_cs), Delay(20_cs), Delay(30_cs), Delay(40_cs)};
+
+  {
+    // Opaque frames are cropped to the changed rectangle
+    const std::vector<Bitmap> bitmaps = {
+      test_frame({2, 3}, color_white),
+      test_frame({10, 12}, color_white),
+      test_frame({10, 12}, color_white),
+      test_frame({11, 12}, color_white)};
+
+    set_max_threads(2);
+    auto frames = quantized_gif_frames(delays,
+      [&](int i){return bitmaps[to_size_t(i)];}, GifOptions());
+    set_max_threads(0);
+
+    ABORT_IF(frames.size() != 4);
+    EQUAL(frames[0].pos, IntPoint(0,0));
+    EQUAL(frames[0].image.map.GetSize(), IntSize(40, 30));
+    EQUAL(frames[1].pos, IntPoint(2, 3));
+    EQUAL(frames[1].image.map.GetSize(), IntSize(13, 13));
+    ABORT_IF(frames[1].image.transparencyIndex.NotSet());
+    EQUAL(frames[1].image.map.Get(12, 0),
+      frames[1].image.transparencyIndex.Get());
+
+    // Unchanged frame
+    EQUAL(frames[2].image.map.GetSize(), IntSize(1, 1));
+    EQUAL(frames[3].pos, IntPoint(10, 12));
+    EQUAL(frames[3].image.map.GetSize(), IntSize(6, 4));
+
+    for (const auto& f : frames){
+      VERIFY(f.disposal == GifDisposal::KEEP);
+    }
+    EQUAL(frames[3].delay.Get().count(), 40);
+
+    const auto path = get_test_save_path(FileName("delta-frames.gif"));
+    VERIFY(write_gif(path, frames).Successful());
+    check_reloaded(path, bitmaps);
+  }
+
+  {
+    // Full frames are used if any frame has transparency
+    const std::vector<Bitmap> bitmaps = {
+      test_frame({2, 3}, color_white),
+      test_frame({10, 12}, color_white),
+      test_frame({10, 12}, color_transparent_white),
+      test_frame({11, 12}, color_white)};
+
+    auto frames = quantized_gif_frames(delays,
+      [&](int i){return bitmaps[to_size_t(i)];}, GifOptions());
+    ABORT_IF(frames.size() != 4);
+    for (const auto& f : frames){
+      EQUAL(f.pos, IntPoint(0,0));
+      EQUAL(f.image.map.GetSize(), IntSize(40, 30));
+      VERIFY(f.disposal == GifDisposal::RESTORE_BACKGROUND);
+    }
+
+    const auto path = get_test_save_path(FileName("full-frames.gif"));
+    VERIFY(write_gif(path, frames).Successful());
+    check_reloaded(path, bitmaps);
+  }
+
+  {
+    // Shared palette
+    std::vector<Bitmap> bitmaps;
+    for (int i = 0; i != 4; i++){
+      Bitmap bmp(IntSize(300, 20));
+      for (int y = 0; y != 20; y++){
+        for (int x = 0; x != 300; x++){
+          put_pixel_raw(bmp, x, y, color_from_ints(x % 256, y * 10, i * 50));
+        }
+      }
+      bitmaps.push_back(bmp);
+    }
+
+    GifOptions options;
+    options.sharedPalette = true;
+    auto frames = quantized_gif_frames(delays,
+      [&](int i){return bitmaps[to_size_t(i)];}, options);
+    ABORT_IF(frames.size() != 4);
+    for (const auto& f : frames){
+      VERIFY(f.image.palette == frames[0].image.palette);
+    }
+
+    const auto path = get_test_save_path(FileName("shared-palette.gif"));
+    VERIFY(write_gif(path, frames).Successful());
+    ImageProps props;
+    read_gif(path, props);
+    EQUAL(props.GetNumFrames().Get(), 4);
+  }
+}
@@ -0,0 +1,164 @@
+// -*- coding: us-ascii-unix -*-
+#include <cstdio>
+#include "test-sys/test.hh"
+#include "tests/test-util/file-handling.hh"
+#include "tests/test-util/print-objects.hh"
+#include "bitmap/bitmap.hh"
+#include "bitmap/color.hh"
+#include "bitmap/draw.hh"
+#include "bitmap/lazy-bitmap.hh"
+#include "formats/bmp/file-bmp.hh"
+#include "formats/bmp/lazy-bmp.hh"
+#include "formats/faint-fopen.hh"
+#include "formats/png/file-png.hh"
+#include "geo/int-point.hh"
+#include "geo/int-rect.hh"
+#include "util/frame-props.hh"
+#include "util/image.hh"
+#include "util/tool-util.hh"
+
+namespace{
+
+using namespace faint;
+
+Bitmap pattern_bitmap(const IntSize& size){
+  Bitmap bmp(size);
+  for (int y = 0; y != size.h; y++){
+    for (int x = 0; x != size.w; x++){
+      put_pixel(bmp, IntPoint(x, y),
+        color_from_ints((x * 7) % 256, (y * 11) % 256, (x + y) % 256));
+    }
+  }
+  return bmp;
+}
+
+Bitmap expect_bitmap(const OrError<Bitmap>& result){
+  return result.Visit(
+    [](const Bitmap& bmp){
+      return bmp;
+    },
+    [](const utf8_string&){
+      return Bitmap();
+    });
+}
+
+bool file_exists(const FilePath& path){
+  FILE* f = faint_fopen_read_binary(path);
+  if (f == nullptr){
+    return false;
+  }
+  fclose(f);
+  return true;
+}
+
+void test_lazy_regions(const LazyBitmap& lazy, const Bitmap& key){
+  EQUAL(lazy.GetSize(), key.GetSize());
+  VERIFY(materialize(lazy) == key);
+
+  const IntRect r(IntPoint(3, 5), IntSize(20, 9));
+  VERIFY(get_region(lazy, r) == subbitmap(key, r));
+
+  const Bitmap sub(get_subsampled(lazy, r, 4));
+  EQUAL(sub.GetSize(), IntSize(5, 3));
+  EQUAL(get_color(sub, IntPoint(2, 1)), get_color(key, IntPoint(11, 9)));
+  EQUAL(get_color(lazy, IntPoint(36, 22)), get_color(key, IntPoint(36, 22)));
+}
+
+} // namespace
+
+void test_lazy_bitmap(){
+  using namespace faint;
+  const Bitmap key(pattern_bitmap(IntSize(37, 23)));
+  auto bmpCachePath = get_test_save_path(FileName("lazy-bmp.cache"));
+  auto get_bmp_cache_path = [&](){
+    return option(bmpCachePath);
+  };
+
+  {
+    // Bmp pixel data copied to a memory mapped cache file
+    auto path = get_test_save_path(FileName("lazy-24bipp.bmp"));
+    ABORT_IF(!write_bmp(path, key, BitmapQuality::COLOR_24BIT).Successful());
+
+    auto lazy = lazy_bmp(path, 0, get_bmp_cache_path);
+    ABORT_IF(lazy == nullptr);
+    VERIFY(file_exists(bmpCachePath));
+    FWD(test_lazy_regions(*lazy, key));
+    VERIFY(materialize(*lazy) == expect_bitmap(read_bmp(path)));
+
+    lazy.reset();
+    NOT(file_exists(bmpCachePath));
+
+    // Small images are not read lazily
+    VERIFY(lazy_bmp(path, 37 * 23 + 1, get_bmp_cache_path) == nullptr);
+  }
+
+  {
+    // 8-bits-per-pixel bmp
+    auto path = get_test_save_path(FileName("lazy-8bipp.bmp"));
+    ABORT_IF(!write_bmp(path, key, BitmapQuality::GRAY_8BIT).Successful());
+
+    auto lazy = lazy_bmp(path, 0, get_bmp_cache_path);
+    ABORT_IF(lazy == nullptr);
+    VERIFY(materialize(*lazy) == expect_bitmap(read_bmp(path)));
+  }
+
+  {
+    // Png decoded to a memory mapped cache file
+    auto path = get_test_save_path(FileName("lazy.png"));
+    auto cachePath = get_test_save_path(FileName("lazy-png.cache"));
+    ABORT_IF(!write_png(path, key, PngColorType::RGB).Successful());
+
+    auto lazy = lazy_png(path, 0,
+      [&](){
+        return option(cachePath);
+      });
+    ABORT_IF(lazy == nullptr);
+    VERIFY(file_exists(cachePath));
+    FWD(test_lazy_regions(*lazy, key));
+
+    lazy.reset();
+    NOT(file_exists(cachePath));
+
+    // Small images are not read lazily, nor is a cache file created
+    int numCreated = 0;
+    VERIFY(lazy_png(path, 37 * 23 + 1,
+      [&](){
+        numCreated++;
+        return option(cachePath);
+      }) == nullptr);
+    EQUAL(numCreated, 0);
+  }
+
+  {
+    // Image with a lazy background
+    auto path = get_test_save_path(FileName("lazy-image.bmp"));
+    ABORT_IF(!write_bmp(path, key, BitmapQuality::COLOR_24BIT).Successful());
+    auto lazy = lazy_bmp(path, 0, get_bmp_cache_path);
+    ABORT_IF(lazy == nullptr);
+
+    Image image(FrameProps(lazy, FrameInfo()));
+    VERIFY(image.GetLazyBackground() != nullptr);
+    EQUAL(image.GetSize(), key.GetSize());
+    EQUAL(get_color(image, IntPoint(5, 6)), get_color(key, IntPoint(5, 6)));
+    VERIFY(image.GetLazyBackground() != nullptr);
+
+    // The first modification reads the pixels, but the original is
+    // kept lazy.
+    image.StoreAsOriginal();
+    VERIFY(image.GetBackground().Get<Bitmap>().Get() == key);
+    VERIFY(image.GetLazyBackground() == nullptr);
+
+    image.SetBitmap(Bitmap(key.GetSize(), color_red));
+    image.Revert();
+    VERIFY(image.GetLazyBackground() != nullptr);
+    VERIFY(image.GetBackground().Get<Bitmap>().Get() == key);
+
+    // Saving a smaller image over the file does not affect the
+    // original
+    ABORT_IF(!write_bmp(path, Bitmap(IntSize(2, 2), color_blue),
+      BitmapQuality::COLOR_24BIT).Successful());
+    image.SetBitmap(Bitmap(key.GetSize(), color_red));
+    image.Revert();
+    VERIFY(image.GetBackground().Get<Bitmap>().Get() == key);
+  }
+}
@@ -0,0 +1,80 @@
+// -*- coding: us-ascii-unix -*-
+#include "test-sys/test.hh"
+#include "tests/test-util/print-objects.hh"
+#include "bitmap/bitmap.hh"
+#include "bitmap/color.hh"
+#include "bitmap/draw.hh"
+#include "geo/int-point.hh"
+#include "geo/int-rect.hh"
+#include "geo/int-size.hh"
+#include "rendering/mip-pyramid.hh"
+#include "util/image.hh"
+
+void test_mip_pyramid(){
+  using namespace faint;
+
+  EQUAL(mip_level_for_zoom(1.0), 0);
+  EQUAL(mip_level_for_zoom(0.6), 0);
+  EQUAL(mip_level_for_zoom(0.5), 1);
+  EQUAL(mip_level_for_zoom(0.3), 1);
+  EQUAL(mip_level_for_zoom(0.25), 2);
+  EQUAL(mip_level_for_zoom(0.1), 3);
+
+  const int T = MIP_TILE_SIZE;
+  Bitmap bmp(IntSize(4 * T + 3, 2 * T + 1), color_white);
+  fill_rect_color(bmp, IntRect(IntPoint(0, 0), IntSize(2, 2)), color_black);
+  put_pixel(bmp, IntPoint(2, 0), Color(100, 100, 100, 255));
+
+  Image image;
+  image.SetBitmap(bmp);
+
+  MipPyramid pyramid;
+  {
+    // Levels are halved, rounding up
+    const Bitmap& level1 = pyramid.GetLevel(image, 1);
+    EQUAL(level1.GetSize(), IntSize(2 * T + 2, T + 1));
+    EQUAL(pyramid.GetNumLevels(), 1);
+    EQUAL(get_color(level1, IntPoint(0, 0)), color_black);
+    EQUAL(get_color(level1, IntPoint(1, 0)), Color(216, 216, 216, 255));
+
+    const Bitmap& level3 = pyramid.GetLevel(image, 3);
+    EQUAL(level3.GetSize(), IntSize(T / 2 + 1, T / 4 + 1));
+    EQUAL(pyramid.GetNumLevels(), 3);
+  }
+
+  {
+    // Only changed regions are updated
+    Bitmap& imageBmp = image.GetBackground().Get<Bitmap>().Get();
+    fill_rect_color(imageBmp, IntRect(IntPoint(3 * T, T), IntSize(4, 4)),
+      color_red);
+    put_pixel(imageBmp, IntPoint(4 * T + 2, 2 * T), color_blue);
+    image.InvalidateRaster(IntRect(IntPoint(3 * T, T), IntSize(4, 4)));
+    image.InvalidateRaster(IntRect(IntPoint(4 * T + 2, 2 * T), IntSize(1, 1)));
+
+    // An unreported change, which should not be picked up
+    put_pixel(imageBmp, IntPoint(0, 2 * T), color_blue);
+
+    const Bitmap level2(pyramid.GetLevel(image, 2));
+    EQUAL(get_color(level2, IntPoint(3 * T / 4, T / 4)), color_red);
+    EQUAL(get_color(level2, IntPoint(T, T / 2)), Color(128, 128, 255, 255));
+    EQUAL(get_color(level2, IntPoint(0, T / 2)), color_white);
+
+    // Replacing the bitmap rebuilds everything
+    image.SetBitmap(Bitmap(imageBmp));
+    MipPyramid rebuilt;
+    VERIFY(pyramid.GetLevel(image, 2) == rebuilt.GetLevel(image, 2));
+    EQUAL(get_color(pyramid.GetLevel(image, 2), IntPoint(0, T / 2)),
+      Color(192, 192, 255, 255));
+  }
+
+  {
+    // The cache keeps pyramids for the most recently used frames
+    MipPyramidCache cache(1);
+    Image other;
+    other.SetBitmap(Bitmap(IntSize(10, 10), color_red));
+    EQUAL(cache.GetLevel(image, 1).GetSize(), IntSize(2 * T + 2, T + 1));
+    EQUAL(cache.GetLevel(other, 1).GetSize(), IntSize(5, 5));
+    EQUAL(get_color(cache.GetLevel(other, 1), IntPoint(0, 0)), color_red);
+    EQUAL(cache.GetLevel(image, 2).GetSize(), IntSize(T + 1, T / 2 + 1));
+  }
+}
@@ -0,0 +1,65 @@
+// -*- coding: us-ascii-unix -*-
+#include <vector>
+#include "test-sys/test.hh"
+#include "tests/test-util/print-objects.hh"
+#include "geo/point.hh"
+#include "geo/rect.hh"
+#include "geo/tri.hh"
+#include "objects/object.hh"
+#include "objects/objrectangle.hh"
+#include "util/default-settings.hh"
+#include "util/object-index.hh"
+#include "util/object-util.hh"
+
+void test_object_index(){
+  using namespace faint;
+
+  // A row of 10x10 rectangles, 20 pixels apart, with a large
+  // rectangle behind them.
+  std::vector<ObjectPtr> owner;
+  objects_t objects;
+  auto add_rect = [&](const Point& p, coord w, coord h){
+    owner.push_back(create_rectangle_object(
+      Tri(p, p + Point(w, 0), p + Point(0, h)),
+      default_rectangle_settings()));
+    objects.push_back(owner.back().get());
+  };
+
+  add_rect(Point(0, 0), 2000, 1000);
+  for (int i = 0; i != 100; i++){
+    add_rect(Point(i * 20.0, 100), 10, 10);
+  }
+
+  ObjectIndex index;
+  {
+    // Bottom to top, only overlapping objects
+    const objects_t hit = index.At(objects, Point(45, 105));
+    EQUAL(hit.size(), 2);
+    VERIFY(hit[0] == objects[0]);
+    VERIFY(hit[1] == objects[3]);
+
+    EQUAL(index.At(objects, Point(55, 500)).size(), 1);
+    EQUAL(index.At(objects, Point(-50, -50)).size(), 0);
+  }
+
+  {
+    // Same result as get_intersected
+    const Rect r(Point(30, 95), Point(95, 120));
+    const objects_t found = index.Intersecting(objects, r);
+    EQUAL(found.size(), 5);
+    VERIFY(found == get_intersected(objects, r));
+  }
+
+  {
+    // Changed bounds are used after invalidation
+    Object* obj = objects[50];
+    obj->SetTri(translated(obj->GetTri(), 0, 500));
+    EQUAL(index.At(objects, Point(985, 605)).size(), 1);
+    index.Invalidate();
+    EQUAL(index.At(objects, Point(985, 605)).size(), 2);
+
+    // Removed objects are noticed even without invalidation
+    objects.erase(objects.begin() + 50);
+    EQUAL(index.At(objects, Point(985, 605)).size(), 1);
+  }
+}
@@ -0,0 +1,121 @@
+// -*- coding: us-ascii-unix -*-
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "test-sys/test.hh"
+#include "util/parallel.hh"
+
+void test_parallel(){
+  using namespace faint;
+
+  const int maxThreads = get_max_threads();
+  VERIFY(maxThreads >= 1);
+
+  for (int numThreads : {1, 2, 4, 7}){
+    set_max_threads(numThreads);
+    EQUAL(get_max_threads(), numThreads);
+
+    // Each item is visited exactly once
+    std::vector<int> visits(1000, 0);
+    parallel_for(1000, 1, [&](int first, int last){
+      for (int i = first; i != last; i++){
+        visits[static_cast<size_t>(i)]++;
+      }
+    });
+    VERIFY(std::all_of(begin(visits), end(visits),
+      [](int n){ return n == 1; }));
+
+    // Nested calls run serially on the calling thread
+    std::vector<int> nested(100, 0);
+    parallel_for(10, 1, [&](int first, int last){
+      for (int i = first; i != last; i++){
+        parallel_for(10, 1, [&](int first2, int last2){
+          for (int j = first2; j != last2; j++){
+            nested[static_cast<size_t>(i * 10 + j)]++;
+          }
+        });
+      }
+    });
+    VERIFY(std::all_of(begin(nested), end(nested),
+      [](int n){ return n == 1; }));
+
+    // Exceptions are rethrown on the calling thread
+    bool thrown = false;
+    try{
+      parallel_for(100, 1, [](int first, int){
+        if (first == 0){
+          throw std::runtime_error("range error");
+        }
+      });
+    }
+    catch (const std::runtime_error&){
+      thrown = true;
+    }
+    VERIFY(thrown);
+  }
+
+  // Too few items for more than one range
+  set_max_threads(4);
+  int calls = 0;
+  parallel_for(10, 100, [&](int first, int last){
+    calls++;
+    EQUAL(first, 0);
+    EQUAL(last, 10);
+  });
+  EQUAL(calls, 1);
+
+  // Row ranges cover [yMin, yMax), with at least
+  // MIN_PIXELS_PER_RANGE pixels per range
+  EQUAL(min_items_per_range(0), MIN_PIXELS_PER_RANGE + 1);
+  EQUAL(min_items_per_range(MIN_PIXELS_PER_RANGE), 2);
+  std::atomic<int> rowsCovered(0);
+  for_row_ranges(5, 1005, 64, [&](int first, int last){
+    VERIFY(first >= 5);
+    VERIFY(last <= 1005);
+    VERIFY(last - first >= min_items_per_range(64) || last == 1005);
+    rowsCovered += last - first;
+  });
+  EQUAL(rowsCovered.load(), 1000);
+
+  calls = 0;
+  for_row_ranges(5, 10, 100, [&](int first, int last){
+    calls++;
+    EQUAL(first, 5);
+    EQUAL(last, 10);
+  });
+  EQUAL(calls, 1);
+
+  {
+    // A job from another thread doesn't delay this thread, which
+    // runs serially while the pool is busy
+    set_max_threads(4);
+    std::atomic<bool> started(false);
+    std::atomic<bool> released(false);
+    std::thread other([&](){
+      parallel_for(100, 1, [&](int, int){
+        started = true;
+        while (!released){
+          std::this_thread::yield();
+        }
+      });
+    });
+    while (!started){
+      std::this_thread::yield();
+    }
+
+    calls = 0;
+    parallel_for(100, 1, [&](int first, int last){
+      calls++;
+      EQUAL(first, 0);
+      EQUAL(last, 100);
+    });
+    EQUAL(calls, 1);
+    released = true;
+    other.join();
+  }
+
+  set_max_threads(0);
+  EQUAL(get_max_threads(), maxThreads);
+}
@@ -0,0 +1,73 @@
+// -*- coding: us-ascii-unix -*-
+#include "test-sys/test.hh"
+#include "tests/test-util/print-objects.hh"
+#include "bitmap/bitmap.hh"
+#include "bitmap/color.hh"
+#include "bitmap/draw.hh"
+#include "bitmap/pixel-tiles.hh"
+#include "geo/int-point.hh"
+#include "geo/int-rect.hh"
+#include "geo/int-size.hh"
+
+void test_pixel_tiles(){
+  using namespace faint;
+
+  const int T = PIXEL_TILE_SIZE;
+  const IntSize sz(3 * T + 10, 2 * T + 5);
+  const Bitmap original(sz, color_white);
+
+  {
+    // Restoring a modified rectangle
+    Bitmap bmp(original);
+    const IntRect r(IntPoint(T - 2, 10), IntSize(4, 4));
+    PixelTiles tiles(bmp, r);
+    EQUAL(tiles.GetNumTiles(), 2);
+    NOT(tiles.Empty());
+    EQUAL(tiles.GetMemoryUsage(),
+      to_size_t(2 * Bitmap(IntSize(T, T)).GetStride() * T));
+
+    fill_rect_color(bmp, r, color_red);
+    VERIFY(bmp != original);
+    tiles.Restore(bmp);
+    VERIFY(bmp == original);
+  }
+
+  {
+    // Rectangles outside the bitmap are clipped
+    Bitmap bmp(original);
+    PixelTiles tiles(bmp, IntRect(IntPoint(-20, -20), IntSize(25, 25)));
+    EQUAL(tiles.GetNumTiles(), 1);
+
+    PixelTiles none(bmp, IntRect(IntPoint(-20, -20), IntSize(5, 5)));
+    VERIFY(none.Empty());
+    none.Restore(bmp);
+    VERIFY(bmp == original);
+  }
+
+  {
+    // Partial edge tiles
+    Bitmap bmp(original);
+    const IntRect r(IntPoint(sz.w - 3, sz.h - 3), IntSize(3, 3));
+    PixelTiles tiles(bmp, r);
+    EQUAL(tiles.GetNumTiles(), 1);
+    EQUAL(tiles.GetMemoryUsage(), to_size_t(Bitmap(IntSize(10, 5)).GetStride() * 5));
+    fill_rect_color(bmp, r, color_blue);
+    tiles.Restore(bmp);
+    VERIFY(bmp == original);
+  }
+
+  {
+    // changed_tiles stores only the tiles which differ
+    Bitmap bmp(original);
+    put_pixel(bmp, IntPoint(0, 0), color_red);
+    put_pixel(bmp, IntPoint(2 * T + 1, T + 1), color_red);
+    put_pixel(bmp, IntPoint(3 * T + 9, 2 * T + 4), color_red);
+
+    PixelTiles tiles(changed_tiles(original, bmp));
+    EQUAL(tiles.GetNumTiles(), 3);
+    tiles.Restore(bmp);
+    VERIFY(bmp == original);
+
+    VERIFY(changed_tiles(original, original).Empty());
+  }
+}
@@ -0,0 +1,297 @@
+// -*- coding: us-ascii-unix -*-
+#include <algorithm>
+#include "test-sys/test.hh"
+#include "tests/test-util/print-objects.hh"
+#include "bitmap/bitmap.hh"
+#include "bitmap/color.hh"
+#include "bitmap/draw.hh"
+#include "bitmap/filter.hh"
+#include "bitmap/paint.hh"
+#include "bitmap/point-ops.hh"
+#include "commands/bitmap-cmd.hh"
+#include "geo/int-point.hh"
+#include "geo/int-size.hh"
+#include "geo/range.hh"
+#include "util/command-util.hh"
+#include "util/parallel.hh"
+
+// Copies of the per-pixel filter implementations which preceded
+// PointOps, so that the fused pipeline is compared with the original
+// output rather than with itself.
+namespace old_filters{
+
+using namespace faint;
+
+static Bitmap brightness_and_contrast(const Bitmap& src,
+  const brightness_contrast_t& v)
+{
+  double scaledBrightness = v.brightness * 255.0;
+  Bitmap dst(src.GetSize());
+
+  for (int y = 0; y != src.m_h; y++){
+    for (int x = 0; x != src.m_w; x++){
+      const auto c = get_color_raw(src, x, y);
+      const auto c2 =
+        color_from_double(c.r * v.contrast + scaledBrightness,
+          c.g * v.contrast + scaledBrightness,
+          c.b * v.contrast + scaledBrightness,
+          c.a);
+      put_pixel_raw(dst, x, y, c2);
+    }
+  }
+  return dst;
+}
+
+static void invert(Bitmap& bmp){
+  for (int y = 0; y != bmp.m_h; y++){
+    for (int x = 0; x != bmp.m_w; x++){
+      const auto c = get_color_raw(bmp, x, y);
+      put_pixel_raw(bmp, x, y, color_from_ints(255 - c.r, 255 - c.g,
+        255 - c.b, c.a));
+    }
+  }
+}
+
+static uchar clip_rgb(coord value){
+  return static_cast<uchar>(std::min(255.0, std::max(0.0, value)));
+}
+
+static void color_balance(Bitmap& bmp,
+  const color_range_t& r,
+  const color_range_t& g,
+  const color_range_t& b)
+{
+  // Note: The green and blue intervals were swapped in the original.
+  const Interval rSpan(r.GetInterval());
+  const Interval gSpan(b.GetInterval());
+  const Interval bSpan(g.GetInterval());
+  double Ar = static_cast<coord>(rSpan.Lower());
+  double Br = static_cast<coord>(rSpan.Upper());
+  double Ag = static_cast<coord>(gSpan.Lower());
+  double Bg = static_cast<coord>(gSpan.Upper());
+  double Ab = static_cast<coord>(bSpan.Lower());
+  double Bb = static_cast<coord>(bSpan.Upper());
+  double L = 0.0;
+  double U = 255.0;
+  double Xr = (U-L) / (Br-Ar);
+  double Yr = L - Ar*((U-L)/ (Br-Ar));
+  double Xg = (U-L) / (Bg-Ag);
+  double Yg = L - Ag*((U-L)/ (Bg-Ag));
+  double Xb = (U-L) / (Bb-Ab);
+  double Yb = L - Ab*((U-L)/ (Bb-Ab));
+
+  for (int y = 0; y != bmp.m_h; y++){
+    for (int x = 0; x != bmp.m_w; x++){
+      const auto c = get_color_raw(bmp, x, y);
+      put_pixel_raw(bmp, x, y, Color(clip_rgb(c.r * Xr + Yr),
+        clip_rgb(c.g * Xg + Yg),
+        clip_rgb(c.b * Xb + Yb),
+        c.a));
+    }
+  }
+}
+
+static void sepia(Bitmap& bmp, int intensity){
+  int depth = 20;
+  for (int y = 0; y != bmp.m_h; y++){
+    for (int x = 0; x != bmp.m_w; x++){
+      Color c = get_color_raw(bmp, x, y);
+      const int gray = (c.r + c.g + c.b) / 3;
+      const int r = std::min(gray + depth * 2, 255);
+      const int g = std::min(gray + depth, 255);
+      const int b = std::max(gray - intensity, 0);
+      put_pixel_raw(bmp, x, y, color_from_ints(r,g,b, c.a));
+    }
+  }
+}
+
+static void set_alpha(Bitmap& bmp, uchar a){
+  for (int y = 0; y != bmp.m_h; y++){
+    for (int x = 0; x != bmp.m_w; x++){
+      Color c = get_color_raw(bmp, x, y);
+      c.a = a;
+      put_pixel_raw(bmp, x, y, c);
+    }
+  }
+}
+
+static void desaturate_simple(Bitmap& bmp){
+  for (int y = 0; y != bmp.m_h; y++){
+    for (int x = 0; x != bmp.m_w; x++){
+      const auto c = get_color_raw(bmp, x, y);
+      const uchar gray = static_cast<uchar>((c.r + c.g + c.b) / 3);
+      put_pixel_raw(bmp, x, y, grayscale_rgba(gray, c.a));
+    }
+  }
+}
+
+static void desaturate_weighted(Bitmap& bmp){
+  for (int y = 0; y != bmp.m_h; y++){
+    for (int x = 0; x != bmp.m_w; x++){
+      const auto c = get_color_raw(bmp, x, y);
+      const uchar gray = static_cast<uchar>(0.3 * c.r + 0.59 * c.g +
+        0.11 * c.b);
+      put_pixel_raw(bmp, x, y, grayscale_rgba(gray, c.a));
+    }
+  }
+}
+
+static void threshold(Bitmap& bmp, const threshold_range_t& range,
+  const Color& in, const Color& out)
+{
+  const Interval interval(range.GetInterval());
+  for (int y = 0; y != bmp.m_h; y++){
+    for (int x = 0; x != bmp.m_w; x++){
+      const auto c = get_color_raw(bmp, x, y);
+      put_pixel_raw(bmp, x, y,
+        interval.Has(c.r + c.g + c.b) ? in : out);
+    }
+  }
+}
+
+} // namespace
+
+static faint::Bitmap varied_bitmap(){
+  using namespace faint;
+  Bitmap bmp(IntSize(256, 300));
+  for (int y = 0; y != bmp.m_h; y++){
+    for (int x = 0; x != bmp.m_w; x++){
+      put_pixel_raw(bmp, x, y, color_from_ints(x,
+        (x * 7 + y * 3) % 256,
+        (x + y * 11) % 256,
+        (x + y * 5) % 256));
+    }
+  }
+  return bmp;
+}
+
+void test_point_ops(){
+  using namespace faint;
+
+  const Bitmap src(varied_bitmap());
+  const brightness_contrast_t bc(0.2, 1.3);
+  const color_range_t r(Interval(min_t(10), max_t(200)));
+  const color_range_t g(Interval(min_t(0), max_t(128)));
+  const color_range_t b(Interval(min_t(50), max_t(250)));
+  const threshold_range_t t(Interval(min_t(100), max_t(500)));
+
+  {
+    // Consecutive lookup table operations are combined
+    PointOps ops;
+    VERIFY(ops.Empty());
+    ops.Invert().SetAlpha(5).BrightnessContrast(bc).ColorBalance(r, g, b);
+    EQUAL(ops.GetNumSteps(), 1);
+    ops.Sepia(20).Invert();
+    EQUAL(ops.GetNumSteps(), 3);
+    NOT(ops.Empty());
+  }
+
+  {
+    // The filters match the original implementations
+    VERIFY(brightness_and_contrast(src, bc) ==
+      old_filters::brightness_and_contrast(src, bc));
+
+    Bitmap bmp(src);
+    Bitmap expected(src);
+    color_balance(bmp, r, g, b);
+    old_filters::color_balance(expected, r, g, b);
+    VERIFY(bmp == expected);
+
+    desaturate_weighted(bmp);
+    old_filters::desaturate_weighted(expected);
+    VERIFY(bmp == expected);
+
+    bmp = src;
+    expected = src;
+    threshold(bmp, t, Paint(color_red), Paint(color_blue));
+    old_filters::threshold(expected, t, color_red, color_blue);
+    VERIFY(bmp == expected);
+
+    bmp = src;
+    expected = src;
+    sepia(bmp, 30);
+    old_filters::sepia(expected, 30);
+    VERIFY(bmp == expected);
+  }
+
+  {
+    // The fused pipeline matches the original filters applied one at
+    // a time
+    Bitmap expected(old_filters::brightness_and_contrast(src, bc));
+    old_filters::invert(expected);
+    old_filters::color_balance(expected, r, g, b);
+    old_filters::sepia(expected, 30);
+    old_filters::set_alpha(expected, 128);
+    old_filters::desaturate_weighted(expected);
+    old_filters::invert(expected);
+    old_filters::threshold(expected, t, color_red, color_blue);
+
+    PointOps ops;
+    ops.BrightnessContrast(bc).
+      Invert().
+      ColorBalance(r, g, b).
+      Sepia(30).
+      SetAlpha(128).
+      DesaturateWeighted().
+      Invert().
+      Threshold(t, color_red, color_blue);
+
+    Bitmap bmp(src);
+    ops.Apply(bmp);
+    VERIFY(bmp == expected);
+
+    // Serial and parallel application are identical
+    set_max_threads(1);
+    Bitmap serial(src);
+    ops.Apply(serial);
+    set_max_threads(0);
+    VERIFY(serial == expected);
+  }
+
+  {
+    // The whole chain is a single command
+    PointOps ops;
+    ops.DesaturateSimple().Invert().Sepia(10);
+    BitmapCommandPtr cmd = get_point_ops_command(ops);
+    EQUAL(cmd->Name(), "Point operations");
+
+    Bitmap expected(src);
+    old_filters::desaturate_simple(expected);
+    old_filters::invert(expected);
+    old_filters::sepia(expected, 10);
+
+    Bitmap bmp(src);
+    cmd->Do(bmp);
+    VERIFY(bmp == expected);
+  }
+
+  {
+    // Desaturation and inverting
+    Bitmap expected(src);
+    old_filters::desaturate_simple(expected);
+    old_filters::invert(expected);
+
+    Bitmap bmp(src);
+    PointOps().DesaturateSimple().Invert().Apply(bmp);
+    VERIFY(bmp == expected);
+  }
+
+  {
+    // Applying to a single color
+    PointOps ops;
+    ops.Invert().SetAlpha(40);
+    EQUAL(ops.Apply(Color(10, 20, 30, 255)), Color(245, 235, 225, 40));
+    EQUAL(PointOps().Apply(color_magenta), color_magenta);
+
+    ops.DesaturateSimple();
+    EQUAL(ops.Apply(Color(10, 20, 30, 255)),
+      desaturated_simple(Color(245, 235, 225, 40)));
+  }
+
+  {
+    // An empty pipeline leaves the bitmap unchanged
+    Bitmap bmp(src);
+    PointOps().Apply(bmp);
+    VERIFY(bmp == src);
+  }
+}
@@ -0,0 +1,84 @@
+// -*- coding: us-ascii-unix -*-
+#include <condition_variable>
+#include <mutex>
+#include "test-sys/test.hh"
+#include "tests/test-util/print-objects.hh"
+#include "bitmap/bitmap.hh"
+#include "bitmap/color.hh"
+#include "geo/int-size.hh"
+#include "util/preview-worker.hh"
+
+namespace{
+
+class Signal{
+public:
+  void Notify(){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_count++;
+    m_cv.notify_all();
+  }
+
+  void WaitFor(int count){
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [&](){return m_count >= count;});
+  }
+private:
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  int m_count = 0;
+};
+
+} // namespace
+
+void test_preview_worker(){
+  using namespace faint;
+
+  Signal done;
+  PreviewWorker worker([&](){done.Notify();});
+  VERIFY(worker.TakeResult().NotSet());
+
+  // A result is available after the job finished
+  worker.Start([](const cancelled_func&){
+    return option(Bitmap(IntSize(2, 3), color_red));
+  });
+  done.WaitFor(1);
+  auto result = worker.TakeResult();
+  VERIFY(result.IsSet());
+  EQUAL(result.Get().GetSize(), IntSize(2, 3));
+  VERIFY(worker.TakeResult().NotSet());
+
+  // Starting a new job cancels the running job
+  Signal started;
+  Signal release;
+  bool wasCancelled = false;
+  worker.Start([&](const cancelled_func& cancelled){
+    started.Notify();
+    release.WaitFor(1);
+    wasCancelled = cancelled();
+    return option(Bitmap(IntSize(1, 1), color_red));
+  });
+  started.WaitFor(1);
+  worker.Start([](const cancelled_func&){
+    return option(Bitmap(IntSize(4, 4), color_blue));
+  });
+  release.Notify();
+  done.WaitFor(2);
+  VERIFY(wasCancelled);
+  result = worker.TakeResult();
+  VERIFY(result.IsSet());
+  EQUAL(result.Get().GetSize(), IntSize(4, 4));
+
+  // Cancel discards pending jobs
+  Signal blocked;
+  worker.Start([&](const cancelled_func&){
+    blocked.WaitFor(1);
+    return option(Bitmap(IntSize(1, 1), color_red));
+  });
+  worker.Cancel();
+  blocked.Notify();
+  worker.Start([](const cancelled_func&){
+    return option(Bitmap(IntSize(5, 5), color_blue));
+  });
+  done.WaitFor(3);
+  EQUAL(worker.TakeResult().Get().GetSize(), IntSize(5, 5));
+}
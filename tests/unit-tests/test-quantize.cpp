@@ -5,6 +5,7 @@
 #include "bitmap/bitmap.hh"
 #include "bitmap/iter-bmp.hh"
 #include "bitmap/color-counting.hh"
+#include "bitmap/mask.hh"
 #include "bitmap/quantize.hh"
 
 void test_quantize(){
@@ -73,4 +74,61 @@ void test_quantize(){
     EQUAL(map.Get(0, 0), mapped.transparencyIndex.Get());
     EQUAL(palette[map.Get(1, 0)], strip_alpha(color_red));
   }
+
+  {
+    // Masked pixels are mapped to the transparency index
+    Bitmap bmp(IntSize(300, 2));
+    Mask mask(bmp.GetSize());
+    for (int x = 0; x != 300; x++){
+      put_pixel_raw(bmp, x, 0, color_from_ints(x % 256, x / 2, 0));
+      put_pixel_raw(bmp, x, 1, color_from_ints(0, 0, x % 256));
+      mask.Set(x, 1, x % 3 == 0);
+    }
+    EQUAL(count_colors(bmp), 555);
+    auto mapped = quantized(bmp, mask, Dithering::OFF);
+    ABORT_IF(mapped.transparencyIndex.NotSet());
+    const int index = mapped.transparencyIndex.Get();
+    VERIFY(mapped.palette.size() <= 256);
+    for (int x = 0; x != 300; x++){
+      VERIFY(mapped.map.Get(x, 0) != index);
+      EQUAL(mapped.map.Get(x, 1) == index, x % 3 == 0);
+    }
+
+    // Few colors are kept
+    Bitmap small(IntSize(2, 1), color_red);
+    put_pixel_raw(small, 1, 0, color_blue);
+    Mask smallMask(small.GetSize());
+    smallMask.Set(0, 0, true);
+    auto mappedSmall = quantized(small, smallMask, Dithering::ON);
+    ABORT_IF(mappedSmall.transparencyIndex.NotSet());
+    EQUAL(mappedSmall.map.Get(0, 0), mappedSmall.transparencyIndex.Get());
+    EQUAL(mappedSmall.palette[mappedSmall.map.Get(1, 0)], ColRGB(0, 0, 255));
+  }
+
+  {
+    // Shared palette
+    Bitmap bmp1(IntSize(300, 1));
+    Bitmap bmp2(IntSize(300, 1));
+    for (int x = 0; x != 300; x++){
+      put_pixel_raw(bmp1, x, 0, color_from_ints(x % 256, 0, 0));
+      put_pixel_raw(bmp2, x, 0, color_from_ints(0, x % 256, 0));
+    }
+
+    SharedPalette palette;
+    palette.Add(bmp1);
+    palette.Add(bmp2);
+    palette.Finish();
+
+    Mask mask(bmp1.GetSize());
+    mask.Set(5, 0, true);
+    auto mapped1 = palette.Map(bmp1, mask, Dithering::ON);
+    auto mapped2 = palette.Map(bmp2, Mask(bmp2.GetSize()), Dithering::ON);
+    VERIFY(mapped1.palette == mapped2.palette);
+    VERIFY(mapped1.palette.size() <= 256);
+    EQUAL(mapped1.transparencyIndex.Get(), resigned(mapped1.palette.size()) - 1);
+    EQUAL(mapped1.map.Get(5, 0), mapped1.transparencyIndex.Get());
+    VERIFY(mapped1.map.Get(6, 0) != mapped1.transparencyIndex.Get());
+    VERIFY(mapped1.palette[mapped1.map.Get(255, 0)].g < 16);
+    VERIFY(mapped2.palette[mapped2.map.Get(255, 0)].r < 16);
+  }
 }
@@ -0,0 +1,234 @@
+// -*- coding: us-ascii-unix -*-
+#include "test-sys/test.hh"
+#include "tests/test-util/print-objects.hh"
+#include "bitmap/bitmap.hh"
+#include "bitmap/color.hh"
+#include "commands/command.hh"
+#include "geo/canvas-geo.hh"
+#include "geo/int-point.hh"
+#include "geo/int-size.hh"
+#include "gui/canvas-panel-contexts.hh"
+#include "util/command-history.hh"
+#include "util/image.hh"
+#include "util/image-list.hh"
+#include "util/image-props.hh"
+#include "util/raster-checkpoints.hh"
+
+namespace{
+
+using namespace faint;
+
+int g_numDoRaster = 0;
+
+class PixelCmd : public Command{
+  // Raster command which can only be undone by reapplying earlier
+  // commands.
+public:
+  explicit PixelCmd(const IntPoint& pos)
+    : Command(CommandType::RASTER),
+      m_pos(pos)
+  {}
+
+  void Do(CommandContext& ctx) override{
+    g_numDoRaster++;
+    put_pixel(ctx.GetRawBitmap(), m_pos, color_red);
+  }
+
+  utf8_string Name() const override{
+    return "Pixel";
+  }
+private:
+  IntPoint m_pos;
+};
+
+class FrameContext : public TargetableCommandContext{
+public:
+  void Add(Object*, const select_added&, const deselect_old&) override{}
+  void Add(Object*, int, const select_added&, const deselect_old&) override{}
+  void AddFrame(Image*) override{}
+  void AddFrame(Image*, const Index&) override{}
+
+  const Bitmap& GetBitmap() const override{
+    return m_frame->GetBackground().Get<Bitmap>().Get();
+  }
+
+  FaintDC& GetDC() override{
+    throw std::exception();
+  }
+
+  Image& GetFrame() override{
+    return *m_frame;
+  }
+
+  Image& GetFrame(const Index&) override{
+    return *m_frame;
+  }
+
+  RasterSelection& GetRasterSelection() override{
+    return m_frame->GetRasterSelection();
+  }
+
+  IntSize GetImageSize() const override{
+    return m_frame->GetSize();
+  }
+
+  const objects_t& GetObjects() override{
+    return m_frame->GetObjects();
+  }
+
+  int GetObjectZ(const Object*) override{
+    return 0;
+  }
+
+  Bitmap& GetRawBitmap() override{
+    return m_frame->GetBackground().Get<Bitmap>().Get();
+  }
+
+  bool HasObjects() const override{
+    return false;
+  }
+
+  void MoveRasterSelection(const IntPoint&) override{}
+  void OffsetOrigin(const IntPoint&) override{}
+  void Remove(Object*) override{}
+  void RemoveFrame(const Index&) override{}
+  void RemoveFrame(Image*) override{}
+  void ReorderFrame(const NewIndex&, const OldIndex&) override{}
+
+  void RevertFrame() override{
+    m_frame->Revert();
+  }
+
+  void SetBitmap(const Bitmap& bmp) override{
+    m_frame->SetBitmap(bmp);
+  }
+
+  void SetBitmap(Bitmap&& bmp) override{
+    m_frame->SetBitmap(std::move(bmp));
+  }
+
+  void SetFrame(Image* frame) override{
+    m_frame = frame;
+  }
+
+  void SetObjectZ(Object*, int) override{}
+  void SetRasterSelection(const SelectionState&) override{}
+  void SetRasterSelectionOptions(const SelectionOptions&) override{}
+private:
+  Image* m_frame = nullptr;
+};
+
+int num_red(const Image& image){
+  const Bitmap& bmp = image.GetBackground().Get<Bitmap>().Get();
+  int num = 0;
+  for (int x = 0; x != bmp.GetSize().w; x++){
+    num += get_color(bmp, IntPoint(x, 0)) == color_red ? 1 : 0;
+  }
+  return num;
+}
+
+} // namespace
+
+void test_raster_checkpoints(){
+  using namespace faint;
+
+  const IntSize imageSize(10, 1);
+  const size_t bmpBytes = to_size_t(Bitmap(imageSize).GetStride());
+
+  {
+    // Snapshot interval and memory budget
+    CheckpointOptions options;
+    options.interval = 2;
+    options.expensiveSeconds = 1.0;
+    options.memoryBudget = 2 * bmpBytes;
+    RasterCheckpoints checkpoints(options);
+
+    Image image;
+    image.SetBitmap(Bitmap(imageSize, color_white));
+    PixelCmd c1(IntPoint(0,0));
+    PixelCmd c2(IntPoint(1,0));
+    PixelCmd c3(IntPoint(2,0));
+    PixelCmd c4(IntPoint(3,0));
+    PixelCmd c5(IntPoint(4,0));
+    PixelCmd c6(IntPoint(5,0));
+
+    checkpoints.Applied(&c1, image, 0.0);
+    EQUAL(checkpoints.GetCount(), 0);
+    checkpoints.Applied(&c2, image, 0.0);
+    EQUAL(checkpoints.GetCount(), 1);
+    VERIFY(checkpoints.Get(&c1) == nullptr);
+    VERIFY(checkpoints.Get(&c2) != nullptr);
+    EQUAL(checkpoints.GetMemoryUsage(), bmpBytes);
+
+    // Expensive commands are always snapshotted
+    checkpoints.Applied(&c3, image, 2.0);
+    EQUAL(checkpoints.GetCount(), 2);
+    VERIFY(checkpoints.Get(&c3) != nullptr);
+
+    // The oldest snapshot is evicted when exceeding the budget
+    checkpoints.Applied(&c4, image, 0.0);
+    checkpoints.Applied(&c5, image, 0.0);
+    EQUAL(checkpoints.GetCount(), 2);
+    VERIFY(checkpoints.Get(&c2) == nullptr);
+    VERIFY(checkpoints.Get(&c3) != nullptr);
+    VERIFY(checkpoints.Get(&c5) != nullptr);
+    EQUAL(checkpoints.GetMemoryUsage(), 2 * bmpBytes);
+
+    checkpoints.Remove(&c5);
+    EQUAL(checkpoints.GetCount(), 1);
+    EQUAL(checkpoints.GetMemoryUsage(), bmpBytes);
+    checkpoints.Remove(&c6); // No snapshot, ignored
+    EQUAL(checkpoints.GetCount(), 1);
+
+    checkpoints.Clear();
+    EQUAL(checkpoints.GetCount(), 0);
+    EQUAL(checkpoints.GetMemoryUsage(), 0);
+  }
+
+  {
+    // Undo restores the nearest snapshot and reapplies only the later
+    // commands.
+    CheckpointOptions options;
+    options.interval = 4;
+    options.expensiveSeconds = 1000.0;
+    CommandHistory history(options);
+
+    ImageList images(ImageProps(Bitmap(imageSize, color_white)));
+    FrameContext ctx;
+    CanvasGeo geo;
+
+    for (int x = 0; x != 10; x++){
+      history.Apply(new PixelCmd(IntPoint(x, 0)), clear_redo(true),
+        &images.Active(), images, ctx, geo);
+    }
+    EQUAL(num_red(images.Active()), 10);
+
+    // Snapshot after the eighth command, only the ninth is reapplied.
+    g_numDoRaster = 0;
+    VERIFY(history.Undo(ctx, geo));
+    EQUAL(num_red(images.Active()), 9);
+    EQUAL(g_numDoRaster, 1);
+
+    g_numDoRaster = 0;
+    VERIFY(history.Undo(ctx, geo));
+    EQUAL(num_red(images.Active()), 8);
+    EQUAL(g_numDoRaster, 0);
+
+    // The snapshot is removed with the undone command, so undoing
+    // again uses the snapshot after the fourth command.
+    g_numDoRaster = 0;
+    VERIFY(history.Undo(ctx, geo));
+    EQUAL(num_red(images.Active()), 7);
+    EQUAL(g_numDoRaster, 3);
+
+    history.Redo(ctx, geo, images);
+    EQUAL(num_red(images.Active()), 8);
+
+    // Undo all the way back to the original image
+    for (int i = 0; i != 8; i++){
+      VERIFY(history.Undo(ctx, geo));
+      EQUAL(num_red(images.Active()), 7 - i);
+    }
+    NOT(history.CanUndo());
+  }
+}
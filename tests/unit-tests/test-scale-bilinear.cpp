@@ -2,8 +2,12 @@
 #include "test-sys/test.hh"
 #include "tests/test-util/file-handling.hh"
 #include "geo/geo-func.hh"
+#include "geo/int-point.hh"
+#include "geo/int-rect.hh"
 #include "geo/scale.hh"
 
+#include "bitmap/color.hh"
+#include "bitmap/draw.hh"
 #include "bitmap/scale-bilinear.hh"
 
 void test_scale_bilinear(){
@@ -12,4 +16,23 @@ void test_scale_bilinear(){
   const Bitmap key = load_test_image(FileName("bilinear-key.png"));
   Bitmap dst = scale_bilinear(src, rounded(src.GetSize() * Scale(2.0, 3.0)));
   VERIFY(dst == key);
+
+  // Scaling only a region gives the same pixels as the full scaling
+  for (const IntRect& r : {IntRect(IntPoint(0, 0), dst.GetSize()),
+        IntRect(IntPoint(13, 7), IntSize(40, 31)),
+        IntRect(IntPoint(dst.m_w - 5, dst.m_h - 1), IntSize(5, 1))})
+  {
+    VERIFY(scale_bilinear(src, dst.GetSize(), r) == subbitmap(dst, r));
+  }
+  const Bitmap shrunk = scale_bilinear(src, IntSize(17, 9));
+  const IntRect shrunkRegion(IntPoint(3, 2), IntSize(10, 5));
+  VERIFY(scale_bilinear(src, IntSize(17, 9), shrunkRegion) ==
+    subbitmap(shrunk, shrunkRegion));
+
+  // Single pixel wide source, interpolated only vertically
+  Bitmap column(IntSize(1, 2), color_black);
+  put_pixel(column, IntPoint(0, 1), color_white);
+  const Bitmap scaled = scale_bilinear(column, IntSize(3, 4));
+  VERIFY(get_color(scaled, IntPoint(2, 0)) == color_black);
+  VERIFY(get_color(scaled, IntPoint(2, 2)) == Color(128, 128, 128));
 }
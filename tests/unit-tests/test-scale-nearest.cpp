@@ -3,8 +3,10 @@
 #include "tests/test-util/bitmap-test-util.hh"
 #include "tests/test-util/file-handling.hh"
 
+#include "bitmap/draw.hh"
 #include "bitmap/scale-nearest.hh"
 #include "geo/geo-func.hh"
+#include "geo/int-rect.hh"
 #include "geo/scale.hh"
 
 void test_scale_nearest(){
@@ -15,4 +17,12 @@ void test_scale_nearest(){
   VERIFY(equal(dst, key));
   VERIFY(equal(scale_nearest(src, 2),
     scale_nearest(src, rounded(src.GetSize() * Scale(2.0)))));
+
+  // Scaling only a region gives the same pixels as the full scaling
+  for (const IntRect& r : {IntRect(IntPoint(0, 0), dst.GetSize()),
+        IntRect(IntPoint(5, 11), IntSize(13, 17)),
+        IntRect(IntPoint(dst.m_w - 1, 0), IntSize(1, dst.m_h))})
+  {
+    VERIFY(equal(scale_nearest(src, dst.GetSize(), r), subbitmap(dst, r)));
+  }
 }
@@ -0,0 +1,105 @@
+// -*- coding: us-ascii-unix -*-
+#include "test-sys/test.hh"
+#include "tests/test-util/print-objects.hh"
+#include "bitmap/bitmap.hh"
+#include "bitmap/color.hh"
+#include "bitmap/draw.hh"
+#include "bitmap/scale-nearest.hh"
+#include "geo/int-point.hh"
+#include "geo/int-rect.hh"
+#include "geo/int-size.hh"
+#include "rendering/scaled-tile-cache.hh"
+#include "util/image.hh"
+#include "util/raster-changes.hh"
+
+void test_scaled_tile_cache(){
+  using namespace faint;
+  // The tile size in image pixels at 3x
+  const int T = scaled_tile_image_size(3);
+
+  {
+    // RasterChanges
+    RasterChanges changes;
+    const IntRect r1(IntPoint(0, 0), IntSize(10, 10));
+    const IntRect r2(IntPoint(100, 100), IntSize(10, 10));
+    NOT(changes.ChangedSince(0, r1));
+
+    changes.Changed(r1);
+    EQUAL(changes.GetGeneration(), 1);
+    VERIFY(changes.ChangedSince(0, r1));
+    NOT(changes.ChangedSince(0, r2));
+    NOT(changes.ChangedSince(1, r1));
+
+    changes.ChangedAll();
+    VERIFY(changes.ChangedSince(1, r2));
+    NOT(changes.ChangedSince(2, r2));
+
+    // Changes too far back are forgotten, and reported as changed.
+    for (int i = 0; i != 100; i++){
+      changes.Changed(r1);
+    }
+    VERIFY(changes.ChangedSince(2, r2));
+    NOT(changes.ChangedSince(changes.GetGeneration() - 1, r2));
+  }
+
+  Image image;
+  Bitmap bmp(IntSize(2 * T + 10, T + 5), color_white);
+  put_pixel(bmp, IntPoint(3, 3), color_red);
+  put_pixel(bmp, IntPoint(2 * T + 9, T + 4), color_blue);
+  image.SetBitmap(bmp);
+  const IntRect region(IntPoint(1, 1), IntSize(2 * T, T + 2));
+
+  {
+    // Composed from tiles, identical to scaling the region
+    ScaledTileCache cache;
+    VERIFY(cache.GetScaled(image, region, 3) ==
+      scale_nearest(subbitmap(bmp, region), 3));
+    EQUAL(cache.GetCount(), 6);
+
+    // Unchanged tiles are reused
+    const size_t memoryUsage = cache.GetMemoryUsage();
+    cache.GetScaled(image, region, 3);
+    EQUAL(cache.GetCount(), 6);
+    EQUAL(cache.GetMemoryUsage(), memoryUsage);
+
+    // Changes are picked up for invalidated rectangles
+    Bitmap& imageBmp = image.GetBackground().Get<Bitmap>().Get();
+    put_pixel(imageBmp, IntPoint(T + 1, 5), color_green);
+    image.InvalidateRaster(IntRect(IntPoint(T + 1, 5), IntSize(1, 1)));
+    put_pixel(bmp, IntPoint(T + 1, 5), color_green);
+    VERIFY(cache.GetScaled(image, region, 3) ==
+      scale_nearest(subbitmap(bmp, region), 3));
+
+    // .. and when the bitmap is replaced
+    fill_rect_color(bmp, IntRect(IntPoint(0, 0), IntSize(T, T)), color_black);
+    image.SetBitmap(bmp);
+    VERIFY(cache.GetScaled(image, region, 2) ==
+      scale_nearest(subbitmap(bmp, region), 2));
+    VERIFY(cache.GetScaled(image, region, 3) ==
+      scale_nearest(subbitmap(bmp, region), 3));
+
+    cache.Clear();
+    EQUAL(cache.GetCount(), 0);
+    EQUAL(cache.GetMemoryUsage(), 0);
+  }
+
+  {
+    // The least recently used tiles are evicted to fit the budget
+    const size_t tileBytes = to_size_t(
+      Bitmap(IntSize(SCALED_TILE_SIZE, SCALED_TILE_SIZE)).GetStride() *
+      SCALED_TILE_SIZE);
+    ScaledTileCache cache(2 * tileBytes);
+    VERIFY(cache.GetScaled(image, region, 2) ==
+      scale_nearest(subbitmap(bmp, region), 2));
+    VERIFY(cache.GetMemoryUsage() <= 2 * tileBytes);
+
+    // Tiles cover fewer image pixels when zoomed in further, so that
+    // they don't grow with the zoom.
+    ScaledTileCache zoomedCache;
+    const IntRect small(IntPoint(0, 0), IntSize(10, 10));
+    VERIFY(zoomedCache.GetScaled(image, small, 40) ==
+      scale_nearest(subbitmap(bmp, small), 40));
+    EQUAL(zoomedCache.GetCount(), 4);
+    VERIFY(zoomedCache.GetMemoryUsage() <= 4 * tileBytes);
+  }
+}
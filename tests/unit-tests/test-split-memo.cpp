@@ -0,0 +1,125 @@
+// -*- coding: us-ascii-unix -*-
+#include "test-sys/test.hh"
+#include "tests/test-util/print-objects.hh"
+#include "geo/int-size.hh"
+#include "text/split-memo.hh"
+#include "text/split-string.hh"
+#include "text/text-geo.hh"
+#include "text/text-buffer.hh"
+#include "util/optional.hh"
+
+namespace{
+
+using namespace faint;
+
+class TextInfo_split_memo : public TextInfo{
+public:
+  int GetWidth(const utf8_string& str) const override{
+    numMeasured++;
+    return resigned(str.size()) * 10;
+  }
+
+  int ComputeRowHeight() const override{
+    return 12;
+  }
+
+  IntSize TextSize(const faint::utf8_string&) const override{
+    ABORT_TEST("Stub called");
+  }
+
+  mutable int numMeasured = 0;
+};
+
+} // namespace
+
+void test_split_memo(){
+  using namespace faint;
+
+  TextInfo_split_memo ti;
+  const SplitFont font("Arial", 12, false, false);
+  TextBuffer buffer("Hello world\nagain");
+  SplitMemo memo;
+
+  {
+    // Splitting again is memoized
+    const auto expected = split_string(ti, buffer.get(), max_width_t(60.0));
+    const auto& split = memo.Get(ti, buffer, font, max_width_t(60.0));
+    EQUAL(split.lines.size(), expected.size());
+    EQUAL(split.lines[0].text, expected[0].text);
+    EQUAL(memo.GetNumSplits(), 1);
+
+    const int numMeasured = ti.numMeasured;
+    EQUAL(memo.Get(ti, buffer, font, max_width_t(60.0)).lines.size(),
+      expected.size());
+    EQUAL(memo.GetNumSplits(), 1);
+    EQUAL(ti.numMeasured, numMeasured);
+  }
+
+  {
+    // Changed width or font splits again
+    EQUAL(memo.Get(ti, buffer, font, no_option()).lines.size(), 2);
+    EQUAL(memo.GetNumSplits(), 2);
+    memo.Get(ti, buffer, SplitFont("Arial", 12, true, false), no_option());
+    EQUAL(memo.GetNumSplits(), 3);
+
+    // ..while the earlier splits are still remembered
+    memo.Get(ti, buffer, font, max_width_t(60.0));
+    memo.Get(ti, buffer, font, no_option());
+    EQUAL(memo.GetNumSplits(), 3);
+  }
+
+  {
+    // Modifying the buffer splits again
+    buffer.caret(buffer.size());
+    buffer.insert(utf8_string(" and again"));
+    const auto& split = memo.Get(ti, buffer, font, no_option());
+    EQUAL(memo.GetNumSplits(), 4);
+    EQUAL(split.lines[1].text, "again and again");
+
+    // Moving the caret does not
+    buffer.caret(0);
+    memo.Get(ti, buffer, font, no_option());
+    EQUAL(memo.GetNumSplits(), 4);
+  }
+
+  {
+    // Other text is memoized by value
+    memo.Get(ti, utf8_string("1 + 2 = 3"), font, no_option());
+    memo.Get(ti, utf8_string("1 + 2 = 3"), font, no_option());
+    EQUAL(memo.GetNumSplits(), 5);
+    memo.Get(ti, utf8_string("1 + 3 = 4"), font, no_option());
+    EQUAL(memo.GetNumSplits(), 6);
+  }
+
+  {
+    // Measurements are computed once
+    memo.Clear();
+    const auto& split = memo.Get(ti, buffer, font, no_option());
+    EQUAL(memo.GetNumSplits(), 7);
+
+    const int numMeasured = ti.numMeasured;
+    EQUAL(split.Extents(ti), IntSize(150, 24));
+    EQUAL(ti.numMeasured, numMeasured + 2);
+    split.Extents(ti);
+    EQUAL(ti.numMeasured, numMeasured + 2);
+    EQUAL(split.Extents(ti), text_extents(ti, split.lines));
+
+    int numCumulative = 0;
+    auto cumulative = [&](const utf8_string& s){
+      numCumulative++;
+      std::vector<int> widths;
+      for (size_t i = 1; i <= s.size(); i++){
+        widths.push_back(resigned(i) * 10);
+      }
+      return widths;
+    };
+
+    EQUAL(split.CumulativeWidths(split.lines[0].text, cumulative).size(),
+      split.lines[0].text.size());
+    split.CumulativeWidths(split.lines[0].text, cumulative);
+    EQUAL(numCumulative, 1);
+    EQUAL(split.CumulativeWidths(split.lines[1].text, cumulative).back(),
+      150);
+    EQUAL(numCumulative, 2);
+  }
+}
@@ -214,4 +214,25 @@ void test_text_buffer(){
     b.move_down();
     KNOWN_INEQUAL(b.caret(), 6);
   }
+
+  {
+    // The generation changes when the text changes
+    TextBuffer b("hello");
+    const size_t gen0 = b.generation();
+    b.caret(2);
+    b.advance(true);
+    EQUAL(b.generation(), gen0);
+
+    b.insert(utf8_char("x"));
+    const size_t gen1 = b.generation();
+    VERIFY(gen1 != gen0);
+    b.del_back();
+    VERIFY(b.generation() != gen1);
+
+    // Distinct buffers have distinct generations, copies share it
+    TextBuffer other("hello");
+    VERIFY(other.generation() != b.generation());
+    TextBuffer copy(b);
+    EQUAL(copy.generation(), b.generation());
+  }
 }
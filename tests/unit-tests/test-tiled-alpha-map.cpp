@@ -0,0 +1,115 @@
+// -*- coding: us-ascii-unix -*-
+#include "test-sys/test.hh"
+#include "tests/test-util/print-objects.hh"
+#include "bitmap/alpha-map.hh"
+#include "bitmap/brush.hh"
+#include "bitmap/tiled-alpha-map.hh"
+#include "geo/int-point.hh"
+#include "geo/int-rect.hh"
+#include "geo/int-size.hh"
+
+namespace{
+
+bool same(const faint::TiledAlphaMap& tiled, const faint::AlphaMap& dense){
+  const faint::IntSize sz(dense.GetSize());
+  if (tiled.GetSize() != sz){
+    return false;
+  }
+  for (int y = 0; y != sz.h; y++){
+    for (int x = 0; x != sz.w; x++){
+      if (tiled.Get(x, y) != dense.Get(x, y)){
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+void test_tiled_alpha_map(){
+  using namespace faint;
+  const int T = ALPHA_TILE_SIZE;
+  const IntSize sz(3 * T + 10, 2 * T + 5);
+
+  {
+    // Tiles are allocated on demand
+    TiledAlphaMap map(sz);
+    EQUAL(map.GetNumTiles(), 0);
+    NOT(map.BoundingRect().IsSet());
+    EQUAL(map.Get(T, T), 0);
+
+    const Brush b(rect_brush(4));
+    EQUAL(map.Add(IntPoint(T - 2, 10), b),
+      IntRect(IntPoint(T - 2, 10), IntSize(4, 4)));
+    EQUAL(map.GetNumTiles(), 2);
+    EQUAL(map.BoundingRect().Get(),
+      IntRect(IntPoint(0, 0), IntSize(2 * T, T)));
+    EQUAL(map.Get(T - 2, 10), 255);
+    EQUAL(map.Get(T + 1, 13), 255);
+    EQUAL(map.Get(T + 2, 13), 0);
+
+    // Dabs outside are clipped
+    EQUAL(map.Add(IntPoint(sz.w - 2, sz.h - 1), b),
+      IntRect(IntPoint(sz.w - 2, sz.h - 1), IntSize(2, 1)));
+    EQUAL(map.GetNumTiles(), 3);
+    VERIFY(empty(map.Add(IntPoint(-10, -10), b)));
+    EQUAL(map.GetNumTiles(), 3);
+
+    map.Reset(sz);
+    EQUAL(map.GetNumTiles(), 0);
+    EQUAL(map.Get(T - 2, 10), 0);
+  }
+
+  {
+    // Adding saturates at 255
+    TiledAlphaMap map(sz);
+    Brush b(IntSize(20, 1));
+    for (int x = 0; x != 20; x++){
+      b.Set(x, 0, static_cast<uchar>(100 + x));
+    }
+    map.Add(IntPoint(0, 0), b);
+    map.Add(IntPoint(0, 0), b);
+    EQUAL(map.Get(0, 0), 200);
+    EQUAL(map.Get(19, 0), 238);
+    map.Add(IntPoint(0, 0), b);
+    EQUAL(map.Get(0, 0), 255);
+    EQUAL(map.Get(19, 0), 255);
+  }
+
+  {
+    // Strokes match the dense AlphaMap, also across tiles
+    const Brush b(circle_brush(9));
+    const UpperLeft p0(IntPoint(-3, 5));
+    const UpperLeft p1(IntPoint(2 * T + 3, T + 20));
+    const UpperLeft p2(IntPoint(T / 2, sz.h - 2));
+
+    AlphaMap dense(sz);
+    stroke(dense, p0, p1, b);
+    stroke(dense, p1, p2, b);
+
+    TiledAlphaMap tiled(sz);
+    const IntRect r1(stroke(tiled, p0, p1, b));
+    EQUAL(r1, IntRect(IntPoint(0, 5), IntPoint(2 * T + 11, T + 28)));
+    stroke(tiled, p1, p2, b);
+    VERIFY(same(tiled, dense));
+
+    const IntRect sub(IntPoint(T - 7, 3), IntSize(T + 20, T + 9));
+    const AlphaMap copy(tiled.SubCopy(sub));
+    EQUAL(copy.GetSize(), sub.GetSize());
+    for (int y = 0; y != sub.h; y++){
+      for (int x = 0; x != sub.w; x++){
+        EQUAL(copy.Get(x, y), dense.Get(x + sub.x, y + sub.y));
+      }
+    }
+
+    int numVisited = 0;
+    tiled.VisitTiles(IntRect(IntPoint(T, 0), IntSize(T, 2 * T)),
+      [&](const AlphaMapRef& tile, const IntPoint& pos){
+        VERIFY(pos.x == T);
+        EQUAL(tile.GetSize(), IntSize(T, T));
+        numVisited++;
+      });
+    EQUAL(numVisited, 2);
+  }
+}
@@ -0,0 +1,110 @@
+// -*- coding: us-ascii-unix -*-
+#include "test-sys/test.hh"
+#include "tests/test-util/print-objects.hh"
+#include "bitmap/bitmap.hh"
+#include "bitmap/color.hh"
+#include "bitmap/draw.hh"
+#include "bitmap/filter.hh"
+#include "bitmap/viewport-filter.hh"
+#include "geo/int-point.hh"
+#include "geo/int-rect.hh"
+#include "geo/int-size.hh"
+
+void test_viewport_filter(){
+  using namespace faint;
+
+  const Bitmap src(IntSize(100, 80), color_white);
+  const auto never = [](){return false;};
+
+  ViewportFilter toRed;
+  toRed.apply = [](Bitmap& bmp, coord){
+    clear(bmp, color_red);
+  };
+
+  {
+    // Only the visible part is filtered
+    const IntRect visible(IntPoint(10, 20), IntSize(30, 15));
+    auto result = filter_viewport(src, visible, 1.0, toRed, never);
+    VERIFY(result.IsSet());
+    EQUAL(result.Get().topLeft, IntPoint(10, 20));
+    VERIFY(result.Get().bitmap == Bitmap(IntSize(30, 15), color_red));
+  }
+
+  {
+    // ...clipped to the bitmap
+    const IntRect visible(IntPoint(-10, 70), IntSize(30, 15));
+    auto result = filter_viewport(src, visible, 1.0, toRed, never);
+    EQUAL(result.Get().topLeft, IntPoint(0, 70));
+    VERIFY(result.Get().bitmap == Bitmap(IntSize(20, 10), color_red));
+  }
+
+  {
+    // Zoomed out, the filter gets a scaled region
+    coord usedScale = 0.0;
+    IntSize usedSize;
+    ViewportFilter filter;
+    filter.apply = [&](Bitmap& bmp, coord scale){
+      usedScale = scale;
+      usedSize = bmp.GetSize();
+      clear(bmp, color_red);
+    };
+    auto result = filter_viewport(src, IntRect(IntPoint(-50, -50),
+      IntSize(500, 500)), 0.25, filter, never);
+    EQUAL(usedScale, 0.25);
+    EQUAL(usedSize, IntSize(25, 20));
+    EQUAL(result.Get().topLeft, IntPoint(0, 0));
+    VERIFY(result.Get().bitmap == Bitmap(src.GetSize(), color_red));
+
+    // ...unless it is not scalable
+    filter.scalable = false;
+    filter_viewport(src, IntRect(IntPoint(0, 0), IntSize(10, 10)), 0.25,
+      filter, never);
+    EQUAL(usedScale, 1.0);
+    EQUAL(usedSize, IntSize(10, 10));
+  }
+
+  {
+    // Margins and alignment extend the filtered region
+    IntSize usedSize;
+    ViewportFilter filter;
+    filter.margin = 2;
+    filter.apply = [&](Bitmap& bmp, coord){
+      usedSize = bmp.GetSize();
+    };
+    filter_viewport(src, IntRect(IntPoint(10, 10), IntSize(5, 5)), 1.0,
+      filter, never);
+    EQUAL(usedSize, IntSize(9, 9));
+
+    filter.margin = 0;
+    filter.align = 8;
+    filter_viewport(src, IntRect(IntPoint(10, 10), IntSize(5, 5)), 1.0,
+      filter, never);
+    EQUAL(usedSize, IntSize(8, 8));
+
+    // Pixelize matches the full-size result when aligned
+    Bitmap pattern(src);
+    fill_rect_color(pattern, IntRect(IntPoint(11, 3), IntSize(20, 9)),
+      color_blue);
+    Bitmap expected(pattern);
+    pixelize(expected, pixelize_range_t(8));
+
+    ViewportFilter pixelizeFilter;
+    pixelizeFilter.align = 8;
+    pixelizeFilter.scalable = false;
+    pixelizeFilter.apply = [](Bitmap& bmp, coord){
+      pixelize(bmp, pixelize_range_t(8));
+    };
+    const IntRect visible(IntPoint(13, 5), IntSize(17, 6));
+    auto result = filter_viewport(pattern, visible, 0.5, pixelizeFilter,
+      never);
+    EQUAL(result.Get().topLeft, visible.TopLeft());
+    VERIFY(result.Get().bitmap == subbitmap(expected, visible));
+  }
+
+  {
+    // Cancelled
+    auto result = filter_viewport(src, IntRect(IntPoint(0, 0),
+      IntSize(10, 10)), 1.0, toRed, [](){return true;});
+    VERIFY(result.NotSet());
+  }
+}
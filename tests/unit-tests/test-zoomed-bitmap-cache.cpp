@@ -0,0 +1,72 @@
+// -*- coding: us-ascii-unix -*-
+#include "test-sys/test.hh"
+#include "tests/test-util/print-objects.hh"
+#include "bitmap/bitmap.hh"
+#include "bitmap/color.hh"
+#include "bitmap/draw.hh"
+#include "bitmap/scale-nearest.hh"
+#include "geo/int-point.hh"
+#include "geo/int-rect.hh"
+#include "geo/int-size.hh"
+#include "rendering/zoomed-bitmap-cache.hh"
+
+void test_zoomed_bitmap_cache(){
+  using namespace faint;
+
+  Bitmap src(IntSize(10, 8), color_white);
+  put_pixel(src, IntPoint(2, 3), color_red);
+  const IntSize zoomedSize(src.GetSize() * 4);
+  const Bitmap fullyZoomed(scale_nearest(src, 4));
+
+  int numZoomed = 0;
+  auto zoom_func_for = [&](const IntRect& region){
+    return [&, region](){
+      numZoomed++;
+      return scale_nearest(src, zoomedSize, region);
+    };
+  };
+
+  ZoomedBitmapCache cache;
+  EQUAL(cache.GetCount(), 0);
+
+  const IntRect r1(IntPoint(4, 6), IntSize(20, 18));
+  VERIFY(cache.Get(src, 4.0, r1, zoom_func_for(r1)) ==
+    subbitmap(fullyZoomed, r1));
+  EQUAL(numZoomed, 1);
+  EQUAL(cache.GetCount(), 1);
+
+  // Same region and a contained region are taken from the cache
+  VERIFY(cache.Get(src, 4.0, r1, zoom_func_for(r1)) ==
+    subbitmap(fullyZoomed, r1));
+  const IntRect inside(IntPoint(8, 10), IntSize(5, 5));
+  VERIFY(cache.Get(src, 4.0, inside, zoom_func_for(inside)) ==
+    subbitmap(fullyZoomed, inside));
+  EQUAL(numZoomed, 1);
+
+  // Another zoom or a region outside the cached one is scaled
+  const IntRect r2(IntPoint(0, 0), IntSize(30, 10));
+  cache.Get(src, 4.0, r2, zoom_func_for(r2));
+  EQUAL(numZoomed, 2);
+  EQUAL(cache.GetCount(), 2);
+  cache.Get(src, 2.0, r1, zoom_func_for(r1));
+  EQUAL(numZoomed, 3);
+
+  // The least recently used region was evicted
+  EQUAL(cache.GetCount(), ZOOMED_BITMAP_CACHE_SIZE);
+  cache.Get(src, 4.0, r2, zoom_func_for(r2));
+  EQUAL(numZoomed, 3);
+  cache.Get(src, 4.0, inside, zoom_func_for(inside));
+  EQUAL(numZoomed, 4);
+  cache.Get(src, 4.0, r2, zoom_func_for(r2));
+  EQUAL(numZoomed, 4);
+
+  // Modifying the source clears the cache
+  put_pixel(src, IntPoint(5, 4), color_blue);
+  VERIFY(cache.Get(src, 4.0, r1, zoom_func_for(r1)) ==
+    subbitmap(scale_nearest(src, 4), r1));
+  EQUAL(numZoomed, 5);
+  EQUAL(cache.GetCount(), 1);
+
+  cache.Clear();
+  EQUAL(cache.GetCount(), 0);
+}
@@ -0,0 +1,145 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <algorithm>
+#include <cassert>
+#include "text/split-memo.hh"
+#include "text/text-buffer.hh"
+
+namespace faint{
+
+// The number of split texts remembered by a SplitMemo. A text object
+// is typically split in a few different ways (e.g. bounded for
+// drawing, unbounded for its extents).
+static const size_t SPLIT_MEMO_SIZE = 4;
+
+SplitFont::SplitFont(const utf8_string& face, int size, bool bold,
+  bool italic)
+  : face(face),
+    size(size),
+    bold(bold),
+    italic(italic)
+{}
+
+bool SplitFont::operator==(const SplitFont& other) const{
+  return face == other.face &&
+    size == other.size &&
+    bold == other.bold &&
+    italic == other.italic;
+}
+
+SplitLines::SplitLines(text_lines_t&& lines)
+  : lines(std::move(lines)),
+    m_widths(this->lines.size())
+{}
+
+IntSize SplitLines::Extents(const TextInfo& info) const{
+  if (m_extents.NotSet()){
+    m_extents.Set(text_extents(info, lines));
+  }
+  return m_extents.Get();
+}
+
+const std::vector<int>& SplitLines::CumulativeWidths(const utf8_string& line,
+  const cumulative_text_width_f& cumulativeTextWidth) const
+{
+  // Lines with the same text have the same widths, so the first
+  // matching line is used.
+  auto it = std::find_if(begin(lines), end(lines),
+    [&](const TextLine& l){
+      return l.text == line;
+    });
+  assert(it != end(lines));
+
+  auto& widths = m_widths[static_cast<size_t>(it - begin(lines))];
+  if (widths.NotSet()){
+    widths.Set(cumulativeTextWidth(line));
+  }
+  return widths.Get();
+}
+
+SplitMemo::Entry::Entry(const Optional<size_t>& generation,
+  const utf8_string& value,
+  const SplitFont& font,
+  const max_width_t& maxWidth,
+  text_lines_t&& lines)
+  : generation(generation),
+    value(value),
+    font(font),
+    maxWidth(maxWidth),
+    split(std::move(lines))
+{}
+
+const SplitLines& SplitMemo::Get(const TextInfo& info,
+  const TextBuffer& buffer,
+  const SplitFont& font,
+  const max_width_t& maxWidth)
+{
+  return Get(info, Optional<size_t>(buffer.generation()), buffer.get(),
+    font, maxWidth);
+}
+
+const SplitLines& SplitMemo::Get(const TextInfo& info,
+  const utf8_string& text,
+  const SplitFont& font,
+  const max_width_t& maxWidth)
+{
+  return Get(info, no_option(), text, font, maxWidth);
+}
+
+const SplitLines& SplitMemo::Get(const TextInfo& info,
+  const Optional<size_t>& generation,
+  const utf8_string& text,
+  const SplitFont& font,
+  const max_width_t& maxWidth)
+{
+  auto it = std::find_if(begin(m_entries), end(m_entries),
+    [&](const Entry& e){
+      const bool sameText = generation.IsSet() ?
+        e.generation == generation :
+        (e.generation.NotSet() && e.value == text);
+      return sameText && e.font == font && e.maxWidth == maxWidth;
+    });
+
+  if (it != end(m_entries)){
+    // Keep the most recently used first
+    m_entries.splice(begin(m_entries), m_entries, it);
+    return m_entries.front().split;
+  }
+
+  m_numSplits++;
+  if (m_entries.size() == SPLIT_MEMO_SIZE){
+    m_entries.pop_back();
+  }
+
+  // Buffer text is identified by the generation, so the value is not
+  // kept.
+  m_entries.emplace_front(generation,
+    generation.IsSet() ? utf8_string() : text,
+    font,
+    maxWidth,
+    split_string(info, text, maxWidth));
+  return m_entries.front().split;
+}
+
+void SplitMemo::Clear(){
+  m_entries.clear();
+}
+
+int SplitMemo::GetNumSplits() const{
+  return m_numSplits;
+}
+
+} // namespace
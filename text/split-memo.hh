@@ -0,0 +1,116 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_SPLIT_MEMO_HH
+#define FAINT_SPLIT_MEMO_HH
+#include <list>
+#include <vector>
+#include "geo/int-size.hh"
+#include "text/split-string.hh"
+#include "text/text-geo.hh" // cumulative_text_width_f
+#include "text/text-line.hh"
+#include "util/optional.hh"
+
+namespace faint{
+
+class TextBuffer;
+
+class SplitFont{
+  // The font properties which affect the measurements of text.
+public:
+  SplitFont(const utf8_string& face, int size, bool bold, bool italic);
+  bool operator==(const SplitFont&) const;
+
+  utf8_string face;
+  int size;
+  bool bold;
+  bool italic;
+};
+
+class SplitLines{
+  // Text split into lines, with the measurements of the lines
+  // computed when first requested.
+public:
+  explicit SplitLines(text_lines_t&&);
+
+  // The pixel size of the lines, as from text_extents.
+  IntSize Extents(const TextInfo&) const;
+
+  // The cumulative character widths of a line (one of the split
+  // lines), as for caret_index_from_pos.
+  const std::vector<int>& CumulativeWidths(const utf8_string& line,
+    const cumulative_text_width_f&) const;
+
+  const text_lines_t lines;
+private:
+  mutable Optional<IntSize> m_extents;
+  mutable std::vector<Optional<std::vector<int>>> m_widths;
+};
+
+class SplitMemo{
+  // Remembers text split into lines, for the most recently used
+  // combinations of text, font and maximum width, so that the text
+  // is not split and measured again until one of these changes.
+  //
+  // The returned SplitLines remain valid until the next call of Get
+  // or Clear.
+public:
+  // Text from a buffer, identified by the buffer generation.
+  const SplitLines& Get(const TextInfo&,
+    const TextBuffer&,
+    const SplitFont&,
+    const max_width_t&);
+
+  // Other text, e.g. evaluated expressions, identified by its value.
+  const SplitLines& Get(const TextInfo&,
+    const utf8_string&,
+    const SplitFont&,
+    const max_width_t&);
+
+  void Clear();
+
+  // The number of times text was split since construction (i.e. the
+  // number of misses).
+  int GetNumSplits() const;
+
+private:
+  class Entry{
+  public:
+    Entry(const Optional<size_t>& generation,
+      const utf8_string& value,
+      const SplitFont&,
+      const max_width_t&,
+      text_lines_t&&);
+
+    Optional<size_t> generation;
+    utf8_string value;
+    SplitFont font;
+    max_width_t maxWidth;
+    SplitLines split;
+  };
+
+  const SplitLines& Get(const TextInfo&,
+    const Optional<size_t>& generation,
+    const utf8_string&,
+    const SplitFont&,
+    const max_width_t&);
+
+  std::list<Entry> m_entries;
+  int m_numSplits = 0;
+};
+
+} // namespace
+
+#endif
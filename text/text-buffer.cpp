@@ -13,6 +13,7 @@
 // implied. See the License for the specific language governing
 // permissions and limitations under the License.
 
+#include <atomic>
 #include <cassert>
 #include "text/char-constants.hh"
 #include "text/text-buffer.hh"
@@ -20,8 +21,14 @@
 
 namespace faint{
 
+static size_t next_generation(){
+  static std::atomic<size_t> generation(0);
+  return ++generation;
+}
+
 TextBuffer::TextBuffer()
-  : m_caret(0)
+  : m_caret(0),
+    m_generation(next_generation())
 {
   m_sel.active = false;
   m_sel.origin = 0;
@@ -30,7 +37,8 @@ TextBuffer::TextBuffer()
 
 TextBuffer::TextBuffer(const utf8_string& text)
   : m_data(text),
-    m_caret(0)
+    m_caret(0),
+    m_generation(next_generation())
 {
   m_sel.active = false;
   m_sel.origin = 0;
@@ -70,6 +78,7 @@ void TextBuffer::caret(Caret caret, bool select){
 
 void TextBuffer::clear(){
   m_data.clear();
+  modified();
   m_caret = 0;
   m_sel.active = false;
 }
@@ -81,6 +90,7 @@ void TextBuffer::del(){
   else{
     if (m_data.size() > m_caret){
       m_data.erase(m_caret,1);
+      modified();
     }
   }
 }
@@ -103,6 +113,7 @@ void TextBuffer::del_selection(){
     return;
   }
   m_data.erase(m_sel.min(), m_sel.num());
+  modified();
   m_caret = m_sel.min();
   m_sel.active = false;
   return;
@@ -121,6 +132,10 @@ void TextBuffer::devance(bool select){
   m_caret = m_sel.end;
 }
 
+size_t TextBuffer::generation() const{
+  return m_generation;
+}
+
 bool TextBuffer::empty() const{
   return m_data.empty();
 }
@@ -144,15 +159,21 @@ utf8_string TextBuffer::get_selection() const{
 void TextBuffer::insert(const utf8_char& c){
   del_selection();
   m_data.insert(m_caret, 1, c);
+  modified();
   m_caret += 1;
 }
 
 void TextBuffer::insert(const utf8_string& str){
   del_selection();
   m_data.insert(m_caret, str);
+  modified();
   m_caret += str.size();
 }
 
+void TextBuffer::modified(){
+  m_generation = next_generation();
+}
+
 void TextBuffer::move_down(bool select){
   size_t currLineStart = prev(chars::eol);
   size_t x = m_caret - currLineStart;
@@ -197,6 +218,7 @@ void TextBuffer::select(const CaretRange& range){
 
 void TextBuffer::set(const utf8_string& s){
   m_data = s;
+  modified();
   select_none();
   m_caret = std::min(m_caret, m_data.size());
 }
@@ -45,6 +45,11 @@ public:
   void del();
   void del_back();
   void devance(bool select=false);
+
+  // Identifies the current text. Changes whenever the text is
+  // modified, but not for caret or selection changes. Buffers with
+  // different text never share a generation.
+  size_t generation() const;
   const utf8_string& get() const;
   CaretRange get_sel_range() const;
   utf8_string get_selection() const;
@@ -63,6 +68,7 @@ public:
   size_t size() const;
 private:
   void del_selection();
+  void modified();
   struct{
     bool active;
     Caret origin;
@@ -81,6 +87,7 @@ private:
 
   utf8_string m_data;
   Caret m_caret;
+  size_t m_generation;
 };
 
 // Finds the boundaries of the word encompassing the position
@@ -18,6 +18,8 @@
 #include "bitmap/alpha-map.hh"
 #include "bitmap/brush.hh"
 #include "bitmap/color.hh"
+#include "bitmap/pixel-tiles.hh"
+#include "bitmap/tiled-alpha-map.hh"
 #include "commands/command.hh"
 #include "geo/adjust.hh"
 #include "geo/geo-func.hh"
@@ -26,6 +28,7 @@
 #include "geo/measure.hh"
 #include "geo/padding.hh"
 #include "rendering/faint-dc.hh"
+#include "rendering/filter-class.hh"
 #include "rendering/overlay.hh"
 #include "rendering/render-brush.hh"
 #include "text/formatting.hh"
@@ -74,10 +77,34 @@ public:
   }
 
   void Do(CommandContext& context){
+    m_oldPixels = PixelTiles(context.GetRawBitmap(), AffectedRect());
     context.GetDC().Blend(offsat(m_alphaMap, m_topLeft), m_first, m_settings);
   }
 
+  Optional<IntRect> GetChangedRect() const override{
+    return option(AffectedRect());
+  }
+
+  bool RestoresRaster() const override{
+    return true;
+  }
+
+  void Undo(CommandContext& context) override{
+    m_oldPixels.Restore(context.GetRawBitmap());
+  }
+
 private:
+  IntRect AffectedRect() const{
+    // Filters (e.g. shadows) can extend outside the stroke
+    auto filter = get_filter(m_settings);
+    const Padding p = filter == nullptr ?
+      Padding::None() : filter->GetPadding();
+
+    return IntRect(m_topLeft - IntPoint(p.left, p.top),
+      m_alphaMap.GetSize() + p.GetSize());
+  }
+
+  PixelTiles m_oldPixels;
   Settings m_settings;
   AlphaMap m_alphaMap;
   IntPoint m_first;
@@ -134,7 +161,7 @@ public:
     const Point& p(info.pos);
 
     if (m_active){
-      dc.Blend(at_top_left(m_alphaMap), m_first.Get(),
+      dc.Blend(m_alphaMap, m_first.Get(),
         maybe_offsat_paint(GetSettings(), m_brush));
     }
     else if (m_drawCursor){
@@ -165,10 +192,13 @@ public:
 
   IntRect GetRefreshRect(const RefreshInfo& info) const override{
     if (!m_active){
-      const IntPoint p(floored(info.mousePos));
-      return padded(IntRect(p, p), get_padding(GetSettings()));
+      return CursorRect(info.mousePos);
+    }
+    if (get_fg(GetSettings()).IsGradient()){
+      // The gradient is stretched over the entire stroke
+      return info.visibleRect;
     }
-    return info.visibleRect;
+    return bounding_rect(m_changed, CursorRect(info.mousePos));
   }
 
   ToolResult MouseDown(const PosInfo& info) override{
@@ -183,8 +213,9 @@ public:
     else{
       SetSwapColors(false);
     }
-    stroke(m_alphaMap, m_prev, m_prev, m_brush);
-
+    m_changed = ChangedRect(stroke(m_alphaMap, m_prev, m_prev, m_brush),
+      info.pos);
+    m_lastPos = info.pos;
     return ToolResult::DRAW;
   }
 
@@ -229,7 +260,9 @@ public:
       }
 
       UpperLeft newPos = brush_top_left(pos, m_brush);
-      stroke(m_alphaMap, m_prev, newPos, m_brush);
+      m_changed = ChangedRect(stroke(m_alphaMap, m_prev, newPos, m_brush),
+        m_lastPos);
+      m_lastPos = info.pos;
       m_covered = bounding_rect(m_covered.TopLeft(),
         m_covered.BottomRight(),
         floored(pos));
@@ -255,6 +288,19 @@ public:
   }
 
 private:
+  IntRect ChangedRect(const IntRect& strokeRect, const Point& lastPos) const{
+    // Includes the previous cursor position, to erase the brush edge
+    const IntRect cursorRect(CursorRect(lastPos));
+    return empty(strokeRect) ? cursorRect :
+      bounding_rect(cursorRect,
+        padded(strokeRect, get_padding(GetSettings())));
+  }
+
+  IntRect CursorRect(const Point& pos) const{
+    const IntPoint p(floored(pos));
+    return padded(IntRect(p, p), get_padding(GetSettings()));
+  }
+
   void InitBrush(){
     m_brush = get_brush(GetSettings());
     m_brushEdge = floated(brush_edge(m_brush));
@@ -288,7 +334,7 @@ private:
     m_first = brush_top_left(info.pos, m_brush);
   }
   bool m_active;
-  AlphaMap m_alphaMap;
+  TiledAlphaMap m_alphaMap;
   Brush m_brush;
   std::vector<LineSegment> m_brushEdge;
   AlphaMap m_brushOverlay;
@@ -299,6 +345,8 @@ private:
   Point m_origin;
   UpperLeft m_prev;
   IntRect m_covered;
+  IntRect m_changed;
+  Point m_lastPos;
   bool m_translucent;
 };
 
@@ -148,12 +148,12 @@ public:
       else if (fill_boundary_flag(info, s)){
         Paint boundary = s.Get(the_other_one(fillSetting));
         assert(boundary.IsColor());
-        m_command.Set(target_full_image(
+        m_command.Set(target_changed_pixels(
           get_boundary_fill_command(floored(info.pos), fill,
             boundary.GetColor())));
       }
       else{
-        m_command.Set(target_full_image(
+        m_command.Set(target_changed_pixels(
           get_flood_fill_command(floored(info.pos), fill)));
       }
     }
@@ -117,7 +117,7 @@ Mod key_modifiers(const wxKeyEvent& event){
 
 wxImage to_wx_image(const Bitmap& bmp){
   const int stride = bmp.m_row_stride;
-  const uchar* bgraData = bmp.m_data;
+  const uchar* bgraData = bmp.GetRaw();
 
   // Using malloc to match wxWidgets free
   uchar* rgbData = (uchar*)malloc(to_size_t(bmp.m_w * bmp.m_h * 3));
@@ -148,7 +148,7 @@ wxBitmap to_wx_bmp(const Bitmap& bmp){
   assert(pData);
   PixelData::Iterator p = pData;
 
-  uchar* data = bmp.m_data;
+  const uchar* data = bmp.GetRaw();
   const int stride = bmp.m_row_stride;
 
   for (int y = 0; y != bmp.m_h; y++){
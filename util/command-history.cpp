@@ -14,9 +14,11 @@
 // permissions and limitations under the License.
 
 #include <cassert>
+#include <chrono>
 #include "commands/command.hh"
 #include "geo/canvas-geo.hh"
 #include "geo/geo-func.hh"
+#include "geo/int-rect.hh"
 #include "gui/canvas-panel-contexts.hh"
 #include "text/formatting.hh"
 #include "util/command-history.hh"
@@ -46,8 +48,46 @@ static utf8_string get_command_name(Command& cmd,
   return cmd.Name();
 }
 
-CommandHistory::CommandHistory()
-  : m_openBundle(false)
+static double seconds_since(const std::chrono::steady_clock::time_point& t0){
+  const std::chrono::duration<double> seconds =
+    std::chrono::steady_clock::now() - t0;
+  return seconds.count();
+}
+
+static bool may_change_objects(const Command& cmd){
+  const CommandType t = cmd.Type();
+  return t != CommandType::RASTER && t != CommandType::SELECTION;
+}
+
+static void invalidate(Image& frame, const Command& cmd){
+  // Mark what applying or undoing the command may have changed, for
+  // cached renderings and object lookups of the frame.
+  if (may_change_objects(cmd)){
+    cmd.GetChangedObjectsRect().Visit(
+      [&](const IntRect& r){
+        frame.ObjectsChanged(r);
+      },
+      [&](){
+        frame.ObjectsChanged();
+      });
+  }
+
+  if (!affects_raster(cmd)){
+    return;
+  }
+
+  cmd.GetChangedRect().Visit(
+    [&](const IntRect& r){
+      frame.InvalidateRaster(r);
+    },
+    [&](){
+      frame.InvalidateRaster();
+    });
+}
+
+CommandHistory::CommandHistory(const CheckpointOptions& checkpointOptions)
+  : m_checkpoints(checkpointOptions),
+    m_openBundle(false)
 {}
 
 CommandHistory::~CommandHistory(){
@@ -80,6 +120,10 @@ void CommandHistory::CloseUndoBundle(const utf8_string& name){
       m_undoList.pop_back();
       bool shouldMerge = !m_undoList.empty() && m_undoList.back().ShouldMerge(cmd);
       if (shouldMerge){
+        // Snapshots taken after either command no longer match the
+        // merged command.
+        m_checkpoints.Remove(m_undoList.back().command);
+        m_checkpoints.Remove(cmd.command);
         m_undoList.back().Merge(cmd); // Fixme: Move
       }
       else{
@@ -205,25 +249,21 @@ bool CommandHistory::Undo(TargetableCommandContext& cmdContext,
     do{
       undone = m_undoList.back();
       if (undone.type == UndoType::NORMAL_COMMAND){
-        CommandType undoType(undone.command->Type());
+        const Command& cmd = *undone.command;
         cmdContext.SetFrame(undone.targetFrame);
 
-        if (somewhat_reversible(undoType)){
+        if (somewhat_reversible(cmd)){
           // Reverse undoable changes
           undone.command->Undo(cmdContext);
+          invalidate(*undone.targetFrame, cmd);
         }
-        if (!fully_reversible(undoType)){
-          // Reset the image and reapply the raster steps of all commands to
-          // undo the irreversible changes of the undone command.
-          // Fixme: This is extremely wasteful with multiple commands
-          cmdContext.RevertFrame();
-          for (auto item : but_last(m_undoList)){
-            if (item.targetFrame == undone.targetFrame){
-              Command& reapplied = *item.command;
-              reapplied.DoRaster(cmdContext);
-            }
-          }
+        if (!fully_reversible(cmd)){
+          // Restore the image and reapply the raster steps of earlier
+          // commands to undo the irreversible changes of the undone
+          // command.
+          RebuildFrame(undone.targetFrame, cmdContext);
         }
+        m_checkpoints.Remove(undone.command);
       }
       m_undoList.pop_back();
       m_redoList.push_front(undone);
@@ -234,24 +274,19 @@ bool CommandHistory::Undo(TargetableCommandContext& cmdContext,
 
   assert(undone.command != nullptr);
   assert(undone.targetFrame != nullptr);
-  CommandType undoType(undone.command->Type());
+  const Command& cmd = *undone.command;
   Image* activeImage = undone.targetFrame;
   IntSize oldSize(activeImage->GetSize());
   cmdContext.SetFrame(activeImage);
-  if (somewhat_reversible(undoType)){
+  if (somewhat_reversible(cmd)){
     // Reverse undoable changes
     undone.command->Undo(cmdContext);
+    invalidate(*activeImage, cmd);
   }
-  if (!fully_reversible(undoType)){
-    // Reset the image and reapply the raster steps of all commands to
-    // undo the irreversible changes of the undone command.
-    cmdContext.RevertFrame();
-    for (auto item : but_last(m_undoList)){
-      if (item.targetFrame == activeImage){
-        Command* reapplied = item.command;
-        reapplied->DoRaster(cmdContext);
-      }
-    }
+  if (!fully_reversible(cmd)){
+    // Restore the image and reapply the raster steps of earlier
+    // commands to undo the irreversible changes of the undone command.
+    RebuildFrame(activeImage, cmdContext);
     if (oldSize != activeImage->GetSize()){
       Point pos(geo.pos.x, geo.pos.y);
       coord zoom = geo.zoom.GetScaleFactor();
@@ -260,6 +295,7 @@ bool CommandHistory::Undo(TargetableCommandContext& cmdContext,
     }
   }
 
+  m_checkpoints.Remove(undone.command);
   m_undoList.pop_back();
   m_redoList.push_front(undone);
   return true;
@@ -326,7 +362,10 @@ Optional<IntPoint> CommandHistory::Apply(Command* cmd,
 
   IntSize oldSize(activeImage->GetSize());
   Optional<IntPoint> offset;
+  const auto t0 = std::chrono::steady_clock::now();
   cmd->Do(commandContext);
+  const double seconds = seconds_since(t0);
+  invalidate(*activeImage, *cmd);
   if (oldSize != activeImage->GetSize()){
     if (targetCurrentFrame){
       const coord zoom = geo.zoom.GetScaleFactor();
@@ -341,6 +380,7 @@ Optional<IntPoint> CommandHistory::Apply(Command* cmd,
     clear_list(m_redoList);
   }
 
+  const bool rasterChanged = affects_raster(*cmd);
   if (Bundling()){
     m_undoList.push_back(OldCommand(cmd, activeImage));
   }
@@ -349,6 +389,7 @@ Optional<IntPoint> CommandHistory::Apply(Command* cmd,
     bool shouldMerge = !m_undoList.empty() && // Fixme: Duplicated Add helper
       m_undoList.back().ShouldMerge(mappedCmd);
     if (shouldMerge){
+      m_checkpoints.Remove(m_undoList.back().command);
       m_undoList.back().Merge(mappedCmd);
       cmd = nullptr;
     }
@@ -356,9 +397,46 @@ Optional<IntPoint> CommandHistory::Apply(Command* cmd,
       m_undoList.push_back(OldCommand(cmd, activeImage));
     }
   }
+
+  if (rasterChanged){
+    m_checkpoints.Applied(m_undoList.back().command, *activeImage, seconds);
+  }
   return offset;
 }
 
+void CommandHistory::RebuildFrame(Image* frame,
+  TargetableCommandContext& cmdContext)
+{
+  assert(!m_undoList.empty());
+  const size_t last = m_undoList.size() - 1;
+
+  // Find the latest snapshot taken before the last command
+  size_t first = 0;
+  const Bitmap* checkpoint = nullptr;
+  for (size_t i = last; i != 0 && checkpoint == nullptr; i--){
+    const OldCommand& item = m_undoList[i - 1];
+    if (item.targetFrame == frame){
+      checkpoint = m_checkpoints.Get(item.command);
+      first = i;
+    }
+  }
+
+  if (checkpoint != nullptr){
+    cmdContext.SetBitmap(*checkpoint);
+  }
+  else{
+    first = 0;
+    cmdContext.RevertFrame();
+  }
+
+  for (size_t i = first; i != last; i++){
+    const OldCommand& item = m_undoList[i];
+    if (item.targetFrame == frame){
+      item.command->DoRaster(cmdContext);
+    }
+  }
+}
+
 bool CommandHistory::ApplyDWIM(ImageList& images,
   TargetableCommandContext& ctx,
   const CanvasGeo& geo)
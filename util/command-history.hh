@@ -18,6 +18,7 @@
 #include <deque>
 #include "commands/old-command.hh"
 #include "util/id-types.hh"
+#include "util/raster-checkpoints.hh"
 #include "util/template-fwd.hh"
 
 namespace faint{
@@ -30,7 +31,7 @@ using clear_redo = Distinct<bool, category_apply_command, 0>;
 
 class CommandHistory{
 public:
-  CommandHistory();
+  explicit CommandHistory(const CheckpointOptions& = CheckpointOptions());
   ~CommandHistory();
 
   // Applies the specified command. Returns the image offset(?), if any.
@@ -62,6 +63,13 @@ public:
   void Redo(TargetableCommandContext&, const CanvasGeo&, ImageList&);
   bool Undo(TargetableCommandContext&, const CanvasGeo&);
 private:
+  // Restores the raster of the frame to the state before the last
+  // command in the undo list, by restoring the nearest checkpoint (or
+  // the original image) and reapplying the raster steps of the
+  // commands after it.
+  void RebuildFrame(Image*, TargetableCommandContext&);
+
+  RasterCheckpoints m_checkpoints;
   std::deque<OldCommand> m_undoList;
   std::deque<OldCommand> m_redoList;
   bool m_openBundle;
@@ -20,6 +20,7 @@
 #include "bitmap/color-counting.hh"
 #include "bitmap/draw.hh"
 #include "bitmap/filter.hh"
+#include "bitmap/point-ops.hh"
 #include "bitmap/quantize.hh"
 #include "commands/add-object-cmd.hh"
 #include "commands/change-setting-cmd.hh"
@@ -475,6 +476,11 @@ BitmapCommandPtr get_invert_command(){
   return function_command("Invert colors", [=](Bitmap& bmp){invert(bmp);});
 }
 
+BitmapCommandPtr get_point_ops_command(const PointOps& ops){
+  return function_command("Point operations",
+    [=](Bitmap& bmp){ops.Apply(bmp);});
+}
+
 CommandPtr get_move_objects_command(const objects_t& objects,
   const NewTris& in_newTris,
   const OldTris& in_oldTris)
@@ -30,6 +30,7 @@
 namespace faint{
 
 class ObjRaster;
+class PointOps;
 enum class ScaleQuality;
 
 // Gets an add object or a draw object command depending on the layer
@@ -94,6 +95,10 @@ BitmapCommandPtr get_brightness_and_contrast_command(const brightness_contrast_t
 
 BitmapCommandPtr get_invert_command();
 
+// Returns a command applying the point operations to the image in a
+// single pass.
+BitmapCommandPtr get_point_ops_command(const PointOps&);
+
 using NewTris = Order<tris_t>::New;
 using OldTris = Order<tris_t>::Old;
 
@@ -24,6 +24,7 @@ class Either{
   // Container for exactly one object of either one type or another.
 public:
   Either(const Either& other) = default;
+  Either(Either&& other) = default;
 
   Either(const T1& v1)
     : m_v1(v1)
@@ -33,6 +34,14 @@ public:
     : m_v2(v2)
  {}
 
+  Either(T1&& v1)
+    : m_v1(std::move(v1))
+ {}
+
+  Either(T2&& v2)
+    : m_v2(std::move(v2))
+ {}
+
   template<typename F1, typename F2>
   auto Visit(const F1& f1, const F2& f2) const -> decltype(f1(*((T1*)nullptr))){
     if (m_v1.IsSet()){
@@ -119,6 +128,7 @@ public:
   }
 
   Either& operator=(const Either& other) = default;
+  Either& operator=(Either&& other) = default;
 
 private:
   void DoGet(Optional<T1>*& opt){
@@ -0,0 +1,180 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <map>
+#include "bitmap/draw.hh"
+#include "geo/geo-func.hh"
+#include "geo/int-point.hh"
+#include "geo/int-size.hh"
+#include "objects/object.hh"
+#include "objects/objtext.hh"
+#include "rendering/faint-dc.hh"
+#include "util/flatten-cache.hh"
+#include "util/image.hh"
+#include "util/image-util.hh"
+
+namespace faint{
+
+static bool intersects(const IntRect& r1, const IntRect& r2){
+  return !empty(intersection(r1, r2));
+}
+
+static bool has_text(const Object& obj){
+  // Text can refer to other objects with expressions, so its
+  // appearance may change without the text object changing.
+  if (is_text(obj)){
+    return true;
+  }
+  for (int i = 0; i != obj.GetObjectCount(); i++){
+    if (has_text(*obj.GetObject(i))){
+      return true;
+    }
+  }
+  return false;
+}
+
+const Bitmap& FlattenCache::Get(const Image& image){
+  if (!m_valid || m_bmp.GetSize() != image.GetSize()){
+    Draw(image, image_rect(image));
+  }
+  else{
+    for (const IntRect& r : GetDirtyRects(image)){
+      Draw(image, r);
+    }
+  }
+  Store(image);
+  return m_bmp;
+}
+
+void FlattenCache::Draw(const Image& image, const IntRect& r){
+  Bitmap region(subbitmap(image, r));
+  {
+    FaintDC dc(region, origin_t(-floated(r.TopLeft())));
+    ExpressionContext& ctx = image.GetExpressionContext();
+    for (Object* obj : image.GetObjects()){
+      if (intersects(obj->GetRefreshRect(), r)){
+        obj->Draw(dc, ctx);
+      }
+    }
+  }
+
+  if (r == image_rect(image)){
+    m_bmp = std::move(region);
+  }
+  else{
+    blit(offsat(region, r.TopLeft()), onto(m_bmp));
+  }
+}
+
+std::vector<IntRect> FlattenCache::GetDirtyRects(const Image& image) const{
+  // Regions of objects which were added, removed, moved, reordered or
+  // resized since drawn. Changes which keep the region (e.g. of color)
+  // are instead reported via Image::GetObjectChanges.
+  std::vector<IntRect> objectRects;
+  std::map<ObjectId, IntRect> drawn;
+  for (const auto& d : m_drawn){
+    drawn.emplace(d.id, d.rect);
+  }
+
+  const objects_t& objects = image.GetObjects();
+  std::map<ObjectId, IntRect> current;
+  std::vector<ObjectId> currentOrder;
+  for (const Object* obj : objects){
+    const IntRect rect(obj->GetRefreshRect());
+    current.emplace(obj->GetId(), rect);
+    auto it = drawn.find(obj->GetId());
+    if (it == drawn.end()){
+      objectRects.push_back(rect);
+    }
+    else{
+      if (it->second != rect){
+        objectRects.push_back(it->second);
+        objectRects.push_back(rect);
+      }
+      currentOrder.push_back(obj->GetId());
+    }
+    if (has_text(*obj)){
+      objectRects.push_back(rect);
+    }
+  }
+
+  size_t pos = 0;
+  for (const auto& d : m_drawn){
+    if (current.find(d.id) == current.end()){
+      objectRects.push_back(d.rect);
+    }
+    else{
+      // Objects remaining in the image but with different
+      // stacking order.
+      if (currentOrder[pos] != d.id){
+        objectRects.push_back(d.rect);
+        objectRects.push_back(current.at(d.id));
+      }
+      pos++;
+    }
+  }
+
+  const RasterChanges& rasterChanges = image.GetRasterChanges();
+  const RasterChanges& objectChanges = image.GetObjectChanges();
+  auto is_dirty = [&](const IntRect& tile){
+    if (rasterChanges.ChangedSince(m_rasterGeneration, tile) ||
+      objectChanges.ChangedSince(m_objectGeneration, tile))
+    {
+      return true;
+    }
+    for (const IntRect& r : objectRects){
+      if (intersects(r, tile)){
+        return true;
+      }
+    }
+    return false;
+  };
+
+  // Dirty tiles, with horizontally adjacent tiles merged
+  const IntRect imageRect(image_rect(image));
+  const int T = FLATTEN_TILE_SIZE;
+  std::vector<IntRect> dirty;
+  for (int y = 0; y < imageRect.h; y += T){
+    int runStart = -1;
+    for (int x = 0; x < imageRect.w; x += T){
+      const bool isDirty = is_dirty(IntRect(IntPoint(x, y), IntSize(T, T)));
+      if (isDirty && runStart == -1){
+        runStart = x;
+      }
+      else if (!isDirty && runStart != -1){
+        dirty.push_back(intersection(imageRect,
+          IntRect(IntPoint(runStart, y), IntSize(x - runStart, T))));
+        runStart = -1;
+      }
+    }
+    if (runStart != -1){
+      dirty.push_back(intersection(imageRect,
+        IntRect(IntPoint(runStart, y), IntSize(imageRect.w - runStart, T))));
+    }
+  }
+  return dirty;
+}
+
+void FlattenCache::Store(const Image& image){
+  m_valid = true;
+  m_rasterGeneration = image.GetRasterChanges().GetGeneration();
+  m_objectGeneration = image.GetObjectChanges().GetGeneration();
+  m_drawn.clear();
+  for (const Object* obj : image.GetObjects()){
+    m_drawn.emplace_back(obj->GetId(), obj->GetRefreshRect());
+  }
+}
+
+} // namespace
@@ -0,0 +1,66 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_FLATTEN_CACHE_HH
+#define FAINT_FLATTEN_CACHE_HH
+#include <vector>
+#include "bitmap/bitmap.hh"
+#include "geo/int-rect.hh"
+#include "util/id-types.hh"
+
+namespace faint{
+
+class Image;
+
+// The width and height of the regions which are redrawn when updating
+// a FlattenCache.
+const int FLATTEN_TILE_SIZE = 128;
+
+class FlattenCache{
+  // A flattened image (the background with the objects drawn onto
+  // it), which is updated by redrawing only the tiles wherein the
+  // background or objects changed since it was last retrieved.
+public:
+  // Updates and returns the flattened image. The image must not have
+  // a floating raster selection.
+  const Bitmap& Get(const Image&);
+private:
+  void Draw(const Image&, const IntRect&);
+  std::vector<IntRect> GetDirtyRects(const Image&) const;
+  void Store(const Image&);
+
+  class DrawnObject{
+  public:
+    DrawnObject(const ObjectId& id, const IntRect& rect)
+      : id(id),
+        rect(rect)
+    {}
+    ObjectId id;
+    IntRect rect;
+  };
+
+  Bitmap m_bmp;
+  bool m_valid = false;
+  int m_rasterGeneration = 0;
+  int m_objectGeneration = 0;
+
+  // The objects in the cached bitmap, from bottom to top, with the
+  // regions they were drawn in.
+  std::vector<DrawnObject> m_drawn;
+};
+
+} // namespace
+
+#endif
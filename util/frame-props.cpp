@@ -14,6 +14,7 @@
 // permissions and limitations under the License.
 
 #include "bitmap/bitmap.hh"
+#include "bitmap/lazy-bitmap.hh"
 #include "objects/object.hh"
 #include "util/frame-props.hh"
 #include "util/grid.hh"
@@ -68,6 +69,14 @@ FrameProps::FrameProps(const Bitmap& bmp, const FrameInfo& info)
     m_hotSpot(info.hotSpot)
 {}
 
+FrameProps::FrameProps(const std::shared_ptr<const LazyBitmap>& lazy,
+  const FrameInfo& info)
+  : m_background(ColorSpan(color_white, lazy->GetSize())),
+    m_delay(info.delay),
+    m_hotSpot(info.hotSpot),
+    m_lazyBackground(lazy)
+{}
+
 FrameProps::FrameProps(const IntSize& size, const objects_t& objects)
   : m_background(ColorSpan(color_white, size)),
     m_delay(jiffies_t(0)),
@@ -89,6 +98,7 @@ FrameProps::FrameProps(FrameProps&& other)
     m_background(std::move(other.m_background)),
     m_delay(other.m_delay),
     m_hotSpot(other.m_hotSpot),
+    m_lazyBackground(std::move(other.m_lazyBackground)),
     m_objects(std::move(other.m_objects))
 {}
 
@@ -125,6 +135,10 @@ HotSpot FrameProps::GetHotSpot() const{
   return m_hotSpot;
 }
 
+std::shared_ptr<const LazyBitmap> FrameProps::GetLazyBackground() const{
+  return m_lazyBackground;
+}
+
 Object* FrameProps::GetObject(const Index& index){
   return m_allObjects.at(to_size_t(index));
 }
@@ -146,6 +160,7 @@ void FrameProps::RemoveObject(Object* obj){
 
 void FrameProps::SetBackground(const Either<Bitmap, ColorSpan>& bg){
   m_background = bg;
+  m_lazyBackground.reset();
   m_delay = Delay(0_cs);
   m_hotSpot = HotSpot(0,0);
 }
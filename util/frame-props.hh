@@ -15,6 +15,7 @@
 
 #ifndef FAINT_FRAME_PROPS_HH
 #define FAINT_FRAME_PROPS_HH
+#include <memory>
 #include "bitmap/bitmap-fwd.hh"
 #include "bitmap/color-span.hh"
 #include "geo/calibration.hh"
@@ -32,6 +33,7 @@
 namespace faint{
 
 class Bitmap;
+class LazyBitmap;
 
 class FrameInfo {
   // Properties for a single frame
@@ -52,6 +54,10 @@ public:
   explicit FrameProps(const Bitmap&);
   explicit FrameProps(const ImageInfo&);
   FrameProps(const Bitmap&, const FrameInfo&);
+
+  // A frame with pixels read on demand. The background is then a
+  // placeholder ColorSpan with the same size.
+  FrameProps(const std::shared_ptr<const LazyBitmap>&, const FrameInfo&);
   FrameProps(const Bitmap&, const objects_t&);
   FrameProps(const IntSize&, const objects_t&);
   ~FrameProps();
@@ -60,6 +66,7 @@ public:
   const Optional<Calibration>& GetCalibration() const;
   Delay GetDelay() const;
   HotSpot GetHotSpot() const;
+  std::shared_ptr<const LazyBitmap> GetLazyBackground() const;
   Object* GetObject(const Index&);
   bool HasObject(const Index&) const;
   bool IsTopLevel(const Index&) const;
@@ -73,6 +80,7 @@ private:
   Optional<Calibration> m_calibration;
   Delay m_delay;
   HotSpot m_hotSpot;
+  std::shared_ptr<const LazyBitmap> m_lazyBackground;
   objects_t m_objects;
 };
 
@@ -28,6 +28,23 @@
 
 namespace faint{
 
+static Color mask_color_at(Object* object,
+  const Point& p,
+  coord zoom,
+  FaintDC& dc,
+  ExpressionContext& expressionContext)
+{
+  // Use the geometric mask color if the object provides it, sampled
+  // at the center of the pixel the DC would render.
+  const auto color = object->GetMaskColor(p + Point::Both(0.5 / zoom));
+  if (color.IsSet()){
+    return color.Get();
+  }
+
+  object->DrawMask(dc, expressionContext);
+  return dc.GetPixel(p);
+}
+
 static std::pair<Object*, Hit> object_at(const Point& p,
   const Image& image,
   const CanvasGeo& geo,
@@ -49,8 +66,8 @@ static std::pair<Object*, Hit> object_at(const Point& p,
   const objects_t& objectSelection(image.GetObjectSelection());
   for (Object* object : top_to_bottom(objectSelection)){
     if (object->HitTest(p)){
-      object->DrawMask(dc, expressionContext);
-      Color color = dc.GetPixel(p);
+      const Color color = mask_color_at(object, p, zoom, dc,
+        expressionContext);
       if (color == mask_edge){
         return {object, Hit::BOUNDARY};
       }
@@ -64,15 +81,15 @@ static std::pair<Object*, Hit> object_at(const Point& p,
     }
   }
 
-  // ...then the rest
+  // ...then the rest, of those near the point
   dc.Clear(mask_outside);
 
-  const objects_t& objects(image.GetObjects());
+  const objects_t objects(image.GetObjectsAt(p));
   for (Object* object : top_to_bottom(objects)){
     if (object->HitTest(p)){
-      object->DrawMask(dc, expressionContext);
-      Color color =  dc.GetPixel(p);
-      if (color  == mask_edge){
+      const Color color = mask_color_at(object, p, zoom, dc,
+        expressionContext);
+      if (color == mask_edge){
         return {object, Hit::BOUNDARY};
       }
       else if (color == mask_fill){
@@ -56,6 +56,13 @@ FrameProps& ImageProps::AddFrame(Bitmap&& bmp, const FrameInfo& info){
   return m_frames.back();
 }
 
+FrameProps& ImageProps::AddFrame(const std::shared_ptr<const LazyBitmap>& lazy,
+  const FrameInfo& info)
+{
+  m_frames.emplace_back(lazy, info);
+  return m_frames.back();
+}
+
 FrameProps& ImageProps::GetFrame(const Index& index){
   assert(has_index(m_frames, index));
   return m_frames[to_size_t(index.Get())];
@@ -32,6 +32,8 @@ public:
   ImageProps(const IntSize&, const objects_t&);
   FrameProps& AddFrame(const ImageInfo&);
   FrameProps& AddFrame(Bitmap&&, const FrameInfo&);
+  FrameProps& AddFrame(const std::shared_ptr<const LazyBitmap>&,
+    const FrameInfo&);
   void AddWarning(const utf8_string&);
   utf8_string GetError() const;
   FrameProps& GetFrame(const Index&);
@@ -82,6 +82,10 @@ static void flatten_onto(Bitmap& bmp,
 Bitmap flatten(const Image& image){
   const objects_t& objects = image.GetObjects();
   const RasterSelection& selection = image.GetRasterSelection();
+  if (!objects.empty() && !selection.Floating()){
+    // Reuse the earlier flattening, redrawing only changed regions.
+    return image.GetFlattened();
+  }
   return image.GetBackground().Visit(
     [&](const Bitmap& bmp){
       Bitmap copy(bmp);
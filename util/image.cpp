@@ -15,9 +15,11 @@
 
 #include <algorithm>
 #include <cassert>
+#include "bitmap/lazy-bitmap.hh"
 #include "geo/primitive.hh"
 #include "objects/object.hh"
 #include "text/text-expression-context.hh"
+#include "util/flatten-cache.hh"
 #include "util/frame-props.hh"
 #include "util/image.hh"
 #include "util/object-util.hh"
@@ -73,6 +75,7 @@ private:
 
 Image::Image(FrameProps&& props)
   : m_bg(std::move(props.GetBackground())),
+    m_lazyBg(props.GetLazyBackground()),
     m_calibration(props.GetCalibration()),
     m_delay(props.GetDelay()),
     m_hotSpot(props.GetHotSpot()),
@@ -85,6 +88,7 @@ Image::Image(FrameProps&& props)
 
 Image::Image(const Image& other)
   : m_bg(other.m_bg),
+    m_lazyBg(other.m_lazyBg),
     m_delay(other.GetDelay()),
     m_hotSpot(other.m_hotSpot),
     m_original()
@@ -113,6 +117,7 @@ Bitmap& Image::ConvertColorSpanToBitmap(){
   const ColorSpan& span(m_bg.Expect<ColorSpan>());
   m_original.Set(span);
   m_bg.Set(Bitmap(span.size, span.color));
+  m_rasterChanges.ChangedAll();
   return m_bg.Expect<Bitmap>();
 }
 
@@ -122,6 +127,8 @@ bool Image::HasStoredOriginal() const{
 
 void Image::StoreAsOriginal(){
   assert(m_original.NotSet());
+  // Keeps a lazy background as is, instead of a copy of all pixels.
+  m_originalLazyBg = m_lazyBg;
   m_bg.Visit(
     [&](const Bitmap& bmp){
       m_original.Set(bmp);
@@ -133,16 +140,27 @@ void Image::StoreAsOriginal(){
 
 void Image::SetBitmap(const Bitmap& bmp){
   m_bg.Set(bmp);
+  m_lazyBg.reset();
+  m_rasterChanges.ChangedAll();
 }
 
 void Image::SetBitmap(Bitmap&& bmp){
   m_bg.Set(std::move(bmp));
+  m_lazyBg.reset();
+  m_rasterChanges.ChangedAll();
 }
 
 ExpressionContext& Image::GetExpressionContext() const{
   return *m_expressionContext;
 }
 
+const Bitmap& Image::GetFlattened() const{
+  if (m_flattenCache == nullptr){
+    m_flattenCache = std::make_unique<FlattenCache>();
+  }
+  return m_flattenCache->Get(*this);
+}
+
 FrameId Image::GetId() const{
   return m_id;
 }
@@ -160,6 +178,7 @@ IntSize Image::GetSize() const{
 void Image::Add(Object* object){
   assert(!Has(object));
   m_objects.push_back(object);
+  m_objectIndex.Invalidate();
 }
 
 void Image::Add(Object* object, int z){
@@ -167,6 +186,7 @@ void Image::Add(Object* object, int z){
   assert(z >= 0);
   assert(to_size_t(z) <= m_objects.size());
   m_objects.insert(begin(m_objects) + z, object);
+  m_objectIndex.Invalidate();
 }
 
 bool Image::Deselect(const Object* object){
@@ -185,6 +205,22 @@ const Optional<Calibration>& Image::GetCalibration() const{
   return m_calibration;
 }
 
+objects_t Image::GetObjectsAt(const Point& p) const{
+  return m_objectIndex.At(m_objects, p);
+}
+
+objects_t Image::GetObjectsIntersecting(const Rect& r) const{
+  return get_intersected(m_objectIndex.Intersecting(m_objects, r), r);
+}
+
+const RasterChanges& Image::GetObjectChanges() const{
+  return m_objectChanges;
+}
+
+const RasterChanges& Image::GetRasterChanges() const{
+  return m_rasterChanges;
+}
+
 const objects_t& Image::GetObjects() const{
   return m_objects;
 }
@@ -229,6 +265,7 @@ void Image::SetObjectZ(Object* obj, int z){
   Remove(obj);
   z = std::min(z, resigned(m_objects.size()));
   m_objects.insert(begin(m_objects) + z, obj);
+  m_objectIndex.Invalidate();
   if (wasSelected){
     size_t pos = get_sorted_insertion_pos(obj, m_objectSelection, m_objects);
     m_objectSelection.insert(begin(m_objectSelection) + resigned(pos), obj);
@@ -239,6 +276,7 @@ void Image::Remove(Object* obj){
   remove(obj, from(m_objectSelection));
   bool removed = remove(obj, from(m_objects));
   assert(removed);
+  m_objectIndex.Invalidate();
 }
 
 int Image::GetNumObjects() const{
@@ -262,20 +300,53 @@ void Image::Revert(){
   m_original.Visit(
     [&](const Either<Bitmap, ColorSpan>& bg){
       m_bg = bg;
+      m_lazyBg = m_originalLazyBg;
+      m_rasterChanges.ChangedAll();
     },
     [](){
       assert(false);
     });
 }
 
+void Image::ObjectsChanged(){
+  m_objectIndex.Invalidate();
+  m_objectChanges.ChangedAll();
+}
+
+void Image::ObjectsChanged(const IntRect& r){
+  m_objectIndex.Invalidate();
+  m_objectChanges.Changed(r);
+}
+
+void Image::InvalidateRaster(const IntRect& r){
+  m_rasterChanges.Changed(r);
+}
+
+void Image::InvalidateRaster(){
+  m_rasterChanges.ChangedAll();
+}
+
 const Either<Bitmap, ColorSpan>& Image::GetBackground() const{
+  MaterializeLazyBackground();
   return m_bg;
 }
 
 FrozenEither<Bitmap, ColorSpan> Image::GetBackground(){
+  MaterializeLazyBackground();
   return frozen(m_bg);
 }
 
+const LazyBitmap* Image::GetLazyBackground() const{
+  return m_lazyBg.get();
+}
+
+void Image::MaterializeLazyBackground() const{
+  if (m_lazyBg != nullptr){
+    m_bg.Set(materialize(*m_lazyBg));
+    m_lazyBg.reset();
+  }
+}
+
 Delay Image::GetDelay() const{
   return m_delay;
 }
@@ -25,14 +25,18 @@
 #include "util/either.hh"
 #include "util/hot-spot.hh"
 #include "util/id-types.hh"
+#include "util/object-index.hh"
 #include "util/objects.hh"
 #include "util/optional.hh"
+#include "util/raster-changes.hh"
 #include "util/raster-selection.hh"
 
 namespace faint {
 
 class ExpressionContext;
+class FlattenCache;
 class FrameProps;
+class LazyBitmap;
 class Object;
 
 class Image {
@@ -52,6 +56,9 @@ public:
   bool Deselect(const Object*);
   bool Deselect(const objects_t&);
   void DeselectObjects();
+
+  // Returns the background, first reading all pixels of a lazy
+  // background into a Bitmap.
   const Either<Bitmap, ColorSpan>& GetBackground() const;
   FrozenEither<Bitmap, ColorSpan> GetBackground();
 
@@ -59,20 +66,56 @@ public:
   Delay GetDelay() const;
 
   ExpressionContext& GetExpressionContext() const;
+
+  // The background with the objects drawn onto it (without any
+  // floating raster selection). Kept between calls, and updated only
+  // where changed.
+  const Bitmap& GetFlattened() const;
   HotSpot GetHotSpot() const;
   FrameId GetId() const;
+
+  // The background pixels, if they are still read on demand (for a
+  // huge loaded image which has not been modified), otherwise
+  // nullptr. For viewing without reading the entire image.
+  const LazyBitmap* GetLazyBackground() const;
   int GetNumObjects() const;
 
+  // Regions wherein objects were changed by commands, since earlier
+  // generations.
+  const RasterChanges& GetObjectChanges() const;
   const objects_t& GetObjects() const;
+
+  // The objects whose bounds contain the point, from bottom to top.
+  // A superset of the objects which could pass Object::HitTest.
+  objects_t GetObjectsAt(const Point&) const;
+
+  // The objects whose bounding rectangles intersect the rectangle,
+  // from bottom to top (like get_intersected).
+  objects_t GetObjectsIntersecting(const Rect&) const;
   int GetObjectZ(const Object*) const;
   const objects_t& GetObjectSelection() const;
   RasterSelection& GetRasterSelection();
   const Optional<Calibration>& GetCalibration() const;
+
+  // Regions of the background changed since earlier generations.
+  const RasterChanges& GetRasterChanges() const;
   const RasterSelection& GetRasterSelection() const;
   IntSize GetSize() const;
   bool Has(const ObjectId&) const;
   bool Has(const Object*) const;
   bool HasStoredOriginal() const;
+
+  // Notes that pixels of the background bitmap were modified
+  // in-place, within the rectangle or anywhere. Replacing the
+  // background (e.g. SetBitmap, Revert) does this automatically.
+  void InvalidateRaster(const IntRect&);
+  void InvalidateRaster();
+
+  // Notes that objects may have moved or changed size (e.g. after a
+  // command), for the object lookups and the flattened image,
+  // anywhere or only within the rectangle.
+  void ObjectsChanged();
+  void ObjectsChanged(const IntRect&);
   void Remove(Object*);
   void Revert();
 
@@ -101,16 +144,29 @@ public:
 
   Image& operator=(const Image&) = delete;
 private:
-  Either<Bitmap, ColorSpan> m_bg;
+  void MaterializeLazyBackground() const;
+
+  // While the lazy background is set, m_bg is a placeholder ColorSpan
+  // of the same size, replaced with the Bitmap when the background is
+  // first requested.
+  mutable Either<Bitmap, ColorSpan> m_bg;
+  mutable std::shared_ptr<const LazyBitmap> m_lazyBg;
   Optional<Calibration> m_calibration;
   Delay m_delay;
   std::unique_ptr<ExpressionContext> m_expressionContext;
+  mutable std::unique_ptr<FlattenCache> m_flattenCache;
   HotSpot m_hotSpot;
   FrameId m_id;
+  RasterChanges m_objectChanges;
   objects_t m_objects;
   objects_t m_objectSelection;
+
+  // Spatial index of m_objects, rebuilt when queried after changes.
+  mutable ObjectIndex m_objectIndex;
   Optional<Either<Bitmap, ColorSpan> > m_original;
+  std::shared_ptr<const LazyBitmap> m_originalLazyBg;
   objects_t m_originalObjects;
+  RasterChanges m_rasterChanges;
   RasterSelection m_rasterSelection;
 };
 
@@ -0,0 +1,152 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include "geo/geo-func.hh"
+#include "geo/int-rect.hh"
+#include "geo/point.hh"
+#include "geo/size.hh"
+#include "objects/object.hh"
+#include "util/object-index.hh"
+#include "util/object-util.hh"
+
+namespace faint{
+
+// Maximum number of grid cells per side.
+static const int MAX_CELLS = 256;
+
+// Objects covering more cells are checked on each query instead of
+// being added to the cells.
+static const int MAX_OBJECT_CELLS = 64;
+
+static Rect bounding_union(const Rect& r1, const Rect& r2){
+  return Rect(min_coords(r1.TopLeft(), r2.TopLeft()),
+    max_coords(r1.BottomRight(), r2.BottomRight()));
+}
+
+static Rect object_bounds(Object* obj){
+  // The refresh rectangle covers hit-testable areas (e.g. wide
+  // lines), the tri covers the rectangle used when selecting
+  // objects by area.
+  return inflated(bounding_union(floated(obj->GetRefreshRect()),
+    bounding_rect(obj)), 1.0);
+}
+
+objects_t ObjectIndex::At(const objects_t& objects, const Point& p){
+  Update(objects);
+  return Query(objects, Rect(p, p));
+}
+
+void ObjectIndex::Invalidate(){
+  m_valid = false;
+}
+
+objects_t ObjectIndex::Intersecting(const objects_t& objects,
+  const Rect& r)
+{
+  Update(objects);
+  return Query(objects, r);
+}
+
+int ObjectIndex::Column(coord x) const{
+  return std::max(0, std::min(m_columns - 1,
+    static_cast<int>((x - m_extents.x) / m_cellWidth)));
+}
+
+int ObjectIndex::Row(coord y) const{
+  return std::max(0, std::min(m_rows - 1,
+    static_cast<int>((y - m_extents.y) / m_cellHeight)));
+}
+
+objects_t ObjectIndex::Query(const objects_t& objects, const Rect& r) const{
+  std::vector<int> candidates(m_large);
+  if (!objects.empty() && intersects(r, m_extents)){
+    for (int row = Row(r.Top()); row <= Row(r.Bottom()); row++){
+      for (int col = Column(r.Left()); col <= Column(r.Right()); col++){
+        const auto& cell = m_cells[to_size_t(row * m_columns + col)];
+        candidates.insert(end(candidates), begin(cell), end(cell));
+      }
+    }
+  }
+
+  std::sort(begin(candidates), end(candidates));
+  candidates.erase(std::unique(begin(candidates), end(candidates)),
+    end(candidates));
+
+  objects_t found;
+  for (int i : candidates){
+    if (intersects(m_bounds[to_size_t(i)], r)){
+      found.push_back(objects[to_size_t(i)]);
+    }
+  }
+  return found;
+}
+
+void ObjectIndex::Rebuild(const objects_t& objects){
+  m_bounds.clear();
+  m_cells.clear();
+  m_large.clear();
+  m_valid = true;
+
+  if (objects.empty()){
+    m_columns = m_rows = 0;
+    return;
+  }
+
+  for (Object* obj : objects){
+    m_bounds.push_back(object_bounds(obj));
+  }
+
+  m_extents = m_bounds.front();
+  for (const Rect& r : m_bounds){
+    m_extents = bounding_union(m_extents, r);
+  }
+
+  // Roughly one object per cell, if evenly spread
+  const int side = static_cast<int>(std::ceil(std::sqrt(objects.size())));
+  m_columns = m_rows = std::max(1, std::min(side, MAX_CELLS));
+  m_cellWidth = std::max(m_extents.w / m_columns, 1.0);
+  m_cellHeight = std::max(m_extents.h / m_rows, 1.0);
+  m_cells.resize(to_size_t(m_columns * m_rows));
+
+  for (size_t i = 0; i != m_bounds.size(); i++){
+    const Rect& r = m_bounds[i];
+    const int col0 = Column(r.Left());
+    const int col1 = Column(r.Right());
+    const int row0 = Row(r.Top());
+    const int row1 = Row(r.Bottom());
+    const int index = resigned(i);
+
+    if ((col1 - col0 + 1) * (row1 - row0 + 1) > MAX_OBJECT_CELLS){
+      m_large.push_back(index);
+      continue;
+    }
+
+    for (int row = row0; row <= row1; row++){
+      for (int col = col0; col <= col1; col++){
+        m_cells[to_size_t(row * m_columns + col)].push_back(index);
+      }
+    }
+  }
+}
+
+void ObjectIndex::Update(const objects_t& objects){
+  if (!m_valid || objects.size() != m_bounds.size()){
+    Rebuild(objects);
+  }
+}
+
+} // namespace
@@ -0,0 +1,70 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_OBJECT_INDEX_HH
+#define FAINT_OBJECT_INDEX_HH
+#include <vector>
+#include "geo/rect.hh"
+#include "util/objects.hh"
+
+namespace faint{
+
+class ObjectIndex{
+  // Uniform grid over the bounds of objects, for finding the objects
+  // at a point or within a rectangle without testing every object.
+  //
+  // The index is built from the objects passed to the queries, and
+  // must be invalidated whenever objects are added, removed,
+  // reordered or change bounds.
+public:
+  // Returns the objects whose bounds contain the point, from bottom
+  // to top.
+  objects_t At(const objects_t&, const Point&);
+
+  // Notes that the objects have changed, so that the index is rebuilt
+  // on the next query.
+  void Invalidate();
+
+  // Returns the objects whose bounds intersect the rectangle, from
+  // bottom to top.
+  objects_t Intersecting(const objects_t&, const Rect&);
+private:
+  void Rebuild(const objects_t&);
+  void Update(const objects_t&);
+  objects_t Query(const objects_t&, const Rect&) const;
+  int Column(coord x) const;
+  int Row(coord y) const;
+
+  bool m_valid = false;
+
+  // The bounds of each object, by z-order
+  std::vector<Rect> m_bounds;
+
+  // The indexes of the objects intersecting each cell
+  std::vector<std::vector<int>> m_cells;
+
+  // Objects covering too many cells to add to each
+  std::vector<int> m_large;
+
+  Rect m_extents;
+  int m_columns = 0;
+  int m_rows = 0;
+  coord m_cellWidth = 1.0;
+  coord m_cellHeight = 1.0;
+};
+
+} // namespace
+
+#endif
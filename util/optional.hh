@@ -318,7 +318,7 @@ T or_throw(Optional<T>&& opt, const Exception& ex){
   if (opt.NotSet()){
     throw ex;
   }
-  return opt.Get();
+  return opt.Take();
 }
 
 } // namespace
@@ -0,0 +1,220 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "util/parallel.hh"
+
+namespace faint{
+
+// True on the worker threads, and on a calling thread while it
+// executes parallel tasks, so that nested calls run serially.
+static thread_local bool t_inParallel = false;
+
+static std::atomic<int> g_maxThreads(0);
+
+class ThreadPool{
+  // Worker threads which, together with the calling thread, execute
+  // the numbered tasks of one job at a time.
+public:
+  ThreadPool() = default;
+
+  ~ThreadPool(){
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads){
+      thread.join();
+    }
+  }
+
+  // Runs the tasks and returns true, or returns false without
+  // running them if the pool is busy with a job from another thread.
+  bool Run(int numTasks, int numThreads,
+    const std::function<void(int)>& task)
+  {
+    std::unique_lock<std::mutex> runLock(m_runMutex, std::try_to_lock);
+    if (!runLock.owns_lock()){
+      return false;
+    }
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      while (static_cast<int>(m_threads.size()) < numThreads - 1){
+        m_threads.emplace_back([this](){WorkerLoop();});
+      }
+      m_task = &task;
+      m_next = 0;
+      m_numTasks = numTasks;
+      m_unfinished = numTasks;
+      m_job++;
+    }
+    m_wake.notify_all();
+    Work();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [&](){return m_unfinished == 0;});
+    m_task = nullptr;
+    if (m_error != nullptr){
+      std::exception_ptr error = m_error;
+      m_error = nullptr;
+      std::rethrow_exception(error);
+    }
+    return true;
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+private:
+  void WorkerLoop(){
+    t_inParallel = true;
+    unsigned int seenJob = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;){
+      m_wake.wait(lock, [&](){
+        return m_stop || (m_job != seenJob && m_task != nullptr);
+      });
+      if (m_stop){
+        return;
+      }
+      seenJob = m_job;
+      lock.unlock();
+      Work();
+      lock.lock();
+    }
+  }
+
+  void Work(){
+    const bool wasInParallel = t_inParallel;
+    t_inParallel = true;
+    for (;;){
+      int index = 0;
+      const std::function<void(int)>* task = nullptr;
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_next >= m_numTasks){
+          break;
+        }
+        index = m_next++;
+        task = m_task;
+      }
+
+      try{
+        (*task)(index);
+      }
+      catch (...){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_error == nullptr){
+          m_error = std::current_exception();
+        }
+      }
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_unfinished--;
+      if (m_unfinished == 0){
+        m_done.notify_all();
+      }
+    }
+    t_inParallel = wasInParallel;
+  }
+
+  std::mutex m_runMutex;
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+  std::vector<std::thread> m_threads;
+  const std::function<void(int)>* m_task = nullptr;
+  std::exception_ptr m_error;
+  unsigned int m_job = 0;
+  int m_next = 0;
+  int m_numTasks = 0;
+  int m_unfinished = 0;
+  bool m_stop = false;
+};
+
+static ThreadPool& get_thread_pool(){
+  static ThreadPool pool;
+  return pool;
+}
+
+int get_max_threads(){
+  const int maxThreads = g_maxThreads;
+  if (maxThreads > 0){
+    return maxThreads;
+  }
+  return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+void set_max_threads(int maxThreads){
+  g_maxThreads = std::max(0, maxThreads);
+}
+
+void parallel_for(int count,
+  int minPerRange,
+  const std::function<void(int, int)>& func)
+{
+  if (count <= 0){
+    return;
+  }
+
+  // A few ranges per thread, to even out uneven ranges
+  const int numThreads = get_max_threads();
+  const int numRanges = std::min(count / std::max(minPerRange, 1),
+    numThreads * 4);
+
+  if (numThreads == 1 || numRanges <= 1 || t_inParallel){
+    func(0, count);
+    return;
+  }
+
+  const bool ran = get_thread_pool().Run(numRanges,
+    std::min(numThreads, numRanges),
+    [&](int range){
+      const auto first = static_cast<long long>(count) * range / numRanges;
+      const auto last = static_cast<long long>(count) * (range + 1) /
+        numRanges;
+      func(static_cast<int>(first), static_cast<int>(last));
+    });
+
+  if (!ran){
+    // The pool is busy with a job from another thread (e.g. a
+    // background preview). Don't wait for it, so that e.g. painting
+    // stays responsive.
+    func(0, count);
+  }
+}
+
+int min_items_per_range(int pixelsPerItem){
+  return MIN_PIXELS_PER_RANGE / std::max(pixelsPerItem, 1) + 1;
+}
+
+void for_row_ranges(int yMin,
+  int yMax,
+  int width,
+  const std::function<void(int first, int last)>& func)
+{
+  parallel_for(yMax - yMin, min_items_per_range(width),
+    [&](int first, int last){
+      func(yMin + first, yMin + last);
+    });
+}
+
+} // namespace
@@ -0,0 +1,61 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_PARALLEL_HH
+#define FAINT_PARALLEL_HH
+#include <functional>
+
+namespace faint{
+
+// Returns the number of threads used by parallel_for, by default the
+// number of hardware threads.
+int get_max_threads();
+
+// Sets the number of threads used by parallel_for, e.g. for
+// benchmarks. Zero restores the default.
+void set_max_threads(int);
+
+// Splits [0, count) into consecutive ranges of at least minPerRange
+// items and calls func(first, last) for each range, concurrently on
+// a shared pool of worker threads and the calling thread. Returns
+// when all ranges are done, rethrowing the first exception thrown by
+// func, if any.
+//
+// Runs func(0, count) directly if only one thread is allowed, when
+// called from within func of another parallel_for, or when the pool
+// is busy with a job from another thread.
+void parallel_for(int count,
+  int minPerRange,
+  const std::function<void(int first, int last)>& func);
+
+// The least number of pixels per range when processing images with
+// parallel_for. Smaller images are processed on the calling thread.
+const int MIN_PIXELS_PER_RANGE = 16384;
+
+// The minPerRange for parallel_for over items (e.g. rows) of the
+// given number of pixels each.
+int min_items_per_range(int pixelsPerItem);
+
+// Calls func(first, last) for ranges of the rows [yMin, yMax) of a
+// region with the given width, using parallel_for with at least
+// MIN_PIXELS_PER_RANGE pixels per range.
+void for_row_ranges(int yMin,
+  int yMax,
+  int width,
+  const std::function<void(int first, int last)>& func);
+
+} // namespace
+
+#endif
@@ -0,0 +1,98 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <exception>
+#include "util/preview-worker.hh"
+
+namespace faint{
+
+PreviewWorker::PreviewWorker(const std::function<void()>& onDone)
+  : m_generation(0),
+    m_onDone(onDone),
+    m_thread([this](){Run();})
+{}
+
+PreviewWorker::~PreviewWorker(){
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_quit = true;
+    m_pending = nullptr;
+    m_generation++;
+  }
+  m_jobAdded.notify_one();
+  m_thread.join();
+}
+
+void PreviewWorker::Start(const preview_job_func& job){
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending = job;
+    m_result.Clear();
+    m_generation++;
+  }
+  m_jobAdded.notify_one();
+}
+
+void PreviewWorker::Cancel(){
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_pending = nullptr;
+  m_result.Clear();
+  m_generation++;
+}
+
+Optional<Bitmap> PreviewWorker::TakeResult(){
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Optional<Bitmap> result(std::move(m_result));
+  m_result.Clear();
+  return result;
+}
+
+void PreviewWorker::Run(){
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for (;;){
+    m_jobAdded.wait(lock, [this](){
+      return m_quit || m_pending != nullptr;
+    });
+    if (m_quit){
+      return;
+    }
+
+    const preview_job_func job(std::move(m_pending));
+    m_pending = nullptr;
+    const int generation = m_generation;
+    lock.unlock();
+
+    Optional<Bitmap> result;
+    try{
+      result = job([this, generation](){
+        return m_generation != generation;
+      });
+    }
+    catch (const std::exception&){
+      // A failed preview (e.g. out of memory) is not shown. The
+      // full-size filter reports errors when applied.
+    }
+
+    lock.lock();
+    if (result.IsSet() && generation == m_generation){
+      m_result = std::move(result);
+      lock.unlock();
+      m_onDone();
+      lock.lock();
+    }
+  }
+}
+
+} // namespace
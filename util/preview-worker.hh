@@ -0,0 +1,70 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_PREVIEW_WORKER_HH
+#define FAINT_PREVIEW_WORKER_HH
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "bitmap/bitmap.hh"
+#include "util/optional.hh"
+
+namespace faint{
+
+// Returns true if the job calling it has been cancelled.
+using cancelled_func = std::function<bool()>;
+
+// A job for the PreviewWorker. Should return nothing if cancelled.
+using preview_job_func = std::function<Optional<Bitmap>(const cancelled_func&)>;
+
+class PreviewWorker{
+  // Runs preview jobs on a background thread, keeping only the latest
+  // job. Starting a job cancels any earlier job, and the result of a
+  // cancelled job is discarded.
+public:
+  // The onDone-function is called on the worker thread when a result
+  // is available (e.g. to wake up the GUI thread).
+  explicit PreviewWorker(const std::function<void()>& onDone);
+
+  // Cancels the current job and waits for the worker thread to exit.
+  ~PreviewWorker();
+
+  void Start(const preview_job_func&);
+  void Cancel();
+
+  // Returns the result of the latest job, if it finished since the
+  // previous call.
+  Optional<Bitmap> TakeResult();
+
+  PreviewWorker(const PreviewWorker&) = delete;
+  PreviewWorker& operator=(const PreviewWorker&) = delete;
+private:
+  void Run();
+
+  std::mutex m_mutex;
+  std::condition_variable m_jobAdded;
+  preview_job_func m_pending;
+  std::atomic<int> m_generation;
+  Optional<Bitmap> m_result;
+  bool m_quit = false;
+  std::function<void()> m_onDone;
+  std::thread m_thread;
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,60 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <cstddef>
+#include "util/raster-changes.hh"
+
+namespace faint{
+
+// The number of rectangles to remember.
+static const size_t MAX_CHANGES = 64;
+
+void RasterChanges::Changed(const IntRect& r){
+  m_generation++;
+  if (m_changes.size() == MAX_CHANGES){
+    m_allChanged = m_changes.front().generation;
+    m_changes.pop_front();
+  }
+  m_changes.emplace_back(m_generation, r);
+}
+
+void RasterChanges::ChangedAll(){
+  m_generation++;
+  m_allChanged = m_generation;
+  m_changes.clear();
+}
+
+int RasterChanges::GetGeneration() const{
+  return m_generation;
+}
+
+bool RasterChanges::ChangedSince(int generation, const IntRect& r) const{
+  if (generation >= m_generation){
+    return false;
+  }
+  if (generation < m_allChanged){
+    return true;
+  }
+  for (const auto& change : m_changes){
+    if (change.generation > generation &&
+      !empty(intersection(change.rect, r)))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
@@ -0,0 +1,66 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_RASTER_CHANGES_HH
+#define FAINT_RASTER_CHANGES_HH
+#include <deque>
+#include "geo/int-rect.hh"
+
+namespace faint{
+
+class RasterChanges{
+  // Records which regions of an image's raster background have been
+  // changed, so that cached renderings of unchanged regions can be
+  // reused.
+  //
+  // Each change increments a generation counter. Only the most recent
+  // changes are remembered, any query reaching further back reports
+  // everything as changed.
+public:
+  // Notes that the pixels within the rectangle were changed.
+  void Changed(const IntRect&);
+
+  // Notes that any pixel may have changed (e.g. the bitmap was
+  // replaced).
+  void ChangedAll();
+
+  // Incremented by each change.
+  int GetGeneration() const;
+
+  // True if pixels within the rectangle may have changed after the
+  // specified generation.
+  bool ChangedSince(int generation, const IntRect&) const;
+private:
+  class Change{
+  public:
+    Change(int generation, const IntRect& rect)
+      : generation(generation),
+        rect(rect)
+    {}
+    int generation;
+    IntRect rect;
+  };
+
+  int m_generation = 0;
+
+  // The latest generation with unknown extent, queries for earlier
+  // generations are reported as changed everywhere.
+  int m_allChanged = 0;
+  std::deque<Change> m_changes;
+};
+
+} // namespace
+
+#endif
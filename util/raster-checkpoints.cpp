@@ -0,0 +1,110 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <algorithm>
+#include <cassert>
+#include "geo/primitive.hh"
+#include "util/image.hh"
+#include "util/raster-checkpoints.hh"
+
+namespace faint{
+
+static size_t memory_usage(const Bitmap& bmp){
+  return to_size_t(bmp.GetStride()) * to_size_t(bmp.GetSize().h);
+}
+
+RasterCheckpoints::RasterCheckpoints(const CheckpointOptions& options)
+  : m_options(options)
+{
+  assert(m_options.interval > 0);
+}
+
+void RasterCheckpoints::Applied(const Command* cmd,
+  const Image& image,
+  double seconds)
+{
+  int& count = m_sinceCheckpoint[&image];
+  count++;
+
+  const bool expensive = seconds >= m_options.expensiveSeconds;
+  if (count < m_options.interval && !expensive){
+    return;
+  }
+
+  image.GetBackground().Get<Bitmap>().IfSet(
+    [&](const Bitmap& bmp){
+      Remove(cmd);
+      Add(cmd, bmp);
+      count = 0;
+    });
+}
+
+void RasterCheckpoints::Clear(){
+  m_checkpoints.clear();
+  m_sinceCheckpoint.clear();
+  m_memoryUsage = 0;
+}
+
+const Bitmap* RasterCheckpoints::Get(const Command* cmd) const{
+  for (const auto& checkpoint : m_checkpoints){
+    if (checkpoint.command == cmd){
+      return &checkpoint.bmp;
+    }
+  }
+  return nullptr;
+}
+
+int RasterCheckpoints::GetCount() const{
+  return resigned(m_checkpoints.size());
+}
+
+size_t RasterCheckpoints::GetMemoryUsage() const{
+  return m_memoryUsage;
+}
+
+void RasterCheckpoints::Remove(const Command* cmd){
+  auto it = std::find_if(begin(m_checkpoints), end(m_checkpoints),
+    [&](const Checkpoint& checkpoint){
+      return checkpoint.command == cmd;
+    });
+
+  if (it != end(m_checkpoints)){
+    m_memoryUsage -= memory_usage(it->bmp);
+    m_checkpoints.erase(it);
+  }
+}
+
+void RasterCheckpoints::Add(const Command* cmd, const Bitmap& bmp){
+  const size_t required = memory_usage(bmp);
+  if (required > m_options.memoryBudget){
+    // Would never fit, keep the older snapshots instead.
+    return;
+  }
+
+  while (m_memoryUsage + required > m_options.memoryBudget){
+    EvictOldest();
+  }
+
+  m_checkpoints.emplace_back(cmd, bmp);
+  m_memoryUsage += required;
+}
+
+void RasterCheckpoints::EvictOldest(){
+  assert(!m_checkpoints.empty());
+  m_memoryUsage -= memory_usage(m_checkpoints.front().bmp);
+  m_checkpoints.pop_front();
+}
+
+} // namespace
@@ -0,0 +1,99 @@
+// -*- coding: us-ascii-unix -*-
+// Copyright 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you
+// may not use this file except in compliance with the License. You
+// may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FAINT_RASTER_CHECKPOINTS_HH
+#define FAINT_RASTER_CHECKPOINTS_HH
+#include <deque>
+#include <map>
+#include "bitmap/bitmap.hh"
+
+namespace faint{
+
+class Command;
+class Image;
+
+class CheckpointOptions{
+public:
+  // Snapshot a frame after this many raster commands.
+  int interval = 16;
+
+  // Snapshot a frame after any command which took at least this long
+  // to apply.
+  double expensiveSeconds = 0.25;
+
+  // Maximum total pixel memory used by snapshots. The oldest
+  // snapshots are evicted when exceeded.
+  size_t memoryBudget = 512 * 1024 * 1024;
+};
+
+class RasterCheckpoints{
+  // Bitmap snapshots of frames, each taken directly after applying a
+  // raster command. Undoing a command which is not fully reversible
+  // can restore the nearest earlier snapshot for the frame and
+  // reapply only the commands after it, instead of reverting the
+  // frame and reapplying every command.
+  //
+  // A snapshot is identified by the command it was taken after, and
+  // must be removed (via Remove) when that command is undone, merged
+  // into or deleted.
+public:
+  explicit RasterCheckpoints(const CheckpointOptions& = CheckpointOptions());
+
+  // Notes that the command was applied to the frame, and takes a
+  // snapshot of the frame if the interval is reached or the command
+  // was expensive.
+  void Applied(const Command*, const Image&, double seconds);
+
+  // Removes all snapshots.
+  void Clear();
+
+  // Returns the snapshot taken after the command, or nullptr.
+  const Bitmap* Get(const Command*) const;
+
+  // The number of stored snapshots.
+  int GetCount() const;
+
+  // The total pixel memory used by snapshots.
+  size_t GetMemoryUsage() const;
+
+  // Removes the snapshot taken after the command, if any.
+  void Remove(const Command*);
+
+  RasterCheckpoints(const RasterCheckpoints&) = delete;
+  RasterCheckpoints& operator=(const RasterCheckpoints&) = delete;
+private:
+  class Checkpoint{
+  public:
+    Checkpoint(const Command* command, const Bitmap& bmp)
+      : command(command),
+        bmp(bmp)
+    {}
+    const Command* command;
+    Bitmap bmp;
+  };
+
+  void Add(const Command*, const Bitmap&);
+  void EvictOldest();
+
+  // Ordered by age, oldest first.
+  std::deque<Checkpoint> m_checkpoints;
+  std::map<const Image*, int> m_sinceCheckpoint;
+  size_t m_memoryUsage = 0;
+  CheckpointOptions m_options;
+};
+
+} // namespace
+
+#endif
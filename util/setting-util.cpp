@@ -15,7 +15,9 @@
 
 #include <cassert>
 #include "bitmap/brush.hh"
+#include "bitmap/color.hh"
 #include "bitmap/filter.hh"
+#include "geo/flat-path.hh"
 #include "objects/object.hh"
 #include "rendering/filter-class.hh"
 #include "util/default-settings.hh"
@@ -230,6 +232,43 @@ Settings mask_settings_line(const Settings& objSettings){
   return s;
 }
 
+static bool on_mask_stroke(const polylines_t& polylines,
+  const Point& p,
+  const Settings& s)
+{
+  return on_stroke(polylines, p, s.GetDefault(ts_LineWidth, 1.0),
+    s.GetDefault(ts_LineCap, LineCap::DEFAULT) == LineCap::BUTT,
+    s.GetDefault(ts_LineJoin, LineJoin::DEFAULT) == LineJoin::MITER);
+}
+
+Color mask_color_fill(const polylines_t& polylines,
+  const Point& p,
+  const Settings& s)
+{
+  const bool hasBorder = border(s);
+  const bool hasFill = filled(s);
+  const bool evenOdd =
+    s.GetDefault(ts_FillRule, FillRule::DEFAULT) == FillRule::FR_EVEN_ODD;
+
+  if (hasBorder && on_mask_stroke(polylines, p, s)){
+    return mask_edge;
+  }
+  else if (inside_polylines(polylines, p, evenOdd)){
+    return hasFill ? mask_fill : mask_no_fill;
+  }
+  else if (!hasBorder && !hasFill && on_mask_stroke(polylines, p, s)){
+    return mask_no_fill;
+  }
+  return mask_outside;
+}
+
+Color mask_color_line(const polylines_t& polylines,
+  const Point& p,
+  const Settings& s)
+{
+  return on_mask_stroke(polylines, p, s) ? mask_edge : mask_outside;
+}
+
 bool masked_background(const Settings& s){
   return s.Get(ts_BackgroundStyle) == BackgroundStyle::MASKED;
 }
@@ -16,12 +16,14 @@
 #ifndef FAINT_SETTING_UTIL_HH
 #define FAINT_SETTING_UTIL_HH
 #include <memory>
+#include "geo/flat-path.hh"
 #include "util/distinct.hh"
 #include "util/setting-id.hh"
 
 namespace faint{
 
 class Brush;
+class Color;
 class Padding;
 class RasterSelection;
 
@@ -81,6 +83,19 @@ Settings mask_settings_fill(const Settings& objSettings);
 // Creates hit test mask settings for unclosed paths (non-fillable objects)
 Settings mask_settings_line(const Settings&);
 
+// Returns the color that drawing the polylines with
+// mask_settings_fill(objSettings) would give the point, without
+// rendering.
+Color mask_color_fill(const polylines_t&,
+  const Point&,
+  const Settings& objSettings);
+
+// Returns the color that stroking the polylines with
+// mask_settings_line(objSettings) would give the point.
+Color mask_color_line(const polylines_t&,
+  const Point&,
+  const Settings& objSettings);
+
 // True if the background is masked (ts_BackgroundStyle)
 bool masked_background(const Settings&);
 
@@ -16,6 +16,7 @@
 #include "app/canvas.hh"
 #include "bitmap/bitmap.hh"
 #include "bitmap/color.hh"
+#include "bitmap/lazy-bitmap.hh"
 #include "bitmap/paint.hh"
 #include "bitmap/pattern.hh"
 #include "geo/adjust.hh"
@@ -57,6 +58,13 @@ Color get_color(const Either<Bitmap, ColorSpan>& bg, const IntPoint& pos){
     });
 }
 
+Color get_color(const Image& image, const IntPoint& pos){
+  const LazyBitmap* lazy = image.GetLazyBackground();
+  return lazy == nullptr ?
+    get_color(image.GetBackground(), pos) :
+    get_color(*lazy, pos);
+}
+
 Paint get_hovered_paint(const PosInside& info,
   const include_hidden_fill& includeHiddenFill,
   const include_floating_selection& includeFloatingSelection)
@@ -74,8 +82,7 @@ Paint get_hovered_paint(const PosInside& info,
     }
   }
 
-  return Paint(get_color(info->canvas.GetImage().GetBackground(),
-    floored(info->pos)));
+  return Paint(get_color(info->canvas.GetImage(), floored(info->pos)));
 }
 
 // Returns the topmost text object in the ObjComposite or 0 if no text
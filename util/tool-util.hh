@@ -20,6 +20,7 @@
 
 namespace faint{
 
+class Image;
 class ObjText;
 
 // Whether actions should use the foreground or background color
@@ -40,6 +41,11 @@ using include_floating_selection = Distinct<bool, category_toolutil, 1>;
 // Note: The position must must be inside.
 Color get_color(const Either<Bitmap, ColorSpan>&, const IntPoint&);
 
+// Returns the background color at the given position, without
+// reading all pixels of a lazy background.
+// Note: The position must must be inside.
+Color get_color(const Image&, const IntPoint&);
+
 // Returns the Paint under the given position. Includes objects if in
 // the object layer.
 Paint get_hovered_paint(const PosInside&,